@@ -0,0 +1,307 @@
+#include "call_timeline.h"
+
+#include <algorithm>
+
+#include "trace_x/trace_x.h"
+
+CallTimeline::CallTimeline():
+    _last_time(0)
+{
+    X_CALL;
+}
+
+void CallTimeline::add(quint64 time, const trace_message_t *message)
+{
+    if((message->type != trace_x::MESSAGE_CALL) && (message->type != trace_x::MESSAGE_RETURN))
+    {
+        return;
+    }
+
+    QMutexLocker lock(&_mutex);
+
+    QHash<tid_index_t, int>::const_iterator lane_it = _lane_by_tid.constFind(message->tid_index);
+
+    if(lane_it == _lane_by_tid.constEnd())
+    {
+        lane_it = _lane_by_tid.insert(message->tid_index, _lanes.size());
+
+        _lanes.append(lane_data_t());
+
+        _lanes.last().lane.process_index = message->process_index;
+        _lanes.last().lane.tid_index = message->tid_index;
+    }
+
+    lane_data_t &lane = _lanes[lane_it.value()];
+
+    if(message->type == trace_x::MESSAGE_CALL)
+    {
+        open_call_t call;
+
+        call.index = message->index;
+        call.function_index = message->function_index;
+
+        lane.stack.append(call);
+
+        return;
+    }
+
+    timeline_span_t span;
+
+    span.index = message->index;
+    span.function_index = message->function_index;
+    span.count = 1;
+
+    // find matching CALL, calls above it have lost their RETURN`s
+
+    int frame_index = lane.stack.size() - 1;
+
+    while((frame_index >= 0) && (lane.stack.at(frame_index).function_index != message->function_index))
+    {
+        frame_index--;
+    }
+
+    if(frame_index >= 0)
+    {
+        span.index = lane.stack.at(frame_index).index;
+
+        lane.stack.resize(frame_index);
+    }
+
+    // RETURN has time of CALL, so span is known even if CALL was not captured
+
+    quint64 duration = (message->timestamp > message->extra_timestamp) ? message->timestamp - message->extra_timestamp : 0;
+
+    span.end = time;
+    span.start = (time > duration) ? time - duration : 0;
+    span.busy = span.end - span.start;
+
+    int depth = qMax(0, int(message->call_level));
+
+    if(lane.depths.size() <= depth)
+    {
+        lane.depths.resize(depth + 1);
+        lane.lane.depth_count = lane.depths.size();
+    }
+
+    append_span(lane.depths[depth], span);
+
+    _last_time = qMax(_last_time, time);
+}
+
+void CallTimeline::remove_before(index_t index)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    for(int i = 0; i < _lanes.size(); ++i)
+    {
+        QVector<span_levels_t> &depths = _lanes[i].depths;
+
+        for(int depth = 0; depth < depths.size(); ++depth)
+        {
+            span_levels_t &levels = depths[depth];
+
+            if(levels.isEmpty())
+            {
+                continue;
+            }
+
+            // calls of one level are sorted by start, so indices of their CALL`s are sorted too
+
+            QVector<timeline_span_t> &spans = levels[0].spans;
+
+            int count = 0;
+
+            while((count < spans.size()) && (spans.at(count).index < index))
+            {
+                count++;
+            }
+
+            if(!count)
+            {
+                continue;
+            }
+
+            spans.remove(0, count);
+
+            levels.resize(1);
+
+            build_levels(levels);
+        }
+    }
+}
+
+void CallTimeline::clear()
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _lanes.clear();
+    _lane_by_tid.clear();
+
+    _last_time = 0;
+}
+
+QVector<timeline_lane_t> CallTimeline::lanes() const
+{
+    QMutexLocker lock(&_mutex);
+
+    QVector<timeline_lane_t> lanes;
+
+    lanes.reserve(_lanes.size());
+
+    foreach (const lane_data_t &lane, _lanes)
+    {
+        lanes.append(lane.lane);
+    }
+
+    return lanes;
+}
+
+int CallTimeline::lane_of(tid_index_t tid_index) const
+{
+    QMutexLocker lock(&_mutex);
+
+    return _lane_by_tid.value(tid_index, -1);
+}
+
+quint64 CallTimeline::last_time() const
+{
+    QMutexLocker lock(&_mutex);
+
+    return _last_time;
+}
+
+QVector<timeline_span_t> CallTimeline::spans(int lane, int depth, quint64 from, quint64 to, quint64 resolution) const
+{
+    QVector<timeline_span_t> result;
+
+    QMutexLocker lock(&_mutex);
+
+    if((lane < 0) || (lane >= _lanes.size()) || (depth < 0) || (depth >= _lanes.at(lane).depths.size()))
+    {
+        return result;
+    }
+
+    const span_levels_t &levels = _lanes.at(lane).depths.at(depth);
+
+    if(levels.isEmpty())
+    {
+        return result;
+    }
+
+    int level = 0;
+
+    while((level < levels.size() - 1) && (levels.at(level + 1).gap <= resolution))
+    {
+        level++;
+    }
+
+    const QVector<timeline_span_t> &spans = levels.at(level).spans;
+
+    // ends of spans are sorted, so the first visible one is found by binary search
+
+    QVector<timeline_span_t>::const_iterator it = std::upper_bound(spans.constBegin(), spans.constEnd(), from,
+                                                                   [](quint64 time, const timeline_span_t &span) { return time < span.end; });
+
+    for(; (it != spans.constEnd()) && (it->start < to); ++it)
+    {
+        result.append(*it);
+    }
+
+    return result;
+}
+
+bool CallTimeline::find(int lane, int depth, quint64 time, timeline_span_t &span) const
+{
+    QMutexLocker lock(&_mutex);
+
+    if((lane < 0) || (lane >= _lanes.size()) || (depth < 0) || (depth >= _lanes.at(lane).depths.size()))
+    {
+        return false;
+    }
+
+    const span_levels_t &levels = _lanes.at(lane).depths.at(depth);
+
+    if(levels.isEmpty())
+    {
+        return false;
+    }
+
+    const QVector<timeline_span_t> &spans = levels.first().spans;
+
+    QVector<timeline_span_t>::const_iterator it = std::lower_bound(spans.constBegin(), spans.constEnd(), time,
+                                                                   [](const timeline_span_t &span, quint64 time) { return span.end < time; });
+
+    if((it == spans.constEnd()) || (it->start > time))
+    {
+        return false;
+    }
+
+    span = *it;
+
+    return true;
+}
+
+void CallTimeline::append_span(span_levels_t &levels, const timeline_span_t &span)
+{
+    if(levels.isEmpty())
+    {
+        levels.resize(1);
+    }
+
+    levels[0].spans.append(span);
+
+    for(int level = 1; level < levels.size(); ++level)
+    {
+        merge_span(levels[level].spans, span, levels.at(level).gap);
+    }
+
+    build_levels(levels);
+}
+
+void CallTimeline::build_levels(span_levels_t &levels)
+{
+    while((levels.last().spans.size() >= MinLevelSize) && (levels.size() < MaxLevels) && (levels.last().gap < MaxGap))
+    {
+        const span_level_t &last = levels.last();
+
+        // blocks of previous level have inner gaps shorter than gap of new level, so they are merged as whole
+
+        span_level_t level;
+
+        level.gap = last.gap ? last.gap : InitialGap / 4;
+
+        do
+        {
+            level.gap *= 4;
+            level.spans.clear();
+
+            foreach (const timeline_span_t &span, last.spans)
+            {
+                merge_span(level.spans, span, level.gap);
+            }
+        }
+        while((level.spans.size() > last.spans.size() / 2) && (level.gap < MaxGap));
+
+        levels.append(level);
+    }
+}
+
+void CallTimeline::merge_span(QVector<timeline_span_t> &spans, const timeline_span_t &span, quint64 gap)
+{
+    if(!spans.isEmpty() && (span.start < spans.last().end + gap))
+    {
+        timeline_span_t &last = spans.last();
+
+        last.end = qMax(last.end, span.end);
+        last.busy += span.busy;
+        last.count += span.count;
+    }
+    else
+    {
+        spans.append(span);
+    }
+}
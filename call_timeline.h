@@ -0,0 +1,134 @@
+#ifndef CALL_TIMELINE_H
+#define CALL_TIMELINE_H
+
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+
+#include "trace_model.h"
+
+//! Call of function or block of calls, merged at coarse level of timeline.
+//! Time is relative to the start of trace, as it is shown in table
+struct timeline_span_t
+{
+    timeline_span_t(): start(0), end(0), busy(0), index(0), count(0), function_index(0) {}
+
+    inline bool is_block() const { return count > 1; }
+
+    quint64 start; // ns
+    quint64 end;   // ns
+
+    //! Total duration of merged calls, blocks are drawn by density busy / (end - start)
+    quint64 busy;  // ns
+
+    //! Index of CALL message (or RETURN one, if CALL was not captured), the first one of block
+    index_t index;
+
+    quint32 count;
+
+    function_index_t function_index;
+};
+
+//! Thread of process with calls of it`s functions
+struct timeline_lane_t
+{
+    timeline_lane_t(): process_index(0), tid_index(0), depth_count(0) {}
+
+    pid_index_t process_index;
+    tid_index_t tid_index;
+
+    //! Number of call levels of lane
+    int depth_count;
+};
+
+//! Spans of calls by thread and call level, made of CALL/RETURN messages of main trace.
+//! Spans of each call level are kept in pyramid: level 0 has all calls, spans of coarse level are merged into blocks,
+//! if gap between them is less than gap of level. Gaps between blocks are not less than gap of their level,
+//! so range of trace has O(range / gap) blocks and drawing depends on viewport, not on size of trace.
+//! Coarse level is built, when the finer one has MinLevelSize spans. It`s gap is widened, until it merges
+//! at least half of spans, so pyramid takes no more than twice of level 0
+class CallTimeline
+{
+public:
+    enum
+    {
+        MinLevelSize = 256,
+        MaxLevels    = 16
+    };
+
+    static const quint64 InitialGap = 1000;          // 1 us, the narrowest gap of coarse level
+    static const quint64 MaxGap     = 1000000000000ULL; // 1000 s
+
+    CallTimeline();
+
+    //! Time of message is relative to the start of trace. Only CALL and RETURN messages are accounted
+    void add(quint64 time, const trace_message_t *message);
+
+    //! Removes calls, which started before message index. Coarse levels are rebuilt
+    void remove_before(index_t index);
+
+    void clear();
+
+    QVector<timeline_lane_t> lanes() const;
+
+    //! Lane of thread or -1
+    int lane_of(tid_index_t tid_index) const;
+
+    //! Time of the latest return
+    quint64 last_time() const;
+
+    //! Spans of lane and call level, which intersect [from, to). They are taken from the coarsest level of pyramid,
+    //! which merges only gaps not wider than resolution (ns per pixel)
+    QVector<timeline_span_t> spans(int lane, int depth, quint64 from, quint64 to, quint64 resolution) const;
+
+    //! Call of lane and call level, which contains time, from level 0
+    bool find(int lane, int depth, quint64 time, timeline_span_t &span) const;
+
+private:
+    //! CALL, which RETURN is not received yet
+    struct open_call_t
+    {
+        index_t index;
+        function_index_t function_index;
+    };
+
+    struct span_level_t
+    {
+        span_level_t(): gap(0) {}
+
+        //! Spans are merged, if gap between them is less than this one
+        quint64 gap; // ns
+
+        QVector<timeline_span_t> spans;
+    };
+
+    //! Pyramid of spans of one call level
+    typedef QVector<span_level_t> span_levels_t;
+
+    struct lane_data_t
+    {
+        timeline_lane_t lane;
+
+        QVector<open_call_t> stack;
+
+        QVector<span_levels_t> depths;
+    };
+
+    void append_span(span_levels_t &levels, const timeline_span_t &span);
+
+    //! Adds coarse levels, while the coarsest one has MinLevelSize spans and can be merged more
+    void build_levels(span_levels_t &levels);
+
+    static void merge_span(QVector<timeline_span_t> &spans, const timeline_span_t &span, quint64 gap);
+
+private:
+    QVector<lane_data_t> _lanes;
+
+    QHash<tid_index_t, int> _lane_by_tid;
+
+    quint64 _last_time;
+
+    mutable QMutex _mutex;
+};
+
+#endif // CALL_TIMELINE_H
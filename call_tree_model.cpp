@@ -0,0 +1,621 @@
+#include "call_tree_model.h"
+
+#include <QHeaderView>
+#include <QMenu>
+#include <QScrollBar>
+#include <QSortFilterProxyModel>
+
+#include <algorithm>
+
+#include "trace_controller.h"
+#include "filter_model.h"
+
+#include "trace_x/trace_x.h"
+
+namespace
+{
+enum
+{
+    SortRole = Qt::UserRole + 1710
+};
+
+inline QString nanoseconds_to_string(uint64_t time)
+{
+    return time ? QString::number(time / 1000000000.0, 'f', 6) : "-";
+}
+
+}
+
+CallTree::CallTree(bool collapse_recursion):
+    _collapse_recursion(collapse_recursion)
+{
+}
+
+CallTree::thread_state_t &CallTree::thread_state(const trace_message_t *message)
+{
+    thread_state_t &state = _threads[qMakePair(qint64(message->process_index), qint64(message->tid_index))];
+
+    if(state.root == -1)
+    {
+        // new thread - new root
+
+        state.root = _nodes.size();
+
+        call_node_t root;
+
+        root.process_index = message->process_index;
+        root.thread_index = message->tid_index;
+        root.row = _roots.size();
+
+        _nodes.append(root);
+        _roots.append(state.root);
+    }
+
+    return state;
+}
+
+int CallTree::child_node(int parent, function_index_t function)
+{
+    QPair<int, qint64> key(parent, qint64(function));
+
+    QHash<QPair<int, qint64>, int>::const_iterator it = _child_hash.constFind(key);
+
+    if(it != _child_hash.cend())
+    {
+        return it.value();
+    }
+
+    int id = _nodes.size();
+
+    call_node_t node;
+
+    node.function_index = function;
+    node.process_index = _nodes[parent].process_index;
+    node.thread_index = _nodes[parent].thread_index;
+    node.parent = parent;
+    node.row = _nodes[parent].children.size();
+
+    _nodes.append(node);
+    _nodes[parent].children.append(id);
+
+    _child_hash.insert(key, id);
+
+    return id;
+}
+
+void CallTree::append(const trace_message_t *message)
+{
+    if(message->type == trace_x::MESSAGE_CALL)
+    {
+        thread_state_t &state = thread_state(message);
+
+        int parent = state.stack.isEmpty() ? state.root : state.stack.last().node;
+
+        if(_collapse_recursion)
+        {
+            // recursive call is accounted in the node of the first entry into function
+
+            for(int i = state.stack.size() - 1; i >= 0; --i)
+            {
+                int ancestor = state.stack.at(i).node;
+
+                if(_nodes.at(ancestor).function_index == message->function_index)
+                {
+                    _nodes[ancestor].call_counter++;
+
+                    state.stack.append(frame_t(ancestor, true));
+
+                    return;
+                }
+            }
+        }
+
+        int node = child_node(parent, message->function_index);
+
+        _nodes[node].call_counter++;
+
+        state.stack.append(frame_t(node, false));
+    }
+    else if(message->type == trace_x::MESSAGE_RETURN)
+    {
+        thread_state_t &state = thread_state(message);
+
+        // find matching CALL, frames above it have lost their RETURN`s
+
+        int frame_index = state.stack.size() - 1;
+
+        while((frame_index >= 0) && (_nodes.at(state.stack.at(frame_index).node).function_index != message->function_index))
+        {
+            frame_index--;
+        }
+
+        if(frame_index < 0)
+        {
+            // CALL was not captured or filtered out
+
+            return;
+        }
+
+        state.stack.resize(frame_index + 1);
+
+        frame_t frame = state.stack.takeLast();
+
+        uint64_t duration = message->timestamp - message->extra_timestamp;
+        uint64_t exclusive_duration = duration > frame.children_time ? duration - frame.children_time : 0;
+
+        call_node_t &node = _nodes[frame.node];
+
+        if(!frame.recursive)
+        {
+            node.inclusive_time += duration;
+        }
+
+        node.exclusive_time += exclusive_duration;
+
+        if(!state.stack.isEmpty())
+        {
+            state.stack.last().children_time += duration;
+        }
+        else
+        {
+            _nodes[state.root].inclusive_time += duration;
+        }
+    }
+}
+
+void CallTree::clear()
+{
+    _nodes.clear();
+    _roots.clear();
+    _child_hash.clear();
+    _threads.clear();
+}
+
+QVector<function_index_t> CallTree::path(int id) const
+{
+    QVector<function_index_t> result;
+
+    while(_nodes.at(id).parent != -1)
+    {
+        result.prepend(_nodes.at(id).function_index);
+
+        id = _nodes.at(id).parent;
+    }
+
+    return result;
+}
+
+/* ===================================================================================== */
+
+CallTreeModel::CallTreeModel(TraceController *controller, TraceDataModel *trace_data, QObject *parent):
+    QAbstractItemModel(parent),
+    _controller(controller),
+    _trace_data(trace_data),
+    _next_index(0),
+    _visible_roots(0)
+{
+    X_CALL;
+
+    _header_model.resize(LastColumn);
+
+    _header_model[Function]   = ColumnData(tr("Function"), tr("Call path"), "namespace::Class::function_____________________");
+    _header_model[Calls]      = ColumnData(tr("Calls"), tr("Number of calls"), "999999_");
+    _header_model[TotalTime]  = ColumnData(tr("Total"), tr("Inclusive time, sec."), "00.00000000_");
+    _header_model[SelfTime]   = ColumnData(tr("Self"), tr("Exclusive time, sec."), "00.00000000_");
+    _header_model[AvgTime]    = ColumnData(tr("Avg"), tr("Average inclusive time, sec."), "00.00000000_");
+    _header_model[ThreadRate] = ColumnData(tr("Thread, %"), tr("Inclusive time rate in thread, %"), "00.000000000");
+
+    build();
+
+    connect(_trace_data, &TraceDataModel::updated, this, &CallTreeModel::update);
+}
+
+CallTreeModel::~CallTreeModel()
+{
+    X_CALL;
+}
+
+void CallTreeModel::build()
+{
+    X_CALL;
+
+    _tree = CallTree(_tree.collapse_recursion());
+
+    _next_index = 0;
+
+    append_messages();
+
+    _visible_roots = _tree.roots().size();
+    _visible_rows.resize(_tree.size());
+
+    for(int i = 0; i < _tree.size(); ++i)
+    {
+        _visible_rows[i] = _tree.node(i).children.size();
+    }
+}
+
+bool CallTreeModel::append_messages()
+{
+    QMutexLocker locker(_trace_data->mutex());
+
+    // rows are removed from the head of model, so tree is continued from index of message
+
+    size_t first = _trace_data->lower_row(_next_index);
+    size_t last = _trace_data->size();
+
+    if(first >= last)
+    {
+        return false;
+    }
+
+    // lazy trace is read by chunks, so tree doesn`t evict cached chunks of view
+
+    _trace_data->for_each_message(first, last, [this](size_t, const trace_message_t *message)
+    {
+        _tree.append(message);
+
+        return true;
+    });
+
+    _next_index = _trace_data->row_index(last - 1) + 1;
+
+    return true;
+}
+
+void CallTreeModel::update()
+{
+    X_CALL;
+
+    {
+        QMutexLocker locker(_trace_data->mutex());
+
+        if(_trace_data->lower_row(_next_index) >= _trace_data->size())
+        {
+            return;
+        }
+    }
+
+    // times of known nodes are changed with layout, so sort model sorts them again
+
+    emit layoutAboutToBeChanged();
+
+    append_messages();
+
+    emit layoutChanged();
+
+    // new node is appended to children of it`s parent, so rows are inserted by one range for each parent.
+    // Parent is created before it`s children, so it is inserted before them
+
+    QVector<int> parents;
+
+    for(int id = _visible_rows.size(); id < _tree.size(); ++id)
+    {
+        parents.append(_tree.node(id).parent);
+    }
+
+    std::sort(parents.begin(), parents.end());
+
+    parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+
+    _visible_rows.resize(_tree.size());
+
+    foreach (int parent, parents)
+    {
+        bool is_root = (parent == -1);
+
+        int &visible = is_root ? _visible_roots : _visible_rows[parent];
+
+        int count = is_root ? _tree.roots().size() : _tree.node(parent).children.size();
+
+        beginInsertRows(is_root ? QModelIndex() : createIndex(_tree.node(parent).row, 0, quintptr(parent)), visible, count - 1);
+
+        visible = count;
+
+        endInsertRows();
+    }
+}
+
+QModelIndex CallTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if(!hasIndex(row, column, parent))
+    {
+        return QModelIndex();
+    }
+
+    if(!parent.isValid())
+    {
+        return createIndex(row, column, quintptr(_tree.roots().at(row)));
+    }
+
+    return createIndex(row, column, quintptr(_tree.node(int(parent.internalId())).children.at(row)));
+}
+
+QModelIndex CallTreeModel::parent(const QModelIndex &child) const
+{
+    if(!child.isValid())
+    {
+        return QModelIndex();
+    }
+
+    int parent_id = _tree.node(int(child.internalId())).parent;
+
+    if(parent_id == -1)
+    {
+        return QModelIndex();
+    }
+
+    return createIndex(_tree.node(parent_id).row, 0, quintptr(parent_id));
+}
+
+int CallTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if(!parent.isValid())
+    {
+        return _visible_roots;
+    }
+
+    if(parent.column() != 0)
+    {
+        return 0;
+    }
+
+    int id = int(parent.internalId());
+
+    return (id < _visible_rows.size()) ? _visible_rows.at(id) : 0;
+}
+
+int CallTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+
+    return _header_model.size();
+}
+
+QVariant CallTreeModel::data(const QModelIndex &index, int role_) const
+{
+    if(!index.isValid())
+    {
+        return QVariant();
+    }
+
+    int role = role_;
+
+    switch(role)
+    {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+    case Qt::BackgroundRole:
+    case Qt::DecorationRole:
+    case Qt::ForegroundRole:
+    case FilterDataRole:
+    case ::SortRole:
+        break;
+    default:
+        return QVariant();
+    }
+
+    if(role_ == ::SortRole)
+    {
+        role = Qt::DisplayRole;
+    }
+
+    const call_node_t &node = _tree.node(int(index.internalId()));
+
+    bool is_root = (node.parent == -1);
+
+    if(index.column() == Function)
+    {
+        if(is_root)
+        {
+            return _controller->thread_at(node.thread_index).item_data(role, EntityItem::FullText | EntityItem::WithDecorator);
+        }
+
+        return _controller->function_at(node.function_index).data(role);
+    }
+
+    if((role != Qt::DisplayRole) && (role != Qt::ToolTipRole))
+    {
+        return QVariant();
+    }
+
+    if(index.column() == Calls)
+    {
+        return is_root ? QVariant() : QVariant(quint64(node.call_counter));
+    }
+
+    if(index.column() == ThreadRate)
+    {
+        int root = int(index.internalId());
+
+        while(_tree.node(root).parent != -1)
+        {
+            root = _tree.node(root).parent;
+        }
+
+        uint64_t thread_time = _tree.node(root).inclusive_time;
+
+        double rate = thread_time ? node.inclusive_time / double(thread_time) : 0.0;
+
+        if(role_ == ::SortRole)
+        {
+            return rate;
+        }
+
+        return rate ? QString::number(rate * 100.0, 'f', 3) : "-";
+    }
+
+    uint64_t time_value = 0;
+
+    switch (index.column())
+    {
+    case TotalTime: time_value = node.inclusive_time; break;
+    case SelfTime:  time_value = node.exclusive_time; break;
+    case AvgTime:   time_value = node.call_counter ? node.inclusive_time / node.call_counter : 0; break;
+    }
+
+    if(role_ == Qt::DisplayRole)
+    {
+        return ::nanoseconds_to_string(time_value);
+    }
+    else if(role_ == ::SortRole)
+    {
+        return quint64(time_value);
+    }
+
+    return QString::number(time_value) + " ns";
+}
+
+QVariant CallTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role == Qt::TextAlignmentRole)
+    {
+        return Qt::AlignLeft;
+    }
+
+    if(orientation == Qt::Horizontal)
+    {
+        if(role == Qt::DisplayRole)
+        {
+            return _header_model.at(section).text;
+        }
+        else if(role == Qt::ToolTipRole)
+        {
+            return _header_model.at(section).tool_tip;
+        }
+    }
+
+    return QVariant();
+}
+
+QString CallTreeModel::column_size_hint(int column) const
+{
+    return _header_model.at(column).width;
+}
+
+void CallTreeModel::clear()
+{
+    X_CALL;
+
+    beginResetModel();
+
+    // tree is built again from rows of model on the next update
+
+    _tree.clear();
+
+    _next_index = 0;
+
+    _visible_rows.clear();
+    _visible_roots = 0;
+
+    endResetModel();
+}
+
+void CallTreeModel::set_collapse_recursion(bool collapse)
+{
+    X_CALL;
+
+    beginResetModel();
+
+    _tree = CallTree(collapse);
+
+    build();
+
+    endResetModel();
+}
+
+//////////////////////
+
+CallTreeView::CallTreeView(TraceController *controller, TraceDataModel *trace_data, QWidget *parent):
+    BaseTreeView(parent)
+{
+    X_CALL;
+
+    setWindowTitle(tr("Call tree"));
+
+    this->header()->setStretchLastSection(true);
+    this->header()->setSectionsMovable(true);
+
+    _model = new CallTreeModel(controller, trace_data, this);
+
+    QSortFilterProxyModel *sort_model = new QSortFilterProxyModel(this);
+
+    sort_model->setSortRole(::SortRole);
+    sort_model->setSourceModel(_model);
+
+    this->setSortingEnabled(true);
+    this->setSelectionBehavior(QAbstractItemView::SelectRows);
+    this->setUniformRowHeights(true);
+
+    this->setModel(sort_model);
+
+    //
+
+    QFontMetrics font_metrics(this->font());
+
+    for(int i = 0; i < _model->columnCount(); ++i)
+        this->setColumnWidth(i, font_metrics.horizontalAdvance(_model->column_size_hint(i)));
+
+    //
+
+    _menu_button = new QToolButton(this);
+
+    _menu_button->setIcon(QIcon(":/icons/dots_dark"));
+    _menu_button->setPopupMode(QToolButton::InstantPopup);
+
+    QMenu *tree_menu = new QMenu();
+
+    _menu_button->setMenu(tree_menu);
+
+    QAction *collapse_action = new QAction(tr("Collapse recursion"), tree_menu);
+
+    collapse_action->setCheckable(true);
+    collapse_action->setChecked(false);
+
+    connect(collapse_action, &QAction::toggled, _model, &CallTreeModel::set_collapse_recursion);
+
+    tree_menu->addAction(collapse_action);
+
+    //
+
+    this->sortByColumn(CallTreeModel::TotalTime, Qt::DescendingOrder);
+}
+
+CallTreeView::~CallTreeView()
+{
+    X_CALL;
+}
+
+CallTreeModel *CallTreeView::model()
+{
+    return _model;
+}
+
+void CallTreeView::resizeEvent(QResizeEvent *event)
+{
+    BaseTreeView::resizeEvent(event);
+
+    update_layout();
+}
+
+void CallTreeView::showEvent(QShowEvent *event)
+{
+    update_layout();
+
+    BaseTreeView::showEvent(event);
+}
+
+void CallTreeView::update_layout()
+{
+    QRect geometry(0, 0, _menu_button->sizeHint().width(), header()->height());
+
+    if(!verticalScrollBar()->isVisible())
+    {
+        geometry.moveTopRight(QPoint(this->width() - 2, 0));
+    }
+    else
+    {
+        geometry.moveTopRight(QPoint(this->width() - this->verticalScrollBar()->width() - 2, 0));
+    }
+
+    _menu_button->setGeometry(geometry);
+}
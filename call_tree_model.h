@@ -0,0 +1,195 @@
+#ifndef CALL_TREE_MODEL_H
+#define CALL_TREE_MODEL_H
+
+#include <QObject>
+#include <QAbstractItemModel>
+#include <QToolButton>
+#include <QVector>
+#include <QHash>
+
+#include "trace_x/impl/types.h"
+#include "trace_data_model.h"
+#include "tree_view.h"
+
+class TraceController;
+
+//! Node of calling-context tree.
+//! All calls with the same call path (process, thread, chain of functions) share one node
+struct call_node_t
+{
+    call_node_t():
+        function_index(0),
+        process_index(0),
+        thread_index(0),
+        parent(-1),
+        row(0),
+        call_counter(0),
+        inclusive_time(0),
+        exclusive_time(0)
+    {}
+
+    function_index_t function_index;
+    pid_index_t      process_index;
+    tid_index_t      thread_index;
+
+    int parent;
+    int row;
+
+    quint64 call_counter;
+
+    uint64_t inclusive_time;
+    uint64_t exclusive_time;
+
+    QVector<int> children;
+};
+
+//! Calling-context tree, built incrementally from CALL/RETURN stream.
+//! Root nodes represent threads, so each (process, thread) pair has it`s own tree
+class CallTree
+{
+public:
+    explicit CallTree(bool collapse_recursion = false);
+
+    void append(const trace_message_t *message);
+
+    void clear();
+
+    inline int size() const { return _nodes.size(); }
+    inline const call_node_t &node(int id) const { return _nodes.at(id); }
+    inline const QVector<int> &roots() const { return _roots; }
+
+    //! Chain of functions from thread root to node (root is not included)
+    QVector<function_index_t> path(int id) const;
+
+    inline bool collapse_recursion() const { return _collapse_recursion; }
+
+private:
+    struct frame_t
+    {
+        frame_t(): node(0), children_time(0), recursive(false) {}
+        frame_t(int node_, bool recursive_): node(node_), children_time(0), recursive(recursive_) {}
+
+        int node;
+        uint64_t children_time;
+        bool recursive;
+    };
+
+    struct thread_state_t
+    {
+        thread_state_t(): root(-1) {}
+
+        int root;
+        QVector<frame_t> stack;
+    };
+
+    thread_state_t &thread_state(const trace_message_t *message);
+
+    int child_node(int parent, function_index_t function);
+
+private:
+    bool _collapse_recursion;
+
+    QVector<call_node_t> _nodes;
+    QVector<int> _roots;
+
+    //! (parent node, function) -> node
+    QHash<QPair<int, qint64>, int> _child_hash;
+
+    //! (process, thread) -> call stack
+    QHash<QPair<qint64, qint64>, thread_state_t> _threads;
+};
+
+class CallTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum TraceColumns
+    {
+        Function = 0,
+        Calls,
+        TotalTime,
+        SelfTime,
+        AvgTime,
+        ThreadRate,
+
+        LastColumn
+    };
+
+    CallTreeModel(TraceController *controller, TraceDataModel *trace_data, QObject *parent = 0);
+    ~CallTreeModel();
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    QModelIndex parent(const QModelIndex &child) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+
+    QString column_size_hint(int column) const;
+
+    const CallTree &call_tree() const { return _tree; }
+
+    void clear();
+
+    void set_collapse_recursion(bool collapse);
+
+    //! Appends messages, which are added to data model after the last appended one
+    void update();
+
+private:
+    void build();
+
+    //! Appends messages after _next_index to tree. Returns false, if there are no new messages
+    bool append_messages();
+
+private:
+    struct ColumnData
+    {
+        ColumnData() {}
+        ColumnData(const QString &text_, const QString tool_tip_, const QString &width_):
+            text(text_), tool_tip(tool_tip_), width(width_) {}
+
+        QString text;
+        QString tool_tip;
+        QString width;
+    };
+
+    TraceController *_controller;
+    TraceDataModel *_trace_data;
+
+    QVector<ColumnData> _header_model;
+
+    CallTree _tree;
+
+    //! Index of message after the last appended one
+    index_t _next_index;
+
+    //! Rows, which are inserted to view: children of each node and roots. New nodes are inserted after tree is updated
+    QVector<int> _visible_rows;
+    int _visible_roots;
+};
+
+class CallTreeView : public BaseTreeView
+{
+public:
+    CallTreeView(TraceController *controller, TraceDataModel *trace_data, QWidget *parent = 0);
+    ~CallTreeView();
+
+    CallTreeModel *model();
+
+protected:
+    void resizeEvent(QResizeEvent *event);
+    void showEvent(QShowEvent *event);
+
+private:
+    void update_layout();
+
+private:
+    CallTreeModel *_model;
+    QToolButton *_menu_button;
+};
+
+#endif // CALL_TREE_MODEL_H
@@ -20,15 +20,9 @@ QVariant CallstackModel::data(const QModelIndex &index, int role) const
     if(!_trace_model)
         return QVariant();
 
+    if(_current_message && (at(index.row()) == _current_message) && (role == Qt::DecorationRole))
     {
-        QMutexLocker locker(_trace_model->mutex());
-
-        const trace_message_t *message = _trace_model->at(index.row());
-
-        if((message == _current_message) && (role == Qt::DecorationRole))
-        {
-            return QIcon(":/icons/callstack_current");
-        }
+        return QIcon(":/icons/callstack_current");
     }
 
     return TraceTableModel::data(index, role);
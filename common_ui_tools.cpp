@@ -259,6 +259,9 @@ ModelTreeView::ModelTreeView(QWidget *parent):
 
    // setItemsExpandable(false);
     setItemDelegate(new TreeItemDelegate(this));
+
+    connect(this, &QTreeView::expanded, this, [this](const QModelIndex &index) { save_expanded(index, true); });
+    connect(this, &QTreeView::collapsed, this, [this](const QModelIndex &index) { save_expanded(index, false); });
 }
 
 void ModelTreeView::setModel(QAbstractItemModel *model)
@@ -270,6 +273,11 @@ void ModelTreeView::setModel(QAbstractItemModel *model)
 
     connect(model, &QAbstractItemModel::layoutChanged, this, &ModelTreeView::update_layout);
 
+    // incremental models insert groups instead of layout change
+
+    connect(model, &QAbstractItemModel::modelReset, this, &ModelTreeView::update_layout, Qt::UniqueConnection);
+    connect(model, &QAbstractItemModel::rowsInserted, this, &ModelTreeView::expand_inserted, Qt::UniqueConnection);
+
     update_layout();
 }
 
@@ -296,7 +304,9 @@ void ModelTreeView::keyPressEvent(QKeyEvent *event)
 
 void ModelTreeView::walk_first_column(const QModelIndex &parent)
 {
-    if(this->model())
+    // spanning has no effect in model with one column, so children of large groups are not walked
+
+    if(this->model() && (model()->columnCount(parent) > 1))
     {
         int row_count = model()->rowCount(parent);
 
@@ -319,12 +329,56 @@ void ModelTreeView::update_layout()
     {
         header()->setSectionResizeMode(0, QHeaderView::Stretch);
 
-        expandAll();
+        restore_expanded(0, model()->rowCount());
 
         walk_first_column(QModelIndex());
     }
 }
 
+void ModelTreeView::expand_inserted(const QModelIndex &parent, int first, int last)
+{
+    if(parent.isValid())
+    {
+        return;
+    }
+
+    for(int i = first; i <= last; ++i)
+    {
+        setFirstColumnSpanned(i, QModelIndex(), !model()->span(model()->index(i, 0)).isNull());
+    }
+
+    restore_expanded(first, last + 1);
+}
+
+void ModelTreeView::restore_expanded(int first, int last)
+{
+    for(int i = first; i < last; ++i)
+    {
+        QModelIndex index = model()->index(i, 0);
+
+        QHash<QString, bool>::const_iterator it = _expanded_groups.constFind(index.data().toString());
+
+        bool is_expanded = (it != _expanded_groups.constEnd()) ? it.value() : !model()->canFetchMore(index);
+
+        if(is_expanded)
+        {
+            expandRecursively(index);
+        }
+        else
+        {
+            collapse(index);
+        }
+    }
+}
+
+void ModelTreeView::save_expanded(const QModelIndex &index, bool is_expanded)
+{
+    if(!index.parent().isValid())
+    {
+        _expanded_groups.insert(index.data().toString(), is_expanded);
+    }
+}
+
 //////////////////////
 
 MessageListModel::MessageListModel(TraceDataModel *data_model, QObject *parent):
@@ -8,6 +8,7 @@
 #include <QTableView>
 #include <QListView>
 #include <QLineEdit>
+#include <QHash>
 
 #include "base_item_views.h"
 #include "tree_view.h"
@@ -109,6 +110,16 @@ protected:
 private:
     void update_layout();
     void walk_first_column(const QModelIndex &parent);
+    void expand_inserted(const QModelIndex &parent, int first, int last);
+
+    //! Sets expansion of top level groups [first, last) as user has left it. Group without saved state is expanded,
+    //! if it`s children are populated, so lazy groups of incremental models are fetched only by user
+    void restore_expanded(int first, int last);
+    void save_expanded(const QModelIndex &index, bool is_expanded);
+
+private:
+    //! Expansion of top level groups by their text, it is kept, while groups are reset or inserted again
+    QHash<QString, bool> _expanded_groups;
 };
 
 class LineEdit : public QLineEdit
@@ -526,20 +526,22 @@ TraceCompleter::TraceCompleter(const QList<EntityClass> &class_list, TraceContro
     {
         switch (entity_class)
         {
-        case ProcessNameEntity:  _entry_set.append(Entry("pn", tr("process name"), _controller->process_names())); break;
-        case ProcessIdEntity:    _entry_set.append(Entry("p",  tr("process id"), _controller->process_models(), ProcessModel::PidRole)); break;
-        case ProcessUserEntity:  _entry_set.append(Entry("pu", tr("process user"), _controller->process_users())); break;
-        case ModuleNameEntity:   _entry_set.append(Entry("m",  tr("module name"), _controller->modules())); break;
-        case ThreadIdEntity:     _entry_set.append(Entry("th", tr("thread id"), _controller->threads(), Qt::DisplayRole, false)); break;
-        case ContextIdEntity:    _entry_set.append(Entry("o",  tr("object id"), _controller->contexts(), Qt::DisplayRole, false)); break;
-        case ClassNameEntity:    _entry_set.append(Entry("c",  tr("class"), _controller->classes())); break;
-        case FunctionNameEntity: _entry_set.append(Entry("f",  tr("function"), _controller->functions())); break;
-        case SourceNameEntity:   _entry_set.append(Entry("s",  tr("source"), _controller->sources(), Qt::ToolTipRole)); break;
-        case MessageTypeEntity:  _entry_set.append(Entry("t",  tr("message type"), _controller->full_message_types(), Qt::DisplayRole, false)); break;
-        case LabelNameEntity:    _entry_set.append(Entry("v",  tr("variable name"), _controller->variables())); break;
-        case MessageTextEntity:  _entry_set.append(Entry("me", tr("message"), 0, Qt::DisplayRole, false)); break;
+        case ProcessNameEntity:  _entry_set.append(Entry("pn", tr("process name"), _controller->entities_by_class(entity_class))); break;
+        case ProcessIdEntity:    _entry_set.append(Entry("p",  tr("process id"), _controller->entities_by_class(entity_class), ProcessModel::PidRole)); break;
+        case ProcessUserEntity:  _entry_set.append(Entry("pu", tr("process user"), _controller->entities_by_class(entity_class))); break;
+        case ModuleNameEntity:   _entry_set.append(Entry("m",  tr("module name"), _controller->entities_by_class(entity_class))); break;
+        case ThreadIdEntity:     _entry_set.append(Entry("th", tr("thread id"), _controller->entities_by_class(entity_class), Qt::DisplayRole, false)); break;
+        case ContextIdEntity:    _entry_set.append(Entry("o",  tr("object id"), _controller->entities_by_class(entity_class), Qt::DisplayRole, false)); break;
+        case ClassNameEntity:    _entry_set.append(Entry("c",  tr("class"), _controller->entities_by_class(entity_class))); break;
+        case FunctionNameEntity: _entry_set.append(Entry("f",  tr("function"), _controller->entities_by_class(entity_class))); break;
+        case SourceNameEntity:   _entry_set.append(Entry("s",  tr("source"), _controller->entities_by_class(entity_class), Qt::ToolTipRole)); break;
+        case MessageTypeEntity:  _entry_set.append(Entry("t",  tr("message type"), _controller->entities_by_class(entity_class, true), Qt::DisplayRole, false)); break;
+        case LabelNameEntity:    _entry_set.append(Entry("v",  tr("variable name"), _controller->entities_by_class(entity_class))); break;
+        case MessageTextEntity:  _entry_set.append(Entry("me", tr("message"), EntityList(), Qt::DisplayRole, false)); break;
         }
 
+        _entry_set.entries.last().index = _controller->name_index(entity_class);
+
         Entry entry = _entry_set.entries.last();
 
         _prefix_hash[entity_class] = entry.prefix;
@@ -780,7 +782,7 @@ void TraceCompleter::find_by_class(const QString &prefix, const QString &pattern
         _search_model.setSourceModel(&_message_search_model);
 
         _search_watcher.setFuture(QtConcurrent::run([this, pattern]() {
-            find_message(QRegExp(pattern, Qt::CaseInsensitive, QRegExp::Wildcard));
+            find_message(pattern);
         }));
     }
     else
@@ -810,7 +812,7 @@ void TraceCompleter::resize_columns()
     _completer_view->resizeColumnToContents(0);
 }
 
-void TraceCompleter::find_message(const QRegExp &regexp)
+void TraceCompleter::find_message(const QString &pattern)
 {
     X_CALL;
 
@@ -821,31 +823,15 @@ void TraceCompleter::find_message(const QRegExp &regexp)
 
     _search_break_flag = false;
 
-    //TODO: parallel
+    // distinct texts of messages are searched instead of messages of trace
 
-    QSet<QString> message_set;
+    const TextIndex &message_texts = _controller->message_texts();
 
-    for(size_t i = 0; i < _controller->trace_model().size(); ++i)
-    {
-        const trace_message_t *message = _controller->trace_model().at(i);
+    // texts are taken with search, because indexes are renumbered, when truncation of trace compacts the index
 
-        if(message->type > trace_x::MESSAGE_RETURN)
-        {
-            if(regexp.indexIn(message->message_text) != -1)
-            {
-                if(!message_set.contains(message->message_text))
-                {
-                    _message_search_model._data.append(QString(message->message_text).replace('\n', ' '));
-
-                    message_set.insert(message->message_text);
-                }
-            }
-        }
-
-        if(_search_break_flag)
-        {
-            break;
-        }
+    foreach (QString text, message_texts.find_texts(pattern, Entry::ResultLimit, &_search_break_flag))
+    {
+        _message_search_model._data.append(text.replace('\n', ' '));
     }
 
     if(_search_break_flag)
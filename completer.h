@@ -87,7 +87,7 @@ private:
     void switch_to_help();
     void resize_columns();
 
-    void find_message(const QRegExp &regexp);
+    void find_message(const QString &pattern);
     void find_message_finished();
 
 protected:
@@ -1,9 +1,116 @@
 #include "data_storage.h"
 
+#include <iterator>
+#include <cstring>
+#include <algorithm>
+
 #include <QtConcurrent/QtConcurrent>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#ifdef WITH_LZ4
+#include <lz4.h>
+#endif
 
 #include "trace_x/trace_x.h"
 
+namespace
+{
+//! Swapping is started, when memory limit is exceeded, and continued till this part of limit
+const double LowWaterRate = 0.75;
+
+//! Data is stored compressed only if it is compressed at least to this rate
+const double CompressionRate = 0.8;
+
+//! Size of sample from begin, middle and end of data for compressibility test
+const int CompressionSampleSize = 4 * 1024;
+
+inline quint64 rotl64(quint64 value, int shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+inline quint64 fmix64(quint64 value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+
+    return value;
+}
+
+//! MurmurHash3 x64 128-bit. Parts of data are hashed by chain, hash of previous part is seed of next one
+hash128_t hash_data(const char *data, size_t size, const hash128_t &seed = hash128_t())
+{
+    const quint64 c1 = 0x87c37b91114253d5ull;
+    const quint64 c2 = 0x4cf5ad432745937full;
+
+    quint64 h1 = seed.low;
+    quint64 h2 = seed.high;
+
+    const size_t block_count = size / 16;
+
+    for(size_t i = 0; i < block_count; ++i)
+    {
+        quint64 k1;
+        quint64 k2;
+
+        memcpy(&k1, data + i * 16, sizeof(k1));
+        memcpy(&k2, data + i * 16 + 8, sizeof(k2));
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uchar *tail = reinterpret_cast<const uchar*>(data + block_count * 16);
+    const int tail_size = int(size & 15);
+
+    quint64 k1 = 0;
+    quint64 k2 = 0;
+
+    for(int i = tail_size - 1; i >= 8; --i)
+    {
+        k2 ^= quint64(tail[i]) << ((i - 8) * 8);
+    }
+
+    for(int i = qMin(tail_size, 8) - 1; i >= 0; --i)
+    {
+        k1 ^= quint64(tail[i]) << (i * 8);
+    }
+
+    if(tail_size > 8)
+    {
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+
+    if(tail_size > 0)
+    {
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= quint64(size);
+    h2 ^= quint64(size);
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    return hash128_t(h1, h2);
+}
+}
+
 class DumpTask : public QRunnable
 {
 public:
@@ -20,38 +127,100 @@ public:
     DataStorage *storage;
 };
 
+DataPin::DataPin(DataStorage *storage, quint64 pin_id):
+    _storage(storage),
+    _pin_id(pin_id)
+{
+}
+
+DataPin::~DataPin()
+{
+    _storage->unpin_data(_pin_id);
+}
+
+/* ===================================================================================== */
+
 DataStorage::DataStorage(QObject *parent) : QObject(parent),
-    _total_size(0),
-    _memory_data_size(0),
+    _use_swap(true),
+    _use_compression(true),
     _memory_limit(512 * 1024 * 1024ull),
     _swap_limit(1024 * 1024 * 1024ull),
-    _use_swap(true)
+    _pin_counter(0),
+    _total_size(0),
+    _memory_data_size(0),
+    _swap_data_size(0),
+    _swap_scheduled(false),
+    _swap_memory(0),
+    _swap_capacity(0),
+    _swap_position(0),
+    _swap_close_pending(false),
+    _swap_remap_pending(false),
+    _data_file_memory(0),
+    _external_data(false),
+    _generation(0)
 {
     X_CALL;
 
     _swap_thread_pool.setMaxThreadCount(1);
 }
 
-void DataStorage::append_data(uint64_t index, const QByteArray &array)
+hash128_t DataStorage::content_hash(const QByteArray &array, qsizetype skip_offset, qsizetype skip_size)
+{
+    if(!skip_size)
+    {
+        return hash_data(array.constData(), size_t(array.size()));
+    }
+
+    qsizetype tail_offset = skip_offset + skip_size;
+
+    hash128_t hash = hash_data(array.constData(), size_t(skip_offset));
+
+    return hash_data(array.constData() + tail_offset, size_t(array.size() - tail_offset), hash);
+}
+
+void DataStorage::append_data(uint64_t index, const QByteArray &array, const hash128_t &hash, quint32 process_index)
 {
     X_CALL;
 
     QMutexLocker lock(&_mutex);
 
-    _memory_data_size += array.size();
-    _total_size += array.size();
+    QHash<hash128_t, quint64>::const_iterator hash_it = _content_hash.constFind(hash);
+
+    if(hash_it != _content_hash.constEnd())
+    {
+        // the same data is stored already. Sizes of data can differ by range, which isn`t hashed,
+        // but sizes of hashed parts are mixed in hash
+
+        _contents[*hash_it].refs++;
+
+        _data_alias.insert(index, *hash_it);
+
+        return;
+    }
+
+    _content_hash.insert(hash, index);
+    _contents.insert(index, content_t(hash, array.size()));
 
     _memory_map[index] = array;
 
     _memory_data_list.append(index);
 
+    _data_process.insert(index, process_index);
+
+    update_usage(index, array.size(), 0);
+
     if(_memory_data_size > _memory_limit)
     {
         if(_use_swap)
         {
-            //push task to single thread queue
+            if(!_swap_scheduled)
+            {
+                //push task to single thread queue, it works until memory usage falls to low-water mark
+
+                _swap_scheduled = true;
 
-            _swap_thread_pool.start(new DumpTask(this));
+                _swap_thread_pool.start(new DumpTask(this));
+            }
         }
         else
         {
@@ -60,42 +229,138 @@ void DataStorage::append_data(uint64_t index, const QByteArray &array)
             size_t size_to_free = 0.1 * double(_memory_limit);
             size_t free_counter = 0;
 
-            do
+            while((free_counter < size_to_free) && !_memory_data_list.isEmpty())
             {
-                quint64 index = _memory_data_list.takeFirst();
+                quint64 index = _memory_data_list.first();
 
-                free_counter += _memory_map[index].size();
+                free_counter += _memory_map.value(index).size();
 
-                _memory_map.remove(index);
+                remove_memory_data(index);
             }
-            while(free_counter < size_to_free);
-
-            _total_size -= free_counter;
-            _memory_data_size -= free_counter;
         }
     }
 }
 
+void DataStorage::update_usage(quint64 index, qint64 memory_delta, qint64 swap_delta)
+{
+    data_usage_t &usage = _process_usage[_data_process.value(index, UnknownProcess)];
+
+    usage.memory_size += memory_delta;
+    usage.swap_size += swap_delta;
+
+    _memory_data_size += memory_delta;
+    _swap_data_size += swap_delta;
+    _total_size += memory_delta + swap_delta;
+}
+
+void DataStorage::remove_memory_data(quint64 index)
+{
+    update_usage(index, -qint64(_memory_map.take(index).size()), 0);
+
+    _memory_data_list.removeOne(index);
+    _data_process.remove(index);
+    _compression_info.remove(index);
+
+    forget_hash(index);
+}
+
+void DataStorage::remove_swap_data(quint64 index)
+{
+    DataObject data = _swap_map.take(index);
+
+    update_usage(index, 0, -qint64(data.size));
+
+    if(!_external_data)
+    {
+        _swap_regions.remove(data.start);
+    }
+
+    _swap_data_list.removeOne(index);
+    _data_process.remove(index);
+    _compression_info.remove(index);
+
+    forget_hash(index);
+}
+
+void DataStorage::forget_content(quint64 index)
+{
+    // called, when message, which refers to content, is removed
+
+    QHash<quint64, content_t>::iterator it = _contents.find(index);
+
+    if((it == _contents.end()) || (--it->refs > 0))
+    {
+        return;
+    }
+
+    forget_hash(index);
+
+    _contents.erase(it);
+}
+
+void DataStorage::forget_hash(quint64 index)
+{
+    // data of content is removed from storage, so equal data is stored again. Content is kept till the last message,
+    // which refers to it, is removed, so aliases of other messages stay valid
+
+    QHash<quint64, content_t>::const_iterator it = _contents.constFind(index);
+
+    if(it == _contents.constEnd())
+    {
+        return;
+    }
+
+    QHash<hash128_t, quint64>::iterator hash_it = _content_hash.find(it->hash);
+
+    // hash can refer to newer content with the same data
+
+    if((hash_it != _content_hash.end()) && (*hash_it == index))
+    {
+        _content_hash.erase(hash_it);
+    }
+}
+
 void DataStorage::clear()
 {
     X_CALL;
 
     QMutexLocker lock(&_mutex);
 
-    if(_swap_file.autoRemove())
+    _generation++;
+
+    if(_external_data)
     {
-        _swap_file.resize(0);
-        _swap_file.seek(0);
+        QWriteLocker file_lock(&_file_lock);
+
+        _data_file.close();
+
+        _data_file_memory = 0;
+        _external_data = false;
     }
 
+    // swap file keeps it`s size and mapping, only write position is reset
+
+    _swap_position = 0;
+
     _total_size = 0;
     _memory_data_size = 0;
+    _swap_data_size = 0;
+
+    _data_process.clear();
+    _process_usage.clear();
+    _compression_info.clear();
+
+    _contents.clear();
+    _content_hash.clear();
+    _data_alias.clear();
 
     _memory_map.clear();
     _memory_data_list.clear();
 
     _swap_map.clear();
     _swap_data_list.clear();
+    _swap_regions.clear();
+    _swap_in_flight.clear();
 }
 
 void DataStorage::set_swap_state(bool enabled)
@@ -104,17 +369,15 @@ void DataStorage::set_swap_state(bool enabled)
 
     if(_use_swap == enabled) return;
 
+    QMutexLocker lock(&_mutex);
+
     _use_swap = enabled;
 
     X_VALUE(_use_swap);
 
     if(!enabled)
     {
-        _total_size -= _swap_file.size();
-
-        _swap_file.close();
-        _swap_map.clear();
-        _swap_data_list.clear();
+        close_swap();
     }
     else if(!_swap_file.isOpen())
     {
@@ -122,17 +385,30 @@ void DataStorage::set_swap_state(bool enabled)
     }
 }
 
+void DataStorage::set_compression_state(bool enabled)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _use_compression = enabled;
+
+    X_VALUE(_use_compression);
+}
+
 void DataStorage::set_swap_dir(const QString &path)
 {
     X_CALL;
 
     if(_swap_dir == path) return;
 
+    QMutexLocker lock(&_mutex);
+
     _swap_dir = path;
 
     X_VALUE(_swap_dir);
 
-    _swap_file.close();
+    close_swap();
 
     _swap_file.setFileTemplate(_swap_dir + "/trace_x");
 
@@ -143,19 +419,83 @@ void DataStorage::set_swap_file(const QString &filename, qint64 offset)
 {
     X_CALL;
 
-    _swap_file.setFileName(filename);
+    QMutexLocker lock(&_mutex);
+    QWriteLocker file_lock(&_file_lock);
+
+    _data_file.close();
+    _data_file.setFileName(filename);
 
-    if(_swap_file.open())
+    if(_data_file.open(QFile::ReadOnly))
     {
-        _swap_file.setAutoRemove(false);
+        X_VALUE("_data_file", filename);
 
-        X_VALUE("_swap_file", filename);
+        QDataStream file_stream(&_data_file);
 
-        QDataStream file_stream(&_swap_file);
-
-        _swap_file.seek(offset);
+        _data_file.seek(offset);
 
         file_stream >> _swap_data_list >> _swap_map;
+
+        // indices with the same data refer to one block of file
+
+        QHash<quint64, quint64> content_by_start;
+        QSet<quint64> alias_set;
+
+        for(QMap<quint64, DataObject>::iterator it = _swap_map.begin(); it != _swap_map.end();)
+        {
+            QHash<quint64, quint64>::const_iterator content_it = content_by_start.constFind(it->start);
+
+            if((it->size > 0) && (content_it != content_by_start.constEnd()) && (_swap_map.value(*content_it).size == it->size))
+            {
+                _contents[*content_it].refs++;
+
+                _data_alias.insert(it.key(), *content_it);
+
+                alias_set.insert(it.key());
+
+                it = _swap_map.erase(it);
+
+                continue;
+            }
+
+            // hash of loaded data is unknown, so only references are counted
+
+            content_by_start.insert(it->start, it.key());
+
+            _contents.insert(it.key(), content_t(hash128_t(), it->size));
+
+            ++it;
+        }
+
+        if(!alias_set.isEmpty())
+        {
+            QList<quint64> data_list;
+
+            foreach (quint64 index, _swap_data_list)
+            {
+                if(!alias_set.contains(index))
+                {
+                    data_list.append(index);
+                }
+            }
+
+            _swap_data_list = data_list;
+        }
+
+        for(QMap<quint64, DataObject>::const_iterator it = _swap_map.begin(); it != _swap_map.end(); ++it)
+        {
+            _data_process.insert(it.key(), UnknownProcess);
+
+            update_usage(it.key(), 0, it->size);
+        }
+
+        _data_file_memory = _data_file.map(0, _data_file.size());
+
+        if(!_data_file_memory)
+        {
+            X_INFO("can`t map {}, data will be read by seek", filename);
+        }
+
+        _external_data = true;
     }
     else
     {
@@ -182,17 +522,38 @@ void DataStorage::set_swap_limit(size_t size)
 
     QMutexLocker lock(&_mutex);
 
+    _swap_limit = size;
+
     X_VALUE(_swap_limit);
 
-    _swap_limit = size;
+    if(!_swap_file.isOpen() || _swap_close_pending)
+    {
+        // file is mapped with new size, when it is opened
+
+        return;
+    }
 
-    if(_swap_file.size() > _swap_limit)
+    if(_swap_capacity > _swap_limit)
     {
-        //truncate swap file
+        // only data beyond the new limit is lost
+
+        free_swap(_swap_limit, _swap_capacity - _swap_limit);
 
-        _swap_map.clear();
+        QWriteLocker file_lock(&_file_lock);
 
-        _swap_file.resize(_swap_limit);
+        _swap_capacity = _swap_limit;
+        _swap_position = qMin<quint64>(_swap_position, _swap_capacity);
+    }
+
+    if(_pins.isEmpty())
+    {
+        // file is resized and mapped again, swapped data keeps it`s place in file
+
+        map_swap();
+    }
+    else
+    {
+        _swap_remap_pending = true;
     }
 }
 
@@ -202,29 +563,41 @@ void DataStorage::remove_from_tail(uint64_t index)
 
     QMutexLocker lock(&_mutex);
 
-    if(!_memory_data_list.empty() && _memory_data_list.first() == index)
-    {
-        quint64 data_size = _memory_map[index].size();
+    quint64 content_index = index;
 
-        _total_size -= data_size;
-        _memory_data_size -= data_size;
+    QHash<quint64, quint64>::iterator alias_it = _data_alias.find(index);
 
-        _memory_map.remove(index);
-        _memory_data_list.removeOne(index);
+    if(alias_it != _data_alias.end())
+    {
+        content_index = *alias_it;
+
+        _data_alias.erase(alias_it);
     }
 
-    if(!_swap_data_list.empty() && _swap_data_list.first() == index)
+    QHash<quint64, content_t>::iterator content_it = _contents.find(content_index);
+
+    if((content_it != _contents.end()) && (content_it->refs > 1))
     {
-        quint64 data_size = _memory_map[index].size();
+        // content is still referred by other messages
+
+        content_it->refs--;
 
-        _total_size -= data_size;
+        return;
+    }
 
-        _swap_map.remove(index);
-        _swap_data_list.removeOne(index);
+    if(_memory_map.contains(content_index))
+    {
+        remove_memory_data(content_index);
+    }
+    else if(_swap_map.contains(content_index))
+    {
+        remove_swap_data(content_index);
     }
+
+    forget_content(content_index);
 }
 
-QByteArray DataStorage::get_data(uint64_t index, bool detach)
+QByteArray DataStorage::get_data(uint64_t index)
 {
     X_CALL;
 
@@ -232,176 +605,548 @@ QByteArray DataStorage::get_data(uint64_t index, bool detach)
 
     if(_swap_map.contains(index))
     {
-        DataObject &data = _swap_map[index];
+        const DataObject &data = _swap_map[index];
 
-        data_array.resize(data.size);
+        data_array.resize(int(data.size));
 
         X_INFO("read swap #{} : {} - {}", index, data.start, data.end);
 
-        read_swap(data_array.data(), data.start, data.size);
+        read_swap(data_array.data(), data.start, data.size, _external_data);
     }
     else if(_memory_map.contains(index))
     {
         data_array = _memory_map[index];
     }
 
-    if(detach)
+    if(quint64 original_size = _compression_info.value(index))
     {
-        //detach because we won`t change original data buffer
-
-        data_array.detach();
+        return uncompress_data(data_array, original_size);
     }
 
     return data_array;
-    //return qUncompress(data_array);
 }
 
-void DataStorage::free_swap(quint64 start, quint64 size)
+QByteArray DataStorage::compress_data(const QByteArray &data)
 {
-    X_CALL;
+    if(data.size() < CompressionMinSize)
+    {
+        return QByteArray();
+    }
 
-    if(!_swap_data_list.empty())
+    // test samples first, so incompressible data is not compressed entirely
+
+    if(data.size() > 4 * CompressionSampleSize)
     {
-        if(start + size > _swap_limit)
-        {
-            quint64 chunk = _swap_limit - start;
+        QByteArray sample = data.left(CompressionSampleSize) +
+                            data.mid(data.size() / 2, CompressionSampleSize) +
+                            data.right(CompressionSampleSize);
 
-            free_swap(start, chunk);
-            free_swap(0, size - chunk);
-        }
-        else
+        if(compress_data(sample).isEmpty())
         {
-            do
-            {
-                quint64 index = _swap_data_list.first();
+            return QByteArray();
+        }
+    }
 
-                const DataObject &obj = _swap_map[index];
+#ifdef WITH_LZ4
+    QByteArray result(LZ4_compressBound(data.size()), Qt::Uninitialized);
 
-                if(is_intersects(obj.start, obj.end, start, start + size - 1))
-                {
-                    _total_size -= obj.size;
+    int size = LZ4_compress_default(data.constData(), result.data(), data.size(), result.size());
 
-                    _swap_data_list.removeFirst();
-                    _swap_map.remove(index);
+    result.resize(size);
+#else
+    QByteArray result = qCompress(data, 1);
+#endif
 
-                    X_INFO("remove {} from swap [{}, {}]", index, obj.start, obj.end);
-                }
-                else
-                {
-                    break;
-                }
-            }
-            while(!_swap_data_list.isEmpty());
-        }
+    if(result.isEmpty() || (result.size() > CompressionRate * data.size()))
+    {
+        return QByteArray();
     }
+
+    return result;
 }
 
-void DataStorage::write_swap(quint64 start, const char *data, quint64 size)
+QByteArray DataStorage::uncompress_data(const QByteArray &data, quint64 original_size)
 {
-    X_CALL;
+#ifdef WITH_LZ4
+    QByteArray result(int(original_size), Qt::Uninitialized);
 
-    if(start + size > _swap_limit)
+    if(LZ4_decompress_safe(data.constData(), result.data(), data.size(), result.size()) != int(original_size))
     {
-        quint64 chunk = _swap_limit - start;
+        X_ERROR_F("can`t uncompress data: {} bytes", data.size());
 
-        write_swap(start, data, chunk);
-        write_swap(0, data + chunk, size - chunk);
+        return QByteArray();
     }
-    else
-    {
-        X_INFO("write swap to {} : {} bytes", start, size);
 
-        _swap_file.seek(start);
+    return result;
+#else
+    Q_UNUSED(original_size)
 
-        _swap_file.write(data, size);
-    }
+    return qUncompress(data);
+#endif
 }
 
-void DataStorage::read_swap(char *dest, quint64 start, quint64 size)
+bool DataStorage::find_swap_place(quint64 size, quint64 &start) const
 {
-    X_CALL;
-
-    if(start + size > quint64(_swap_file.size()))
+    if(size > _swap_capacity)
     {
-        quint64 chunk = _swap_file.size() - start;
-
-        read_swap(dest, start, chunk);
-        read_swap(dest + chunk, 0, size - chunk);
+        return false;
     }
-    else
-    {
-        qint64 orig_pos = _swap_file.pos();
 
-        X_INFO("read {} bytes from {} ", size, start);
+    quint64 position = _swap_position;
 
-        _swap_file.seek(start);
+    // every pinned region moves position once, plus one wrap of the ring
 
-        // TODO read by chunks for break_flag support
-        _swap_file.read(dest, size);
+    for(int attempt = 0; attempt < 2 * (_pins.size() + 1); ++attempt)
+    {
+        if(position + size > _swap_capacity)
+        {
+            // data is never splitted, so it can be mapped as continuous block
 
-        _swap_file.seek(orig_pos);
-    }
-}
+            position = 0;
+        }
 
-void DataStorage::swap_memory()
-{
-    X_CALL;
+        bool is_pinned = false;
 
-    _total_size -= _memory_data_size;
+        for(QHash<quint64, DataObject>::const_iterator it = _pins.begin(); it != _pins.end(); ++it)
+        {
+            if((it->start < position + size) && (position < it->start + it->size))
+            {
+                position = it->start + it->size;
 
-    _memory_data_size = 0;
+                is_pinned = true;
 
-    QMutexLocker lock(&_mutex);
+                break;
+            }
+        }
 
-    quint64 data_size = 0;
+        if(!is_pinned)
+        {
+            start = position;
 
-    foreach (quint64 index, _memory_data_list)
-    {
-        data_size += _memory_map[index].size();
+            return true;
+        }
     }
 
-    // forget about old data in tale of swap - it`s gone ¯\_(ツ)_/¯
+    return false;
+}
+
+void DataStorage::free_swap(quint64 start, quint64 size)
+{
+    X_CALL;
 
-    free_swap(_swap_file.pos(), data_size);
+    QMap<quint64, region_t>::iterator it = _swap_regions.lowerBound(start);
 
-    if(data_size > _swap_limit)
+    if(it != _swap_regions.begin())
     {
-        // we can`t swap all data in memory - remove data from tail
+        QMap<quint64, region_t>::iterator prev = std::prev(it);
 
-        do
+        if(prev.key() + prev->size > start)
         {
-            quint64 index = _memory_data_list.takeFirst();
-            quint64 size =  _memory_map[index].size();
-
-            data_size -= size;
-
-            X_IMPORTANT("drop #{} : ", index, size);
+            it = prev;
         }
-        while(data_size > _swap_limit);
     }
 
-    foreach (quint64 index, _memory_data_list)
+    QSet<quint64> removed_set;
+
+    while((it != _swap_regions.end()) && (it.key() < start + size))
     {
-        const QByteArray &data = _memory_map[index];
+        quint64 index = it->index;
 
-        X_INFO("write swap #{}", index);
+        if(!_swap_in_flight.remove(index))
+        {
+            // forget about old data in swap - it`s gone ¯\_(ツ)_/¯
 
-        DataObject &swap_info = _swap_map[index];
+            update_usage(index, 0, -qint64(it->size));
 
-        swap_info.start = _swap_file.pos();
-        swap_info.size = data.size();
+            _swap_map.remove(index);
+            removed_set.insert(index);
+            _data_process.remove(index);
+            _compression_info.remove(index);
 
-        write_swap(_swap_file.pos(), data.data(), data.size());
+            forget_hash(index);
 
-        swap_info.end = _swap_file.pos() - 1;
+            X_INFO("remove {} from swap [{}, {}]", index, it.key(), it.key() + it->size - 1);
+        }
 
-        _swap_data_list.append(index);
+        it = _swap_regions.erase(it);
+    }
 
-        _total_size += data.size();
+    // ring reuse frees the oldest data from the head of list, large range is removed by one pass
+
+    if(removed_set.size() == 1)
+    {
+        _swap_data_list.removeOne(*removed_set.constBegin());
     }
+    else if(!removed_set.isEmpty())
+    {
+        _swap_data_list.erase(std::remove_if(_swap_data_list.begin(), _swap_data_list.end(),
+                                             [&removed_set](quint64 index) { return removed_set.contains(index); }),
+                              _swap_data_list.end());
+    }
+}
 
-    _memory_data_list.clear();
-    _memory_map.clear();
+bool DataStorage::write_swap(quint64 start, const char *data, quint64 size)
+{
+    X_CALL;
+
+    X_INFO("write swap to {} : {} bytes", start, size);
+
+    QReadLocker file_lock(&_file_lock);
+
+    if(start + size > _swap_capacity)
+    {
+        // swap was remapped after space reservation
+
+        X_WARNING("swap region [{}, {}] is out of swap capacity {}", start, start + size - 1, _swap_capacity);
+
+        return false;
+    }
+
+    if(_swap_memory)
+    {
+        memcpy(_swap_memory + start, data, size);
+
+        return true;
+    }
+
+    QMutexLocker lock(&_file_mutex);
+
+    _swap_file.seek(start);
+
+    if(_swap_file.write(data, size) != qint64(size))
+    {
+        X_ERROR("can`t write {} bytes to swap at {} : {}", size, start, _swap_file.errorString());
+
+        return false;
+    }
+
+    return true;
+}
+
+void DataStorage::read_swap(char *dest, quint64 start, quint64 size, bool external)
+{
+    X_CALL;
+
+    X_INFO("read {} bytes from {} ", size, start);
+
+    QReadLocker file_lock(&_file_lock);
+
+    if(const char *source = mapped_data(start, external))
+    {
+        memcpy(dest, source, size);
+    }
+    else
+    {
+        QMutexLocker lock(&_file_mutex);
+
+        QFile &file = external ? static_cast<QFile&>(_data_file) : _swap_file;
+
+        file.seek(start);
+
+        // TODO read by chunks for break_flag support
+        file.read(dest, size);
+    }
+}
+
+const char *DataStorage::mapped_data(quint64 start, bool external) const
+{
+    const uchar *memory = external ? _data_file_memory : _swap_memory;
+
+    return memory ? reinterpret_cast<const char*>(memory + start) : 0;
+}
+
+quint64 DataStorage::pin_data(const DataObject &data)
+{
+    quint64 pin_id = ++_pin_counter;
+
+    _pins.insert(pin_id, data);
+
+    return pin_id;
+}
+
+void DataStorage::unpin_data(quint64 pin_id)
+{
+    QMutexLocker lock(&_mutex);
+
+    _pins.remove(pin_id);
+
+    if(_pins.isEmpty())
+    {
+        release_swap();
+    }
+}
+
+void DataStorage::swap_memory()
+{
+    X_CALL;
+
+    // batches are pipelined: written batch is published and next batch is reserved under one lock,
+    // data is copied to swap without lock, so readers and append_data are not blocked
+
+    swap_batch_t written_batch;
+
+    forever
+    {
+        swap_batch_t compression_batch;
+
+        {
+            QMutexLocker lock(&_mutex);
+
+            publish_swap(written_batch);
+
+            written_batch = swap_batch_t();
+
+            take_compression_batch(compression_batch);
+        }
+
+        // oldest data is compressed before swapping, it can be enough to fit in memory limit
+
+        for(int i = 0; i < compression_batch.tasks.size(); ++i)
+        {
+            swap_task_t &task = compression_batch.tasks[i];
+
+            QByteArray compressed = compress_data(task.data);
+
+            if(!compressed.isEmpty())
+            {
+                task.original_size = task.data.size();
+                task.data = compressed;
+            }
+        }
+
+        swap_batch_t batch;
+
+        {
+            QMutexLocker lock(&_mutex);
+
+            apply_compression(compression_batch);
+
+            if(!reserve_swap(batch))
+            {
+                _swap_scheduled = false;
+
+                return;
+            }
+        }
+
+        bool is_written = batch.tasks.isEmpty();
+
+        for(int i = 0; i < batch.tasks.size(); ++i)
+        {
+            swap_task_t &task = batch.tasks[i];
+
+            X_INFO("write swap #{}", task.index);
+
+            task.is_written = write_swap(task.start, task.data.constData(), task.data.size());
+
+            is_written = is_written || task.is_written;
+        }
+
+        written_batch = batch;
+
+        if(!is_written)
+        {
+            // data is kept in memory, swapping is retried with the next appended data
+
+            QMutexLocker lock(&_mutex);
+
+            publish_swap(written_batch);
+
+            _swap_scheduled = false;
+
+            return;
+        }
+    }
+}
+
+void DataStorage::take_compression_batch(swap_batch_t &batch)
+{
+    X_CALL;
+
+    if(!_use_compression || (_memory_data_size <= size_t(LowWaterRate * _memory_limit)))
+    {
+        return;
+    }
+
+    batch.generation = _generation;
+
+    size_t batch_size = 0;
+
+    for(QList<quint64>::const_iterator it = _memory_data_list.constBegin(); (it != _memory_data_list.constEnd()) && (batch_size < SwapBatchSize); ++it)
+    {
+        if(!_compression_info.contains(*it))
+        {
+            swap_task_t task;
+
+            task.index = *it;
+            task.data = _memory_map.value(task.index);
+
+            batch_size += task.data.size();
+
+            batch.tasks.append(task);
+        }
+    }
+}
+
+void DataStorage::apply_compression(const swap_batch_t &batch)
+{
+    X_CALL;
+
+    if(batch.generation != _generation)
+    {
+        return;
+    }
+
+    foreach (const swap_task_t &task, batch.tasks)
+    {
+        QMap<quint64, QByteArray>::iterator it = _memory_map.find(task.index);
+
+        if(it == _memory_map.end())
+        {
+            // removed while compressing
+
+            continue;
+        }
+
+        if(task.original_size)
+        {
+            update_usage(task.index, qint64(task.data.size()) - it->size(), 0);
+
+            *it = task.data;
+        }
+
+        _compression_info.insert(task.index, task.original_size);
+    }
+}
+
+bool DataStorage::reserve_swap(swap_batch_t &batch)
+{
+    X_CALL;
+
+    if(!_swap_file.isOpen() || _external_data || _swap_close_pending)
+    {
+        return false;
+    }
+
+    size_t low_water_mark = size_t(LowWaterRate * _memory_limit);
+
+    if(_memory_data_size <= low_water_mark)
+    {
+        return false;
+    }
+
+    size_t memory_size = _memory_data_size;
+    size_t batch_size = 0;
+
+    batch.generation = _generation;
+
+    // oldest data is swapped first
+
+    QList<quint64>::const_iterator it = _memory_data_list.constBegin();
+
+    QList<quint64> dropped_list;
+
+    while((it != _memory_data_list.constEnd()) && (memory_size > low_water_mark) && (batch_size < SwapBatchSize))
+    {
+        if(_use_compression && !_compression_info.contains(*it))
+        {
+            // data is not compressed yet, it will be swapped on next step
+
+            break;
+        }
+
+        swap_task_t task;
+
+        task.index = *it++;
+        task.data = _memory_map.value(task.index);
+
+        memory_size -= task.data.size();
+
+        if(!find_swap_place(task.data.size(), task.start))
+        {
+            // we can`t swap this data - remove it
+
+            X_IMPORTANT("drop #{} : {}", task.index, task.data.size());
+
+            dropped_list.append(task.index);
+
+            continue;
+        }
+
+        free_swap(task.start, task.data.size());
+
+        _swap_regions.insert(task.start, region_t(task.index, task.data.size()));
+        _swap_in_flight.insert(task.index);
+
+        _swap_position = task.start + task.data.size();
+
+        batch_size += task.data.size();
+
+        batch.tasks.append(task);
+    }
+
+    foreach (quint64 index, dropped_list)
+    {
+        remove_memory_data(index);
+    }
+
+    return !batch.tasks.isEmpty() || !dropped_list.isEmpty();
+}
+
+void DataStorage::publish_swap(const swap_batch_t &batch)
+{
+    X_CALL;
+
+    if(batch.generation != _generation)
+    {
+        // storage was cleared or swap was remapped while writing
+
+        return;
+    }
+
+    foreach (const swap_task_t &task, batch.tasks)
+    {
+        quint64 data_size = task.data.size();
+
+        if(!_swap_in_flight.remove(task.index))
+        {
+            // region was freed by newer data in this pass or by shrinking of swap, data isn`t persisted,
+            // so it stays in memory at the head of list and is swapped again by the next reservation
+
+            continue;
+        }
+
+        if(!task.is_written)
+        {
+            // data stays in memory and is swapped again by the next reservation
+
+            _swap_regions.remove(task.start);
+
+            continue;
+        }
+
+        if(!_memory_map.contains(task.index))
+        {
+            // removed from tail while writing
+
+            _swap_regions.remove(task.start);
+
+            continue;
+        }
+
+        DataObject &swap_info = _swap_map[task.index];
+
+        swap_info.start = task.start;
+        swap_info.size = data_size;
+        swap_info.end = task.start + data_size - 1;
+
+        _swap_data_list.append(task.index);
+
+        _memory_map.remove(task.index);
+        _memory_data_list.removeOne(task.index);
+
+        update_usage(task.index, -qint64(data_size), data_size);
+    }
 }
 
 void DataStorage::copy_data_to(QFile *dest)
@@ -414,7 +1159,17 @@ void DataStorage::copy_data_to(QFile *dest)
 
     QMap<quint64, DataObject> swap_map;
 
-    QList<quint64> data_list = _swap_data_list + _memory_data_list;
+    QList<quint64> content_list = _swap_data_list + _memory_data_list;
+
+    QList<quint64> data_list = content_list;
+
+    for(QHash<quint64, quint64>::const_iterator it = _data_alias.constBegin(); it != _data_alias.constEnd(); ++it)
+    {
+        if(_swap_map.contains(*it) || _memory_map.contains(*it))
+        {
+            data_list.append(it.key());
+        }
+    }
 
     stream << data_list;
 
@@ -427,9 +1182,11 @@ void DataStorage::copy_data_to(QFile *dest)
 
     stream << swap_map;
 
-    foreach (quint64 index, data_list)
+    // every content is written once, duplicates refer to the same block of file
+
+    foreach (quint64 index, content_list)
     {
-        QByteArray array = get_data(index, false);
+        QByteArray array = get_data(index);
 
         DataObject &swap_info = swap_map[index];
 
@@ -441,6 +1198,14 @@ void DataStorage::copy_data_to(QFile *dest)
         swap_info.end = dest->pos() - 1;
     }
 
+    for(QHash<quint64, quint64>::const_iterator it = _data_alias.constBegin(); it != _data_alias.constEnd(); ++it)
+    {
+        if(swap_map.contains(it.key()))
+        {
+            swap_map[it.key()] = swap_map.value(*it);
+        }
+    }
+
     dest->seek(start_pos);
 
     stream << swap_map;
@@ -450,9 +1215,18 @@ void DataStorage::open_swap()
 {
     X_CALL;
 
+    if(_swap_close_pending)
+    {
+        // swap is opened again, when the last pin is released
+
+        return;
+    }
+
     if(_swap_file.open())
     {
         X_VALUE("_swap_file", _swap_file.fileName());
+
+        map_swap();
     }
     else
     {
@@ -460,25 +1234,155 @@ void DataStorage::open_swap()
     }
 }
 
-QByteArray DataStorage::request_data(uint64_t index /*boost::atomic<bool> *break_flag*/)
+void DataStorage::close_swap()
 {
     X_CALL;
 
-    QMutexLocker lock(&_mutex);
+    if(!_external_data)
+    {
+        _generation++;
+
+        free_swap(0, _swap_capacity);
+    }
+
+    _swap_position = 0;
 
-    return get_data(index, true);
+    if(!_pins.isEmpty())
+    {
+        // images on screen refer to mapped data, so file is unmapped after them
+
+        _swap_close_pending = true;
+
+        return;
+    }
+
+    QWriteLocker file_lock(&_file_lock);
+
+    // file is unmapped on close
+
+    _swap_file.close();
+
+    _swap_memory = 0;
+    _swap_capacity = 0;
 }
 
-bool DataStorage::is_intersects(quint64 left_1, quint64 right_1, quint64 left_2, quint64 right_2) const
+void DataStorage::release_swap()
 {
-    if(left_1 > right_1)
+    X_CALL;
+
+    if(_swap_close_pending)
+    {
+        _swap_close_pending = false;
+
+        close_swap();
+
+        // swap was closed by change of swap directory or it was enabled again
+
+        if(_use_swap)
+        {
+            open_swap();
+        }
+    }
+    else if(_swap_remap_pending)
     {
-        return is_intersects(left_1, _swap_limit, left_2, right_2) || is_intersects(0, right_1, left_2, right_2);
+        map_swap();
     }
-    else
+
+    _swap_remap_pending = false;
+}
+
+void DataStorage::map_swap()
+{
+    X_CALL;
+
+    QWriteLocker file_lock(&_file_lock);
+
+    if(_swap_memory)
+    {
+        _swap_file.unmap(_swap_memory);
+
+        _swap_memory = 0;
+    }
+
+    // ring file is allocated once, data is written by position
+
+    if(_swap_file.resize(_swap_limit))
+    {
+        _swap_memory = _swap_file.map(0, _swap_limit);
+    }
+
+    if(!_swap_memory)
     {
-        return !((left_1 > right_2) || (left_2 > right_1));
+        X_ERROR("can`t map swap file {}, data will be read by seek", _swap_file.fileName());
     }
+
+    _swap_capacity = _swap_limit;
+}
+
+QByteArray DataStorage::request_data(uint64_t index, DataPinPtr *pin /*boost::atomic<bool> *break_flag*/)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    index = _data_alias.value(index, index);
+
+    quint64 original_size = _compression_info.value(index);
+
+    if(!_swap_map.contains(index))
+    {
+        QByteArray data_array = _memory_map.value(index);
+
+        lock.unlock();
+
+        if(original_size)
+        {
+            // compressed data is uncompressed on demand
+
+            return uncompress_data(data_array, original_size);
+        }
+
+        if(!pin)
+        {
+            //detach because we won`t change original data buffer
+
+            data_array.detach();
+        }
+
+        return data_array;
+    }
+
+    // swapped data is pinned, so it can be read without lock
+
+    DataObject data = _swap_map.value(index);
+
+    bool external = _external_data;
+
+    quint64 pin_id = pin_data(data);
+
+    lock.unlock();
+
+    X_INFO("read swap #{} : {} - {}", index, data.start, data.end);
+
+    if(pin && !external && !original_size && (data.size >= ZeroCopyThreshold))
+    {
+        QReadLocker file_lock(&_file_lock);
+
+        if(const char *source = mapped_data(data.start, false))
+        {
+            *pin = DataPinPtr(new DataPin(this, pin_id));
+
+            return QByteArray::fromRawData(source, int(data.size));
+        }
+    }
+
+    QByteArray data_array(int(data.size), Qt::Uninitialized);
+
+    read_swap(data_array.data(), data.start, data.size, external);
+
+    unpin_data(pin_id);
+
+    return original_size ? uncompress_data(data_array, original_size) : data_array;
 }
 
 size_t DataStorage::memory_limit() const
@@ -493,7 +1397,14 @@ size_t DataStorage::total_data_size() const
 
 size_t DataStorage::swap_size() const
 {
-    return _swap_file.size();
+    return _swap_data_size;
+}
+
+QHash<quint32, data_usage_t> DataStorage::process_usage()
+{
+    QMutexLocker lock(&_mutex);
+
+    return _process_usage;
 }
 
 QDataStream &operator <<(QDataStream &out, const DataObject &value)
@@ -3,9 +3,14 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QFile>
 #include <QTemporaryFile>
 #include <QThreadPool>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QSharedPointer>
 
 #include <boost/function.hpp>
 #include <boost/atomic.hpp>
@@ -24,22 +29,90 @@ public:
     quint64 size;
 };
 
-//! Class for data storaging. Supports asynchronous swapping and rotation
+class DataStorage;
+
+//! Pin of data block in swap file.
+//! While pin exists, swap region of the block is not overwritten, so zero-copy view of the block stays valid
+class DataPin
+{
+public:
+    ~DataPin();
+
+private:
+    friend class DataStorage;
+
+    DataPin(DataStorage *storage, quint64 pin_id);
+
+    DataStorage *_storage;
+    quint64 _pin_id;
+};
+
+typedef QSharedPointer<DataPin> DataPinPtr;
+
+//! 128-bit hash of data content
+struct hash128_t
+{
+    hash128_t(): low(0), high(0) {}
+    hash128_t(quint64 low_, quint64 high_): low(low_), high(high_) {}
+
+    quint64 low;
+    quint64 high;
+};
+
+inline bool operator==(const hash128_t &h1, const hash128_t &h2)
+{
+    return (h1.low == h2.low) && (h1.high == h2.high);
+}
+
+inline size_t qHash(const hash128_t &h, size_t seed = 0) noexcept
+{
+    return size_t(h.low ^ h.high) ^ seed;
+}
+
+//! Data size of one process in memory and in swap
+struct data_usage_t
+{
+    data_usage_t(): memory_size(0), swap_size(0) {}
+
+    size_t memory_size;
+    size_t swap_size;
+};
+
+//! Class for data storaging. Supports asynchronous swapping and rotation.
+//! Swap file is a memory-mapped ring buffer, so data can be read concurrently with swapping.
+//! Equal data blocks are stored once: message index refers to content, which is identified by the first index with this data
 class DataStorage : public QObject
 {
     Q_OBJECT
 
 public:
+    enum
+    {
+        ZeroCopyThreshold   = 64 * 1024,       //! minimal size of block, returned as zero-copy view of swap file
+        SwapBatchSize       = 16 * 1024 * 1024, //! maximal size of data, swapped by one step
+        CompressionMinSize  = 4 * 1024          //! smaller blocks are not compressed
+    };
+
+    //! Process of data, which was loaded from file
+    static const quint32 UnknownProcess = quint32(-1);
+
     explicit DataStorage(QObject *parent = 0);
 
-    void append_data(uint64_t index, const QByteArray &array);
+    //! Hash of data for append_data(). It is calculated by caller before lock of trace.
+    //! Range [skip_offset, skip_offset + skip_size) isn`t part of content, so data with other text there is equal
+    static hash128_t content_hash(const QByteArray &array, qsizetype skip_offset = 0, qsizetype skip_size = 0);
+
+    void append_data(uint64_t index, const QByteArray &array, const hash128_t &hash, quint32 process_index = 0);
 
     void remove_from_tail(uint64_t index);
     void clear();
 
-    QByteArray request_data(uint64_t index);
+    //! Returns copy of data. If pin is set, large swapped block is returned as zero-copy view,
+    //! which is valid while pin exists
+    QByteArray request_data(uint64_t index, DataPinPtr *pin = 0);
 
     void set_swap_state(bool enabled);
+    void set_compression_state(bool enabled);
     void set_swap_dir(const QString &path);
     void set_swap_file(const QString &filename, qint64 offset = 0);
 
@@ -52,20 +125,87 @@ public:
     size_t total_data_size() const;
     size_t swap_size() const;
 
+    //! Memory and swap usage by process index
+    QHash<quint32, data_usage_t> process_usage();
+
 private:
+    struct region_t
+    {
+        region_t(): index(0), size(0) {}
+        region_t(quint64 index_, quint64 size_): index(index_), size(size_) {}
+
+        quint64 index;
+        quint64 size;
+    };
+
+    struct content_t
+    {
+        content_t(): size(0), refs(1) {}
+        content_t(const hash128_t &hash_, quint64 size_): hash(hash_), size(size_), refs(1) {}
+
+        hash128_t hash;
+        quint64 size; //! size of data before compression
+        int refs;     //! number of message indices, which refer to content
+    };
+
     void open_swap();
+    void close_swap();
+    void map_swap();
+
+    //! Applies closing or remapping of swap file, which waited for release of pins
+    void release_swap();
+    struct swap_task_t
+    {
+        swap_task_t(): index(0), start(0), original_size(0), is_written(false) {}
+
+        quint64 index;
+        quint64 start;
+        QByteArray data;
+
+        quint64 original_size; //! size of data before compression, 0 if data is not compressed
+
+        bool is_written; //! data isn`t published, if it was not written to swap
+    };
+
+    struct swap_batch_t
+    {
+        swap_batch_t(): generation(0) {}
+
+        quint64 generation;
+        QVector<swap_task_t> tasks;
+    };
+
     void swap_memory();
+    void take_compression_batch(swap_batch_t &batch);
+    void apply_compression(const swap_batch_t &batch);
+    bool reserve_swap(swap_batch_t &batch);
+    void publish_swap(const swap_batch_t &batch);
+    void update_usage(quint64 index, qint64 memory_delta, qint64 swap_delta);
+    void remove_memory_data(quint64 index);
+    void remove_swap_data(quint64 index);
+    void forget_content(quint64 index);
+    void forget_hash(quint64 index);
+    bool find_swap_place(quint64 size, quint64 &start) const;
     void free_swap(quint64 start, quint64 size);
-    void write_swap(quint64 start, const char *data, quint64 size);
-    void read_swap(char *dest, quint64 start, quint64 size);
-    bool is_intersects(quint64 left_1, quint64 right_1, quint64 left_2, quint64 right_2) const;
+    //! Returns false, if swap was remapped after space reservation
+    bool write_swap(quint64 start, const char *data, quint64 size);
+    void read_swap(char *dest, quint64 start, quint64 size, bool external);
+    const char * mapped_data(quint64 start, bool external) const;
+
+    quint64 pin_data(const DataObject &data);
+    void unpin_data(quint64 pin_id);
+
+    QByteArray get_data(uint64_t index);
 
-    QByteArray get_data(uint64_t index, bool detach = false);
+    static QByteArray compress_data(const QByteArray &data);
+    static QByteArray uncompress_data(const QByteArray &data, quint64 original_size);
 
 private:
     friend class DumpTask;
+    friend class DataPin;
 
     bool _use_swap;
+    bool _use_compression;
     QString _swap_dir;
 
     size_t _memory_limit; // bytes
@@ -77,14 +217,68 @@ private:
     QMap<quint64, DataObject> _swap_map;
     QList<quint64> _swap_data_list;
 
-    size_t _total_size;
-    size_t _memory_data_size;
+    //! Occupied regions of swap file: start -> data index
+    QMap<quint64, region_t> _swap_regions;
+
+    //! Data, which is written to swap now, but is not published in _swap_map
+    QSet<quint64> _swap_in_flight;
+
+    //! Pinned regions of swap file: pin id -> region
+    QHash<quint64, DataObject> _pins;
+    quint64 _pin_counter;
+
+    //! Sizes are changed under _mutex, but can be read without lock
+    boost::atomic<size_t> _total_size;
+    boost::atomic<size_t> _memory_data_size;
+    boost::atomic<size_t> _swap_data_size;
+
+    QHash<quint64, quint32> _data_process;
+
+    //! Data, tested for compression: index -> original size, or 0 if data is incompressible
+    QHash<quint64, quint64> _compression_info;
+
+    QHash<quint32, data_usage_t> _process_usage;
+
+    //! Stored contents: content index -> content info
+    QHash<quint64, content_t> _contents;
+
+    //! Content index by hash of data
+    QHash<hash128_t, quint64> _content_hash;
+
+    //! Message indices with duplicated data: message index -> content index
+    QHash<quint64, quint64> _data_alias;
+
+    //! Swapping task is queued and not finished yet
+    bool _swap_scheduled;
 
     QTemporaryFile _swap_file;
 
+    uchar *_swap_memory;
+    quint64 _swap_capacity;
+    quint64 _swap_position;
+
+    //! Swap file is closed or mapped again with new size, when the last pin is released,
+    //! zero-copy views of pinned data refer to it`s mapping
+    bool _swap_close_pending;
+    bool _swap_remap_pending;
+
+    //! Data file of loaded trace. It is used instead of swap file until clear()
+    QFile _data_file;
+    uchar *_data_file_memory;
+    bool _external_data;
+
+    //! Incremented on clear, so swapping of cleared data is discarded
+    quint64 _generation;
+
     QThreadPool _swap_thread_pool;
 
     QMutex _mutex;
+
+    //! Read lock protects mapping while reading or writing of swap, write lock - while remapping
+    QReadWriteLock _file_lock;
+
+    //! Serializes seek-based I/O, when file can`t be mapped
+    QMutex _file_mutex;
 };
 
 QDataStream & operator << (QDataStream &out, const DataObject &value);
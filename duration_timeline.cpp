@@ -0,0 +1,87 @@
+#include "duration_timeline.h"
+
+void timeline_bucket_t::record(uint64_t duration)
+{
+    calls++;
+    total_time += duration;
+    max_time = qMax(max_time, duration);
+
+    histogram.record(duration);
+}
+
+void timeline_bucket_t::merge(const timeline_bucket_t &other)
+{
+    calls += other.calls;
+    total_time += other.total_time;
+    max_time = qMax(max_time, other.max_time);
+
+    histogram.merge(other.histogram);
+}
+
+/* ===================================================================================== */
+
+DurationTimeline::DurationTimeline():
+    _bucket_width(InitialBucketWidth)
+{
+}
+
+void DurationTimeline::record(uint64_t time, uint64_t duration)
+{
+    while(time / _bucket_width >= MaxBuckets)
+    {
+        widen();
+    }
+
+    int bucket = int(time / _bucket_width);
+
+    if(bucket >= _buckets.size())
+    {
+        _buckets.resize(bucket + 1);
+    }
+
+    _buckets[bucket].record(duration);
+}
+
+void DurationTimeline::widen()
+{
+    QVector<timeline_bucket_t> buckets((_buckets.size() + 1) / 2);
+
+    for(int i = 0; i < _buckets.size(); ++i)
+    {
+        buckets[i / 2].merge(_buckets.at(i));
+    }
+
+    _buckets = buckets;
+    _bucket_width *= 2;
+}
+
+int DurationTimeline::level_count() const
+{
+    int levels = 1;
+
+    for(int size = _buckets.size(); size > 1; size = (size + 1) / 2)
+    {
+        levels++;
+    }
+
+    return levels;
+}
+
+QVector<timeline_bucket_t> DurationTimeline::buckets(int level) const
+{
+    if(level <= 0)
+    {
+        return _buckets;
+    }
+
+    int step = 1 << level;
+
+    QVector<timeline_bucket_t> result((_buckets.size() + step - 1) / step);
+
+    for(int i = 0; i < _buckets.size(); ++i)
+    {
+        result[i / step].merge(_buckets.at(i));
+    }
+
+    return result;
+}
@@ -0,0 +1,65 @@
+#ifndef DURATION_TIMELINE_H
+#define DURATION_TIMELINE_H
+
+#include <stdint.h>
+
+#include <QVector>
+
+#include "latency_histogram.h"
+
+//! Aggregated durations of calls, finished in one time bucket
+struct timeline_bucket_t
+{
+    timeline_bucket_t(): calls(0), total_time(0), max_time(0) {}
+
+    void record(uint64_t duration);
+    void merge(const timeline_bucket_t &other);
+
+    quint64 calls;
+    uint64_t total_time;
+    uint64_t max_time;
+
+    LatencyHistogram histogram;
+};
+
+//! Duration aggregates of one function, bucketed by time.
+//! Bucket width is adaptive: when trace goes out of MaxBuckets buckets, width is doubled and
+//! adjacent buckets are merged, so memory is bounded for any capture length.
+//! Coarser levels are made by merging of 2^level adjacent buckets
+class DurationTimeline
+{
+public:
+    enum
+    {
+        MaxBuckets = 64
+    };
+
+    static const uint64_t InitialBucketWidth = 1000000; // 1 ms
+
+    DurationTimeline();
+
+    //! time - timestamp of call end (ns), duration - call duration (ns)
+    void record(uint64_t time, uint64_t duration);
+
+    inline bool is_empty() const { return _buckets.isEmpty(); }
+
+    inline uint64_t bucket_width() const { return _bucket_width; }
+    inline const QVector<timeline_bucket_t> &buckets() const { return _buckets; }
+
+    //! Number of available resolution levels, 0 - the finest one
+    int level_count() const;
+
+    QVector<timeline_bucket_t> buckets(int level) const;
+
+    inline uint64_t bucket_width(int level) const { return _bucket_width << level; }
+
+private:
+    void widen();
+
+private:
+    uint64_t _bucket_width;
+
+    QVector<timeline_bucket_t> _buckets;
+};
+
+#endif // DURATION_TIMELINE_H
@@ -0,0 +1,143 @@
+#include "entity_table.h"
+
+#include "trace_x/trace_x.h"
+
+EntityTable::EntityTable(int class_id):
+    _class_id(class_id)
+{
+    clear();
+}
+
+int EntityTable::append(const entity_row_t &row)
+{
+    QWriteLocker lock(&_lock);
+
+    int type = row.id.typeId();
+
+    _id_types.append(quint16(type));
+
+    if(type == QMetaType::QString)
+    {
+        _ids.append(intern(row.id.toString()));
+    }
+    else
+    {
+        _ids.append(row.id.toULongLong());
+    }
+
+    _texts.append(intern(row.text));
+    _tool_tips.append(intern(row.tool_tip));
+    _notes.append(intern(row.note));
+    _colors.append(color_index(row.bg_color, row.fg_color));
+    _parents.append(row.parent);
+    _ordinals.append(row.ordinal);
+
+    return _texts.size() - 1;
+}
+
+void EntityTable::insert_key(const QString &key, int row)
+{
+    QWriteLocker lock(&_lock);
+
+    _rows_by_key.insert(intern(key), row);
+}
+
+int EntityTable::find(const QString &key) const
+{
+    QReadLocker lock(&_lock);
+
+    QHash<QString, quint32>::const_iterator it = _string_ids.constFind(key);
+
+    if(it == _string_ids.constEnd())
+    {
+        return -1;
+    }
+
+    return _rows_by_key.value(it.value(), -1);
+}
+
+void EntityTable::clear()
+{
+    X_CALL;
+
+    QWriteLocker lock(&_lock);
+
+    _ids = QVector<quint64>();
+    _id_types = QVector<quint16>();
+    _texts = QVector<quint32>();
+    _tool_tips = QVector<quint32>();
+    _notes = QVector<quint32>();
+    _colors = QVector<quint16>();
+    _parents = QVector<quint32>();
+    _ordinals = QVector<quint32>();
+
+    _strings = QVector<QString>() << QString("");
+    _string_ids = QHash<QString, quint32>();
+    _string_ids.insert(QString(""), 0);
+
+    _palette = QVector<QPair<QColor, QColor>>() << qMakePair(QColor(), QColor());
+
+    _rows_by_key = QHash<quint32, int>();
+}
+
+QVariant EntityTable::id(int row) const
+{
+    QReadLocker lock(&_lock);
+
+    int type = _id_types.at(row);
+
+    if(type == QMetaType::QString)
+    {
+        return _strings.at(quint32(_ids.at(row)));
+    }
+
+    if(type == QMetaType::UnknownType)
+    {
+        return QVariant();
+    }
+
+    QVariant id(qulonglong(_ids.at(row)));
+
+    id.convert(QMetaType(type));
+
+    return id;
+}
+
+quint32 EntityTable::intern(const QString &string)
+{
+    if(string.isEmpty())
+    {
+        return 0;
+    }
+
+    QHash<QString, quint32>::const_iterator it = _string_ids.constFind(string);
+
+    if(it != _string_ids.constEnd())
+    {
+        return it.value();
+    }
+
+    quint32 id = _strings.size();
+
+    _strings.append(string);
+    _string_ids.insert(string, id);
+
+    return id;
+}
+
+quint16 EntityTable::color_index(const QColor &bg_color, const QColor &fg_color)
+{
+    // colors are taken from color generators, so palette is short
+
+    for(int i = 0; i < _palette.size(); ++i)
+    {
+        if((_palette.at(i).first == bg_color) && (_palette.at(i).second == fg_color))
+        {
+            return quint16(i);
+        }
+    }
+
+    _palette.append(qMakePair(bg_color, fg_color));
+
+    return quint16(_palette.size() - 1);
+}
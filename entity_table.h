@@ -0,0 +1,106 @@
+#ifndef ENTITY_TABLE_H
+#define ENTITY_TABLE_H
+
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVariant>
+#include <QColor>
+#include <QReadWriteLock>
+
+//! Entity, as it is registered in table
+struct entity_row_t
+{
+    entity_row_t(): parent(0), ordinal(0) {}
+    entity_row_t(const QVariant &id_, const QString &text_, const QString &tool_tip_ = QString(),
+                 const QColor &bg_color_ = QColor(), const QColor &fg_color_ = QColor()):
+        id(id_), text(text_), tool_tip(tool_tip_), bg_color(bg_color_), fg_color(fg_color_), parent(0), ordinal(0) {}
+
+    QVariant id;
+
+    QString text;
+    QString tool_tip;
+
+    //! Additional text of entity, class name of context
+    QString note;
+
+    QColor bg_color;
+    QColor fg_color;
+
+    //! Parent entity: process of thread or context (index + 1), class of function
+    quint32 parent;
+
+    //! Number of entity in parent
+    quint32 ordinal;
+};
+
+//! Entities of one class, kept by columns. Row of table is index of entity, which is stored in messages,
+//! so it is stable, while trace isn`t cleared. Strings are interned, so name, path and id of entity share one string,
+//! colors are kept as index of palette and entity takes a few integers instead of QStandardItem with variants of it`s data.
+//! Rows are appended by capture thread and read by gui and formatting threads, so columns are read under lock and returned by value
+class EntityTable
+{
+public:
+    explicit EntityTable(int class_id);
+
+    inline int class_id() const { return _class_id; }
+    inline int size() const { QReadLocker lock(&_lock); return _texts.size(); }
+
+    //! Appends entity and returns it`s row
+    int append(const entity_row_t &row);
+
+    //! Registers key of row, so it is found by find()
+    void insert_key(const QString &key, int row);
+
+    //! Row of key or -1
+    int find(const QString &key) const;
+
+    void clear();
+
+    QVariant id(int row) const;
+
+    inline QString text(int row) const { QReadLocker lock(&_lock); return _strings.at(_texts.at(row)); }
+    inline QString tool_tip(int row) const { QReadLocker lock(&_lock); return _strings.at(_tool_tips.at(row)); }
+    inline QString note(int row) const { QReadLocker lock(&_lock); return _strings.at(_notes.at(row)); }
+
+    inline QColor bg_color(int row) const { QReadLocker lock(&_lock); return _palette.at(_colors.at(row)).first; }
+    inline QColor fg_color(int row) const { QReadLocker lock(&_lock); return _palette.at(_colors.at(row)).second; }
+
+    inline quint32 parent(int row) const { QReadLocker lock(&_lock); return _parents.at(row); }
+    inline quint32 ordinal(int row) const { QReadLocker lock(&_lock); return _ordinals.at(row); }
+
+private:
+    //! Called under write lock
+    quint32 intern(const QString &string);
+    quint16 color_index(const QColor &bg_color, const QColor &fg_color);
+
+private:
+    int _class_id;
+
+    //! Id is kept as number of it`s type: interned string or integer
+    QVector<quint64> _ids;
+    QVector<quint16> _id_types;
+
+    QVector<quint32> _texts;
+    QVector<quint32> _tool_tips;
+    QVector<quint32> _notes;
+    QVector<quint16> _colors;
+    QVector<quint32> _parents;
+    QVector<quint32> _ordinals;
+
+    //! Interned strings, string 0 is empty one
+    QVector<QString> _strings;
+    QHash<QString, quint32> _string_ids;
+
+    //! Pairs of background and text colors, pair 0 has no colors
+    QVector<QPair<QColor, QColor>> _palette;
+
+    //! Rows by interned string of key
+    QHash<quint32, int> _rows_by_key;
+
+    //! Appending of rows reallocates columns
+    mutable QReadWriteLock _lock;
+};
+
+#endif // ENTITY_TABLE_H
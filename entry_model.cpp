@@ -1,22 +1,29 @@
 #include "entry_model.h"
 #include "filter_model.h"
+#include "trace_model.h"
 
 #include "trace_x/trace_x.h"
 
 #include <QSet>
 
 EntityItem::EntityItem():
-    QStandardItem()
+    QStandardItem(),
+    _table(0),
+    _table_row(-1)
 {}
 
-EntityItem::EntityItem(int class_id)
+EntityItem::EntityItem(int class_id):
+    _table(0),
+    _table_row(-1)
 {
     _descriptor.class_id = class_id;
 }
 
 EntityItem::EntityItem(int class_id, const QVariant &id, const QString &text,
                        qint64 index, const QColor &bg_color, const QColor &fg_color, const QString &tool_tip):
-    QStandardItem(text)
+    QStandardItem(text),
+    _table(0),
+    _table_row(-1)
 {
     if(!tool_tip.isEmpty())
     {
@@ -42,6 +49,23 @@ EntityItem::EntityItem(int class_id, const QVariant &id, const QString &text,
     _descriptor.index = index;
 }
 
+EntityItem::EntityItem(EntityTable *table, int row):
+    _table(table),
+    _table_row(row)
+{
+    _descriptor.class_id = table->class_id();
+}
+
+ItemDescriptor EntityItem::descriptor() const
+{
+    if(!_table)
+    {
+        return _descriptor;
+    }
+
+    return EntityRow(_table, _table_row).descriptor();
+}
+
 QVariant EntityItem::data(int role) const
 {
     return item_data(role, FullText);
@@ -49,47 +73,286 @@ QVariant EntityItem::data(int role) const
 
 QVariant EntityItem::item_data(int role, int flags) const
 {
+    if(_table)
+    {
+        // item keeps only data, which are set by views
+
+        QVariant result = EntityRow(_table, _table_row).item_data(role, flags);
+
+        return result.isValid() ? result : QStandardItem::data(role);
+    }
+
     if(role == FilterDataRole)
     {
-        return QVariant::fromValue(FilterItem(text(), _descriptor.id, _descriptor.class_id, FilterItem::ID, _descriptor.index,
+        ItemDescriptor descriptor = this->descriptor();
+
+        return QVariant::fromValue(FilterItem(text(), descriptor.id, descriptor.class_id, FilterItem::ID, descriptor.index,
                                               data(Qt::ForegroundRole), data(ColorRole)));
     }
 
     if((flags & EntityItem::WithDecorator) && (role == Qt::DecorationRole))
     {
-        return QStandardItem::data(ColorRole);
+        return row_data(ColorRole);
     }
 
     if((flags & EntityItem::WithBackColor) && (role == Qt::BackgroundRole))
     {
-        return QStandardItem::data(ColorRole);
+        return row_data(ColorRole);
     }
 
-    return QStandardItem::data(role);
+    return row_data(role);
 }
 
 void EntityItem::read(QDataStream &in)
+{
+    entity_row_t row;
+
+    read_row(in, row);
+}
+
+void EntityItem::write(QDataStream &out) const
+{
+    ItemDescriptor descriptor = this->descriptor();
+
+    out << descriptor.class_id;
+    out << descriptor.id;
+    out << descriptor.index;
+    out << descriptor.label;
+
+    if(!_table)
+    {
+        QStandardItem::write(out);
+
+        return;
+    }
+
+    // file has data of QStandardItem, so it is read by item of table or by standalone item
+
+    QStandardItem values;
+
+    fill_values(values);
+
+    values.write(out);
+}
+
+void EntityItem::read_row(QDataStream &in, entity_row_t &row)
 {
     in >> _descriptor.class_id;
     in >> _descriptor.id;
     in >> _descriptor.index;
     in >> _descriptor.label;
 
-    QStandardItem::read(in);
+    if(!_table)
+    {
+        QStandardItem::read(in);
+
+        return;
+    }
+
+    QStandardItem values;
+
+    values.read(in);
+
+    row.id = _descriptor.id;
+
+    if(row.text.isNull())
+    {
+        row.text = values.text();
+    }
+
+    row.tool_tip = values.toolTip();
+    row.bg_color = values.data(ColorRole).value<QColor>();
+    row.fg_color = values.data(TextColorRole).value<QColor>();
+
+    _table_row = _table->append(row);
+
+    // descriptor is kept by table
+
+    _descriptor = ItemDescriptor();
+    _descriptor.class_id = _table->class_id();
 }
 
-void EntityItem::write(QDataStream &out) const
+void EntityItem::fill_values(QStandardItem &values) const
+{
+    values.setData(row_data(Qt::DisplayRole), Qt::DisplayRole);
+    values.setData(row_data(Qt::ToolTipRole), Qt::ToolTipRole);
+    values.setData(row_data(ColorRole), ColorRole);
+    values.setData(row_data(TextColorRole), TextColorRole);
+}
+
+QVariant EntityItem::row_data(int role) const
+{
+    if(!_table)
+    {
+        return QStandardItem::data(role);
+    }
+
+    QVariant result = EntityRow(_table, _table_row).row_data(role);
+
+    return result.isValid() ? result : QStandardItem::data(role);
+}
+
+ItemDescriptor EntityRow::descriptor() const
+{
+    if(_item)
+    {
+        return _item->descriptor();
+    }
+
+    if(!_table)
+    {
+        return ItemDescriptor();
+    }
+
+    // row of table is index of entity
+
+    ItemDescriptor descriptor(_table->id(_row));
+
+    descriptor.class_id = _table->class_id();
+    descriptor.index = _row;
+
+    return descriptor;
+}
+
+QVariant EntityRow::item_data(int role, int flags) const
+{
+    if(_item)
+    {
+        return _item->item_data(role, flags);
+    }
+
+    if(!_table)
+    {
+        return QVariant();
+    }
+
+    if(role == FilterDataRole)
+    {
+        ItemDescriptor descriptor = this->descriptor();
+
+        return QVariant::fromValue(FilterItem(text(), descriptor.id, descriptor.class_id, FilterItem::ID, descriptor.index,
+                                              data(Qt::ForegroundRole), data(ColorRole)));
+    }
+
+    // thread and context are sorted by "i1_i2", where i1 and i2 are parent and ordinal of row
+
+    int class_id = _table->class_id();
+
+    bool is_id = (class_id == ThreadIdEntity) || (class_id == ContextIdEntity);
+
+    if(role == Qt::DisplayRole)
+    {
+        if((class_id == ContextIdEntity) && (flags & EntityItem::FullText))
+        {
+            return QString(_table->text(_row) % " " % _table->note(_row));
+        }
+
+        if(is_id && (flags & EntityItem::OnlyIndex))
+        {
+            return QString("%1_%2").arg(_table->parent(_row)).arg(_table->ordinal(_row));
+        }
+    }
+
+    if(is_id && (role == IDItem::Idx1Role))
+    {
+        return quint64(_table->parent(_row));
+    }
+
+    if(is_id && (role == IDItem::Idx2Role))
+    {
+        return quint64(_table->ordinal(_row));
+    }
+
+    if((class_id == ContextIdEntity) && (role == ContextEntityItem::ClassNameRole))
+    {
+        return _table->note(_row);
+    }
+
+    if((flags & EntityItem::WithDecorator) && (role == Qt::DecorationRole))
+    {
+        return row_data(ColorRole);
+    }
+
+    if((flags & EntityItem::WithBackColor) && (role == Qt::BackgroundRole))
+    {
+        return row_data(ColorRole);
+    }
+
+    return row_data(role);
+}
+
+QVariant EntityRow::row_data(int role) const
 {
-    out << _descriptor.class_id;
-    out << _descriptor.id;
-    out << _descriptor.index;
-    out << _descriptor.label;
+    if(_item)
+    {
+        return _item->data(role);
+    }
+
+    if(!_table)
+    {
+        return QVariant();
+    }
+
+    if((role == Qt::DisplayRole) || (role == Qt::EditRole))
+    {
+        return _table->text(_row);
+    }
+
+    if(role == Qt::ToolTipRole)
+    {
+        // entity without tool tip shows it`s id
+
+        QString tool_tip = _table->tool_tip(_row);
+
+        return tool_tip.isEmpty() ? _table->id(_row).toString() : tool_tip;
+    }
+
+    if((role == ColorRole) || (role == TextColorRole))
+    {
+        QColor color = (role == ColorRole) ? _table->bg_color(_row) : _table->fg_color(_row);
 
-    QStandardItem::write(out);
+        return color.isValid() ? QVariant(color) : QVariant();
+    }
+
+    return QVariant();
+}
+
+bool EntityRow::operator<(const EntityRow &other) const
+{
+    if(_item && other._item)
+    {
+        return *_item < *other._item;
+    }
+
+    if(!_table || (_table != other._table))
+    {
+        return text() < other.text();
+    }
+
+    int class_id = _table->class_id();
+
+    if((class_id != ThreadIdEntity) && (class_id != ContextIdEntity))
+    {
+        return text() < other.text();
+    }
+
+    if(_table->parent(_row) != _table->parent(other._row))
+    {
+        return _table->parent(_row) < _table->parent(other._row);
+    }
+
+    // objects of process are sorted by class name
+
+    if(class_id == ContextIdEntity)
+    {
+        return _table->note(_row) < _table->note(other._row);
+    }
+
+    return _table->ordinal(_row) < _table->ordinal(other._row);
 }
 
 //! Процедура фильтрации элементов модели по тексту
-QStandardItem * parse_entry(const Entry &entry, const QRegExp &re)
+QStandardItem * parse_entry(const Entry &entry, const QString &pattern)
 {
     X_CALL_F;
 
@@ -97,44 +360,70 @@ QStandardItem * parse_entry(const Entry &entry, const QRegExp &re)
 
     QSet<QString> string_set;
 
-    if(!entry.item_list->isEmpty())
+    bool is_cut = false;
+
+    // entities are appended by capture thread, so they are searched up to size, which is read once
+
+    int size = entry.entities.size();
+
+    if(size)
     {
+        // texts of entities, which are registered after the previous search, are appended to index
+
+        if(entry.index->size() > size)
+        {
+            entry.index->clear();
+        }
+
+        for(int i = entry.index->size(); i < size; ++i)
+        {
+            entry.index->append(entry.entities.at(i).data(entry.search_role).toString());
+        }
+
+        QVector<int> found = entry.index->find(pattern, Entry::ResultLimit + 1);
+
+        if(found.size() > Entry::ResultLimit)
+        {
+            is_cut = true;
+
+            found.resize(Entry::ResultLimit);
+        }
+
         // Выравниваем слова по колонкам
-        int word_count = entry.item_list->last()->data(entry.search_role).toString().split(' ').size();
+        int word_count = entry.entities.at(size - 1).data(entry.search_role).toString().split(' ').size();
 
         QVector<int> word_max_len(word_count);
 
-        foreach(const QStandardItem *item, *entry.item_list)
+        foreach(int index, found)
         {
-            QString text = item->data(entry.search_role).toString();
+            EntityRow entity = entry.entities.at(index);
+
+            QString text = entity.data(entry.search_role).toString();
             QString display_text = text;
 
-            if(!display_text.isEmpty() && re.indexIn(text) != -1)
+            if(!entry.remove_equals || !string_set.contains(text))
             {
-                if(!entry.remove_equals || !string_set.contains(text))
+                if(entry.remove_equals)
                 {
-                    if(entry.remove_equals)
-                    {
-                        string_set.insert(text);
-                    }
+                    string_set.insert(text);
+                }
 
-                    if(word_count > 1)
-                    {
-                        QStringList word_list = text.split(' ');
+                if(word_count > 1)
+                {
+                    QStringList word_list = text.split(' ');
 
-                        for(int i = 0; i < word_list.size(); ++i)
+                    for(int i = 0; i < word_list.size(); ++i)
+                    {
+                        if(word_list[i].length() > word_max_len[i])
                         {
-                            if(word_list[i].length() > word_max_len[i])
-                            {
-                                word_max_len[i] = word_list[i].length();
-                            }
+                            word_max_len[i] = word_list[i].length();
                         }
                     }
+                }
 
-                    QStandardItem *it = new ProxyEntryItem(display_text, item);
+                QStandardItem *it = new ProxyEntryItem(display_text, entity);
 
-                    result_list.append(it);
-                }
+                result_list.append(it);
             }
         }
 
@@ -163,7 +452,7 @@ QStandardItem * parse_entry(const Entry &entry, const QRegExp &re)
 
    // if(!result_list.isEmpty())
     {
-        QStandardItem *entry_root = new QStandardItem(entry.name);
+        QStandardItem *entry_root = new QStandardItem(is_cut ? QObject::tr("%1 (first %2)").arg(entry.name).arg(int(Entry::ResultLimit)) : entry.name);
 
         entry_root->setEnabled(false);
         entry_root->appendRows(result_list);
@@ -179,15 +468,13 @@ void find_in_entries(QList<QStandardItem *> &result, const QString &prefix, cons
 {
     X_CALL_F;
 
-    QRegExp re(pattern, Qt::CaseInsensitive, QRegExp::Wildcard);
-
     if(prefix.isEmpty())
     {
         foreach(const Entry &entry, entry_set.entries)
         {
             if(entry.is_common)
             {
-                QStandardItem *entry_root = parse_entry(entry, re);
+                QStandardItem *entry_root = parse_entry(entry, pattern);
 
                 if(entry_root->rowCount() > 0)
                 {
@@ -198,9 +485,11 @@ void find_in_entries(QList<QStandardItem *> &result, const QString &prefix, cons
     }
     else
     {
-        if(Entry *entry = entry_set.entry_hash.value(prefix))
+        QHash<QString, int>::const_iterator it = entry_set.entry_hash.constFind(prefix);
+
+        if(it != entry_set.entry_hash.constEnd())
         {
-            result.append(parse_entry(*entry, re));
+            result.append(parse_entry(entry_set.entries.at(it.value()), pattern));
         }
     }
 }
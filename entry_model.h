@@ -7,6 +7,8 @@
 #include <QRegExp>
 
 #include "trace_tools.h"
+#include "entity_table.h"
+#include "text_index.h"
 
 enum
 {
@@ -29,6 +31,9 @@ struct ItemDescriptor
 
 typedef QHashBuilder<int, ItemDescriptor> TraceMessageDescription;
 
+//! Item of entity. Processes and message types are few, so their items keep their data themselves.
+//! Entities of tables have no items in controller: item of table is a temporary view of it`s row,
+//! which reads and writes row in format of trace file
 class EntityItem : public QStandardItem
 {
 public:
@@ -46,7 +51,13 @@ public:
     EntityItem(int class_id, const QVariant &id, const QString &text,
                qint64 index, const QColor &bg_color = QColor(), const QColor &fg_color = QColor(), const QString &tool_tip = QString());
 
-    inline const ItemDescriptor & descriptor() const { return _descriptor ; }
+    //! View of row of table. Item with row -1 appends row to table, when it is read
+    EntityItem(EntityTable *table, int row = -1);
+
+    ItemDescriptor descriptor() const;
+
+    inline const EntityTable * table() const { return _table; }
+    inline int table_row() const { return _table_row; }
 
     virtual QVariant data(int role) const;
     virtual QVariant item_data(int role, int flags = ShortText) const;
@@ -54,35 +65,115 @@ public:
     virtual void read(QDataStream &in);
     virtual void write(QDataStream &out) const;
 
+protected:
+    //! Reads descriptor and data of item. Item of table appends them to table, fields of row,
+    //! which are read by subclass (parent, ordinal, note, text), are set by caller
+    void read_row(QDataStream &in, entity_row_t &row);
+
+    //! Data of item of table, which are written instead of stored data of QStandardItem
+    virtual void fill_values(QStandardItem &values) const;
+
+    //! Data of row of table or stored data of item
+    QVariant row_data(int role) const;
+
 protected:
     ItemDescriptor _descriptor;
+
+    EntityTable *_table;
+    int _table_row;
+};
+
+//! Lightweight view of entity: row of entity table or item, which keeps it`s data itself. Accessors and lists of controller
+//! return it instead of item of entity, so entity of table takes no QStandardItem. Item of table shows data of it`s row view
+class EntityRow
+{
+public:
+    EntityRow(): _table(0), _row(-1), _item(0) {}
+    EntityRow(const EntityTable *table, int row): _table(table), _row(row), _item(0) {}
+    explicit EntityRow(const EntityItem *item): _table(0), _row(-1), _item(item) {}
+
+    inline bool is_null() const { return !_table && !_item; }
+
+    inline const EntityTable * table() const { return _table; }
+    inline int row() const { return _row; }
+
+    ItemDescriptor descriptor() const;
+
+    inline QString text() const { return data(Qt::DisplayRole).toString(); }
+    inline QString tool_tip() const { return data(Qt::ToolTipRole).toString(); }
+
+    inline QVariant data(int role) const { return item_data(role, EntityItem::FullText); }
+
+    //! Data of row, as item of entity`s class shows it
+    QVariant item_data(int role, int flags = EntityItem::ShortText) const;
+
+    //! Data of columns of row
+    QVariant row_data(int role) const;
+
+    //! Entities are sorted as items of their class: threads and contexts by "i1_i2", other entities by text
+    bool operator<(const EntityRow &other) const;
+
+private:
+    const EntityTable *_table;
+    int _row;
+
+    const EntityItem *_item;
+};
+
+//! Entities of one class: rows of table or items of list. It is taken by value, size is read on each call,
+//! so appended entities are seen
+class EntityList
+{
+public:
+    EntityList(): _table(0), _items(0) {}
+    explicit EntityList(const EntityTable *table): _table(table), _items(0) {}
+    explicit EntityList(const QList<EntityItem*> *items): _table(0), _items(items) {}
+
+    inline int size() const { return _table ? _table->size() : (_items ? int(_items->size()) : 0); }
+    inline bool is_empty() const { return !size(); }
+
+    inline EntityRow at(int index) const { return _table ? EntityRow(_table, index) : EntityRow(_items->at(index)); }
+
+private:
+    const EntityTable *_table;
+    const QList<EntityItem*> *_items;
 };
 
 struct Entry
 {
-    Entry(){}
-    Entry(const QString &prefix_, const QString &name_, const QList<EntityItem*> *list_,
+    enum
+    {
+        ResultLimit = 1000 //! completer shows no more items of entry
+    };
+
+    Entry(): index(0) {}
+    Entry(const QString &prefix_, const QString &name_, const EntityList &list_,
           int role_ = Qt::DisplayRole, bool common_ = true, bool remove_equals_ = false):
-        prefix(prefix_), name(name_), item_list(list_), search_role(role_),
-        is_common(common_), remove_equals(remove_equals_) {}
+        prefix(prefix_), name(name_), entities(list_), search_role(role_),
+        is_common(common_), remove_equals(remove_equals_), index(0) {}
 
     QString prefix;
     QString name;
-    const QList<EntityItem*> *item_list;
+    EntityList entities;
     int search_role;
     bool is_common;
     bool remove_equals;
+
+    //! Texts of search role of items, they are appended, when items are searched
+    TextIndex *index;
 };
 
 struct EntrySet
 {
     QList<Entry> entries;
-    QHash<QString, Entry*> entry_hash;
+
+    //! Index of entry by prefix, entries are moved, while they are appended
+    QHash<QString, int> entry_hash;
 
     void append(const Entry &entry)
     {
         entries.append(entry);
-        entry_hash.insert(entry.prefix, &entries.last());
+        entry_hash.insert(entry.prefix, entries.size() - 1);
     }
 };
 
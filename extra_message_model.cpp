@@ -70,7 +70,7 @@ class ProcessNameItem : public ModelItem
     {
         if(!message()) return QVariant();
 
-        return trace_controller().process_name_at(message())->data(role);
+        return trace_controller().process_name_at(message()).data(role);
     }
 };
 
@@ -90,7 +90,7 @@ class ModuleItem : public ModelItem
     {
         if(!message() || (message()->type >= trace_x::_MESSAGE_END_)) return QVariant();
 
-        return trace_controller().module_at(message())->item_data(role, EntityItem::WithDecorator | EntityItem::ShortText);
+        return trace_controller().module_at(message()).item_data(role, EntityItem::WithDecorator | EntityItem::ShortText);
     }
 };
 
@@ -100,7 +100,7 @@ class Contexttem : public ModelItem
     {
         if(!message() || (message()->type >= trace_x::_MESSAGE_END_)) return QVariant();
 
-        return trace_controller().context_item_at(message())->item_data(role, EntityItem::WithDecorator | EntityItem::ShortText);
+        return trace_controller().context_at(message()).item_data(role, EntityItem::WithDecorator | EntityItem::ShortText);
     }
 };
 
@@ -110,7 +110,7 @@ class ClassItem : public ModelItem
     {
         if(!message() || (message()->type >= trace_x::_MESSAGE_END_)) return QVariant();
 
-        return trace_controller().class_at(message())->data(role);
+        return trace_controller().class_at(message()).data(role);
     }
 };
 
@@ -120,7 +120,7 @@ class FunctionItem : public ModelItem
     {
         if(!message() || (message()->type >= trace_x::_MESSAGE_END_)) return QVariant();
 
-        return trace_controller().function_at(message())->data(role);
+        return trace_controller().function_at(message()).data(role);
     }
 };
 
@@ -130,7 +130,7 @@ class SourceFileItem : public ModelItem
     {
         if(!message() || (message()->type >= trace_x::_MESSAGE_END_)) return QVariant();
 
-        return trace_controller().source_at(message())->data(role);
+        return trace_controller().source_at(message()).data(role);
     }
 };
 
@@ -155,7 +155,7 @@ class ThreadItem : public ModelItem
     {
         if(!message() || (message()->type >= trace_x::_MESSAGE_END_)) return QVariant();
 
-        return trace_controller().thread_item_at(message())->item_data(role, EntityItem::WithDecorator | EntityItem::ShortText);
+        return trace_controller().thread_at(message()).item_data(role, EntityItem::WithDecorator | EntityItem::ShortText);
     }
 };
 
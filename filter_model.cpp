@@ -613,7 +613,7 @@ int FilterGroup::check_filter(const trace_message_t *message) const
         }
         else
         {
-            if(item_at(i)->matched(model()->_controller->items_by_class(EntityClass(_class_id), true).at(model()->_controller->index_by_class(message, _class_id))->descriptor()))
+            if(item_at(i)->matched(model()->_controller->entities_by_class(EntityClass(_class_id), true).at(int(model()->_controller->index_by_class(message, _class_id))).descriptor()))
             {
                 in_set = true;
 
@@ -844,14 +844,14 @@ void FilterGroup::update_indexes()
 
         if(item->is_exact() && (item->_index == -1))
         {
-            EntityItem * entity = model()->_controller->item_by_descriptor_id(EntityClass(item->class_id()), item->_id_pattern);
+            EntityRow entity = model()->_controller->entity_by_descriptor_id(EntityClass(item->class_id()), item->_id_pattern);
 
-            if(entity)
+            if(!entity.is_null())
             {
-                item->setText(entity->item_data(Qt::DisplayRole, EntityItem::FullText).toString());
-                item->setData(entity->data(ColorRole), Qt::DecorationRole);
-                item->setData(entity->data(Qt::ForegroundRole), Qt::ForegroundRole);
-                item->_index = entity->descriptor().index;
+                item->setText(entity.item_data(Qt::DisplayRole, EntityItem::FullText).toString());
+                item->setData(entity.data(ColorRole), Qt::DecorationRole);
+                item->setData(entity.data(Qt::ForegroundRole), Qt::ForegroundRole);
+                item->_index = entity.descriptor().index;
             }
         }
     }
@@ -0,0 +1,64 @@
+#include "frame_scheduler.h"
+
+#include <QCoreApplication>
+
+#include "trace_x/trace_x.h"
+
+FrameScheduler::FrameScheduler(QObject *parent) : QObject(parent)
+{
+    X_CALL;
+
+    connect(&_timer, &QTimer::timeout, this, &FrameScheduler::next_frame);
+
+    _timer.start(MinInterval);
+
+    _frame_time.start();
+}
+
+FrameScheduler &FrameScheduler::instance()
+{
+    // scheduler is deleted with application, before event loop of gui thread is gone
+
+    static FrameScheduler *scheduler = new FrameScheduler(qApp);
+
+    return *scheduler;
+}
+
+int FrameScheduler::interval() const
+{
+    return _timer.interval();
+}
+
+void FrameScheduler::next_frame()
+{
+    int interval = _timer.interval();
+
+    // delay of timer is time of painting and other events of the previous frame
+
+    qint64 delay = qMax<qint64>(0, _frame_time.restart() - interval);
+
+    QElapsedTimer update_time;
+
+    update_time.start();
+
+    emit frame();
+    emit frame_finished();
+
+    qint64 load = delay + update_time.elapsed();
+
+    if(load > interval / 2)
+    {
+        interval = qMin<int>(interval * 2, MaxInterval);
+    }
+    else if(load < interval / 8)
+    {
+        interval = qMax<int>(interval * 3 / 4, MinInterval);
+    }
+
+    if(interval != _timer.interval())
+    {
+        X_INFO("frame interval: {} ms, load: {} ms", interval, load);
+
+        _timer.setInterval(interval);
+    }
+}
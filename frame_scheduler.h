@@ -0,0 +1,45 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+//! Single timer of gui updates. Models check their changes once per frame, so views get one notification per frame.
+//! Frame interval grows, while updates take large part of frame or frames are delayed by event loop, and shrinks when gui is idle
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        MinInterval = 16,  //! ms, 60 fps
+        MaxInterval = 500  //! ms
+    };
+
+    static FrameScheduler &instance();
+
+    int interval() const;
+
+signals:
+    //! Models publish changes, which are collected since the previous frame
+    void frame();
+
+    //! Emitted after frame, when views have taken changes of models
+    void frame_finished();
+
+private slots:
+    void next_frame();
+
+private:
+    explicit FrameScheduler(QObject *parent = 0);
+
+private:
+    QTimer _timer;
+
+    //! Time since the previous frame
+    QElapsedTimer _frame_time;
+};
+
+#endif // FRAME_SCHEDULER_H
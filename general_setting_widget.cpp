@@ -35,7 +35,9 @@ void GeneralSettingWidget::save()
     x_settings().memory_limit_option->set_value(ui->memory_limit_spinbox->value());
     x_settings().swap_limit_option->set_value(ui->swap_limit_spinbox->value());
     x_settings().file_data_limit_option->set_value(ui->file_limit_spinbox->value());
+    x_settings().trace_memory_limit_option->set_value(ui->trace_memory_limit_spinbox->value());
     x_settings().no_swap_option->set_value(!ui->use_swap_checkbox->isChecked());
+    x_settings().no_compression_option->set_value(!ui->use_compression_checkbox->isChecked());
     x_settings().swap_path_option->init_value(ui->swap_path_line_edit->text());
 }
 
@@ -47,6 +49,8 @@ void GeneralSettingWidget::restore()
     ui->memory_limit_spinbox->setValue(x_settings().memory_limit_option->uint_value());
     ui->swap_limit_spinbox->setValue(x_settings().swap_limit_option->uint_value());
     ui->file_limit_spinbox->setValue(x_settings().file_data_limit_option->uint_value());
+    ui->trace_memory_limit_spinbox->setValue(x_settings().trace_memory_limit_option->uint_value());
     ui->use_swap_checkbox->setChecked(!x_settings().no_swap_option->bool_value());
+    ui->use_compression_checkbox->setChecked(!x_settings().no_compression_option->bool_value());
     ui->swap_path_line_edit->setText(x_settings().swap_path_option->string_value());
 }
@@ -0,0 +1,103 @@
+#include "histogram_widget.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+
+namespace
+{
+
+inline QString nanoseconds_to_string(uint64_t time)
+{
+    return QString::number(time / 1000000000.0, 'f', 6);
+}
+
+}
+
+HistogramWidget::HistogramWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void HistogramWidget::set_histogram(const LatencyHistogram &histogram, const QString &title)
+{
+    _histogram = histogram;
+    _title = title;
+
+    update();
+}
+
+QSize HistogramWidget::sizeHint() const
+{
+    return QSize(360, 160);
+}
+
+void HistogramWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+
+    painter.fillRect(rect(), palette().base());
+
+    int text_h = fontMetrics().height();
+
+    QRect bars_rect = rect().adjusted(4, text_h + 4, -4, -text_h - 4);
+
+    painter.setPen(palette().text().color());
+
+    painter.drawText(rect().adjusted(4, 2, -4, 0), Qt::AlignLeft | Qt::AlignTop,
+                     _title.isEmpty() ? tr("%1 calls").arg(_histogram.total_count()) : _title + tr(" : %1 calls").arg(_histogram.total_count()));
+
+    if(_histogram.is_empty() || (bars_rect.width() <= 0) || (bars_rect.height() <= 0))
+        return;
+
+    quint32 max_count = 0;
+
+    for(int i = _histogram.first_bucket(); i < _histogram.first_bucket() + _histogram.bucket_count(); ++i)
+    {
+        max_count = qMax(max_count, _histogram.count_at(i));
+    }
+
+    double bar_w = bars_rect.width() / double(_histogram.bucket_count());
+
+    for(int i = 0; i < _histogram.bucket_count(); ++i)
+    {
+        quint32 count = _histogram.count_at(_histogram.first_bucket() + i);
+
+        if(count)
+        {
+            int bar_h = qMax(1, int(bars_rect.height() * count / double(max_count)));
+
+            QRectF bar(bars_rect.left() + i * bar_w, bars_rect.bottom() - bar_h + 1, qMax(1.0, bar_w - 1), bar_h);
+
+            painter.fillRect(bar, Qt::darkCyan);
+        }
+    }
+
+    // percentile markers
+
+    const double percentiles[] = { 50.0, 99.0 };
+
+    for(double percentile : percentiles)
+    {
+        int bucket = LatencyHistogram::bucket_index(_histogram.value_at_percentile(percentile)) - _histogram.first_bucket();
+
+        int x = int(bars_rect.left() + (bucket + 0.5) * bar_w);
+
+        painter.setPen(QPen(Qt::red, 1, Qt::DashLine));
+        painter.drawLine(x, bars_rect.top(), x, bars_rect.bottom());
+
+        painter.setPen(Qt::red);
+        painter.drawText(x + 2, bars_rect.top() + text_h, QString("p%1").arg(percentile));
+    }
+
+    // value range
+
+    painter.setPen(palette().text().color());
+
+    QRect axis_rect(bars_rect.left(), bars_rect.bottom() + 2, bars_rect.width(), text_h);
+
+    painter.drawText(axis_rect, Qt::AlignLeft, ::nanoseconds_to_string(_histogram.min_value()));
+    painter.drawText(axis_rect, Qt::AlignRight, ::nanoseconds_to_string(_histogram.max_value()));
+}
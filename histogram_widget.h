@@ -0,0 +1,28 @@
+#ifndef HISTOGRAM_WIDGET_H
+#define HISTOGRAM_WIDGET_H
+
+#include <QWidget>
+
+#include "latency_histogram.h"
+
+//! Small widget for drawing of duration distribution with marked percentiles
+class HistogramWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HistogramWidget(QWidget *parent = 0);
+
+    void set_histogram(const LatencyHistogram &histogram, const QString &title = QString());
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    LatencyHistogram _histogram;
+    QString _title;
+};
+
+#endif // HISTOGRAM_WIDGET_H
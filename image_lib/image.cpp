@@ -143,6 +143,138 @@ void histogram_quantiles(const cimg_library::CImg<uint64_t> &histogram, uint64_t
     }
 }
 
+//! Header of image data, as it is sent by trace_x.
+//! Fields are packed without alignment: size, elem_size, channels, unit_type, data_format, band_index, axes,
+//! message_size, palette_size, byte_size, then message text, palette and pixels
+struct image_header_t
+{
+    image_header_t():
+        elem_size(0),
+        channels(0),
+        unit_type(0),
+        data_format(0),
+        message_size(0),
+        palette_size(0),
+        byte_size(0),
+        message(0),
+        palette(0),
+        data(0)
+    {}
+
+    std::vector<quint64> size;
+    quint64 elem_size;
+    quint32 channels;
+    qint8   unit_type;
+    quint32 data_format;
+
+    std::vector<quint8> band_index;
+    std::vector<quint8> axes;
+
+    quint32 message_size;
+    quint32 palette_size;
+    quint64 byte_size;
+
+    const char *message;
+    const char *palette;
+    const char *data;
+};
+
+template<class T>
+bool read_vector(const char *buffer, size_t buffer_size, size_t &offset, std::vector<T> &result)
+{
+    if(offset + sizeof(quint64) > buffer_size)
+    {
+        return false;
+    }
+
+    quint64 count = get_value<quint64>(buffer, offset);
+
+    if(count > (buffer_size - offset) / sizeof(T))
+    {
+        return false;
+    }
+
+    result.assign((const T*)(buffer + offset), (const T*)(buffer + offset) + count);
+
+    offset += count * sizeof(T);
+
+    return true;
+}
+
+//! Reads header in place, pointers refer to image_data
+bool read_image_header(const QByteArray &image_data, image_header_t &header)
+{
+    const char *buffer = image_data.constData();
+    const size_t buffer_size = image_data.size();
+
+    size_t offset = 0;
+
+    if(!read_vector(buffer, buffer_size, offset, header.size) ||
+            (offset + sizeof(quint64) + 2 * sizeof(quint32) + sizeof(qint8) > buffer_size))
+    {
+        return false;
+    }
+
+    header.elem_size   = get_value<quint64>(buffer, offset);
+    header.channels    = get_value<quint32>(buffer, offset);
+    header.unit_type   = get_value<qint8>(buffer, offset);
+    header.data_format = get_value<quint32>(buffer, offset);
+
+    if(!read_vector(buffer, buffer_size, offset, header.band_index) ||
+            !read_vector(buffer, buffer_size, offset, header.axes) ||
+            (offset + 2 * sizeof(quint32) + sizeof(quint64) > buffer_size))
+    {
+        return false;
+    }
+
+    header.message_size = get_value<quint32>(buffer, offset);
+    header.palette_size = get_value<quint32>(buffer, offset);
+    header.byte_size    = get_value<quint64>(buffer, offset);
+
+    // sizes are sent by client, so each one is checked by remaining bytes and their sum can`t overflow
+
+    size_t remaining = buffer_size - offset;
+
+    if(header.message_size > remaining)
+    {
+        return false;
+    }
+
+    remaining -= header.message_size;
+
+    if(header.palette_size > remaining)
+    {
+        return false;
+    }
+
+    remaining -= header.palette_size;
+
+    if(header.byte_size > remaining)
+    {
+        return false;
+    }
+
+    header.message = buffer + offset;
+    header.palette = header.message + header.message_size;
+    header.data = header.palette + header.palette_size;
+
+    return true;
+}
+
+template<class T>
+void append_value(QByteArray &array, T value)
+{
+    array.append((const char*)(&value), sizeof(T));
+}
+
+template<class T>
+void append_vector(QByteArray &array, const QVector<T> &vector)
+{
+    append_value<quint64>(array, vector.size());
+
+    array.append((const char*)(vector.constData()), vector.size() * sizeof(T));
+}
+
 }
 
 template<class T>
@@ -364,33 +496,30 @@ Image get_image(const QByteArray &image_data)
 
     Image image;
 
-    QDataStream stream(image_data);
-
-    QVector<quint64> size;
-
-    quint64 elem_size;
-    quint64 byte_size;
-    quint32 data_format;
-    quint32 palette_size;
+    // data is stored as received, so header is read in place without copying of pixels
 
-    stream >> size >> elem_size >> image.channels >> image.unit_type >> data_format >> image.band_index >> image.axes >> palette_size >> byte_size;
+    image_header_t header;
 
-    if((size.size() != 2) || !size[0] || !size[1])
+    if(!read_image_header(image_data, header) || (header.size.size() != 2) || !header.size[0] || !header.size[1])
     {
         return image;
     }
 
-    X_INFO_F("image band_index: {}", image.band_index);
+    const quint64 byte_size = header.byte_size;
+    const quint32 data_format = header.data_format;
+    const quint32 palette_size = header.palette_size;
 
-    image.height = size[0];
-    image.width = size[1];
+    image.channels = header.channels;
+    image.unit_type = header.unit_type;
+    image.band_index = QVector<quint8>(header.band_index.begin(), header.band_index.end());
+    image.axes = QVector<quint8>(header.axes.begin(), header.axes.end());
 
-    const char *palette_data = 0;
+    X_INFO_F("image band_index: {}", image.band_index);
 
-    if(palette_size)
-    {
-        palette_data = image_data.constData() + stream.device()->pos();
-    }
+    image.height = header.size[0];
+    image.width = header.size[1];
+
+    const char *palette_data = header.palette;
 
     if(image.axes.isEmpty())
     {
@@ -398,7 +527,7 @@ Image get_image(const QByteArray &image_data)
     }
 
     image.data = image_data;
-    image.data_start = image_data.constData() + palette_size + stream.device()->pos();
+    image.data_start = header.data;
 
     if(data_format & trace_x::QT_IMAGE_FORMAT)
     {
@@ -501,6 +630,107 @@ Image get_image(const QByteArray &image_data)
     return image;
 }
 
+QString image_description(const QByteArray &image_data)
+{
+    X_CALL_F;
+
+    image_header_t header;
+
+    if(!read_image_header(image_data, header))
+    {
+        X_ERROR_F("wrong image header: {} bytes", image_data.size());
+
+        return QString();
+    }
+
+    QString description;
+
+    QString unit_type_s = "user type";
+
+    if(header.unit_type != trace_x::T_CUSTOM)
+    {
+        unit_type_s = trace_x::data_type_names[header.unit_type];
+    }
+    else if(header.data_format & trace_x::QT_IMAGE_FORMAT)
+    {
+        unit_type_s = trace_x::data_type_names[trace_x::T_8U];
+    }
+
+    if(header.size.size() == 2)
+    {
+        description = QString(" [%1x%2 ; %3 ; %4 ch] ").arg(header.size[1]).arg(header.size[0]).arg(unit_type_s).arg(header.channels);
+    }
+    else if(header.size.empty())
+    {
+        description = " [empty]";
+    }
+
+    QString message_string = QString::fromLocal8Bit(header.message, int(header.message_size));
+
+    if(!message_string.isEmpty())
+    {
+        description += ": " + message_string;
+    }
+
+    return description;
+}
+
+bool image_message_range(const QByteArray &image_data, qsizetype &offset, qsizetype &size)
+{
+    image_header_t header;
+
+    if(!read_image_header(image_data, header))
+    {
+        return false;
+    }
+
+    offset = header.message - image_data.constData();
+    size = header.message_size;
+
+    return true;
+}
+
+QByteArray convert_legacy_image(const QByteArray &legacy_data)
+{
+    X_CALL_F;
+
+    QDataStream stream(legacy_data);
+
+    QVector<quint64> size;
+    quint64 elem_size;
+    quint32 channels;
+    qint8 unit_type;
+    quint32 data_format;
+    QVector<quint8> band_index;
+    QVector<quint8> axes;
+    quint32 palette_size;
+    quint64 byte_size;
+
+    stream >> size >> elem_size >> channels >> unit_type >> data_format >> band_index >> axes >> palette_size >> byte_size;
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        return QByteArray();
+    }
+
+    QByteArray result;
+
+    append_vector(result, size);
+    append_value(result, elem_size);
+    append_value(result, channels);
+    append_value(result, unit_type);
+    append_value(result, data_format);
+    append_vector(result, band_index);
+    append_vector(result, axes);
+    append_value<quint32>(result, 0); // message text was not stored
+    append_value(result, palette_size);
+    append_value(result, byte_size);
+
+    result.append(legacy_data.mid(int(stream.device()->pos())));
+
+    return result;
+}
+
 void save_image(const Image &image, const QString &save_file_name)
 {
     X_CALL_F;
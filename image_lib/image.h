@@ -4,6 +4,8 @@
 #include <QByteArray>
 #include <QImage>
 #include <QMap>
+#include <QSharedPointer>
+#include <QMetaType>
 
 //! macro for generation template functions
 #define GENERATE_FUNCTION_ACCESS(gn, fp, fn)            \
@@ -23,7 +25,14 @@
     }
 
 
-QByteArray make_image_array(const char *data, QString &description);
+//! Description of image for message text: size, type, channels and message of image
+QString image_description(const QByteArray &image_data);
+
+//! Position of message text in image data. Message isn`t part of image content, so it is skipped by content hash
+bool image_message_range(const QByteArray &image_data, qsizetype &offset, qsizetype &size);
+
+//! Converts image data of trace files before version 2, which was serialized by QDataStream
+QByteArray convert_legacy_image(const QByteArray &legacy_data);
 
 struct Image
 {
@@ -52,9 +61,13 @@ struct Image
     QImage display_image;
     QImage shared_image; //image for data sharing(instead of QByteArray data)
 
+    QSharedPointer<void> data_pin; //keeps zero-copy data buffer valid
+
     int max_width;
 };
 
+Q_DECLARE_METATYPE(Image)
+
 Image get_image(const QByteArray &image_data);
 
 void save_image(const Image &image, const QString &save_file_name);
@@ -18,7 +18,10 @@ ImageBrowser::ImageBrowser(TraceController *controller, QWidget *parent) :
     ui(new Ui::ImageBrowser),
     _data_set(0),
     _current_index(0),
-    _controller(controller)
+    _current_data_index(0),
+    _controller(controller),
+    _direction(1),
+    _image_cache(controller)
 {
     X_CALL;
 
@@ -125,6 +128,9 @@ ImageBrowser::ImageBrowser(TraceController *controller, QWidget *parent) :
 
     connect(ui->next_button, &QToolButton::clicked, this, &ImageBrowser::next_image);
     connect(ui->prev_button, &QToolButton::clicked, this, &ImageBrowser::prev_image);
+
+    connect(_controller, &TraceController::cleaned, &_image_cache, &ImageCache::clear);
+    connect(&_image_cache, &ImageCache::prefetched, this, &ImageBrowser::image_prefetched);
 }
 
 void ImageBrowser::set_image(const Image &image)
@@ -187,9 +193,65 @@ void ImageBrowser::set_current_index(index_t index)
 
     ui->current_index_label->setText(QString("%1 / %2").arg(index + 1).arg(_data_set->size()));
 
-    Image image = ::get_image(_controller->data_at(message));
+    _current_data_index = message->index;
+
+    // image, which is not cached, is decoded by prefetching task first and is shown, when it is ready
+
+    Image image;
+
+    if(_image_cache.find(_current_data_index, image))
+    {
+        set_image(image);
+    }
+
+    prefetch_images();
+}
+
+void ImageBrowser::image_prefetched(quint64 data_index, const Image &image)
+{
+    if(data_index == _current_data_index)
+    {
+        set_image(image);
+    }
+}
+
+void ImageBrowser::prefetch_images()
+{
+    X_CALL;
+
+    if(!_data_set->safe_size())
+    {
+        return;
+    }
+
+    QList<quint64> data_indices;
+
+    // current image is the first one, cached images are skipped by cache
+
+    data_indices.append(_current_data_index);
+
+    index_t index = _current_index;
 
-    set_image(image);
+    size_t count = qMin<size_t>(PrefetchCount, _data_set->safe_size() - 1);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        index = step_index(index, _direction);
+
+        data_indices.append(_data_set->at(index)->index);
+    }
+
+    _image_cache.prefetch(data_indices);
+}
+
+index_t ImageBrowser::step_index(index_t index, int direction) const
+{
+    if(direction > 0)
+    {
+        return (index + 1 < _data_set->safe_size()) ? index + 1 : 0;
+    }
+
+    return (index != 0) ? index - 1 : _data_set->safe_size() - 1;
 }
 
 void ImageBrowser::set_data_set(TraceDataModel *data_set)
@@ -272,28 +334,18 @@ void ImageBrowser::next_image()
 {
     X_CALL;
 
-    if(_current_index + 1 < _data_set->safe_size())
-    {
-        set_current_index(_current_index + 1);
-    }
-    else
-    {
-        set_current_index(0);
-    }
+    _direction = 1;
+
+    set_current_index(step_index(_current_index, _direction));
 }
 
 void ImageBrowser::prev_image()
 {
     X_CALL;
 
-    if(_current_index != 0)
-    {
-        set_current_index(_current_index - 1);
-    }
-    else
-    {
-        set_current_index(_data_set->safe_size() - 1);
-    }
+    _direction = -1;
+
+    set_current_index(step_index(_current_index, _direction));
 }
 
 void ImageBrowser::save_current()
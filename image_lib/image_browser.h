@@ -5,6 +5,7 @@
 #include <QMenuBar>
 #include <QFileDialog>
 
+#include "image_cache.h"
 #include "image_scene.h"
 #include "image_table_model.h"
 #include "pixel_trace_graphics_item.h"
@@ -20,6 +21,11 @@ class ImageBrowser : public QFrame
     Q_OBJECT
 
 public:
+    enum
+    {
+        PrefetchCount = 8 //! number of images, prefetched in browsing direction
+    };
+
     explicit ImageBrowser(TraceController *controller, QWidget *parent = 0);
     ~ImageBrowser();
 
@@ -41,6 +47,13 @@ private slots:
     void set_smooth_upsampling(bool enabled);
     void set_smooth_downsampling(bool enabled);
 
+    void image_prefetched(quint64 data_index, const Image &image);
+
+private:
+    void prefetch_images();
+
+    index_t step_index(index_t index, int direction) const;
+
 private:
     Ui::ImageBrowser *ui;
     QMenuBar *_menu_bar;
@@ -51,6 +64,14 @@ private:
 
     index_t _current_index;
 
+    //! Data index of current message, it`s image is shown, when it is prefetched
+    quint64 _current_data_index;
+
+    //! Browsing direction: 1 - next, -1 - previous
+    int _direction;
+
+    ImageCache _image_cache;
+
     ImageScene _image_scene;
     ImageTableModel _table_model;
     PixelTraceGraphicsItem _pixel_trace_item;
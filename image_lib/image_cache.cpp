@@ -0,0 +1,236 @@
+#include "image_cache.h"
+
+#include "trace_controller.h"
+
+#include "trace_x/trace_x.h"
+
+class PrefetchTask : public QRunnable
+{
+public:
+    PrefetchTask(ImageCache *cache_):
+        cache(cache_)
+    {
+    }
+
+    void run()
+    {
+        cache->prefetch_images();
+    }
+
+    ImageCache *cache;
+};
+
+/* ===================================================================================== */
+
+ImageCache::ImageCache(TraceController *controller, QObject *parent) : QObject(parent),
+    _controller(controller),
+    _budget(DefaultBudget),
+    _size(0),
+    _prefetch_scheduled(false),
+    _generation(0)
+{
+    X_CALL;
+
+    _thread_pool.setMaxThreadCount(1);
+}
+
+ImageCache::~ImageCache()
+{
+    X_CALL;
+
+    {
+        QMutexLocker lock(&_mutex);
+
+        _prefetch_queue.clear();
+    }
+
+    _thread_pool.waitForDone();
+}
+
+bool ImageCache::find(quint64 data_index, Image &image)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    QHash<quint64, entry_t>::const_iterator it = _images.constFind(data_index);
+
+    if(it == _images.constEnd())
+    {
+        return false;
+    }
+
+    image = it->image;
+
+    _lru_list.removeOne(data_index);
+    _lru_list.append(data_index);
+
+    return true;
+}
+
+void ImageCache::prefetch(const QList<quint64> &data_indices)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    // images, requested before, are not needed any more
+
+    _prefetch_queue.clear();
+
+    foreach (quint64 data_index, data_indices)
+    {
+        if(!_images.contains(data_index))
+        {
+            _prefetch_queue.append(data_index);
+        }
+    }
+
+    if(!_prefetch_queue.isEmpty() && !_prefetch_scheduled)
+    {
+        _prefetch_scheduled = true;
+
+        _thread_pool.start(new PrefetchTask(this));
+    }
+}
+
+void ImageCache::set_budget(size_t size)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _budget = size;
+
+    X_VALUE(_budget);
+
+    trim();
+}
+
+void ImageCache::clear()
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _generation++;
+
+    _images.clear();
+    _lru_list.clear();
+    _prefetch_queue.clear();
+
+    _size = 0;
+}
+
+void ImageCache::prefetch_images()
+{
+    X_CALL;
+
+    forever
+    {
+        quint64 data_index;
+        quint64 generation;
+
+        {
+            QMutexLocker lock(&_mutex);
+
+            if(_prefetch_queue.isEmpty())
+            {
+                _prefetch_scheduled = false;
+
+                return;
+            }
+
+            data_index = _prefetch_queue.takeFirst();
+            generation = _generation;
+
+            if(_images.contains(data_index))
+            {
+                continue;
+            }
+        }
+
+        // data is read without pin, so cached image owns it`s data and doesn`t hold swap region
+
+        Image image = ::get_image(_controller->data_by_index(data_index));
+
+        prepare_display(image);
+
+        X_INFO("prefetched image #{}", data_index);
+
+        {
+            QMutexLocker lock(&_mutex);
+
+            if(generation != _generation)
+            {
+                continue;
+            }
+
+            insert_entry(data_index, image);
+        }
+
+        emit prefetched(data_index, image);
+    }
+}
+
+void ImageCache::insert_entry(quint64 data_index, const Image &image)
+{
+    if(!image.data_start || image.data_pin)
+    {
+        // empty images are not cached, pinned images refer to swap file
+
+        return;
+    }
+
+    entry_t &entry = _images[data_index];
+
+    _size -= entry.size;
+
+    entry.image = image;
+    entry.size = image_size(image);
+
+    _size += entry.size;
+
+    _lru_list.removeOne(data_index);
+    _lru_list.append(data_index);
+
+    trim();
+}
+
+void ImageCache::trim()
+{
+    // the most recent image is kept even if it is larger than budget
+
+    while((_size > _budget) && (_lru_list.size() > 1))
+    {
+        quint64 data_index = _lru_list.takeFirst();
+
+        _size -= _images.take(data_index).size;
+    }
+}
+
+void ImageCache::prepare_display(Image &image)
+{
+    // painter converts other formats on each paint
+
+    if(!image.display_image.isNull() && (image.display_image.format() != QImage::Format_ARGB32_Premultiplied))
+    {
+        image.display_image = image.display_image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+}
+
+size_t ImageCache::image_size(const Image &image)
+{
+    size_t size = image.data.size();
+
+    const char *display_bits = reinterpret_cast<const char*>(image.display_image.constBits());
+
+    if((display_bits < image.data.constBegin()) || (display_bits >= image.data.constEnd()))
+    {
+        // display image is converted, so it has own buffer
+
+        size += image.display_image.sizeInBytes();
+    }
+
+    return size + image.shared_image.sizeInBytes();
+}
@@ -0,0 +1,90 @@
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+
+#include "image.h"
+
+class TraceController;
+
+//! LRU cache of decoded images, limited by size in bytes.
+//! Images of requested messages are read, decoded and normalized by background task, so switching to them is not blocked
+//! by swap and gui thread only shows ready images
+class ImageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        DefaultBudget = 256 * 1024 * 1024
+    };
+
+    explicit ImageCache(TraceController *controller, QObject *parent = 0);
+    ~ImageCache();
+
+    //! Returns true and image of data_index, if it is decoded already
+    bool find(quint64 data_index, Image &image);
+
+    //! Replaces queue of prefetched images. Indices are decoded in given order
+    void prefetch(const QList<quint64> &data_indices);
+
+    void set_budget(size_t size);
+
+signals:
+    //! Image is decoded by prefetching task, it is emitted even if image isn`t cached
+    void prefetched(quint64 data_index, const Image &image);
+
+public slots:
+    void clear();
+
+private:
+    struct entry_t
+    {
+        entry_t(): size(0) {}
+
+        Image image;
+        size_t size;
+    };
+
+    void prefetch_images();
+
+    void insert_entry(quint64 data_index, const Image &image);
+    void trim();
+
+    static size_t image_size(const Image &image);
+
+    //! Converts display image to format, which is drawn without conversion
+    static void prepare_display(Image &image);
+
+private:
+    friend class PrefetchTask;
+
+    TraceController *_controller;
+
+    size_t _budget; // bytes
+    size_t _size;   // bytes
+
+    QHash<quint64, entry_t> _images;
+
+    //! Data indices of cached images, least recently used first
+    QList<quint64> _lru_list;
+
+    QList<quint64> _prefetch_queue;
+
+    //! Prefetching task is queued and not finished yet
+    bool _prefetch_scheduled;
+
+    //! Incremented on clear, so images of cleared trace are discarded
+    quint64 _generation;
+
+    QThreadPool _thread_pool;
+
+    QMutex _mutex;
+};
+
+#endif // IMAGE_CACHE_H
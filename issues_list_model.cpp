@@ -1,11 +1,15 @@
 #include "issues_list_model.h"
 
+#include <algorithm>
+
 #include "trace_x/trace_x.h"
 
-#include "trace_model.h"
+#include "frame_scheduler.h"
 
 IssuesListModel::IssuesListModel(QObject *parent):
-    MessageListModel(_data_model = new TraceDataModel, parent)
+    QAbstractListModel(parent),
+    _has_updates(false),
+    _safe_rows(0)
 {
     X_CALL;
 
@@ -23,88 +27,61 @@ IssuesListModel::IssuesListModel(QObject *parent):
     {
         int type = int(_issue_types[i]);
 
+        _issues[type].position = i;
         _issues[type].title_message.type = type;
         _issues[type].title_message.message_text = MessageTypeItem::message_type_name(type);
         _issues[type].color = MessageTypeItem::message_type_color(type);
+    }
 
-        if(i > 0)
-        {
-            _issues[type].prev = &_issues[int(_issue_types[i - 1])];
-        }
+    _offsets.fill(0, _issue_types.size() + 1);
 
-        if(i < _issue_types.size() - 1)
-        {
-            _issues[type].next = &_issues[int(_issue_types[i + 1])];
-        }
-    }
+    connect(&FrameScheduler::instance(), &FrameScheduler::frame, this, &IssuesListModel::check_updates);
 }
 
-IssuesListModel::~IssuesListModel()
+int IssuesListModel::rowCount(const QModelIndex &parent) const
 {
-    delete _data_model;
+    return parent.isValid() ? 0 : _safe_rows;
 }
 
 QVariant IssuesListModel::data(const QModelIndex &index, int role) const
-{    
-    if(index.row() >= int(_data_model->safe_size()))
+{
+    if(index.row() >= _safe_rows)
     {
         return QVariant();
     }
 
+    trace_message_t message = message_at(index.row());
+
     if(role == Qt::DisplayRole)
     {
-        _data_model->lock();
-
-        QString message = _data_model->at(index.row())->message_text;
-
-        _data_model->unlock();
-
-        return message.replace('\n', ' ');
+        return message.message_text.replace('\n', ' ');
     }
 
     if(role == Qt::DecorationRole)
     {
-        _data_model->lock();
-
-        trace_message_t message = *_data_model->at(index.row());
-
-        _data_model->unlock();
-
         if(message.flags == IssueFlag) return _issues[message.type].color;
     }
 
     if(role == Qt::ToolTipRole)
     {
-        _data_model->lock();
-
-        trace_message_t message = *_data_model->at(index.row());
-
-        _data_model->unlock();
+        if(message.flags == IssueFlag) return QString("%1 %2 issues").arg(issues_count(message.type)).arg(message.message_text);
 
-        if(message.flags == IssueFlag) return QString("%1 %2 issues").arg(_issues[message.type].size).arg(message.message_text);
+        return message.message_text;
     }
 
-    return MessageListModel::data(index, role);
+    return QVariant();
 }
 
 Qt::ItemFlags IssuesListModel::flags(const QModelIndex &index) const
 {
-    trace_message_t message;
-
+    if(index.row() >= _safe_rows)
     {
-        QMutexLocker lock(_data_model->mutex());
-
-        if(index.row() >= int(_data_model->size()))
-        {
-            return Qt::NoItemFlags;
-        }
-
-        message = *_data_model->at(index.row());
+        return Qt::NoItemFlags;
     }
 
-    if(message.flags == IssueFlag) return Qt::NoItemFlags;
+    if(message_at(index.row()).flags == IssueFlag) return Qt::NoItemFlags;
 
-    return MessageListModel::flags(index);
+    return QAbstractListModel::flags(index);
 }
 
 void IssuesListModel::append(const trace_message_t *message)
@@ -114,28 +91,22 @@ void IssuesListModel::append(const trace_message_t *message)
     issue_t &issue = _issues[message->type];
 
     // check if message is issue
-    if(!issue.title_message.message_text.isEmpty())
+    if(issue.position < 0)
     {
-        issue.size++;
-
-        if(issue.size == 1)
-        {
-            // append title fake-message for new issue
-            _data_model->insert(&issue.title_message, issue.end);
+        return;
+    }
 
-     //       qDebug() << "append HEADER" << issue.title_message.message_text << issue.end;
+    _mutex.lock();
 
-            issue.inc_shift();
+    issue.messages.append(message);
 
-            issue.start = issue.end;
-        }
+    // title of issue is added with the first message
 
-        _data_model->insert(message, issue.end);
+    shift_offsets(issue.position, (issue.size() == 1) ? 2 : 1);
 
-    //    qDebug() << "append MESSAGE" << issue.title_message.message_text << issue.end;
+    _mutex.unlock();
 
-        issue.inc_shift();
-    }
+    _has_updates = true;
 }
 
 void IssuesListModel::clear()
@@ -144,19 +115,27 @@ void IssuesListModel::clear()
 
     emit layoutAboutToBeChanged();
 
-    _data_model->clear();
+    _mutex.lock();
 
     for(int i = 0; i < _issues.size(); ++i)
     {
         _issues[i].clear();
     }
 
+    _offsets.fill(0);
+
+    _safe_rows = 0;
+
+    _mutex.unlock();
+
     emit layoutChanged();
 }
 
-int IssuesListModel::issues_count(int issue_type)
+int IssuesListModel::issues_count(int issue_type) const
 {
-    return _issues[issue_type].size;
+    QMutexLocker lock(&_mutex);
+
+    return _issues[issue_type].size();
 }
 
 void IssuesListModel::remove_from_tail(index_t index)
@@ -167,80 +146,100 @@ void IssuesListModel::remove_from_tail(index_t index)
     {
         issue_t &issue = _issues[type];
 
-        if(issue.size && (_data_model->at(issue.start)->index == index))
+        if(issue.size() && (issue.messages.at(issue.first)->index == index))
         {
-            issue.size--;
+            issue.first++;
 
-           // qDebug() << "remove" << _data_model->trace_list().at(issue.start)->message_text << issue.title_message.message_text;
+            // title of issue is removed with the last message
 
-            _data_model->trace_list().removeAt(issue.start);
+            shift_offsets(issue.position, issue.size() ? -1 : -2);
 
-            issue.dec_shift();
-
-            if(issue.size == 0)
+            if((issue.first >= DropSize) && (issue.first * 2 >= issue.messages.size()))
             {
-             //   qDebug() << "remove HEADER" << _data_model->trace_list().at(issue.start - 1)->message_text;
-
-                _data_model->trace_list().removeAt(issue.start - 1);
+                issue.messages.remove(0, issue.first);
 
-                issue.dec_shift();
-
-                issue.size = 0;
-                issue.end = 0;
-                issue.start = 0;
+                issue.first = 0;
             }
 
+            _has_updates = true;
+
             return;
         }
     }
 }
 
-IssuesListModel::issue_t::issue_t():
-    start(0),
-    end(0),
-    size(0),
-    next(0),
-    prev(0)
+trace_message_t IssuesListModel::message_at(int row) const
 {
-    title_message.flags = IssueFlag;
+    QMutexLocker lock(&_mutex);
+
+    const issue_t *issue;
+    int message;
+
+    if(!locate(row, issue, message))
+    {
+        return trace_message_t();
+    }
+
+    return (message < 0) ? issue->title_message : *issue->messages.at(issue->first + message);
 }
 
-void IssuesListModel::issue_t::clear()
+void IssuesListModel::emit_updated()
 {
-    size = 0;
-    end = 0;
-    start = 0;
+    _has_updates = true;
 }
 
-void IssuesListModel::issue_t::inc_shift(bool inc_start)
+void IssuesListModel::check_updates()
 {
-    if(inc_start)
+    if(_has_updates.exchange(false))
     {
-        start++;
-    }
+        emit layoutAboutToBeChanged();
 
-    end++;
+        _mutex.lock();
 
-    if(next)
-    {
-        next->inc_shift(true);
+        _safe_rows = _offsets.last();
+
+        _mutex.unlock();
+
+        emit layoutChanged();
     }
 }
 
-void IssuesListModel::issue_t::dec_shift(bool dec_start)
+bool IssuesListModel::locate(int row, const issue_t *&issue, int &message) const
 {
-    if(dec_start && (start > 0))
+    if((row < 0) || (row >= _offsets.last()))
     {
-        start--;
+        return false;
     }
 
-    if(end > 0)
-    {
-        end--;
-    }
+    // the last issue, which starts not after row, is not empty
 
-    if(next)
+    int position = int(std::upper_bound(_offsets.constBegin(), _offsets.constEnd(), row) - _offsets.constBegin()) - 1;
+
+    issue = &_issues.at(int(_issue_types.at(position)));
+
+    message = row - _offsets.at(position) - 1;
+
+    return true;
+}
+
+void IssuesListModel::shift_offsets(int position, int delta)
+{
+    for(int i = position + 1; i < _offsets.size(); ++i)
     {
-        next->dec_shift(true);
+        _offsets[i] += delta;
     }
 }
+
+IssuesListModel::issue_t::issue_t():
+    first(0),
+    position(-1)
+{
+    title_message.flags = IssueFlag;
+}
+
+void IssuesListModel::issue_t::clear()
+{
+    messages = QVector<const trace_message_t*>();
+
+    first = 0;
+}
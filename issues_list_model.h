@@ -1,18 +1,27 @@
 #ifndef ISSUESLISTMODEL_H
 #define ISSUESLISTMODEL_H
 
-#include <QObject>
+#include <QAbstractListModel>
+#include <QVector>
+#include <QColor>
+#include <QMutex>
 
-#include "common_ui_tools.h"
-#include "trace_data_model.h"
+#include <boost/atomic.hpp>
+
+#include "trace_model.h"
 
 //! Модель для хранения списка проблемных сообщений
 //! В модель встроена логика сортировки
-class IssuesListModel : public MessageListModel
+//! Messages of each issue type are kept in own append-only list, rows of "linear" tree (title and messages of each issue)
+//! are found by table of first rows of issues, so message is appended without shift of other issues
+class IssuesListModel : public QAbstractListModel
 {
+    Q_OBJECT
+
 public:
-    IssuesListModel(QObject *parent = 0);
-    ~IssuesListModel();
+    explicit IssuesListModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
 
     QVariant data(const QModelIndex &index, int role) const;
     Qt::ItemFlags flags(const QModelIndex &index) const Q_DECL_OVERRIDE;
@@ -20,16 +29,31 @@ public:
     void append(const trace_message_t *message);
     void clear();
 
-    int issues_count(int issue_type);
+    int issues_count(int issue_type) const;
 
+    //! Called under lock()
     void remove_from_tail(index_t index);
 
-private:
-    TraceDataModel *_data_model; //! data model for messages, grouped by issues ("linear" tree model)
+    //! Message of row, title of issue has IssueFlag
+    trace_message_t message_at(int row) const;
+
+    inline void lock() { _mutex.lock(); }
+    inline void unlock() { _mutex.unlock(); }
+
+    //! Rows are published on the next frame
+    void emit_updated();
 
+    const QVector<trace_x::MessageType> &issue_types() const { return _issue_types; }
+
+private slots:
+    void check_updates();
+
+private:
     enum
     {
         IssueFlag = 100,
+
+        DropSize = 4096 // count of removed messages, which are dropped from the head of issue
     };
 
     struct issue_t
@@ -37,22 +61,41 @@ private:
         issue_t();
 
         void clear();
-        void inc_shift(bool inc_start = false);
-        void dec_shift(bool dec_start = false);
 
-        size_t start; //! start index of issue in data model
-        size_t end; //! end index of issue in data model
-        size_t size; //! issues count
+        inline int size() const { return messages.size() - first; }
+
+        //! Rows of issue in linear tree: title and messages
+        inline int rows() const { return size() ? size() + 1 : 0; }
+
+        //! Messages, which are removed from the head of trace, are skipped by first and dropped in chunks
+        QVector<const trace_message_t*> messages;
+        int first;
+
+        //! Position of issue in _issue_types or -1
+        int position;
 
         trace_message_t title_message;
         QColor color;
-
-        issue_t *prev;
-        issue_t *next;
     };
 
+    //! Finds issue and message (-1 for title) of row
+    bool locate(int row, const issue_t *&issue, int &message) const;
+
+    //! Moves first rows of issues after position
+    void shift_offsets(int position, int delta);
+
+private:
     QVector<issue_t> _issues;
     QVector<trace_x::MessageType> _issue_types;
+
+    //! First row of each issue in order of _issue_types and count of rows at the end
+    QVector<int> _offsets;
+
+    mutable QMutex _mutex;
+
+    boost::atomic<bool> _has_updates;
+
+    int _safe_rows; //! count of rows, published to gui
 };
 
 #endif // ISSUESLISTMODEL_H
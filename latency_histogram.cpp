@@ -0,0 +1,174 @@
+#include "latency_histogram.h"
+
+#include <cmath>
+
+namespace
+{
+
+inline int most_significant_bit(uint64_t value)
+{
+    int bit = 0;
+
+    while(value >>= 1)
+    {
+        bit++;
+    }
+
+    return bit;
+}
+
+}
+
+LatencyHistogram::LatencyHistogram():
+    _offset(0),
+    _total_count(0),
+    _min_value(0),
+    _max_value(0)
+{
+}
+
+int LatencyHistogram::bucket_index(uint64_t value)
+{
+    if(value < SubBuckets)
+    {
+        // linear region
+        return int(value);
+    }
+
+    int exponent = most_significant_bit(value);
+    int shift = exponent - SubBucketBits;
+
+    return (shift + 1) * SubBuckets + int((value >> shift) & (SubBuckets - 1));
+}
+
+uint64_t LatencyHistogram::bucket_lower_bound(int bucket)
+{
+    if(bucket < SubBuckets)
+    {
+        return uint64_t(bucket);
+    }
+
+    int shift = bucket / SubBuckets - 1;
+
+    return uint64_t(SubBuckets + bucket % SubBuckets) << shift;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(int bucket)
+{
+    if(bucket < SubBuckets)
+    {
+        return uint64_t(bucket);
+    }
+
+    int shift = bucket / SubBuckets - 1;
+
+    return bucket_lower_bound(bucket) + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value, quint32 count)
+{
+    if(!count)
+        return;
+
+    int bucket = bucket_index(value);
+
+    if(_counts.isEmpty())
+    {
+        _offset = bucket;
+        _counts.resize(1);
+
+        _min_value = value;
+        _max_value = value;
+    }
+    else
+    {
+        if(bucket < _offset)
+        {
+            _counts.insert(0, _offset - bucket, 0);
+            _offset = bucket;
+        }
+        else if(bucket >= _offset + _counts.size())
+        {
+            _counts.resize(bucket - _offset + 1);
+        }
+
+        _min_value = qMin(_min_value, value);
+        _max_value = qMax(_max_value, value);
+    }
+
+    _counts[bucket - _offset] += count;
+    _total_count += count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if(other.is_empty())
+        return;
+
+    if(is_empty())
+    {
+        *this = other;
+
+        return;
+    }
+
+    int first = qMin(_offset, other._offset);
+    int last = qMax(_offset + _counts.size(), other._offset + other._counts.size());
+
+    if(first < _offset)
+    {
+        _counts.insert(0, _offset - first, 0);
+        _offset = first;
+    }
+
+    if(last > _offset + _counts.size())
+    {
+        _counts.resize(last - _offset);
+    }
+
+    for(int i = 0; i < other._counts.size(); ++i)
+    {
+        _counts[other._offset - _offset + i] += other._counts.at(i);
+    }
+
+    _total_count += other._total_count;
+
+    _min_value = qMin(_min_value, other._min_value);
+    _max_value = qMax(_max_value, other._max_value);
+}
+
+void LatencyHistogram::clear()
+{
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const
+{
+    if(is_empty())
+        return 0;
+
+    quint64 rank = quint64(std::ceil(qBound(0.0, percentile, 100.0) / 100.0 * _total_count));
+
+    rank = qMax(rank, quint64(1));
+
+    quint64 counter = 0;
+
+    for(int i = 0; i < _counts.size(); ++i)
+    {
+        counter += _counts.at(i);
+
+        if(counter >= rank)
+        {
+            // middle of bucket, but not out of recorded range
+
+            int bucket = _offset + i;
+
+            uint64_t lower = bucket_lower_bound(bucket);
+            uint64_t value = lower + (bucket_upper_bound(bucket) - lower) / 2;
+
+            return qBound(_min_value, value, _max_value);
+        }
+    }
+
+    return _max_value;
+}
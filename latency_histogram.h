@@ -0,0 +1,57 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#include <QVector>
+
+//! Log-linear (HDR-like) histogram of durations in nanoseconds.
+//! Each power of two is split into SubBuckets linear buckets, so relative error of percentiles
+//! is bounded by 1 / SubBuckets. Counters are allocated only for range between min and max recorded buckets,
+//! so memory is limited by MaxBuckets counters.
+//! Histograms with equal layout are mergeable by adding counters, that allows building of them by parts
+class LatencyHistogram
+{
+public:
+    enum
+    {
+        SubBucketBits = 4,
+        SubBuckets = 1 << SubBucketBits,
+        MaxBuckets = (64 - SubBucketBits + 1) * SubBuckets
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t value, quint32 count = 1);
+    void merge(const LatencyHistogram &other);
+    void clear();
+
+    inline bool is_empty() const { return !_total_count; }
+    inline quint64 total_count() const { return _total_count; }
+    inline uint64_t min_value() const { return _min_value; }
+    inline uint64_t max_value() const { return _max_value; }
+
+    //! Value at percentile (0 - 100)
+    uint64_t value_at_percentile(double percentile) const;
+
+    //! Range of allocated buckets: [first_bucket(), first_bucket() + bucket_count())
+    inline int first_bucket() const { return _offset; }
+    inline int bucket_count() const { return _counts.size(); }
+
+    inline quint32 count_at(int bucket) const { return _counts.value(bucket - _offset, 0); }
+
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_lower_bound(int bucket);
+    static uint64_t bucket_upper_bound(int bucket);
+
+private:
+    QVector<quint32> _counts;
+    int _offset;
+
+    quint64 _total_count;
+
+    uint64_t _min_value;
+    uint64_t _max_value;
+};
+
+#endif // LATENCY_HISTOGRAM_H
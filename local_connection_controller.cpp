@@ -15,6 +15,9 @@ namespace
 
 static const size_t ShmemSize = 65536000;
 
+//! Size of shared memory for large payloads of one process
+static const size_t BlobShmemSize = 256 * 1024 * 1024;
+
 }
 
 LocalConnectionController::LocalConnectionController(TraceController *trace_controller, const QString &name, QObject *parent):
@@ -22,6 +25,7 @@ LocalConnectionController::LocalConnectionController(TraceController *trace_cont
     _trace_controller(trace_controller),
     _process_model(0),
     _srv_flag(0),
+    _blob_release(0),
     _disconnect_time(0),
     _srv_name(name),
     _drop_buffer(false)
@@ -96,6 +100,13 @@ LocalConnectionController::~LocalConnectionController()
         _filter_index.mutex = 0;
     }
 
+    if(!_blob_shm_name.empty())
+    {
+        // segment is unmapped on destruction of _blob_shm
+
+        boost::interprocess::shared_memory_object::remove(_blob_shm_name.c_str());
+    }
+
     stop_async();
 
     _thread.quit();
@@ -111,7 +122,7 @@ LocalConnectionController::~LocalConnectionController()
     emit connection_closed();
 }
 
-void LocalConnectionController::process_packet(const QByteArray &frame, bool &ack)
+void LocalConnectionController::process_packet(QByteArray &frame, bool &ack)
 {
     X_CALL;
 
@@ -124,6 +135,8 @@ void LocalConnectionController::process_packet(const QByteArray &frame, bool &ac
         raw_message_t *message = new raw_message_t;
 
         message->subtype   = get_value<uint8_t>(frame, offset);
+        message->blob      = 0;
+        message->blob_size = 0;
         message->timestamp = get_value<uint64_t>(frame, offset);
         message->extra_timestamp = get_value<uint64_t>(frame, offset);
         message->tid       = get_value<uint64_t>(frame, offset);
@@ -136,8 +149,44 @@ void LocalConnectionController::process_packet(const QByteArray &frame, bool &ac
 
         X_INFO("new message: subtype = {} ; size = {}; data offset = {}", message->subtype, frame.size(), offset);
 
-        message->data = new char[frame.size() - offset];
-        memcpy(message->data, frame.data() + offset, frame.size() - offset);
+        if(message->subtype & BlobMessageFlag)
+        {
+            // large payload is left in shared memory, it is copied in controller thread, so next frames are not delayed
+
+            message->subtype &= ~BlobMessageFlag;
+
+            blob_handle_t blob = blob_handle_t();
+
+            if(size_t(frame.size()) >= offset + sizeof(blob_handle_t))
+            {
+                size_t handle_offset = frame.size() - sizeof(blob_handle_t);
+
+                blob = get_value<blob_handle_t>(frame, handle_offset);
+
+                frame.chop(sizeof(blob_handle_t));
+            }
+
+            if(_blob_release && blob.size && (blob.size <= _blob_shm.get_size()) && (blob.handle <= _blob_shm.get_size() - blob.size))
+            {
+                message->blob = static_cast<char*>(_blob_shm.get_address_from_handle(blob.handle));
+                message->blob_size = blob.size;
+            }
+            else
+            {
+                // payload is lost, so message is dropped instead of being shown truncated
+
+                X_ERROR("wrong blob: {} : {} bytes", blob.handle, blob.size);
+
+                delete message;
+
+                return;
+            }
+        }
+
+        // frame is taken by message without copying
+
+        message->frame.swap(frame);
+        message->data = message->frame.constData() + offset;
 
         _mutex.lock();
 
@@ -213,6 +262,8 @@ void LocalConnectionController::register_process(uint64_t pid, uint64_t timestam
             ::fchmod(mutex_fd, access.get_permissions());
 #endif
 
+            create_blob_area(access);
+
             _srv_flag = _filter_shm.construct<int8_t>(TxFlagID)(1);
 
             _process_model = _trace_controller->register_process(pid, timestamp, process_name, user_name, _filter_index);
@@ -230,6 +281,68 @@ void LocalConnectionController::register_process(uint64_t pid, uint64_t timestam
     }
 }
 
+void LocalConnectionController::create_blob_area(const boost::interprocess::permissions &access)
+{
+    X_CALL;
+
+    _blob_shm_name = _shm_name + "_blob";
+
+    boost::interprocess::shared_memory_object::remove(_blob_shm_name.c_str());
+
+    try
+    {
+        _blob_shm = boost::interprocess::managed_shared_memory(boost::interprocess::create_only, _blob_shm_name.c_str(), BlobShmemSize, 0, access);
+
+        blob_release_ring_t *release = _blob_shm.construct<blob_release_ring_t>(TxBlobReleaseID)();
+
+        release->head = 0;
+        release->tail = 0;
+
+        _blob_release = release;
+
+        // without this object client sends all payloads through connection
+
+        _filter_shm.construct<uint64_t>(TxBlobAreaID)(BlobShmemSize);
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << "can`t create blob area " << _blob_shm_name << " : " << e.what() << std::endl;
+    }
+}
+
+void LocalConnectionController::read_blob(raw_message_t *message)
+{
+    X_CALL;
+
+    QByteArray frame(message->frame.size() + qsizetype(message->blob_size), Qt::Uninitialized);
+
+    memcpy(frame.data(), message->frame.constData(), message->frame.size());
+    memcpy(frame.data() + message->frame.size(), message->blob, message->blob_size);
+
+    // blob is returned to client, which deallocates it on the next allocation
+
+    uint64_t handle = uint64_t(_blob_shm.get_handle_from_address(message->blob));
+
+    uint64_t head = _blob_release->head.load(boost::memory_order_relaxed);
+
+    if(head - _blob_release->tail.load(boost::memory_order_acquire) < blob_release_ring_t::Capacity)
+    {
+        _blob_release->handles[head % blob_release_ring_t::Capacity] = handle;
+
+        _blob_release->head.store(head + 1, boost::memory_order_release);
+    }
+    else
+    {
+        X_WARNING("blob release ring is full, blob {} is left allocated", handle);
+    }
+
+    message->data = frame.constData() + (message->data - message->frame.constData());
+    message->frame.swap(frame);
+
+    message->blob = 0;
+    message->blob_size = 0;
+}
+
 void LocalConnectionController::controller_thread()
 {
     X_CALL;
@@ -251,9 +364,13 @@ void LocalConnectionController::controller_thread()
             {
                 message = *it;
 
+                if(message->blob)
+                {
+                    read_blob(message);
+                }
+
                 _process_model->append_message(message);
 
-                delete [] message->data;
                 delete message;
             }
 
@@ -5,12 +5,40 @@
 #include <QThread>
 #include <QLinkedList>
 
+#include <boost/atomic.hpp>
 #include <boost/interprocess/managed_shared_memory.hpp>
 
 #include "process_model.h"
 
 class LocalConnection;
 
+//! Out-of-band channel for large payloads.
+//! Client allocates payload in shared memory segment "<filter segment name>_blob", which is announced by
+//! TxBlobAreaID object in filter segment, and sends TRACE_MESSAGE frame with BlobMessageFlag in subtype.
+//! Tail of such frame is replaced by blob_handle_t. Server doesn`t deallocate blobs: handles of copied blobs
+//! are returned through TxBlobReleaseID ring in blob segment and client deallocates them, so offset, which
+//! was never allocated, can`t corrupt the segment
+static const char TxBlobAreaID[] = "TxBlobArea";
+static const char TxBlobReleaseID[] = "TxBlobRelease";
+static const uint8_t BlobMessageFlag = 0x80;
+
+struct blob_handle_t
+{
+    uint64_t handle; //! offset of blob in segment, see managed_shared_memory::get_handle_from_address
+    uint64_t size;
+};
+
+//! Single producer (server) and single consumer (client) ring of handles of copied blobs
+struct blob_release_ring_t
+{
+    enum { Capacity = 4096 };
+
+    boost::atomic<uint64_t> head; //! count of released handles, written by server
+    boost::atomic<uint64_t> tail; //! count of deallocated handles, written by client
+
+    uint64_t handles[Capacity];
+};
+
 //! Класс управления локальным соединением с _одним_ процессом
 //! Занимается первичной обработкой входящих пакетов
 class LocalConnectionController : public QObject
@@ -22,7 +50,8 @@ public:
 
     ~LocalConnectionController();
 
-    void process_packet(const QByteArray &data, bool &ack);
+    //! Trace message takes frame, so it`s data is stored without copying
+    void process_packet(QByteArray &data, bool &ack);
     void stop_async();
     void stop_sync();
 
@@ -34,6 +63,8 @@ signals:
 
 private:
     void register_process(uint64_t pid, uint64_t timestamp, const QString &process_name, const QString &user_name);
+    void create_blob_area(const boost::interprocess::permissions &access);
+    void read_blob(raw_message_t *message);
     void controller_thread();
 
 private:
@@ -49,6 +80,10 @@ private:
     boost::interprocess::managed_shared_memory _filter_shm;
     trace_x::filter_index _filter_index;
 
+    std::string _blob_shm_name;
+    boost::interprocess::managed_shared_memory _blob_shm;
+    blob_release_ring_t *_blob_release;
+
     int8_t *_srv_flag;
 
     QThread _thread;
@@ -11,6 +11,7 @@
 
 #include "settings.h"
 #include "trace_service.h"
+#include "trace_exporter.h"
 
 #include <backward.hpp>
 
@@ -50,6 +51,40 @@ void exit_qt(int)
     QCoreApplication::exit();
 }
 
+int run_export(TraceController &controller)
+{
+    ExportFormat format = export_format_by_name(x_settings().export_option->command_line_value());
+
+    if(format == UnknownFormat)
+    {
+        QTextStream(stderr) << "unknown export format: " << x_settings().export_option->command_line_value() << Qt::endl;
+
+        return 1;
+    }
+
+    QString file_name = x_settings().export_file_option->command_line_value();
+
+    if(file_name.isEmpty())
+    {
+        const char *extensions[] = { "json", "folded", "csv" };
+
+        file_name = QString("%1.%2").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss"), extensions[format]);
+    }
+
+    QTextStream(stdout) << "Exporting trace: " << controller.trace_model().size() << " messages" << Qt::endl;
+
+    if(!::export_trace(format, file_name, &controller, &controller.trace_model()))
+    {
+        QTextStream(stderr) << "export failed" << Qt::endl;
+
+        return 1;
+    }
+
+    QTextStream(stdout) << "Trace exported to: " << QFileInfo(file_name).absoluteFilePath() << Qt::endl;
+
+    return 0;
+}
+
 void init_config()
 {
     QSettings *config;
@@ -100,7 +135,12 @@ void init_config()
     x_settings().memory_limit_option->init_value(1024);
     x_settings().swap_limit_option->init_value(2048);
     x_settings().file_data_limit_option->init_value(10);
+    x_settings().trace_memory_limit_option->init_value(512);
+    x_settings().journal_size_option->init_value(1024);
+    x_settings().journal_time_option->init_value(60);
+    x_settings().journal_count_option->init_value(5);
     x_settings().no_swap_option->init_value(false);
+    x_settings().no_compression_option->init_value(false);
     x_settings().swap_path_option->init_value(QDir::tempPath());
 }
 
@@ -205,6 +245,24 @@ int main(int argc, char *argv[])
 
         TraceService service;
 
+        bool export_mode = x_settings().export_option->is_command_line_set();
+
+        if(export_mode && !x_settings().cl_parser.positionalArguments().isEmpty())
+        {
+            // offline export of saved trace
+
+            if(!service.trace_controller().load_trace(x_settings().cl_parser.positionalArguments().first()))
+            {
+                QTextStream(stderr) << "can`t load trace: " << x_settings().cl_parser.positionalArguments().first() << Qt::endl;
+
+                return 1;
+            }
+
+            service.trace_controller().wait_for_loading();
+
+            return ::run_export(service.trace_controller());
+        }
+
         service.set_server_state(true);
 
         if(service.trace_server().is_started())
@@ -213,6 +271,11 @@ int main(int argc, char *argv[])
 
             int result = app.exec();
 
+            if(export_mode)
+            {
+                result = ::run_export(service.trace_controller());
+            }
+
 //            QTextStream(stdout) << "\n";
 
 //            if(service.trace_controller().trace_model().safe_size())
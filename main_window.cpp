@@ -118,6 +118,7 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->action_session_manager, &QAction::triggered, _session_manager, &SessionManager::show);
     connect(ui->action_save, &QAction::triggered, this, &MainWindow::save_trace);
     connect(ui->action_open, &QAction::triggered, this, &MainWindow::load_trace);
+    connect(ui->action_open_journal, &QAction::triggered, this, &MainWindow::load_last_journal);
     connect(ui->action_settings, &QAction::triggered, &_settings_dialog, &QDialog::exec);
     connect(ui->action_about, &QAction::triggered, &_about_dialog, &QDialog::show);
 
@@ -324,6 +325,22 @@ void MainWindow::load_trace()
     }
 }
 
+void MainWindow::load_last_journal()
+{
+    X_CALL;
+
+    QString file_name = _trace_service.trace_controller().journal().last_journal();
+
+    if(file_name.isEmpty())
+    {
+        X_INFO("journal is not found");
+
+        return;
+    }
+
+    _trace_service.trace_controller().load_trace(file_name);
+}
+
 void MainWindow::show_gui()
 {
     X_CALL;
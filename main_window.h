@@ -53,6 +53,7 @@ private slots:
 
     void save_trace();
     void load_trace();
+    void load_last_journal();
     void show_gui();
 
 private:
@@ -0,0 +1,211 @@
+#include "message_density.h"
+
+#include <algorithm>
+
+#include "trace_x/trace_x.h"
+
+MessageDensity::MessageDensity()
+{
+    X_CALL;
+
+    clear();
+}
+
+void MessageDensity::add(quint64 time, uint8_t type)
+{
+    update(time, type, 1);
+}
+
+void MessageDensity::remove(quint64 time, uint8_t type)
+{
+    update(time, type, -1);
+}
+
+void MessageDensity::add_mark(quint64 time, index_t index)
+{
+    QMutexLocker lock(&_mutex);
+
+    // messages between marks are earlier than time of the previous mark + MarkStep
+
+    if(_marks.isEmpty() || (time >= _marks.last().first + MarkStep))
+    {
+        _marks.append(qMakePair(time, index));
+    }
+}
+
+void MessageDensity::remove_marks(index_t first_index)
+{
+    QMutexLocker lock(&_mutex);
+
+    int removed = int(std::lower_bound(_marks.constBegin(), _marks.constEnd(), first_index,
+                                       [](const QPair<quint64, index_t> &mark, index_t index) { return mark.second < index; }) - _marks.constBegin());
+
+    if(removed)
+    {
+        _marks.remove(0, removed);
+    }
+}
+
+void MessageDensity::find_marks(quint64 time, bool &has_first, index_t &first, bool &has_last, index_t &last) const
+{
+    QMutexLocker lock(&_mutex);
+
+    // messages before mark are earlier than it, so the first message of time is after the last earlier mark
+
+    int i = int(std::lower_bound(_marks.constBegin(), _marks.constEnd(), time,
+                                 [](const QPair<quint64, index_t> &mark, quint64 time) { return mark.first < time; }) - _marks.constBegin());
+
+    has_first = (i > 0);
+    has_last = (i < _marks.size());
+
+    first = has_first ? _marks.at(i - 1).second : 0;
+    last = has_last ? _marks.at(i).second : 0;
+}
+
+void MessageDensity::clear()
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _bucket_width = InitialBucketWidth;
+    _last_time = 0;
+
+    _levels.clear();
+    _marks.clear();
+
+    for(int size = BucketCount; size; size /= 2)
+    {
+        _levels.append(QVector<quint32>(size * TypeCount));
+    }
+}
+
+quint64 MessageDensity::last_time() const
+{
+    QMutexLocker lock(&_mutex);
+
+    return _last_time;
+}
+
+QVector<quint32> MessageDensity::counts(quint64 from, quint64 to, int bucket_count) const
+{
+    QVector<quint32> result(qMax(0, bucket_count) * TypeCount);
+
+    if((to <= from) || (bucket_count <= 0))
+    {
+        return result;
+    }
+
+    QMutexLocker lock(&_mutex);
+
+    quint64 step = (to - from) / bucket_count;
+
+    int level = 0;
+
+    while((level < _levels.size() - 1) && ((_bucket_width << (level + 1)) <= step))
+    {
+        level++;
+    }
+
+    const QVector<quint32> &level_counts = _levels.at(level);
+
+    quint64 width = _bucket_width << level;
+
+    int first = int(from / width);
+    int last = int(qMin<quint64>((to - 1) / width, level_counts.size() / TypeCount - 1));
+
+    for(int i = first; i <= last; ++i)
+    {
+        // bucket of level is counted in requested bucket of it`s middle
+
+        quint64 middle = i * width + width / 2;
+
+        if((middle < from) || (middle >= to))
+        {
+            continue;
+        }
+
+        int bucket = int((middle - from) * bucket_count / (to - from));
+
+        for(int type = 0; type < TypeCount; ++type)
+        {
+            result[bucket * TypeCount + type] += level_counts.at(i * TypeCount + type);
+        }
+    }
+
+    return result;
+}
+
+void MessageDensity::update(quint64 time, uint8_t type, int delta)
+{
+    if(type >= TypeCount)
+    {
+        return;
+    }
+
+    QMutexLocker lock(&_mutex);
+
+    if(delta > 0)
+    {
+        rescale(time);
+
+        _last_time = qMax(_last_time, time);
+    }
+
+    quint64 bucket = qMin<quint64>(time / _bucket_width, BucketCount - 1);
+
+    for(int level = 0; level < _levels.size(); ++level)
+    {
+        _levels[level][int(bucket >> level) * TypeCount + type] += delta;
+    }
+}
+
+void MessageDensity::rescale(quint64 time)
+{
+    if(time < _bucket_width * BucketCount)
+    {
+        return;
+    }
+
+    QVector<quint32> &counts = _levels.first();
+
+    while(time >= _bucket_width * BucketCount)
+    {
+        // pairs of buckets are merged, so the second half of range is free
+
+        _bucket_width *= 2;
+
+        for(int i = 0; i < BucketCount; ++i)
+        {
+            for(int type = 0; type < TypeCount; ++type)
+            {
+                quint32 count = counts.at(i * TypeCount + type);
+
+                counts[i * TypeCount + type] = 0;
+                counts[(i / 2) * TypeCount + type] += count;
+            }
+        }
+    }
+
+    X_INFO("bucket width: {} ns", _bucket_width);
+
+    build_levels();
+}
+
+void MessageDensity::build_levels()
+{
+    for(int level = 1; level < _levels.size(); ++level)
+    {
+        const QVector<quint32> &source = _levels.at(level - 1);
+
+        QVector<quint32> &counts = _levels[level];
+
+        for(int i = 0; i < counts.size(); ++i)
+        {
+            int type = i % TypeCount;
+            int bucket = i / TypeCount;
+
+            counts[i] = source.at((bucket * 2) * TypeCount + type) + source.at((bucket * 2 + 1) * TypeCount + type);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef MESSAGE_DENSITY_H
+#define MESSAGE_DENSITY_H
+
+#include <QVector>
+#include <QMutex>
+
+#include "trace_model.h"
+
+//! Counts of messages per time bucket and message type at several resolutions.
+//! Level 0 has BucketCount buckets, bucket of each next level merges two buckets of the previous one.
+//! If message is later than range of buckets, bucket width is doubled, so levels cover the whole trace.
+//! Rows of trace are in order of arrival and processes have their own time deltas, so time of rows isn`t monotonic,
+//! but it`s running maximum is. Messages, which raise it by MarkStep, are marked, so message of time is found between two marks
+class MessageDensity
+{
+public:
+    enum
+    {
+        BucketCount        = 4096,
+        TypeCount          = trace_x::_MESSAGE_END_,
+        InitialBucketWidth = 1000000, //! ns
+        MarkStep           = 1000000  //! ns
+    };
+
+    MessageDensity();
+
+    //! Time is relative to the start of trace, as it is shown in table
+    void add(quint64 time, uint8_t type);
+    void remove(quint64 time, uint8_t type);
+
+    //! Called for messages in order of rows
+    void add_mark(quint64 time, index_t index);
+
+    //! Drops marks of messages, which are removed from the head of trace
+    void remove_marks(index_t first_index);
+
+    //! The first message, which time isn`t less than time, is in (first, last] of indexes of messages.
+    //! has_first and has_last are false, if range starts from the first message or ends by the last one
+    void find_marks(quint64 time, bool &has_first, index_t &first, bool &has_last, index_t &last) const;
+
+    void clear();
+
+    //! Time of the latest message
+    quint64 last_time() const;
+
+    //! Counts of messages of [from, to) in bucket_count equal buckets, counts[bucket * TypeCount + type].
+    //! Counts are summed from the coarsest level, which has buckets not wider than requested ones, so it takes O(bucket_count)
+    QVector<quint32> counts(quint64 from, quint64 to, int bucket_count) const;
+
+private:
+    void update(quint64 time, uint8_t type, int delta);
+    void rescale(quint64 time);
+    void build_levels();
+
+private:
+    quint64 _bucket_width; // ns, width of bucket of level 0
+    quint64 _last_time;
+
+    //! Counts of each level by bucket and message type
+    QVector<QVector<quint32>> _levels;
+
+    //! Running maximum of time and index of message, which has raised it, time of marks grows by MarkStep at least
+    QVector<QPair<quint64, index_t>> _marks;
+
+    mutable QMutex _mutex;
+};
+
+#endif // MESSAGE_DENSITY_H
@@ -185,7 +185,9 @@ void PanelManager::restore_state(const QByteArray &state_data)
 
     foreach (QAction *action, _menu->actions())
     {
-        action->setChecked(view_states.isEmpty() ? true : view_states[index]);
+        // panels, added after state was saved, are shown
+
+        action->setChecked((index < view_states.size()) ? view_states[index] : true);
 
         _widgets[index]->setVisible(action->isChecked());
 
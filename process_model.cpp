@@ -10,6 +10,7 @@
 
 #include "trace_controller.h"
 #include "data_parser.h"
+#include "image_lib/image.h"
 
 ProcessModel::ProcessModel():
     EntityItem(),
@@ -142,7 +143,7 @@ void ProcessModel::append_message(raw_message_t *message)
 
                 _module_index_hash.insert(message->module, trace_message->module_index);
 
-                X_INFO("new module id: #{} ; [{}][#{}]", message->module, _trace_controller->module_at(trace_message)->text(), trace_message->module_index);
+                X_INFO("new module id: #{} ; [{}][#{}]", message->module, _trace_controller->module_at(trace_message).text(), trace_message->module_index);
             }
             else
             {
@@ -160,7 +161,7 @@ void ProcessModel::append_message(raw_message_t *message)
 
                 _source_index_hash.insert(message->source, trace_message->source_index);
 
-                X_INFO("new source id: #{} ; [{}][#{}]", message->source, _trace_controller->source_at(trace_message)->descriptor().id.toString(), trace_message->source_index);
+                X_INFO("new source id: #{} ; [{}][#{}]", message->source, _trace_controller->source_at(trace_message).descriptor().id.toString(), trace_message->source_index);
             }
             else
             {
@@ -178,7 +179,7 @@ void ProcessModel::append_message(raw_message_t *message)
 
                 _function_index_hash.insert(message->function, trace_message->function_index);
 
-                X_INFO("new function id: #{} ; [{}][#{}]", message->function, _trace_controller->function_at(trace_message)->text(), trace_message->function_index);
+                X_INFO("new function id: #{} ; [{}][#{}]", message->function, _trace_controller->function_at(trace_message).text(), trace_message->function_index);
             }
             else
             {
@@ -265,7 +266,7 @@ void ProcessModel::append_message(raw_message_t *message)
 
             _label_index_hash.insert(label_id, trace_message->label_index);
 
-            X_INFO("new label: #{} ; [{}][#{}]", label_id, _trace_controller->label_item_at(trace_message)->text(), trace_message->label_index);
+            X_INFO("new label: #{} ; [{}][#{}]", label_id, _trace_controller->label_at(trace_message).text(), trace_message->label_index);
         }
         else
         {
@@ -274,7 +275,7 @@ void ProcessModel::append_message(raw_message_t *message)
 
         QString current_text = trace_message->message_text;
 
-        trace_message->message_text = _trace_controller->label_item_at(trace_message)->text();
+        trace_message->message_text = _trace_controller->label_at(trace_message).text();
 
         if(!current_text.isEmpty())
         {
@@ -312,7 +313,32 @@ void ProcessModel::append_message(raw_message_t *message)
         }
     }
 
-    _trace_controller->append(trace_message, !result.first->is_accepted, message->data + offset);
+    QByteArray data;
+    hash128_t data_hash;
+
+    if(result.first->is_accepted && (trace_message->type == trace_x::MESSAGE_IMAGE))
+    {
+        // image is stored as received: frame is adopted and it`s header is dropped in place
+
+        qsizetype data_offset = message->data + offset - message->frame.constData();
+
+        data.swap(message->frame);
+        data.remove(0, data_offset);
+
+        trace_message->message_text += ::image_description(data);
+
+        // data is hashed in connection thread, before lock of trace. Message of image isn`t hashed,
+        // so equal images with other messages are stored once
+
+        qsizetype message_offset = 0;
+        qsizetype message_size = 0;
+
+        ::image_message_range(data, message_offset, message_size);
+
+        data_hash = DataStorage::content_hash(data, message_offset, message_size);
+    }
+
+    _trace_controller->append(trace_message, !result.first->is_accepted, data, data_hash);
 }
 
 QVariant ProcessModel::item_data(int role, int flags) const
@@ -331,12 +357,12 @@ QVariant ProcessModel::item_data(int role, int flags) const
 
             if(flags & FullText)
             {
-                if(_trace_controller->_process_names.size() > 1)
+                if(_trace_controller->_process_name_table.size() > 1)
                 {
                     text += " " % _process_name;
                 }
 
-                if(_trace_controller->_process_users.size() > 1)
+                if(_trace_controller->_process_user_table.size() > 1)
                 {
                     text += " " % _user_name;
                 }
@@ -396,14 +422,14 @@ void ProcessModel::register_index(trace_x::filter_index_t::iterator &it)
 
         descriptor[ProcessIdEntity] = this->descriptor();
 
-        descriptor[ProcessNameEntity] = _trace_controller->process_name_at(this->name_index())->descriptor();
-        descriptor[ProcessUserEntity] = _trace_controller->process_user_at(this->user_index())->descriptor();
-        descriptor[ModuleNameEntity] = _trace_controller->module_at(it->module_index)->descriptor();
-        descriptor[FunctionNameEntity] = _trace_controller->function_at(it->function_index)->descriptor();
-        descriptor[ClassNameEntity] = _trace_controller->class_at(it->function_index)->descriptor();
-        descriptor[SourceNameEntity] = _trace_controller->source_at(it->source_index)->descriptor();
-        descriptor[ThreadIdEntity] = _trace_controller->thread_item_at(it->thread_index)->descriptor();
-        descriptor[ContextIdEntity] = _trace_controller->context_item_at(it->context_index)->descriptor();
+        descriptor[ProcessNameEntity] = _trace_controller->process_name_at(this->name_index()).descriptor();
+        descriptor[ProcessUserEntity] = _trace_controller->process_user_at(this->user_index()).descriptor();
+        descriptor[ModuleNameEntity] = _trace_controller->module_at(it->module_index).descriptor();
+        descriptor[FunctionNameEntity] = _trace_controller->function_at(it->function_index).descriptor();
+        descriptor[ClassNameEntity] = _trace_controller->class_at(it->function_index).descriptor();
+        descriptor[SourceNameEntity] = _trace_controller->source_at(it->source_index).descriptor();
+        descriptor[ThreadIdEntity] = _trace_controller->thread_at(it->thread_index).descriptor();
+        descriptor[ContextIdEntity] = _trace_controller->context_at(it->context_index).descriptor();
         descriptor[MessageTypeEntity] = _trace_controller->message_type_at(it->type)->descriptor();
 
         it->is_accepted = capture_filter->check_filter(descriptor);
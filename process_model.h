@@ -29,7 +29,12 @@ struct raw_message_t
     uint64_t source;
     uint32_t line;
     uint64_t label;
-    char*    data;
+
+    QByteArray  frame; //! received frame, owns data
+    const char* data;  //! message data in frame
+
+    char*    blob;      //! tail of data in shared memory, it is appended to frame before processing
+    uint64_t blob_size;
 };
 
 class TraceController;
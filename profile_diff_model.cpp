@@ -0,0 +1,355 @@
+#include "profile_diff_model.h"
+
+#include <limits>
+
+#include <QHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QColor>
+#include <QHeaderView>
+#include <QSortFilterProxyModel>
+
+#include "trace_x/trace_x.h"
+
+namespace
+{
+enum
+{
+    SortRole = Qt::UserRole + 1720
+};
+
+const quint32 ProfileSummaryMagic = 0x54585046; // "TXPF"
+const quint16 ProfileSummaryVersion = 1;
+
+inline QString nanoseconds_to_string(uint64_t time)
+{
+    return time ? QString::number(time / 1000000000.0, 'f', 6) : "-";
+}
+
+inline QString delta_to_string(qint64 time)
+{
+    return time ? QString::number(time / 1000000000.0, 'f', 6).prepend(time > 0 ? "+" : "") : "-";
+}
+
+}
+
+QDataStream & operator << (QDataStream &out, const function_summary_t &value)
+{
+    out << value.function_name;
+    out << value.source;
+    out << value.calls;
+    out << value.total_time;
+    out << value.max_time;
+    out << value.avg_time;
+    out << value.p99_time;
+
+    return out;
+}
+
+QDataStream & operator >> (QDataStream &in, function_summary_t &value)
+{
+    in >> value.function_name;
+    in >> value.source;
+    in >> value.calls;
+    in >> value.total_time;
+    in >> value.max_time;
+    in >> value.avg_time;
+    in >> value.p99_time;
+
+    return in;
+}
+
+bool save_profile_summary(const QString &file_name, const profile_summary_t &summary)
+{
+    X_CALL_F;
+
+    QFile file(file_name);
+
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        X_ERROR_F("can`t save profile to {}", file_name);
+
+        return false;
+    }
+
+    QDataStream stream(&file);
+
+    stream << ProfileSummaryMagic << ProfileSummaryVersion << quint32(stream.version());
+    stream << summary;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool load_profile_summary(const QString &file_name, profile_summary_t &summary)
+{
+    X_CALL_F;
+
+    QFile file(file_name);
+
+    if(!file.open(QFile::ReadOnly))
+    {
+        X_ERROR_F("can`t load profile from {}", file_name);
+
+        return false;
+    }
+
+    QDataStream stream(&file);
+
+    quint32 magic;
+    quint16 version;
+    quint32 stream_version;
+
+    stream >> magic >> version >> stream_version;
+
+    if((magic != ProfileSummaryMagic) || (version != ProfileSummaryVersion))
+    {
+        X_ERROR_F("{} is not a profile file", file_name);
+
+        return false;
+    }
+
+    stream.setVersion(stream_version);
+
+    stream >> summary;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+/* ===================================================================================== */
+
+ProfileDiffModel::ProfileDiffModel(const profile_summary_t &base, const profile_summary_t &current, QObject *parent):
+    QAbstractTableModel(parent),
+    _base(base),
+    _current(current)
+{
+    X_CALL;
+
+    _header_model.resize(LastColumn);
+
+    _header_model[Function]       = ColumnData(tr("Function"), tr("Function"), "namespace::Class::function_____________");
+    _header_model[Source]         = ColumnData(tr("Source"), tr("Source file"), "source_file.cpp_");
+    _header_model[BaseCalls]      = ColumnData(tr("Base calls"), tr("Number of calls in base profile"), "999999_");
+    _header_model[Calls]          = ColumnData(tr("Calls"), tr("Number of calls"), "999999_");
+    _header_model[DeltaCalls]     = ColumnData(tr("Δ Calls"), tr("Difference of calls number"), "+999999_");
+    _header_model[BaseTotalTime]  = ColumnData(tr("Base total"), tr("Total time in base profile, sec."), "00.00000000_");
+    _header_model[TotalTime]      = ColumnData(tr("Total"), tr("Total time, sec."), "00.00000000_");
+    _header_model[DeltaTotalTime] = ColumnData(tr("Δ Total"), tr("Difference of total time, sec."), "+00.00000000_");
+    _header_model[DeltaAvgTime]   = ColumnData(tr("Δ Avg"), tr("Difference of average time, sec."), "+00.00000000_");
+    _header_model[DeltaP99Time]   = ColumnData(tr("Δ p99"), tr("Difference of 99th percentile of time, sec."), "+00.00000000_");
+    _header_model[TotalChange]    = ColumnData(tr("Change, %"), tr("Relative change of total time, %"), "+0000.000_");
+
+    // hash join by (function name, source)
+
+    QHash<QPair<QString, QString>, int> base_hash;
+
+    base_hash.reserve(_base.size());
+
+    for(int i = 0; i < _base.size(); ++i)
+    {
+        base_hash.insert(qMakePair(_base.at(i).function_name, _base.at(i).source), i);
+    }
+
+    QVector<bool> base_joined(_base.size(), false);
+
+    _diff.reserve(qMax(_base.size(), _current.size()));
+
+    for(int i = 0; i < _current.size(); ++i)
+    {
+        diff_t diff;
+
+        diff.current = i;
+        diff.base = base_hash.value(qMakePair(_current.at(i).function_name, _current.at(i).source), -1);
+
+        if(diff.base != -1)
+        {
+            base_joined[diff.base] = true;
+        }
+
+        _diff.append(diff);
+    }
+
+    // functions, which are not called anymore
+
+    for(int i = 0; i < _base.size(); ++i)
+    {
+        if(!base_joined.at(i))
+        {
+            diff_t diff;
+
+            diff.base = i;
+
+            _diff.append(diff);
+        }
+    }
+}
+
+const function_summary_t &ProfileDiffModel::side(int index, const profile_summary_t &summary) const
+{
+    static const function_summary_t empty_summary;
+
+    return (index != -1) ? summary.at(index) : empty_summary;
+}
+
+int ProfileDiffModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : _diff.size();
+}
+
+int ProfileDiffModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : _header_model.size();
+}
+
+QVariant ProfileDiffModel::data(const QModelIndex &index, int role) const
+{
+    if((role != Qt::DisplayRole) && (role != Qt::ToolTipRole) && (role != Qt::ForegroundRole) && (role != ::SortRole))
+    {
+        return QVariant();
+    }
+
+    const diff_t &diff = _diff.at(index.row());
+
+    const function_summary_t &base = side(diff.base, _base);
+    const function_summary_t &current = side(diff.current, _current);
+
+    const function_summary_t &any = (diff.current != -1) ? current : base;
+
+    switch (index.column())
+    {
+    case Function:
+        return (role == Qt::ForegroundRole) ? QVariant() : QVariant(any.function_name);
+
+    case Source:
+        if(role == Qt::ForegroundRole) return QVariant();
+        return (role == Qt::ToolTipRole) ? any.source : QFileInfo(any.source).fileName();
+
+    case BaseCalls:
+    case Calls:
+        if(role == Qt::ForegroundRole) return QVariant();
+        return quint64(index.column() == Calls ? current.calls : base.calls);
+
+    case BaseTotalTime:
+    case TotalTime:
+    {
+        if(role == Qt::ForegroundRole) return QVariant();
+
+        quint64 time = (index.column() == TotalTime) ? current.total_time : base.total_time;
+
+        if(role == ::SortRole) return time;
+        if(role == Qt::ToolTipRole) return QString::number(time) + " ns";
+
+        return ::nanoseconds_to_string(time);
+    }
+
+    default:
+        break;
+    }
+
+    qint64 delta = 0;
+
+    switch (index.column())
+    {
+    case DeltaCalls:     delta = qint64(current.calls) - qint64(base.calls); break;
+    case DeltaTotalTime: delta = qint64(current.total_time) - qint64(base.total_time); break;
+    case DeltaAvgTime:   delta = qint64(current.avg_time) - qint64(base.avg_time); break;
+    case DeltaP99Time:   delta = qint64(current.p99_time) - qint64(base.p99_time); break;
+    case TotalChange:    delta = qint64(current.total_time) - qint64(base.total_time); break;
+    }
+
+    if(role == Qt::ForegroundRole)
+    {
+        return delta > 0 ? QColor(Qt::red) : (delta < 0 ? QColor(Qt::darkGreen) : QVariant());
+    }
+
+    if(index.column() == DeltaCalls)
+    {
+        return (role == ::SortRole) ? QVariant(delta) : QVariant((delta > 0 ? "+" : "") + QString::number(delta));
+    }
+
+    if(index.column() == TotalChange)
+    {
+        if(diff.base == -1) return (role == ::SortRole) ? QVariant(std::numeric_limits<double>::infinity()) : QVariant(tr("new"));
+        if(diff.current == -1) return (role == ::SortRole) ? QVariant(-100.0) : QVariant(tr("gone"));
+
+        double change = base.total_time ? delta * 100.0 / base.total_time : 0.0;
+
+        return (role == ::SortRole) ? QVariant(change) : QVariant(QString::number(change, 'f', 3).prepend(change > 0 ? "+" : ""));
+    }
+
+    if(role == ::SortRole) return delta;
+    if(role == Qt::ToolTipRole) return QString::number(delta) + " ns";
+
+    return ::delta_to_string(delta);
+}
+
+QVariant ProfileDiffModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role == Qt::TextAlignmentRole)
+    {
+        return Qt::AlignLeft;
+    }
+
+    if(orientation == Qt::Horizontal)
+    {
+        if(role == Qt::DisplayRole)
+        {
+            return _header_model.at(section).text;
+        }
+        else if(role == Qt::ToolTipRole)
+        {
+            return _header_model.at(section).tool_tip;
+        }
+    }
+
+    return QVariant();
+}
+
+QString ProfileDiffModel::column_size_hint(int column) const
+{
+    return _header_model.at(column).width;
+}
+
+//////////////////////
+
+ProfileDiffTable::ProfileDiffTable(const profile_summary_t &base, const profile_summary_t &current, QWidget *parent):
+    TableView(parent)
+{
+    X_CALL;
+
+    setWindowTitle(tr("Profile difference"));
+
+    this->verticalHeader()->setVisible(false);
+
+    this->horizontalHeader()->setStretchLastSection(true);
+    this->horizontalHeader()->setSectionsMovable(true);
+
+    _model = new ProfileDiffModel(base, current, this);
+
+    QSortFilterProxyModel *sort_model = new QSortFilterProxyModel(this);
+
+    sort_model->setSortRole(::SortRole);
+    sort_model->setSourceModel(_model);
+
+    this->setSortingEnabled(true);
+    this->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    this->setModel(sort_model);
+
+    //
+
+    QFontMetrics font_metrics(this->font());
+
+    for(int i = 0; i < _model->columnCount(); ++i)
+        this->setColumnWidth(i, font_metrics.horizontalAdvance(_model->column_size_hint(i)));
+
+    this->verticalHeader()->setDefaultSectionSize(font_metrics.height() + 5);
+
+    // the worst regressions first
+
+    this->sortByColumn(ProfileDiffModel::DeltaTotalTime, Qt::DescendingOrder);
+}
+
+ProfileDiffModel *ProfileDiffTable::model()
+{
+    return _model;
+}
@@ -0,0 +1,112 @@
+#ifndef PROFILE_DIFF_MODEL_H
+#define PROFILE_DIFF_MODEL_H
+
+#include <QObject>
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QDataStream>
+
+#include "base_item_views.h"
+
+//! Profile of function, aggregated over all processes and threads.
+//! Function is identified by full name and source path, because indexes are different between traces
+struct function_summary_t
+{
+    function_summary_t(): calls(0), total_time(0), max_time(0), avg_time(0), p99_time(0) {}
+
+    QString function_name;
+    QString source;
+
+    quint64 calls;
+
+    quint64 total_time;
+    quint64 max_time;
+    quint64 avg_time;
+    quint64 p99_time;
+};
+
+typedef QVector<function_summary_t> profile_summary_t;
+
+QDataStream & operator << (QDataStream &out, const function_summary_t &value);
+QDataStream & operator >> (QDataStream &in, function_summary_t &value);
+
+//! Saves profile summary to file, which can be used as baseline for comparison with other trace
+bool save_profile_summary(const QString &file_name, const profile_summary_t &summary);
+bool load_profile_summary(const QString &file_name, profile_summary_t &summary);
+
+//! Table model of per-function differences between two profiles
+class ProfileDiffModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum TraceColumns
+    {
+        Function = 0,
+        Source,
+        BaseCalls,
+        Calls,
+        DeltaCalls,
+        BaseTotalTime,
+        TotalTime,
+        DeltaTotalTime,
+        DeltaAvgTime,
+        DeltaP99Time,
+        TotalChange,
+
+        LastColumn
+    };
+
+    ProfileDiffModel(const profile_summary_t &base, const profile_summary_t &current, QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+
+    QString column_size_hint(int column) const;
+
+private:
+    struct diff_t
+    {
+        diff_t(): base(-1), current(-1) {}
+
+        int base;
+        int current;
+    };
+
+    struct ColumnData
+    {
+        ColumnData() {}
+        ColumnData(const QString &text_, const QString tool_tip_, const QString &width_):
+            text(text_), tool_tip(tool_tip_), width(width_) {}
+
+        QString text;
+        QString tool_tip;
+        QString width;
+    };
+
+    const function_summary_t &side(int index, const profile_summary_t &summary) const;
+
+private:
+    profile_summary_t _base;
+    profile_summary_t _current;
+
+    QVector<diff_t> _diff;
+
+    QVector<ColumnData> _header_model;
+};
+
+class ProfileDiffTable : public TableView
+{
+public:
+    ProfileDiffTable(const profile_summary_t &base, const profile_summary_t &current, QWidget *parent = 0);
+
+    ProfileDiffModel *model();
+
+private:
+    ProfileDiffModel *_model;
+};
+
+#endif // PROFILE_DIFF_MODEL_H
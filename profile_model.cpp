@@ -11,8 +11,12 @@
 #include <QMenu>
 #include <QScrollBar>
 #include <QActionGroup>
+#include <QContextMenuEvent>
+#include <QFileDialog>
 
 #include "trace_controller.h"
+#include "histogram_widget.h"
+#include "trace_exporter.h"
 
 #include "trace_x/trace_x.h"
 
@@ -40,6 +44,10 @@ struct function_stat
         avg_time(0),
         max_time(0),
         min_time(0),
+        p50_time(0),
+        p90_time(0),
+        p99_time(0),
+        p999_time(0),
         process_rate(0),
         thread_rate(0)
     {
@@ -60,6 +68,16 @@ struct function_stat
         total_time += duration;
 
         avg_time = total_time / call_counter;
+
+        histogram.record(duration);
+    }
+
+    void update_percentiles()
+    {
+        p50_time = histogram.value_at_percentile(50.0);
+        p90_time = histogram.value_at_percentile(90.0);
+        p99_time = histogram.value_at_percentile(99.0);
+        p999_time = histogram.value_at_percentile(99.9);
     }
 
     void update_global_stat(uint64_t process_time, uint64_t thread_time)
@@ -80,8 +98,15 @@ struct function_stat
     uint64_t min_time;
     uint64_t max_time;
 
+    uint64_t p50_time;
+    uint64_t p90_time;
+    uint64_t p99_time;
+    uint64_t p999_time;
+
     double process_rate;
     double thread_rate;
+
+    LatencyHistogram histogram;
 };
 
 struct function_profile_t
@@ -110,6 +135,8 @@ struct function_profile_t
     mutable function_stat exclusive_stat;
     mutable function_stat inclusive_stat;
 
+    mutable DurationTimeline timeline;
+
     mutable int level;
 
     struct ByKey {};
@@ -196,6 +223,10 @@ ProfileModel::ProfileModel(TraceController *controller, TraceDataModel *trace_da
     _header_model[MinTime]     = ColumnData(tr("Min"), tr("Minimum time, sec."), "00.00000000_");
     _header_model[MaxTime]     = ColumnData(tr("Max"), tr("Maximum time, sec."), "00.00000000_");
     _header_model[AvgTime]     = ColumnData(tr("Avg"), tr("Average time, sec."), "00.00000000_");
+    _header_model[P50Time]     = ColumnData(tr("p50"), tr("Median time, sec."), "00.00000000_");
+    _header_model[P90Time]     = ColumnData(tr("p90"), tr("90th percentile of time, sec."), "00.00000000_");
+    _header_model[P99Time]     = ColumnData(tr("p99"), tr("99th percentile of time, sec."), "00.00000000_");
+    _header_model[P999Time]    = ColumnData(tr("p99.9"), tr("99.9th percentile of time, sec."), "00.00000000_");
     _header_model[ProcessRate] = ColumnData(tr("Proc. %"), tr("Process rate, %"), "00.000000000");
     _header_model[ThreadRate]  = ColumnData(tr("Thread, %"), tr("Thread rate, %"), "00.000000000");
 
@@ -205,10 +236,10 @@ ProfileModel::ProfileModel(TraceController *controller, TraceDataModel *trace_da
 
     /// Build profile
 
-    for(size_t i = 0; i < trace_data->size(); ++i)
-    {
-        const trace_message_t *message = trace_data->at(i);
+    // lazy trace is read by chunks, so profiling doesn`t evict cached chunks of view
 
+    trace_data->for_each_message(0, trace_data->size(), [&](size_t, const trace_message_t *message)
+    {
         if((message->type == trace_x::MESSAGE_CALL) || (message->type == trace_x::MESSAGE_RETURN))
         {
             profile_index_t::index<function_profile_t::ByKey>::type::iterator function =
@@ -277,6 +308,8 @@ ProfileModel::ProfileModel(TraceController *controller, TraceDataModel *trace_da
 
                             function->inclusive_stat.update_stat(duration, function->call_counter);
                             function->exclusive_stat.update_stat(exlusive_duration, function->call_counter);
+
+                            function->timeline.record(message->timestamp + _controller->process_at(message).time_delta(), duration);
                         }
                         else
                         {
@@ -301,7 +334,9 @@ ProfileModel::ProfileModel(TraceController *controller, TraceDataModel *trace_da
                 }
             }
         }
-    }
+
+        return true;
+    });
 
     for(auto it = _p->data.begin(); it != _p->data.end(); ++it)
     {
@@ -310,6 +345,9 @@ ProfileModel::ProfileModel(TraceController *controller, TraceDataModel *trace_da
 
         it->exclusive_stat.update_global_stat(process_duration, thread_duration);
         it->inclusive_stat.update_global_stat(process_duration, thread_duration);
+
+        it->exclusive_stat.update_percentiles();
+        it->inclusive_stat.update_percentiles();
     }
 }
 
@@ -347,6 +385,7 @@ QVariant ProfileModel::data(const QModelIndex &index, int role_) const
     case Qt::ForegroundRole:
     case FilterDataRole:
     case ::SortRole:
+    case ExportRole:
         process_role = true;
         break;
     default:
@@ -355,7 +394,7 @@ QVariant ProfileModel::data(const QModelIndex &index, int role_) const
 
     if(process_role)
     {
-        if(role_ == ::SortRole)
+        if((role_ == ::SortRole) || (role_ == ExportRole))
         {
             role = Qt::DisplayRole;
         }
@@ -363,9 +402,9 @@ QVariant ProfileModel::data(const QModelIndex &index, int role_) const
         switch (index.column())
         {
         case Process:  return _controller->process_item_at(_p->data[index.row()].process_index)->item_data(role, EntityItem::OnlyIndex | EntityItem::WithBackColor);
-        case Thread:   return _controller->thread_item_at(_p->data[index.row()].thread_index)->item_data(role, EntityItem::OnlyIndex | EntityItem::WithBackColor);
-        case Module:   return _controller->module_at(_p->data[index.row()].module_index)->item_data(role, EntityItem::WithDecorator);
-        case Function: return _controller->function_at(_p->data[index.row()].function_index)->data(role);
+        case Thread:   return _controller->thread_at(_p->data[index.row()].thread_index).item_data(role, EntityItem::OnlyIndex | EntityItem::WithBackColor);
+        case Module:   return _controller->module_at(_p->data[index.row()].module_index).item_data(role, EntityItem::WithDecorator);
+        case Function: return _controller->function_at(_p->data[index.row()].function_index).data(role);
         }
 
         if((role == Qt::DisplayRole) || (role == Qt::ToolTipRole))
@@ -393,6 +432,10 @@ QVariant ProfileModel::data(const QModelIndex &index, int role_) const
                 case MinTime: time_value = stats->min_time; break;
                 case MaxTime: time_value = stats->max_time; break;
                 case AvgTime: time_value = stats->avg_time; break;
+                case P50Time: time_value = stats->p50_time; break;
+                case P90Time: time_value = stats->p90_time; break;
+                case P99Time: time_value = stats->p99_time; break;
+                case P999Time: time_value = stats->p999_time; break;
                 default: rate = true;
                 }
 
@@ -402,7 +445,7 @@ QVariant ProfileModel::data(const QModelIndex &index, int role_) const
                     {
                         return ::nanoseconds_to_string(time_value);
                     }
-                    else if(role_ == ::SortRole)
+                    else if((role_ == ::SortRole) || (role_ == ExportRole))
                     {
                         return quint64(time_value);
                     }
@@ -425,6 +468,10 @@ QVariant ProfileModel::data(const QModelIndex &index, int role_) const
                     {
                         return rate;
                     }
+                    else if(role_ == ExportRole)
+                    {
+                        return rate * 100.0;
+                    }
                     else
                     {
                         return rate ? QString::number(rate * 100.0, 'f', 3) : "-";
@@ -454,6 +501,15 @@ QVariant ProfileModel::headerData(int section, Qt::Orientation orientation, int
         {
             return _header_model.at(section).tool_tip;
         }
+        else if(role == ExportRole)
+        {
+            if((section >= MinTime) && (section <= TotalTime))
+            {
+                return _header_model.at(section).text + ", ns";
+            }
+
+            return _header_model.at(section).text;
+        }
     }
 
     return QVariant();
@@ -486,6 +542,67 @@ void ProfileModel::set_inclusive_mode(bool is_inclusive)
     emit layoutChanged();
 }
 
+LatencyHistogram ProfileModel::histogram(int row) const
+{
+    return _exclusive_mode ? _p->data[row].exclusive_stat.histogram : _p->data[row].inclusive_stat.histogram;
+}
+
+DurationTimeline ProfileModel::timeline(int row) const
+{
+    return _p->data[row].timeline;
+}
+
+profile_summary_t ProfileModel::function_summary() const
+{
+    X_CALL;
+
+    profile_summary_t summary;
+    QVector<LatencyHistogram> histograms;
+
+    QHash<QPair<QString, QString>, int> summary_hash;
+
+    for(auto it = _p->data.begin(); it != _p->data.end(); ++it)
+    {
+        const function_stat &stats = _exclusive_mode ? it->exclusive_stat : it->inclusive_stat;
+
+        QPair<QString, QString> key(_controller->function_at(it->function_index).descriptor().id.toString(),
+                                    _controller->source_at(it->source_index).descriptor().id.toString());
+
+        int index = summary_hash.value(key, -1);
+
+        if(index == -1)
+        {
+            index = summary.size();
+
+            summary_hash.insert(key, index);
+
+            function_summary_t function;
+
+            function.function_name = key.first;
+            function.source = key.second;
+
+            summary.append(function);
+            histograms.append(LatencyHistogram());
+        }
+
+        function_summary_t &function = summary[index];
+
+        function.calls += it->call_counter;
+        function.total_time += stats.total_time;
+        function.max_time = qMax(function.max_time, quint64(stats.max_time));
+
+        histograms[index].merge(stats.histogram);
+    }
+
+    for(int i = 0; i < summary.size(); ++i)
+    {
+        summary[i].avg_time = summary[i].calls ? summary[i].total_time / summary[i].calls : 0;
+        summary[i].p99_time = histograms[i].value_at_percentile(99.0);
+    }
+
+    return summary;
+}
+
 //////////////////////
 
 ProfilerTable::ProfilerTable(TraceController *controller, TraceDataModel *trace_data, QWidget *parent):
@@ -529,9 +646,9 @@ ProfilerTable::ProfilerTable(TraceController *controller, TraceDataModel *trace_
 
     //
 
-    setColumnHidden(ProfileModel::Process, controller->items_by_class(ProcessIdEntity).size() <= 1);
-    setColumnHidden(ProfileModel::Thread, controller->items_by_class(ThreadIdEntity).size() <= 2);
-    setColumnHidden(ProfileModel::Module, controller->items_by_class(ModuleNameEntity).size() <= 1);
+    setColumnHidden(ProfileModel::Process, controller->entities_by_class(ProcessIdEntity).size() <= 1);
+    setColumnHidden(ProfileModel::Thread, controller->entities_by_class(ThreadIdEntity).size() <= 2);
+    setColumnHidden(ProfileModel::Module, controller->entities_by_class(ModuleNameEntity).size() <= 1);
 
     //
 
@@ -560,6 +677,15 @@ ProfilerTable::ProfilerTable(TraceController *controller, TraceDataModel *trace_
     table_menu->addAction(exclusive_action);
     table_menu->addAction(inclusive_action);
 
+    table_menu->addSeparator();
+
+    table_menu->addAction(tr("Save as Baseline ..."), this, &ProfilerTable::save_baseline);
+    table_menu->addAction(tr("Compare with Baseline ..."), this, &ProfilerTable::compare_with_baseline);
+
+    table_menu->addSeparator();
+
+    table_menu->addAction(tr("Export CSV ..."), this, &ProfilerTable::export_csv);
+
     //
 
     this->sortByColumn(ProfileModel::TotalTime, Qt::DescendingOrder);
@@ -589,6 +715,89 @@ void ProfilerTable::showEvent(QShowEvent *event)
     TableView::showEvent(event);
 }
 
+void ProfilerTable::save_baseline()
+{
+    X_CALL;
+
+    QString file_name = QFileDialog::getSaveFileName(this, tr("Save profile"), QString(), tr("Profile (*.txprofile)"));
+
+    if(!file_name.isEmpty())
+    {
+        save_profile_summary(file_name, _model->function_summary());
+    }
+}
+
+void ProfilerTable::compare_with_baseline()
+{
+    X_CALL;
+
+    QString file_name = QFileDialog::getOpenFileName(this, tr("Open baseline profile"), QString(), tr("Profile (*.txprofile)"));
+
+    profile_summary_t baseline;
+
+    if(!file_name.isEmpty() && load_profile_summary(file_name, baseline))
+    {
+        ProfileDiffTable *diff_table = new ProfileDiffTable(baseline, _model->function_summary());
+
+        Dialog *diff_dialog = new Dialog(diff_table, this->window());
+
+        diff_dialog->setWindowTitle(diff_table->windowTitle() + " : " + QFileInfo(file_name).fileName());
+        diff_dialog->setAttribute(Qt::WA_DeleteOnClose);
+        diff_dialog->resize(this->window()->size());
+        diff_dialog->show();
+    }
+}
+
+void ProfilerTable::export_csv()
+{
+    X_CALL;
+
+    QString file_name = QFileDialog::getSaveFileName(this, tr("Export profile"), QString(), tr("CSV (*.csv)"));
+
+    if(!file_name.isEmpty())
+    {
+        ::export_csv(file_name, _model, ProfileModel::ExportRole);
+    }
+}
+
+int ProfilerTable::source_row(const QModelIndex &index) const
+{
+    if(!index.isValid())
+    {
+        return -1;
+    }
+
+    return static_cast<QSortFilterProxyModel*>(QTableView::model())->mapToSource(index).row();
+}
+
+void ProfilerTable::contextMenuEvent(QContextMenuEvent *event)
+{
+    X_CALL;
+
+    int row = source_row(indexAt(event->pos()));
+
+    if(row != -1)
+    {
+        HistogramWidget *histogram_popup = new HistogramWidget(this);
+
+        histogram_popup->setWindowFlags(Qt::Popup);
+        histogram_popup->setAttribute(Qt::WA_DeleteOnClose);
+
+        histogram_popup->set_histogram(_model->histogram(row),
+                                       _model->index(row, ProfileModel::Function).data(Qt::DisplayRole).toString());
+
+        histogram_popup->resize(histogram_popup->sizeHint());
+        histogram_popup->move(event->globalPos());
+        histogram_popup->show();
+
+        event->accept();
+
+        return;
+    }
+
+    TableView::contextMenuEvent(event);
+}
+
 void ProfilerTable::update_layout()
 {
     QRect geometry(0, 0, _menu_button->sizeHint().width(), horizontalHeader()->height());
@@ -9,6 +9,9 @@
 #include "trace_x/impl/types.h"
 #include "trace_data_model.h"
 #include "common_ui_tools.h"
+#include "latency_histogram.h"
+#include "duration_timeline.h"
+#include "profile_diff_model.h"
 
 struct ProfileModelPrivate;
 
@@ -27,6 +30,10 @@ public:
         MinTime,
         MaxTime,
         AvgTime,
+        P50Time,
+        P90Time,
+        P99Time,
+        P999Time,
         TotalTime,
         ProcessRate,
         ThreadRate,
@@ -34,6 +41,12 @@ public:
         LastColumn
     };
 
+    enum
+    {
+        //! Raw values for export: times in nanoseconds, rates in percents
+        ExportRole = Qt::UserRole + 1701
+    };
+
     ProfileModel(TraceController *controller, TraceDataModel *trace_data, QObject *parent = 0);
     ~ProfileModel();
 
@@ -49,6 +62,15 @@ public:
 
     void set_inclusive_mode(bool is_inclusive);
 
+    //! Duration histogram of function at row, according to current inclusive/exclusive mode
+    LatencyHistogram histogram(int row) const;
+
+    //! Inclusive durations of function at row over time
+    DurationTimeline timeline(int row) const;
+
+    //! Profile aggregated by function name and source, for comparison with other traces
+    profile_summary_t function_summary() const;
+
 protected:
     struct ColumnData
     {
@@ -80,13 +102,21 @@ public:
 
     ~ProfilerTable();
 
+    //! Row of profile model for view index
+    int source_row(const QModelIndex &index) const;
+
 protected:
     void resizeEvent(QResizeEvent *event);
     void showEvent(QShowEvent *event);
+    void contextMenuEvent(QContextMenuEvent *event);
 
 private:
     void update_layout();
 
+    void save_baseline();
+    void compare_with_baseline();
+    void export_csv();
+
 private:
     ProfileModel *_model;
     QToolButton *_menu_button;
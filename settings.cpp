@@ -72,7 +72,15 @@ XSettings::XSettings():
     swap_limit_option      = add_command_line_option("swap_limit", "Data swap file limit, MB.", "size");
     swap_path_option       = add_command_line_option("swap_path", "Data swap path.", "path");
     file_data_limit_option = add_command_line_option("file_limit", "Data size limit in .trace_x file, MB.", "size");
+    trace_memory_limit_option = add_command_line_option("trace_mem_limit", "Memory limit of loaded trace, MB. Larger trace is read on demand.", "size");
+    journal_dir_option     = add_command_line_option("journal", "Capture journal directory. Journal is disabled, if it is empty.", "path");
+    journal_size_option    = add_command_line_option("journal_size", "Journal file rotation size, MB.", "size");
+    journal_time_option    = add_command_line_option("journal_time", "Journal file rotation period, minutes.", "minutes");
+    journal_count_option   = add_command_line_option("journal_count", "Number of kept journal files.", "number");
     no_swap_option         = add_command_line_option("no_swap", "Don`t use data swapping");
+    no_compression_option  = add_command_line_option("no_compress", "Don`t compress data");
+    export_option          = add_command_line_option("export", "Export trace on exit, or trace file from arguments, and exit.", "[chrome] [folded] [csv]");
+    export_file_option     = add_command_line_option("export_file", "Export file name.", "path");
 
     check_option = add_command_line_option("check", "Returns 42. Because we can. ¯\\_(ツ)_/¯");
 }
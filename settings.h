@@ -54,11 +54,19 @@ public:
     SettingsOption *config_name_option;
     SettingsOption *log_dir_option;
     SettingsOption *no_swap_option;
+    SettingsOption *no_compression_option;
     SettingsOption *message_limit_option;
     SettingsOption *memory_limit_option;
     SettingsOption *swap_limit_option;
     SettingsOption *swap_path_option;
     SettingsOption *file_data_limit_option;
+    SettingsOption *trace_memory_limit_option;
+    SettingsOption *journal_dir_option;
+    SettingsOption *journal_size_option;
+    SettingsOption *journal_time_option;
+    SettingsOption *journal_count_option;
+    SettingsOption *export_option;
+    SettingsOption *export_file_option;
 
     SettingsOption *check_option;
 
@@ -0,0 +1,122 @@
+#include "sparkline_widget.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QWheelEvent>
+
+SparklineWidget::SparklineWidget(QWidget *parent) :
+    QWidget(parent),
+    _level(0)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setToolTip(tr("Call rate and p99 of inclusive time. Use mouse wheel to change resolution"));
+}
+
+void SparklineWidget::set_timeline(const DurationTimeline &timeline, const QString &title)
+{
+    _timeline = timeline;
+    _title = title;
+    _level = 0;
+
+    update();
+}
+
+void SparklineWidget::clear()
+{
+    set_timeline(DurationTimeline());
+}
+
+QSize SparklineWidget::sizeHint() const
+{
+    return QSize(400, 4 * fontMetrics().height() + 16);
+}
+
+void SparklineWidget::wheelEvent(QWheelEvent *event)
+{
+    int level = qBound(0, _level + (event->angleDelta().y() < 0 ? 1 : -1), qMax(0, _timeline.level_count() - 1));
+
+    if(level != _level)
+    {
+        _level = level;
+
+        update();
+    }
+
+    event->accept();
+}
+
+void SparklineWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+
+    painter.fillRect(rect(), palette().base());
+
+    int text_h = fontMetrics().height();
+
+    QVector<timeline_bucket_t> buckets = _timeline.buckets(_level);
+
+    double width_sec = _timeline.bucket_width(_level) / 1000000000.0;
+
+    painter.setPen(palette().text().color());
+
+    painter.drawText(rect().adjusted(4, 2, -4, 0), Qt::AlignLeft | Qt::AlignTop, _title);
+    painter.drawText(rect().adjusted(4, 2, -4, 0), Qt::AlignRight | Qt::AlignTop, tr("bucket: %1 sec.").arg(width_sec));
+
+    if(buckets.isEmpty())
+        return;
+
+    QVector<double> rate_values(buckets.size());
+    QVector<double> p99_values(buckets.size());
+
+    for(int i = 0; i < buckets.size(); ++i)
+    {
+        rate_values[i] = buckets.at(i).calls / width_sec;
+        p99_values[i] = buckets.at(i).histogram.value_at_percentile(99.0) / 1000000000.0;
+    }
+
+    QRect chart_rect = rect().adjusted(4, text_h + 4, -4, -4);
+
+    QRect rate_rect = chart_rect.adjusted(0, 0, 0, -chart_rect.height() / 2 - 2);
+    QRect p99_rect = chart_rect.adjusted(0, chart_rect.height() / 2 + 2, 0, 0);
+
+    draw_series(painter, rate_rect, rate_values, Qt::darkBlue, tr("calls/sec"));
+    draw_series(painter, p99_rect, p99_values, Qt::red, tr("p99, sec."));
+}
+
+void SparklineWidget::draw_series(QPainter &painter, const QRect &rect, const QVector<double> &values, const QColor &color, const QString &label)
+{
+    double max_value = 0;
+
+    for(double value : values)
+    {
+        max_value = qMax(max_value, value);
+    }
+
+    double step = values.size() > 1 ? rect.width() / double(values.size() - 1) : 0;
+
+    QPainterPath path;
+
+    for(int i = 0; i < values.size(); ++i)
+    {
+        QPointF point(rect.left() + i * step, rect.bottom() - (max_value ? values.at(i) / max_value * rect.height() : 0));
+
+        if(i == 0)
+        {
+            path.moveTo(point);
+        }
+        else
+        {
+            path.lineTo(point);
+        }
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(color, 1.5));
+    painter.drawPath(path);
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    painter.setPen(palette().text().color());
+    painter.drawText(rect, Qt::AlignRight | Qt::AlignTop, QString("%1 max: %2").arg(label).arg(max_value, 0, 'g', 4));
+}
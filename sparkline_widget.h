@@ -0,0 +1,36 @@
+#ifndef SPARKLINE_WIDGET_H
+#define SPARKLINE_WIDGET_H
+
+#include <QWidget>
+
+#include "duration_timeline.h"
+
+//! Widget for drawing of call rate and p99 duration of one function over time.
+//! Mouse wheel switches resolution level of timeline
+class SparklineWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SparklineWidget(QWidget *parent = 0);
+
+    void set_timeline(const DurationTimeline &timeline, const QString &title = QString());
+    void clear();
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void wheelEvent(QWheelEvent *event);
+
+private:
+    void draw_series(QPainter &painter, const QRect &rect, const QVector<double> &values, const QColor &color, const QString &label);
+
+private:
+    DurationTimeline _timeline;
+    QString _title;
+
+    int _level;
+};
+
+#endif // SPARKLINE_WIDGET_H
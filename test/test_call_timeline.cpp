@@ -0,0 +1,136 @@
+#include <QTest>
+
+#include "trace_viewer/call_timeline.h"
+
+#include <trace_x/trace_x.h>
+
+class Test : public QObject
+{
+    Q_OBJECT
+
+private:
+    //! RETURN keeps time of CALL in extra_timestamp
+    static trace_message_t make_message(index_t index, uint8_t type, function_index_t function_index, quint64 time, quint64 duration = 0, int call_level = 0)
+    {
+        trace_message_t message;
+
+        message.index = index;
+        message.type = type;
+        message.timestamp = time;
+        message.extra_timestamp = time - duration;
+        message.process_index = 0;
+        message.tid_index = 1;
+        message.function_index = function_index;
+        message.call_level = call_level;
+
+        return message;
+    }
+
+    //! Calls of one level: each one takes 100 ns and is followed by gap of 100 ns
+    static void add_calls(CallTimeline &timeline, int count)
+    {
+        for(int i = 0; i < count; ++i)
+        {
+            quint64 end = quint64(i) * 200 + 100;
+
+            trace_message_t call = make_message(i * 2, trace_x::MESSAGE_CALL, 1, end - 100);
+            trace_message_t ret = make_message(i * 2 + 1, trace_x::MESSAGE_RETURN, 1, end, 100);
+
+            timeline.add(end - 100, &call);
+            timeline.add(end, &ret);
+        }
+    }
+
+private slots:
+    void test_spans()
+    {
+        CallTimeline timeline;
+
+        trace_message_t info = make_message(0, trace_x::MESSAGE_INFO, 0, 100);
+
+        timeline.add(100, &info);
+
+        QVERIFY(timeline.lanes().isEmpty());
+
+        // RETURN of the inner call is lost, it`s CALL is dropped with the outer call
+
+        trace_message_t call = make_message(1, trace_x::MESSAGE_CALL, 1, 400);
+        trace_message_t inner = make_message(2, trace_x::MESSAGE_CALL, 2, 500);
+        trace_message_t ret = make_message(3, trace_x::MESSAGE_RETURN, 1, 1000, 600);
+
+        timeline.add(400, &call);
+        timeline.add(500, &inner);
+        timeline.add(1000, &ret);
+
+        QCOMPARE(timeline.lanes().size(), 1);
+        QCOMPARE(timeline.lanes().first().depth_count, 1);
+        QCOMPARE(timeline.lane_of(1), 0);
+        QCOMPARE(timeline.lane_of(2), -1);
+        QCOMPARE(timeline.last_time(), quint64(1000));
+
+        timeline_span_t span;
+
+        QVERIFY(timeline.find(0, 0, 500, span));
+
+        QCOMPARE(span.index, index_t(1));
+        QCOMPARE(span.start, quint64(400));
+        QCOMPARE(span.end, quint64(1000));
+        QCOMPARE(span.function_index, function_index_t(1));
+
+        QVERIFY(!timeline.find(0, 0, 1500, span));
+        QVERIFY(!timeline.find(0, 1, 500, span));
+
+        timeline.clear();
+
+        QVERIFY(timeline.lanes().isEmpty());
+        QCOMPARE(timeline.last_time(), quint64(0));
+    }
+
+    void test_levels()
+    {
+        CallTimeline timeline;
+
+        add_calls(timeline, CallTimeline::MinLevelSize);
+
+        QVector<timeline_span_t> spans = timeline.spans(0, 0, 0, quint64(-1), 0);
+
+        QCOMPARE(spans.size(), int(CallTimeline::MinLevelSize));
+
+        // gaps are shorter than gap of coarse level, so calls are merged into one block
+
+        spans = timeline.spans(0, 0, 0, quint64(-1), CallTimeline::InitialGap);
+
+        QCOMPARE(spans.size(), 1);
+        QVERIFY(spans.first().is_block());
+        QCOMPARE(spans.first().count, quint32(CallTimeline::MinLevelSize));
+        QCOMPARE(spans.first().busy, quint64(CallTimeline::MinLevelSize) * 100);
+        QCOMPARE(spans.first().index, index_t(0));
+
+        // only visible spans are returned
+
+        spans = timeline.spans(0, 0, 1000, 1300, 0);
+
+        QCOMPARE(spans.size(), 2);
+        QCOMPARE(spans.first().start, quint64(1000));
+    }
+
+    void test_remove_before()
+    {
+        CallTimeline timeline;
+
+        add_calls(timeline, CallTimeline::MinLevelSize);
+
+        timeline.remove_before(CallTimeline::MinLevelSize);
+
+        // coarse level is rebuilt and isn`t built for half of calls
+
+        QVector<timeline_span_t> spans = timeline.spans(0, 0, 0, quint64(-1), CallTimeline::InitialGap);
+
+        QCOMPARE(spans.size(), int(CallTimeline::MinLevelSize) / 2);
+        QCOMPARE(spans.first().index, index_t(CallTimeline::MinLevelSize));
+    }
+};
+
+QTEST_MAIN(Test)
+
+#include "test_call_timeline.moc"
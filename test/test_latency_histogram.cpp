@@ -0,0 +1,103 @@
+#include <QTest>
+
+#include "trace_viewer/latency_histogram.h"
+
+class Test : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_bucket_bounds()
+    {
+        QList<uint64_t> values;
+
+        values << 0 << 1 << 15 << 16 << 17 << 100 << 1000 << 123456789 << (uint64_t(1) << 40) << ~uint64_t(0);
+
+        foreach (uint64_t value, values)
+        {
+            int bucket = LatencyHistogram::bucket_index(value);
+
+            QVERIFY(bucket < LatencyHistogram::MaxBuckets);
+
+            uint64_t lower = LatencyHistogram::bucket_lower_bound(bucket);
+            uint64_t upper = LatencyHistogram::bucket_upper_bound(bucket);
+
+            QVERIFY(lower <= value);
+            QVERIFY(value <= upper);
+
+            // relative error is bounded by 1 / SubBuckets
+
+            QVERIFY(upper - lower <= lower / LatencyHistogram::SubBuckets);
+        }
+    }
+
+    void test_empty()
+    {
+        LatencyHistogram histogram;
+
+        QVERIFY(histogram.is_empty());
+        QCOMPARE(histogram.value_at_percentile(50), uint64_t(0));
+        QCOMPARE(histogram.bucket_count(), 0);
+
+        histogram.record(100, 0);
+
+        QVERIFY(histogram.is_empty());
+    }
+
+    void test_percentiles()
+    {
+        LatencyHistogram histogram;
+
+        for(uint64_t value = 1; value <= 100; ++value)
+        {
+            histogram.record(value);
+        }
+
+        QCOMPARE(histogram.total_count(), quint64(100));
+        QCOMPARE(histogram.min_value(), uint64_t(1));
+        QCOMPARE(histogram.max_value(), uint64_t(100));
+
+        QCOMPARE(histogram.value_at_percentile(0), uint64_t(1));
+        QCOMPARE(histogram.value_at_percentile(50), uint64_t(50));
+        QCOMPARE(histogram.value_at_percentile(100), uint64_t(100));
+
+        histogram.clear();
+
+        QVERIFY(histogram.is_empty());
+    }
+
+    void test_merge()
+    {
+        LatencyHistogram full;
+        LatencyHistogram first;
+        LatencyHistogram second;
+
+        for(uint64_t value = 1; value <= 100000; value += 7)
+        {
+            full.record(value);
+
+            (value < 5000 ? second : first).record(value);
+        }
+
+        // buckets of the second histogram are before the first ones, so range of counters grows at the front
+
+        first.merge(second);
+
+        QCOMPARE(first.total_count(), full.total_count());
+        QCOMPARE(first.min_value(), full.min_value());
+        QCOMPARE(first.max_value(), full.max_value());
+        QCOMPARE(first.first_bucket(), full.first_bucket());
+        QCOMPARE(first.bucket_count(), full.bucket_count());
+
+        for(int bucket = full.first_bucket(); bucket < full.first_bucket() + full.bucket_count(); ++bucket)
+        {
+            QCOMPARE(first.count_at(bucket), full.count_at(bucket));
+        }
+
+        QCOMPARE(first.value_at_percentile(99), full.value_at_percentile(99));
+    }
+};
+
+QTEST_MAIN(Test)
+
+#include "test_latency_histogram.moc"
@@ -0,0 +1,111 @@
+#include <QTest>
+
+#include "trace_viewer/message_density.h"
+
+#include <trace_x/trace_x.h>
+
+class Test : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_counts()
+    {
+        MessageDensity density;
+
+        density.add(500000, trace_x::MESSAGE_INFO);
+        density.add(1500000, trace_x::MESSAGE_ERROR);
+        density.add(1600000, trace_x::MESSAGE_ERROR);
+
+        QCOMPARE(density.last_time(), quint64(1600000));
+
+        QVector<quint32> counts = density.counts(0, 4000000, 4);
+
+        QCOMPARE(counts.size(), 4 * int(MessageDensity::TypeCount));
+
+        QCOMPARE(counts[0 * MessageDensity::TypeCount + trace_x::MESSAGE_INFO], quint32(1));
+        QCOMPARE(counts[1 * MessageDensity::TypeCount + trace_x::MESSAGE_ERROR], quint32(2));
+        QCOMPARE(counts[2 * MessageDensity::TypeCount + trace_x::MESSAGE_ERROR], quint32(0));
+
+        density.remove(1500000, trace_x::MESSAGE_ERROR);
+
+        counts = density.counts(0, 4000000, 4);
+
+        QCOMPARE(counts[1 * MessageDensity::TypeCount + trace_x::MESSAGE_ERROR], quint32(1));
+    }
+
+    void test_rescale()
+    {
+        MessageDensity density;
+
+        quint64 range = quint64(MessageDensity::InitialBucketWidth) * MessageDensity::BucketCount;
+
+        density.add(0, trace_x::MESSAGE_INFO);
+        density.add(range / 2, trace_x::MESSAGE_INFO);
+
+        // message after range of buckets doubles their width, counts are kept
+
+        density.add(range + 1, trace_x::MESSAGE_INFO);
+
+        QVector<quint32> counts = density.counts(0, range * 2, 2);
+
+        QCOMPARE(counts[0 * MessageDensity::TypeCount + trace_x::MESSAGE_INFO], quint32(2));
+        QCOMPARE(counts[1 * MessageDensity::TypeCount + trace_x::MESSAGE_INFO], quint32(1));
+    }
+
+    void test_marks()
+    {
+        MessageDensity density;
+
+        // time of rows isn`t monotonic, marks are added, when running maximum grows by MarkStep
+
+        density.add_mark(0, 0);
+        density.add_mark(500000, 1);
+        density.add_mark(2000000, 2);
+        density.add_mark(1500000, 3);
+        density.add_mark(3000000, 4);
+
+        bool has_first, has_last;
+        index_t first, last;
+
+        density.find_marks(1000000, has_first, first, has_last, last);
+
+        QVERIFY(has_first);
+        QVERIFY(has_last);
+        QCOMPARE(first, index_t(0));
+        QCOMPARE(last, index_t(2));
+
+        density.find_marks(0, has_first, first, has_last, last);
+
+        QVERIFY(!has_first);
+        QVERIFY(has_last);
+        QCOMPARE(last, index_t(0));
+
+        density.find_marks(5000000, has_first, first, has_last, last);
+
+        QVERIFY(has_first);
+        QVERIFY(!has_last);
+        QCOMPARE(first, index_t(4));
+
+        // marks of removed messages are dropped
+
+        density.remove_marks(3);
+
+        density.find_marks(1000000, has_first, first, has_last, last);
+
+        QVERIFY(!has_first);
+        QVERIFY(has_last);
+        QCOMPARE(last, index_t(4));
+
+        density.clear();
+
+        density.find_marks(1000000, has_first, first, has_last, last);
+
+        QVERIFY(!has_first);
+        QVERIFY(!has_last);
+    }
+};
+
+QTEST_MAIN(Test)
+
+#include "test_message_density.moc"
@@ -0,0 +1,108 @@
+#include <QTest>
+
+#include "trace_viewer/text_index.h"
+
+class Test : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_find()
+    {
+        TextIndex index;
+
+        index.append("Alpha");
+        index.append("beta");
+        index.append("alphabet");
+
+        QCOMPARE(index.size(), 3);
+        QCOMPARE(index.text(1), QString("beta"));
+        QCOMPARE(index.text(3), QString());
+
+        // search is case insensitive, texts are returned as they are appended
+
+        QCOMPARE(index.find("alpha*", 10), QVector<int>() << 0 << 2);
+        QCOMPARE(index.find("*BET", 10), QVector<int>() << 1 << 2);
+        QCOMPARE(index.find_texts("*ph*", 10), QStringList() << "Alpha" << "alphabet");
+        QCOMPARE(index.find("*a*", 1), QVector<int>() << 0);
+        QVERIFY(index.find("gamma", 10).isEmpty());
+
+        boost::atomic<bool> break_flag(true);
+
+        QVERIFY(index.find("*", 10, &break_flag).isEmpty());
+
+        index.clear();
+
+        QCOMPARE(index.size(), 0);
+        QVERIFY(index.find("*", 10).isEmpty());
+    }
+
+    void test_distinct()
+    {
+        TextIndex index(true);
+
+        index.append("alpha");
+        index.append("alpha");
+        index.append("beta");
+        index.append(QString());
+
+        QCOMPARE(index.size(), 2);
+
+        // text is found, while it has references
+
+        index.remove("alpha");
+
+        QCOMPARE(index.find_texts("*", 10), QStringList() << "alpha" << "beta");
+
+        index.remove("alpha");
+
+        QCOMPARE(index.find_texts("*", 10), QStringList() << "beta");
+        QCOMPARE(index.find("*", 10), QVector<int>() << 1);
+
+        // unknown text is ignored
+
+        index.remove("gamma");
+
+        QCOMPARE(index.find_texts("*", 10), QStringList() << "beta");
+
+        // removed text is appended again as new one
+
+        index.append("alpha");
+
+        QCOMPARE(index.find("alpha", 10), QVector<int>() << 2);
+    }
+
+    void test_compact()
+    {
+        TextIndex index(true);
+
+        const int count = TextIndex::CompactSize * 2;
+
+        for(int i = 0; i < count; ++i)
+        {
+            index.append(QString("text_%1").arg(i));
+        }
+
+        // half of texts is removed, so they are dropped and the rest ones are renumbered
+
+        for(int i = 0; i < TextIndex::CompactSize; ++i)
+        {
+            index.remove(QString("text_%1").arg(i));
+        }
+
+        QCOMPARE(index.size(), int(TextIndex::CompactSize));
+        QCOMPARE(index.text(0), QString("text_%1").arg(TextIndex::CompactSize));
+        QCOMPARE(index.find(QString("text_%1").arg(count - 1), 10), QVector<int>() << count - 1 - TextIndex::CompactSize);
+
+        // references survive compaction
+
+        index.append(QString("text_%1").arg(count - 1));
+        index.remove(QString("text_%1").arg(count - 1));
+
+        QCOMPARE(index.find_texts(QString("text_%1").arg(count - 1), 10), QStringList() << QString("text_%1").arg(count - 1));
+    }
+};
+
+QTEST_MAIN(Test)
+
+#include "test_text_index.moc"
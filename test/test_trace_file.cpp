@@ -0,0 +1,274 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDataStream>
+#include <QFile>
+
+#include "trace_viewer/trace_controller.h"
+#include "trace_viewer/trace_file.h"
+#include "trace_viewer/process_model.h"
+
+#include <trace_x/trace_x.h>
+
+//! Messages of main trace, which are compared after loading
+QVector<trace_message_t> trace_messages(TraceController &controller)
+{
+    QVector<trace_message_t> result;
+
+    TraceDataModel &model = controller.trace_model();
+
+    model.lock();
+
+    model.for_each_message(0, model.size(), [&result](size_t, const trace_message_t *message)
+    {
+        result.append(*message);
+
+        return true;
+    });
+
+    model.unlock();
+
+    return result;
+}
+
+class Test : public QObject
+{
+    Q_OBJECT
+
+private:
+    //! Trace of one process with messages, which take several chunks of file
+    void fill_trace(TraceController &controller, int count)
+    {
+        ProcessModel *process = controller.register_process(1, 0, "test_process", "test_user", trace_x::filter_index());
+
+        controller.register_message_type(trace_x::MESSAGE_INFO);
+
+        for(int i = 0; i < count; ++i)
+        {
+            trace_message_t *message = new trace_message_t;
+
+            message->type = trace_x::MESSAGE_INFO;
+            message->timestamp = quint64(i) * 1000;
+            message->extra_timestamp = 0;
+            message->process_index = process->index();
+            message->tid_index = 0;
+            message->context_index = 0;
+            message->module_index = 0;
+            message->function_index = 0;
+            message->label_index = 0;
+            message->source_index = 0;
+            message->source_line = i;
+            message->call_level = 0;
+            message->message_text = QString("message %1").arg(i);
+            message->flags = 0;
+
+            controller.append(message);
+        }
+    }
+
+    void compare_traces(TraceController &saved, TraceController &loaded)
+    {
+        QVector<trace_message_t> expected = trace_messages(saved);
+        QVector<trace_message_t> actual = trace_messages(loaded);
+
+        QCOMPARE(actual.size(), expected.size());
+
+        for(int i = 0; i < expected.size(); ++i)
+        {
+            QCOMPARE(actual[i].index, expected[i].index);
+            QCOMPARE(actual[i].type, expected[i].type);
+            QCOMPARE(actual[i].timestamp, expected[i].timestamp);
+            QCOMPARE(actual[i].process_index, expected[i].process_index);
+            QCOMPARE(actual[i].source_line, expected[i].source_line);
+            QCOMPARE(actual[i].message_text, expected[i].message_text);
+        }
+
+        QCOMPARE(loaded.process_name_at(&actual.first()).text(), QString("test_process"));
+        QCOMPARE(loaded.process_user_at(&actual.first()).text(), QString("test_user"));
+    }
+
+    //! Trace file of version 1 or 2: compressed entity tables and messages, which follow them
+    void write_legacy_file(const QString &file_name, quint16 version, TraceController &controller)
+    {
+        QFile file(file_name);
+
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+
+        QDataStream file_stream(&file);
+
+        file_stream << version;
+        file_stream << quint32(file_stream.version());
+
+        QByteArray data_array = qUncompress(controller.entity_data());
+
+        QDataStream stream(&data_array, QIODevice::WriteOnly | QIODevice::Append);
+
+        stream.setVersion(file_stream.version());
+
+        QVector<trace_message_t> messages = trace_messages(controller);
+
+        stream << quint32(messages.size());
+
+        foreach (const trace_message_t &message, messages)
+        {
+            stream << message;
+        }
+
+        file_stream << qCompress(data_array);
+    }
+
+private slots:
+    void test_save_load()
+    {
+        QTemporaryDir dir;
+
+        QString file_name = dir.filePath("trace.tx");
+
+        TraceController saved;
+
+        fill_trace(saved, TraceChunkSize * 2 + 100);
+
+        saved.save_trace(file_name);
+
+        TraceController loaded;
+
+        QVERIFY(loaded.load_trace(file_name));
+
+        loaded.wait_for_loading();
+
+        QVERIFY(!loaded.trace_model().is_lazy());
+
+        compare_traces(saved, loaded);
+    }
+
+    void test_save_load_lazy()
+    {
+        QTemporaryDir dir;
+
+        QString file_name = dir.filePath("trace.tx");
+
+        TraceController saved;
+
+        fill_trace(saved, TraceChunkSize * 2 + 100);
+
+        saved.save_trace(file_name);
+
+        // trace doesn`t fit into memory limit, so messages are decoded on demand
+
+        TraceController loaded;
+
+        loaded.set_trace_memory_limit(1);
+
+        QVERIFY(loaded.load_trace(file_name));
+
+        loaded.wait_for_loading();
+
+        QVERIFY(loaded.trace_model().is_lazy());
+
+        compare_traces(saved, loaded);
+    }
+
+    void test_footer()
+    {
+        QTemporaryDir dir;
+
+        QString file_name = dir.filePath("trace.tx");
+
+        TraceController saved;
+
+        fill_trace(saved, TraceChunkSize + 1);
+
+        saved.save_trace(file_name);
+
+        QFile file(file_name);
+
+        QVERIFY(file.open(QFile::ReadOnly));
+
+        QDataStream stream(&file);
+
+        quint16 version;
+        quint32 stream_version;
+        quint64 footer_position;
+
+        stream >> version >> stream_version >> footer_position;
+
+        stream.setVersion(stream_version);
+
+        QCOMPARE(version, TraceFileVersion);
+
+        QVERIFY(file.seek(footer_position));
+
+        trace_footer_t footer;
+
+        stream >> footer;
+
+        // connection message of process is the first one
+
+        QCOMPARE(footer.chunks.size(), 2);
+        QCOMPARE(footer.row_count(), quint64(TraceChunkSize + 2));
+        QCOMPARE(footer.chunks[1].first_row, quint64(TraceChunkSize));
+
+        QVERIFY(file.seek(footer.chunks[1].offset));
+
+        QList<const trace_message_t*> messages = decode_chunk(file.read(footer.chunks[1].size), stream_version);
+
+        QCOMPARE(messages.size(), 2);
+        QCOMPARE(messages.last()->message_text, QString("message %1").arg(TraceChunkSize));
+
+        qDeleteAll(messages);
+    }
+
+    void test_load_legacy()
+    {
+        QTemporaryDir dir;
+
+        TraceController saved;
+
+        fill_trace(saved, 100);
+
+        for(quint16 version = 1; version < 3; ++version)
+        {
+            QString file_name = dir.filePath(QString("trace_%1.tx").arg(version));
+
+            write_legacy_file(file_name, version, saved);
+
+            TraceController loaded;
+
+            QVERIFY(loaded.load_trace(file_name));
+
+            loaded.wait_for_loading();
+
+            compare_traces(saved, loaded);
+        }
+    }
+
+    void test_load_journal_without_index()
+    {
+        QTemporaryDir dir;
+
+        QString file_name = dir.filePath("journal.tx");
+
+        // journal, which was broken before the first checkpoint, has zero position of footer
+
+        QFile file(file_name);
+
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+
+        QDataStream stream(&file);
+
+        stream << TraceFileVersion;
+        stream << quint32(stream.version());
+        stream << quint64(0);
+
+        file.close();
+
+        TraceController loaded;
+
+        QVERIFY(!loaded.load_trace(file_name));
+
+        QCOMPARE(loaded.trace_model().size(), size_t(0));
+    }
+};
+
+QTEST_MAIN(Test)
+
+#include "test_trace_file.moc"
@@ -0,0 +1,281 @@
+#include "text_index.h"
+
+#include <QRegExp>
+#include <QByteArrayMatcher>
+
+#include <algorithm>
+
+#include "trace_x/trace_x.h"
+
+TextIndex::TextIndex(bool is_distinct):
+    _is_distinct(is_distinct),
+    _size(0),
+    _removed(0)
+{
+}
+
+void TextIndex::append(const QString &text)
+{
+    QMutexLocker lock(&_mutex);
+
+    if(_is_distinct)
+    {
+        // empty text isn`t found by search, so it isn`t counted
+
+        if(text.isEmpty())
+        {
+            return;
+        }
+
+        QHash<QString, text_ref_t>::iterator it = _text_ids.find(text);
+
+        if(it != _text_ids.end())
+        {
+            it->refs++;
+
+            return;
+        }
+
+        text_ref_t ref;
+
+        ref.id = _size;
+        ref.refs = 1;
+
+        _text_ids.insert(text, ref);
+    }
+
+    append_text(text);
+}
+
+void TextIndex::remove(const QString &text)
+{
+    QMutexLocker lock(&_mutex);
+
+    QHash<QString, text_ref_t>::iterator it = _text_ids.find(text);
+
+    if((it == _text_ids.end()) || (--it->refs > 0))
+    {
+        return;
+    }
+
+    int id = it->id;
+
+    _text_ids.erase(it);
+
+    // empty text is skipped by search, its bytes are dropped by compaction
+
+    QVector<segment_t>::iterator segment = std::upper_bound(_segments.begin(), _segments.end(), id,
+                                                            [](int id, const segment_t &segment) { return id < segment.first; }) - 1;
+
+    segment->texts[id - segment->first] = QString();
+
+    _removed++;
+
+    if((_removed >= CompactSize) && (_removed * 2 >= _size))
+    {
+        compact();
+    }
+}
+
+void TextIndex::append_text(const QString &text)
+{
+    // sealed segments are shared by snapshots of search, only the last one is detached
+
+    if(_segments.isEmpty() || (_segments.last().data.size() >= SegmentSize))
+    {
+        _segments.append(segment_t());
+
+        _segments.last().first = _size;
+    }
+
+    segment_t &segment = _segments.last();
+
+    segment.data.append(text.toLower().toUtf8());
+    segment.ends.append(segment.data.size());
+    segment.data.append('\0');
+
+    segment.texts.append(text);
+
+    _size++;
+}
+
+void TextIndex::compact()
+{
+    X_CALL;
+
+    QVector<segment_t> segments;
+
+    segments.swap(_segments);
+
+    _size = 0;
+    _removed = 0;
+
+    foreach (const segment_t &segment, segments)
+    {
+        foreach (const QString &text, segment.texts)
+        {
+            if(!text.isEmpty())
+            {
+                _text_ids[text].id = _size;
+
+                append_text(text);
+            }
+        }
+    }
+}
+
+void TextIndex::clear()
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _segments = QVector<segment_t>();
+    _text_ids = QHash<QString, text_ref_t>();
+
+    _size = 0;
+    _removed = 0;
+}
+
+int TextIndex::size() const
+{
+    QMutexLocker lock(&_mutex);
+
+    return _size;
+}
+
+QString TextIndex::text(int index) const
+{
+    QMutexLocker lock(&_mutex);
+
+    QVector<segment_t>::const_iterator it = std::upper_bound(_segments.constBegin(), _segments.constEnd(), index,
+                                                             [](int index, const segment_t &segment) { return index < segment.first; });
+
+    if((it == _segments.constBegin()) || (index < 0) || (index >= _size))
+    {
+        return QString();
+    }
+
+    --it;
+
+    return it->texts.at(index - it->first);
+}
+
+QVector<int> TextIndex::find(const QString &pattern, int limit, const boost::atomic<bool> *break_flag) const
+{
+    QVector<int> result;
+
+    search(pattern, limit, break_flag, &result, 0);
+
+    return result;
+}
+
+QStringList TextIndex::find_texts(const QString &pattern, int limit, const boost::atomic<bool> *break_flag) const
+{
+    QStringList result;
+
+    search(pattern, limit, break_flag, 0, &result);
+
+    return result;
+}
+
+void TextIndex::search(const QString &pattern, int limit, const boost::atomic<bool> *break_flag, QVector<int> *indexes, QStringList *texts) const
+{
+    X_CALL;
+
+    QVector<segment_t> segments;
+
+    {
+        QMutexLocker lock(&_mutex);
+
+        segments = _segments;
+    }
+
+    QRegExp regexp(pattern, Qt::CaseInsensitive, QRegExp::Wildcard);
+
+    QByteArray literal = literal_part(pattern).toLower().toUtf8();
+
+    QByteArrayMatcher matcher(literal);
+
+    int count = 0;
+
+    foreach (const segment_t &segment, segments)
+    {
+        int from = 0;
+
+        while((count < limit) && (from < segment.data.size()))
+        {
+            if(break_flag && *break_flag)
+            {
+                return;
+            }
+
+            int position = literal.isEmpty() ? from : matcher.indexIn(segment.data, from);
+
+            if(position < 0)
+            {
+                break;
+            }
+
+            // literal has no zeros, so it is found inside of one text
+
+            int i = int(std::upper_bound(segment.ends.constBegin(), segment.ends.constEnd(), position) - segment.ends.constBegin());
+
+            if(i >= segment.ends.size())
+            {
+                break;
+            }
+
+            const QString &text = segment.texts.at(i);
+
+            if(!text.isEmpty() && (regexp.indexIn(text) != -1))
+            {
+                if(indexes) indexes->append(segment.first + i);
+                if(texts) texts->append(text);
+
+                count++;
+            }
+
+            from = segment.ends.at(i) + 1;
+        }
+    }
+}
+
+QString TextIndex::literal_part(const QString &pattern)
+{
+    QString result;
+    QString part;
+
+    for(int i = 0; i < pattern.size(); ++i)
+    {
+        QChar c = pattern.at(i);
+
+        if((c != '*') && (c != '?') && (c != '['))
+        {
+            part += c;
+
+            continue;
+        }
+
+        if(part.size() > result.size())
+        {
+            result = part;
+        }
+
+        part.clear();
+
+        if(c == '[')
+        {
+            // set of characters is skipped, pattern without end of set is cut
+
+            i = pattern.indexOf(']', i + 1);
+
+            if(i < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    return (part.size() > result.size()) ? part : result;
+}
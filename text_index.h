@@ -0,0 +1,98 @@
+#ifndef TEXT_INDEX_H
+#define TEXT_INDEX_H
+
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QMutex>
+
+#include <boost/atomic.hpp>
+
+//! Texts with search by wildcard pattern of completer. Texts are kept in segments of lower case text, search looks for
+//! the longest literal part of pattern by QByteArrayMatcher and checks only found texts by pattern, so completer scans
+//! compact text instead of items or messages. Search takes snapshot of segments, so it doesn`t block adding of texts.
+//! Distinct index counts references of texts, removed texts are skipped by search and dropped by compaction
+class TextIndex
+{
+public:
+    enum
+    {
+        SegmentSize = 1024 * 1024, // bytes of text of segment
+
+        CompactSize = 4096 // least count of removed texts, which are dropped by compaction
+    };
+
+    //! Distinct index keeps each text once
+    explicit TextIndex(bool is_distinct = false);
+
+    //! Appends text, distinct index counts reference of known one
+    void append(const QString &text);
+
+    //! Releases reference of text of distinct index, text without references isn`t found anymore.
+    //! Compaction renumbers texts, so indexes of find() are valid only until the next remove()
+    void remove(const QString &text);
+
+    void clear();
+
+    int size() const;
+
+    QString text(int index) const;
+
+    //! Indexes of texts, which match wildcard pattern (case insensitive), in order of adding.
+    //! Search is stopped after limit of texts or by break flag
+    QVector<int> find(const QString &pattern, int limit, const boost::atomic<bool> *break_flag = 0) const;
+
+    //! Texts, which match wildcard pattern, they are taken from the same snapshot as found indexes
+    QStringList find_texts(const QString &pattern, int limit, const boost::atomic<bool> *break_flag = 0) const;
+
+private:
+    struct segment_t
+    {
+        segment_t(): first(0) {}
+
+        //! Lower case texts in UTF-8, each one is ended by zero
+        QByteArray data;
+
+        //! Position of zero after each text
+        QVector<int> ends;
+
+        QVector<QString> texts;
+
+        //! Index of the first text of segment
+        int first;
+    };
+
+    //! The longest part of pattern without wildcards, all matched texts contain it
+    static QString literal_part(const QString &pattern);
+
+    void search(const QString &pattern, int limit, const boost::atomic<bool> *break_flag, QVector<int> *indexes, QStringList *texts) const;
+
+    //! Appends text to the last segment, called under lock
+    void append_text(const QString &text);
+
+    //! Rebuilds segments from texts with references, called under lock
+    void compact();
+
+private:
+    struct text_ref_t
+    {
+        int id;
+        int refs;
+    };
+
+private:
+    bool _is_distinct;
+
+    QVector<segment_t> _segments;
+
+    QHash<QString, text_ref_t> _text_ids;
+
+    int _size;
+    int _removed; //! count of texts without references
+
+    mutable QMutex _mutex;
+};
+
+#endif // TEXT_INDEX_H
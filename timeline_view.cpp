@@ -0,0 +1,561 @@
+#include "timeline_view.h"
+
+#include <QPainter>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
+
+#include "trace_controller.h"
+#include "settings.h"
+
+#include "trace_x/trace_x.h"
+
+namespace
+{
+
+QColor function_color(function_index_t index)
+{
+    return QColor::fromHsv(int(index * 47 % 360), 70, 235);
+}
+
+QString duration_text(quint64 duration)
+{
+    return QString::number(duration / 1000000000.0, 'f', 6) + " sec.";
+}
+
+}
+
+TimelineView::TimelineView(QWidget *parent) :
+    QAbstractScrollArea(parent),
+    _controller(0),
+    _from(0),
+    _scale(1),
+    _is_fitted(true),
+    _is_scrolling(false),
+    _press_from(0),
+    _is_dragged(false),
+    _has_current(false),
+    _current_lane(-1),
+    _current_depth(-1),
+    _current_time(0)
+{
+    X_CALL;
+
+    setFrameStyle(QFrame::NoFrame);
+    setWindowTitle(tr("Timeline"));
+
+    horizontalScrollBar()->setRange(0, 0);
+    verticalScrollBar()->setRange(0, 0);
+}
+
+void TimelineView::set_controller(TraceController *controller)
+{
+    X_CALL;
+
+    _controller = controller;
+
+    clear();
+}
+
+void TimelineView::set_current(const trace_message_t *message)
+{
+    X_CALL;
+
+    if(!message || !_controller)
+    {
+        _has_current = false;
+
+        viewport()->update();
+
+        return;
+    }
+
+    _lanes = _controller->timeline().lanes();
+
+    _has_current = true;
+
+    _current_time = _controller->message_time(message);
+    _current_lane = _controller->timeline().lane_of(message->tid_index);
+
+    // message inside of call is on the next level after it
+
+    bool is_call = (message->type == trace_x::MESSAGE_CALL) || (message->type == trace_x::MESSAGE_RETURN);
+
+    _current_depth = is_call ? message->call_level : message->call_level - 1;
+
+    if(!_is_fitted && ((_current_time < _from) || (_current_time > time_at(viewport()->width()))))
+    {
+        quint64 half = quint64(chart_width() * _scale / 2);
+
+        _from = (_current_time > half) ? _current_time - half : 0;
+    }
+
+    update_scrollbars();
+
+    if(_current_lane != -1)
+    {
+        int top = 0;
+
+        for(int i = 0; i < _current_lane; ++i)
+        {
+            top += lane_height(_lanes.at(i));
+        }
+
+        int row_top = top + qMax(0, _current_depth) * row_height();
+
+        if((row_top < verticalScrollBar()->value()) || (row_top + row_height() > verticalScrollBar()->value() + viewport()->height()))
+        {
+            verticalScrollBar()->setValue(row_top - viewport()->height() / 2);
+        }
+    }
+
+    viewport()->update();
+}
+
+void TimelineView::clear()
+{
+    X_CALL;
+
+    _lanes.clear();
+
+    _has_current = false;
+    _current_lane = -1;
+
+    _from = 0;
+    _scale = 1;
+    _is_fitted = true;
+
+    refresh();
+}
+
+void TimelineView::refresh()
+{
+    if(!_controller || !isVisible())
+    {
+        return;
+    }
+
+    _lanes = _controller->timeline().lanes();
+
+    if(_is_fitted)
+    {
+        fit();
+    }
+    else
+    {
+        update_scrollbars();
+
+        viewport()->update();
+    }
+}
+
+void TimelineView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(viewport());
+
+    painter.fillRect(viewport()->rect(), palette().base());
+
+    if(!_controller)
+    {
+        return;
+    }
+
+    int top = -verticalScrollBar()->value();
+
+    for(int i = 0; (i < _lanes.size()) && (top < viewport()->height()); ++i)
+    {
+        int height = lane_height(_lanes.at(i));
+
+        if(top + height > 0)
+        {
+            draw_lane(painter, i, _lanes.at(i), top);
+        }
+
+        top += height;
+    }
+
+    if(_has_current)
+    {
+        int x = int(x_of(_current_time));
+
+        if(x >= LabelWidth)
+        {
+            painter.setPen(x_settings().main_color);
+            painter.drawLine(x, 0, x, viewport()->height());
+        }
+    }
+}
+
+void TimelineView::draw_lane(QPainter &painter, int lane_index, const timeline_lane_t &lane, int top)
+{
+    const CallTimeline &timeline = _controller->timeline();
+
+    int row_h = row_height();
+    int height = lane_height(lane) - LaneSpacing;
+
+    // label
+
+    painter.fillRect(0, top, LabelWidth, height, palette().alternateBase());
+
+    QString label = QString("%1 : %2").arg(_controller->process_item_at(lane.process_index)->text(), _controller->thread_at(lane.tid_index).text());
+
+    painter.setPen(palette().text().color());
+    painter.drawText(QRect(4, top, LabelWidth - 8, row_h), Qt::AlignLeft | Qt::AlignVCenter, fontMetrics().elidedText(label, Qt::ElideMiddle, LabelWidth - 8));
+
+    // calls
+
+    painter.setClipRect(LabelWidth, top, chart_width(), height);
+
+    quint64 from = _from;
+    quint64 to = time_at(viewport()->width()) + 1;
+
+    quint64 resolution = quint64(_scale);
+
+    for(int depth = 0; depth < lane.depth_count; ++depth)
+    {
+        int y = top + depth * row_h;
+
+        if((y + row_h < 0) || (y > viewport()->height()))
+        {
+            continue;
+        }
+
+        QVector<timeline_span_t> spans = timeline.spans(lane_index, depth, from, to, resolution);
+
+        foreach (const timeline_span_t &span, spans)
+        {
+            int x1 = int(qMax(x_of(span.start), double(LabelWidth - 1)));
+            int x2 = int(qMin(x_of(span.end), double(viewport()->width() + 1)));
+
+            QRect rect(x1, y + 1, qMax(1, x2 - x1), row_h - 2);
+
+            if(span.is_block())
+            {
+                // block of short calls is drawn by density of them
+
+                QColor color = palette().text().color();
+
+                color.setAlpha(40 + int(180 * span.busy / qMax<quint64>(1, span.end - span.start)));
+
+                painter.fillRect(rect, color);
+            }
+            else
+            {
+                painter.fillRect(rect, function_color(span.function_index));
+
+                if(rect.width() >= MinTextWidth)
+                {
+                    QString name = _controller->function_at(span.function_index).text();
+
+                    painter.setPen(Qt::black);
+                    painter.drawText(rect.adjusted(2, 0, -2, 0), Qt::AlignLeft | Qt::AlignVCenter, fontMetrics().elidedText(name, Qt::ElideRight, rect.width() - 4));
+                }
+            }
+        }
+
+        timeline_span_t current;
+
+        if(_has_current && (lane_index == _current_lane) && (depth == _current_depth) && timeline.find(lane_index, depth, _current_time, current))
+        {
+            int x1 = int(qMax(x_of(current.start), double(LabelWidth - 1)));
+            int x2 = int(qMin(x_of(current.end), double(viewport()->width() + 1)));
+
+            painter.setPen(QPen(x_settings().main_color, 2));
+            painter.setBrush(Qt::NoBrush);
+            painter.drawRect(x1, y + 1, qMax(1, x2 - x1), row_h - 2);
+        }
+    }
+
+    painter.setClipping(false);
+
+    painter.setPen(palette().mid().color());
+    painter.drawLine(0, top + height + LaneSpacing / 2, viewport()->width(), top + height + LaneSpacing / 2);
+}
+
+void TimelineView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+
+    refresh();
+}
+
+void TimelineView::showEvent(QShowEvent *event)
+{
+    QAbstractScrollArea::showEvent(event);
+
+    // view isn`t refreshed while it is hidden
+
+    refresh();
+}
+
+void TimelineView::wheelEvent(QWheelEvent *event)
+{
+    if(event->modifiers() & Qt::ControlModifier)
+    {
+        zoom((event->angleDelta().y() > 0) ? 0.8 : 1.25, int(event->position().x()));
+
+        event->accept();
+    }
+    else
+    {
+        QAbstractScrollArea::wheelEvent(event);
+    }
+}
+
+void TimelineView::mousePressEvent(QMouseEvent *event)
+{
+    _press_pos = event->pos();
+    _press_from = _from;
+    _is_dragged = false;
+
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void TimelineView::mouseMoveEvent(QMouseEvent *event)
+{
+    if(event->buttons() & Qt::LeftButton)
+    {
+        int dx = event->pos().x() - _press_pos.x();
+
+        if(!_is_dragged && ((event->pos() - _press_pos).manhattanLength() > DragThreshold))
+        {
+            _is_dragged = true;
+
+            viewport()->setCursor(Qt::ClosedHandCursor);
+        }
+
+        if(_is_dragged)
+        {
+            double from = double(_press_from) - dx * _scale;
+
+            _from = quint64(qMax(0.0, from));
+            _is_fitted = false;
+
+            update_scrollbars();
+
+            viewport()->update();
+        }
+    }
+
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void TimelineView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if(_is_dragged)
+    {
+        _is_dragged = false;
+
+        viewport()->unsetCursor();
+    }
+    else if(event->button() == Qt::LeftButton)
+    {
+        timeline_span_t span;
+
+        if(span_at(event->pos(), span))
+        {
+            emit message_selected(span.index);
+        }
+    }
+
+    QAbstractScrollArea::mouseReleaseEvent(event);
+}
+
+void TimelineView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    timeline_span_t span;
+
+    if(span_at(event->pos(), span))
+    {
+        show_range(span.start, span.end);
+    }
+    else
+    {
+        fit();
+    }
+}
+
+bool TimelineView::viewportEvent(QEvent *event)
+{
+    if(event->type() == QEvent::ToolTip)
+    {
+        QHelpEvent *help_event = static_cast<QHelpEvent*>(event);
+
+        timeline_span_t span;
+
+        if(span_at(help_event->pos(), span))
+        {
+            QString text;
+
+            if(span.is_block())
+            {
+                text = tr("%1 calls\nbusy: %2\nrange: %3").arg(span.count).arg(duration_text(span.busy), duration_text(span.end - span.start));
+            }
+            else
+            {
+                text = tr("%1\n%2").arg(_controller->function_at(span.function_index).text(), duration_text(span.end - span.start));
+            }
+
+            QToolTip::showText(help_event->globalPos(), text, viewport());
+        }
+        else
+        {
+            QToolTip::hideText();
+        }
+
+        return true;
+    }
+
+    return QAbstractScrollArea::viewportEvent(event);
+}
+
+void TimelineView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dy)
+
+    if(dx && !_is_scrolling)
+    {
+        _from = quint64(horizontalScrollBar()->value()) * scroll_step();
+        _is_fitted = false;
+    }
+
+    viewport()->update();
+}
+
+bool TimelineView::row_at(const QPoint &pos, int &lane, int &depth) const
+{
+    if(pos.x() < LabelWidth)
+    {
+        return false;
+    }
+
+    int top = -verticalScrollBar()->value();
+
+    for(int i = 0; i < _lanes.size(); ++i)
+    {
+        int height = lane_height(_lanes.at(i));
+
+        if(pos.y() < top + height)
+        {
+            lane = i;
+            depth = (pos.y() - top) / row_height();
+
+            return (depth < _lanes.at(i).depth_count);
+        }
+
+        top += height;
+    }
+
+    return false;
+}
+
+bool TimelineView::span_at(const QPoint &pos, timeline_span_t &span) const
+{
+    int lane = 0;
+    int depth = 0;
+
+    if(!_controller || !row_at(pos, lane, depth))
+    {
+        return false;
+    }
+
+    // spans are drawn at least one pixel wide, so they are looked for around the pixel
+
+    quint64 from = time_at(pos.x() - 1);
+    quint64 to = time_at(pos.x() + 1) + 1;
+
+    QVector<timeline_span_t> spans = _controller->timeline().spans(lane, depth, from, to, quint64(_scale));
+
+    foreach (const timeline_span_t &candidate, spans)
+    {
+        int x1 = int(x_of(candidate.start));
+        int x2 = qMax(x1 + 1, int(x_of(candidate.end)));
+
+        if((pos.x() >= x1 - 1) && (pos.x() <= x2))
+        {
+            span = candidate;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TimelineView::zoom(double factor, int x)
+{
+    quint64 anchor = time_at(qMax(x, int(LabelWidth)));
+
+    _scale = qBound(0.1, _scale * factor, 1e12);
+
+    _from = quint64(qMax(0.0, double(anchor) - (qMax(x, int(LabelWidth)) - LabelWidth) * _scale));
+    _is_fitted = false;
+
+    update_scrollbars();
+
+    viewport()->update();
+}
+
+void TimelineView::show_range(quint64 from, quint64 to)
+{
+    quint64 length = qMax<quint64>(1, to - from);
+    quint64 margin = length / 10;
+
+    _from = (from > margin) ? from - margin : 0;
+    _scale = qMax(0.1, double(length + 2 * margin) / chart_width());
+    _is_fitted = false;
+
+    update_scrollbars();
+
+    viewport()->update();
+}
+
+void TimelineView::fit()
+{
+    quint64 total = _controller ? _controller->timeline().last_time() + 1 : 1;
+
+    _from = 0;
+    _scale = qMax(0.1, double(total) / chart_width());
+    _is_fitted = true;
+
+    update_scrollbars();
+
+    viewport()->update();
+}
+
+void TimelineView::update_scrollbars()
+{
+    int total_height = 0;
+
+    foreach (const timeline_lane_t &lane, _lanes)
+    {
+        total_height += lane_height(lane);
+    }
+
+    verticalScrollBar()->setRange(0, qMax(0, total_height - viewport()->height()));
+    verticalScrollBar()->setPageStep(viewport()->height());
+    verticalScrollBar()->setSingleStep(row_height());
+
+    // time is scrolled by ScrollSteps steps, so long trace doesn`t overflow range of scrollbar
+
+    quint64 total = _controller ? _controller->timeline().last_time() + 1 : 1;
+    quint64 step = scroll_step();
+    quint64 visible = quint64(chart_width() * _scale);
+
+    _is_scrolling = true;
+
+    horizontalScrollBar()->setRange(0, (total > visible) ? int((total - visible) / step) : 0);
+    horizontalScrollBar()->setPageStep(int(qMin<quint64>(visible / step + 1, ScrollSteps)));
+    horizontalScrollBar()->setValue(int(qMin<quint64>(_from / step, ScrollSteps)));
+
+    _is_scrolling = false;
+}
+
+quint64 TimelineView::scroll_step() const
+{
+    quint64 total = _controller ? _controller->timeline().last_time() + 1 : 1;
+
+    return qMax<quint64>(1, total / ScrollSteps);
+}
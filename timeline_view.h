@@ -0,0 +1,102 @@
+#ifndef TIMELINE_VIEW_H
+#define TIMELINE_VIEW_H
+
+#include <QAbstractScrollArea>
+
+#include "call_timeline.h"
+
+class TraceController;
+
+//! Gantt chart of calls: lane of each thread has row for each call level, calls are drawn as nested bars.
+//! Calls, shorter than pixel, are merged into blocks of pyramid of CallTimeline, so it is drawn in time of viewport.
+//! Ctrl + wheel zooms around cursor, drag pans, click selects call, double click zooms to call or whole trace
+class TimelineView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        LabelWidth    = 160,
+        LaneSpacing   = 4,
+        MinTextWidth  = 40,
+        ScrollSteps   = 100000,
+        DragThreshold = 4
+    };
+
+    explicit TimelineView(QWidget *parent = 0);
+
+    void set_controller(TraceController *controller);
+
+    //! Marks call of message and scrolls to it, if it is out of view
+    void set_current(const trace_message_t *message);
+
+public slots:
+    void clear();
+    void refresh();
+
+signals:
+    void message_selected(index_t message_index);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void showEvent(QShowEvent *event);
+    void wheelEvent(QWheelEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
+    void mouseDoubleClickEvent(QMouseEvent *event);
+    bool viewportEvent(QEvent *event);
+    void scrollContentsBy(int dx, int dy);
+
+private:
+    //! Lane and call level at viewport position
+    bool row_at(const QPoint &pos, int &lane, int &depth) const;
+    bool span_at(const QPoint &pos, timeline_span_t &span) const;
+
+    void draw_lane(QPainter &painter, int lane_index, const timeline_lane_t &lane, int top);
+
+    inline int row_height() const { return fontMetrics().height() + 4; }
+    inline int lane_height(const timeline_lane_t &lane) const { return qMax(1, lane.depth_count) * row_height() + LaneSpacing; }
+
+    inline double x_of(quint64 time) const { return LabelWidth + (double(time) - double(_from)) / _scale; }
+    inline quint64 time_at(double x) const { return quint64(qMax(0.0, double(_from) + (x - LabelWidth) * _scale)); }
+
+    //! Width of trace in viewport, px
+    inline int chart_width() const { return qMax(1, viewport()->width() - LabelWidth); }
+
+    void zoom(double factor, int x);
+    void show_range(quint64 from, quint64 to);
+    void fit();
+    void update_scrollbars();
+
+    //! Time of step of horizontal scrollbar, ns
+    quint64 scroll_step() const;
+
+private:
+    TraceController *_controller;
+
+    QVector<timeline_lane_t> _lanes;
+
+    quint64 _from;  // ns, time of the left edge of chart
+    double _scale;  // ns per pixel
+
+    //! Whole trace is shown, while it is not zoomed or panned, so it follows capture
+    bool _is_fitted;
+
+    //! Horizontal scrollbar is changed by view, not by user
+    bool _is_scrolling;
+
+    QPoint _press_pos;
+    quint64 _press_from;
+    bool _is_dragged;
+
+    //! Call of current message
+    bool _has_current;
+    int _current_lane;
+    int _current_depth;
+    quint64 _current_time;
+};
+
+#endif // TIMELINE_VIEW_H
@@ -4,84 +4,17 @@
 #include <QDateTime>
 #include <QFileInfo>
 #include <QDir>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
 
 #include <boost/filesystem.hpp>
 
 #include "image_lib/image.h"
-#include "data_parser.h"
+#include "trace_file.h"
+#include "frame_scheduler.h"
 #include "settings.h"
 #include "trace_x/trace_x.h"
 
-namespace
-{
-
-QByteArray make_data_array(const char *data_buffer, QString &message)
-{
-    X_CALL_F;
-
-    QByteArray array;
-
-    QDataStream stream(&array, QIODevice::WriteOnly);
-
-    size_t offset = 0;
-
-    std::vector<quint64> size    = get_vector<quint64>(data_buffer, offset);
-    quint64 elem_size            = get_value<uint64_t>(data_buffer, offset);
-    qint32 channels              = get_value<uint32_t>(data_buffer, offset);
-    qint8 unit_type              = get_value<int8_t>(data_buffer, offset);
-    quint32 data_format          = get_value<uint32_t>(data_buffer, offset);
-    std::vector<quint8> band_map = get_vector<quint8>(data_buffer, offset);
-    std::vector<quint8> axes     = get_vector<quint8>(data_buffer, offset);
-    quint32 message_size         = get_value<uint32_t>(data_buffer, offset);
-    quint32 palette_size         = get_value<uint32_t>(data_buffer, offset);
-    quint64 byte_size            = get_value<uint64_t>(data_buffer, offset);
-
-    QString message_string = QString::fromLocal8Bit(data_buffer + offset, int(message_size));
-    offset += message_size;
-
-    stream << QVector<quint64>(size.begin(), size.end()) << elem_size << channels << unit_type <<
-              data_format << QVector<quint8>(band_map.begin(), band_map.end()) << QVector<quint8>(axes.begin(), axes.end()) <<
-              palette_size << byte_size;
-
-    if(palette_size)
-    {
-        stream.writeRawData(data_buffer + offset, palette_size);
-
-        offset += palette_size;
-    }
-
-    QString unit_type_s = "user type";
-
-    if(unit_type != trace_x::T_CUSTOM)
-    {
-        unit_type_s = trace_x::data_type_names[unit_type];
-    }
-    else if(data_format & trace_x::QT_IMAGE_FORMAT)
-    {
-        unit_type_s = trace_x::data_type_names[trace_x::T_8U];
-    }
-
-    stream.writeRawData(data_buffer + offset, byte_size);
-
-    if(size.size() == 2)
-    {
-        message = QString(" [%1x%2 ; %3 ; %4 ch] ").arg(size[1]).arg(size[0]).arg(unit_type_s).arg(channels);
-    }
-    else if(size.empty())
-    {
-        message = " [empty]";
-    }
-
-    if(!message_string.isEmpty())
-    {
-        message += ": " + message_string;
-    }
-
-    return array;
-}
-
-}
-
 TraceController::TraceController(QObject *parent):
     QObject(parent),
     _start_point(0),
@@ -93,8 +26,22 @@ TraceController::TraceController(QObject *parent):
     _model_updated(false),
     _index_updated(false),
     _index_counter(0),
+    _legacy_data(false),
+    _load_cancelled(false),
     _message_limit(10000000),
-    _file_data_limit(10 * 1024 * 1024)
+    _file_data_limit(10 * 1024 * 1024),
+    _trace_memory_limit(TraceChunkCache::DefaultBudget),
+    _process_name_table(ProcessNameEntity),
+    _process_user_table(ProcessUserEntity),
+    _module_table(ModuleNameEntity),
+    _source_table(SourceNameEntity),
+    _function_table(FunctionNameEntity),
+    _class_table(ClassNameEntity),
+    _label_table(LabelNameEntity),
+    _thread_table(ThreadIdEntity),
+    _context_table(ContextIdEntity),
+    _journal(this),
+    _message_texts(true)
 {
     X_CALL;
 
@@ -103,27 +50,17 @@ TraceController::TraceController(QObject *parent):
         _full_message_types.append(new MessageTypeItem(trace_x::MessageType(i)));
     }
 
-    _items_hash[ProcessNameEntity]  = &_process_names;
-    _items_hash[ProcessIdEntity]    = &_process_models;
-    _items_hash[ProcessUserEntity]  = &_process_users;
-    _items_hash[ModuleNameEntity]   = &_modules;
-    _items_hash[ThreadIdEntity]     = &_threads;
-    _items_hash[ContextIdEntity]    = &_contexts;
-    _items_hash[ClassNameEntity]    = &_classes;
-    _items_hash[FunctionNameEntity] = &_functions;
-    _items_hash[SourceNameEntity]   = &_sources;
-    _items_hash[MessageTypeEntity]  = &_full_message_types;
-    _items_hash[LabelNameEntity]    = &_labels;
+    for(int class_id = ProcessNameEntity; class_id < MessageTextEntity; ++class_id)
+    {
+        _name_indexes[class_id] = new TextIndex;
+    }
 
     initialize();
 
     //
 
-    QTimer *timer = new QTimer(this);
-
-    connect(timer, &QTimer::timeout, this, &TraceController::check_updates);
-
-    timer->start(100);
+    connect(&FrameScheduler::instance(), &FrameScheduler::frame, this, &TraceController::check_updates);
+    connect(&FrameScheduler::instance(), &FrameScheduler::frame_finished, this, &TraceController::delete_retired);
 
     //
 
@@ -135,25 +72,22 @@ TraceController::~TraceController()
 {
     X_CALL;
 
+    cancel_loading();
+
     emit close_connections();
 
+    _journal.close();
+
     delete _tx_model_service;
     delete _trace_model_service;
 
     qDeleteAll(_process_models);
-    qDeleteAll(_modules);
-    qDeleteAll(_classes);
-    qDeleteAll(_functions);
-    qDeleteAll(_sources);
-    qDeleteAll(_process_names);
-    qDeleteAll(_process_users);
-    qDeleteAll(_contexts);
-    qDeleteAll(_threads);
-    qDeleteAll(_labels);
     qDeleteAll(_message_types);
+
+    qDeleteAll(_name_indexes);
 }
 
-void TraceController::append(trace_message_t *message, bool register_only, const char *data_buffer)
+void TraceController::append(trace_message_t *message, bool register_only, const QByteArray &data, const hash128_t &data_hash)
 {
     X_CALL;
 
@@ -203,64 +137,88 @@ void TraceController::append(trace_message_t *message, bool register_only, const
             X_INFO("erase {} messages", erased.size());
 
             _main_trace._safe_size = _main_trace.size();
+            _main_trace.reset_snapshot();
+            _main_trace.trim_type_index();
 
             foreach (const trace_message_t *message, erased)
             {
                 _data_storage.remove_from_tail(message->index);
                 _trace_model_service->remove_from_tail(message->index);
+
+                _density.remove(message_time(message), message->type);
+
+                if(message->type > trace_x::MESSAGE_RETURN)
+                {
+                    _message_texts.remove(message->message_text);
+                }
             }
 
-            qDeleteAll(erased);
+            index_t first_index = _main_trace._trace_list.isEmpty() ? erased.last()->index + 1 : _main_trace._trace_list.first()->index;
+
+            _timeline.remove_before(first_index);
+            _density.remove_marks(first_index);
+
+            // table models read snapshots without lock, so erased messages are deleted after frame, which replaces snapshots
+
+            _retired_messages.append(erased);
 
             _trace_model_service->unlock();
 
             _main_trace.unlock();
 
+            _main_trace.emit_updated();
+
             _trace_model_service->update_all_data();
         }
 
         //
 
-        _main_trace.lock();
+        // index counter is changed only under _append_mutex, so data is stored without trace lock
 
         message->index = _index_counter++;
 
-        //
+        account_message(message);
 
-        if(message->type == trace_x::MESSAGE_IMAGE)
+        if(!data.isNull())
         {
-            QString description;
-
-            QByteArray data_array = ::make_data_array(data_buffer, description);
-
-            message->message_text += description;
-
-            _data_storage.append_data(message->index, data_array);
+            _data_storage.append_data(message->index, data, data_hash, message->process_index);
         }
 
         //
 
+        _main_trace.lock();
+
         _main_trace._trace_list.append(message);
+        _main_trace.index_type(message->index, message->type);
 
         _main_trace._has_new_messages = true;
 
         _main_trace.unlock();
+
+        if(_journal.is_enabled())
+        {
+            _journal.append(*message, data);
+        }
     }
 }
 
-EntityItem *TraceController::item_by_descriptor_id(EntityClass class_id, QVariant item_id) const
+EntityRow TraceController::entity_by_descriptor_id(EntityClass class_id, QVariant item_id) const
 {
     X_CALL;
 
-    foreach (EntityItem *item, items_by_class(class_id, true))
+    EntityList entities = entities_by_class(class_id, true);
+
+    for(int i = 0; i < entities.size(); ++i)
     {
-        if(item->descriptor().id == item_id)
+        EntityRow entity = entities.at(i);
+
+        if(entity.descriptor().id == item_id)
         {
-            return item;
+            return entity;
         }
     }
 
-    return 0;
+    return EntityRow();
 }
 
 ProcessModel * TraceController::register_process(uint64_t pid, uint64_t timestamp, const QString &process_name, const QString &user_name, trace_x::filter_index index_container)
@@ -330,59 +288,61 @@ ProcessModel * TraceController::register_process(uint64_t pid, uint64_t timestam
     return process_item;
 }
 
-pid_index_t TraceController::register_process_name(const QString &process_name)
+QVector<process_info_t> TraceController::process_infos()
 {
-    X_CALL;
+    QMutexLocker locker(&_index_mutex);
 
-    pid_index_t index = 0;
+    QVector<process_info_t> infos;
 
-    QHash<QString, pid_index_t>::const_iterator it = _process_name_hash.find(process_name);
+    infos.reserve(_process_models.size());
 
-    if(it == _process_name_hash.cend())
+    foreach (const EntityItem *item, _process_models)
     {
-        index = _process_names.size();
-
-        _process_name_hash.insert(process_name, index);
+        const ProcessModel *process = static_cast<const ProcessModel*>(item);
 
-        EntityItem *process_name_item = new EntityItem(ProcessNameEntity, process_name, QFileInfo(process_name).baseName(), index);
+        process_info_t info;
 
-        process_name_item->setToolTip(tr("Process path: ") + QDir::fromNativeSeparators(process_name));
+        info.pid = process->pid();
+        info.time_delta = process->time_delta();
+        info.name_index = process->name_index();
 
-        _process_names.append(process_name_item);
-    }
-    else
-    {
-        index = it.value();
+        infos.append(info);
     }
 
-    return index;
+    return infos;
 }
 
-pid_index_t TraceController::register_user_name(const QString &user_name)
+pid_index_t TraceController::register_process_name(const QString &process_name)
 {
     X_CALL;
 
-    pid_index_t index;
+    int index = _process_name_table.find(process_name);
 
-    QHash<QString, pid_index_t>::const_iterator it = _process_user_hash.find(user_name);
-
-    if(it == _process_user_hash.cend())
+    if(index < 0)
     {
-        index = _process_users.size();
+        index = _process_name_table.append(entity_row_t(process_name, QFileInfo(process_name).baseName(),
+                                                        tr("Process path: ") + QDir::fromNativeSeparators(process_name)));
+
+        _process_name_table.insert_key(process_name, index);
+    }
 
-        _process_user_hash.insert(user_name, index);
+    return pid_index_t(index);
+}
 
-        EntityItem *user_item = new EntityItem(ProcessUserEntity, user_name, user_name, index);
-        user_item->setToolTip(tr("Process user: ") + user_name);
+pid_index_t TraceController::register_user_name(const QString &user_name)
+{
+    X_CALL;
 
-        _process_users.append(user_item);
-    }
-    else
+    int index = _process_user_table.find(user_name);
+
+    if(index < 0)
     {
-        index = it.value();
+        index = _process_user_table.append(entity_row_t(user_name, user_name, tr("Process user: ") + user_name));
+
+        _process_user_table.insert_key(user_name, index);
     }
 
-    return index;
+    return pid_index_t(index);
 }
 
 void TraceController::register_message_type(uint8_t type)
@@ -406,6 +366,12 @@ void TraceController::clear_trace(bool disconnect)
 {
     X_CALL;
 
+    cancel_loading();
+
+    // messages of cleared trace are written to their journal file, new trace starts the next one
+
+    _journal.close();
+
     emit cleaned();
 
     _loaded_file_name.clear();
@@ -428,18 +394,36 @@ void TraceController::clear_trace(bool disconnect)
 
     //
 
-    qDeleteAll(_main_trace._trace_list);
+    // messages are deleted after table models have replaced snapshots and stopped formatting of them
+
+    _retired_messages.append(_main_trace._trace_list);
 
     _main_trace._safe_size = 0;
     _main_trace._trace_list = QList<const trace_message_t*>();
+    _main_trace._chunk_cache.clear();
+    _main_trace.reset_snapshot();
+    _main_trace.clear_type_index();
 
     _data_storage.clear();
 
+    _legacy_data = false;
+
     //
 
     _start_point = 0;
     _zero_time = 0;
 
+    _density.clear();
+    _timeline.clear();
+    _message_texts.clear();
+
+    _entity_data_mutex.lock();
+
+    _entity_data.clear();
+    _entity_counts.clear();
+
+    _entity_data_mutex.unlock();
+
     clear_indexes();
 
     _main_trace.unlock();
@@ -462,6 +446,21 @@ uint64_t TraceController::message_limit() const
     return _message_limit;
 }
 
+void TraceController::delete_retired()
+{
+    // messages, retired before the previous frame, aren`t referred by snapshots of this frame
+
+    qDeleteAll(_deleted_messages);
+
+    _main_trace.lock();
+
+    _deleted_messages = _retired_messages;
+
+    _retired_messages.clear();
+
+    _main_trace.unlock();
+}
+
 void TraceController::check_updates()
 {
     //TODO наверное можно убрать
@@ -487,39 +486,30 @@ void TraceController::clear_indexes()
     _trace_index = trace_index_t();
 
     qDeleteAll(_process_models);
-    qDeleteAll(_modules);
-    qDeleteAll(_classes);
-    qDeleteAll(_functions);
-    qDeleteAll(_sources);
-    qDeleteAll(_process_names);
-    qDeleteAll(_process_users);
-    qDeleteAll(_contexts);
-    qDeleteAll(_threads);
-    qDeleteAll(_labels);
     qDeleteAll(_message_types);
 
     _process_models = QList<EntityItem*>();
-    _modules = QList<EntityItem*>();
-    _classes = QList<EntityItem*>();
-    _functions = QList<EntityItem*>();
-    _sources = QList<EntityItem*>();
-    _process_names = QList<EntityItem*>();
-    _process_users = QList<EntityItem*>();
-    _contexts = QList<EntityItem*>();
-    _threads = QList<EntityItem*>();
-    _labels = QList<EntityItem*>();
     _message_types = QList<EntityItem*>();
 
     _process_id_hash = QHash<quint64, pid_index_t>();
-    _process_name_hash = QHash<QString, pid_index_t>();
-    _process_user_hash = QHash<QString, pid_index_t>();
-    _modules_hash = QHash<QString, module_index_t>();
-    _sources_hash = QHash<QString, source_index_t>();
     _functions_hash = QHash<FunctionID, function_index_t>();
-    _class_hash = QHash<QString, class_index_t>();
-    _variable_hash = QHash<QString, label_index_t>();
     _message_type_set = QSet<uint8_t>();
 
+    _process_name_table.clear();
+    _process_user_table.clear();
+    _module_table.clear();
+    _source_table.clear();
+    _function_table.clear();
+    _class_table.clear();
+    _label_table.clear();
+    _thread_table.clear();
+    _context_table.clear();
+
+    foreach (TextIndex *index, _name_indexes)
+    {
+        index->clear();
+    }
+
     _pid_colorer.reset();
     _tid_colorer.reset();
     _context_colorer.reset();
@@ -536,39 +526,39 @@ void TraceController::initialize()
 
     ColorPair cp = _context_colorer.next();
 
-    IDItem *global_context_item = new ContextEntityItem(0, "<global>", 0, 0, 0, cp.bg_color, cp.fg_color);
+    entity_row_t global_context = ContextEntityItem::make_row(0, "<global>", 0, 0, cp.bg_color, cp.fg_color);
 
-    global_context_item->setToolTip(tr("outside of the context"));
+    global_context.tool_tip = tr("outside of the context");
 
-    _contexts.append(global_context_item);
+    _context_table.append(global_context);
 
     //
 
-    _threads.append(new IDItem(ThreadIdEntity, "", 0, 0, 0, 0, QColor(), QColor()));
+    _thread_table.append(IDItem::make_row("", 0, 0, 0, QColor(), QColor()));
 
     //
 
-    _classes.append(new EntityItem(ClassNameEntity, 0, "<global>", 0, QColor(), QColor(), tr("outside of the class")));
-    _class_hash.insert("<global>", 0);
+    _class_table.append(entity_row_t(0, "<global>", tr("outside of the class")));
+    _class_table.insert_key("<global>", 0);
 
     //
 
-    _labels.append(new EntityItem(LabelNameEntity, 0, "", 0, QColor(), QColor(), ""));
-    _variable_hash.insert("", 0);
+    _label_table.append(entity_row_t(0, ""));
+    _label_table.insert_key("", 0);
 
     //
 
-    _modules.append(new EntityItem(ModuleNameEntity, 0, "", 0, QColor(), QColor(), ""));
-    _modules_hash.insert("", 0);
+    _module_table.append(entity_row_t(0, ""));
+    _module_table.insert_key("", 0);
 
     //
 
-    _sources.append(new EntityItem(SourceNameEntity, "", "", 0, QColor(), QColor(), ""));
-    _sources_hash.insert("", 0);
+    _source_table.append(entity_row_t("", ""));
+    _source_table.insert_key("", 0);
 
     //
 
-    _functions.append(new FunctionEntityItem(function_t(), 0, 0));
+    _function_table.append(FunctionEntityItem::make_row(function_t(), 0));
     _functions_hash.insert(FunctionID(), 0);
 }
 
@@ -584,34 +574,45 @@ void TraceController::set_file_data_limit(uint64_t file_data_limit)
     _file_data_limit = file_data_limit;
 }
 
-module_index_t TraceController::register_module(const QString &module, const ProcessModel &process)
+uint64_t TraceController::trace_memory_limit() const
 {
-    X_CALL;
+    return _trace_memory_limit;
+}
 
-    QMutexLocker locker(&_index_mutex);
+void TraceController::set_trace_memory_limit(uint64_t trace_memory_limit)
+{
+    X_CALL;
 
-    module_index_t index = 0;
+    _trace_memory_limit = trace_memory_limit;
 
-    QHash<QString, module_index_t>::const_iterator it = _modules_hash.find(module);
+    X_VALUE(_trace_memory_limit);
 
-    if(it == _modules_hash.cend())
+    if(_main_trace.chunk_cache())
     {
-        index = _modules.size();
+        _main_trace.chunk_cache()->set_budget(_trace_memory_limit);
+    }
+}
+
+module_index_t TraceController::register_module(const QString &module, const ProcessModel &process)
+{
+    X_CALL;
+
+    QMutexLocker locker(&_index_mutex);
 
-        _modules_hash.insert(module, index);
+    int index = _module_table.find(module);
 
+    if(index < 0)
+    {
         ColorPair cp = _module_colorer.next();
 
-        _modules.append(new EntityItem(ModuleNameEntity, module, module, index, cp.bg_color, cp.fg_color));
+        index = _module_table.append(entity_row_t(module, module, QString(), cp.bg_color, cp.fg_color));
+
+        _module_table.insert_key(module, index);
 
         _model_updated = true;
     }
-    else
-    {
-        index = it.value();
-    }
 
-    return index;
+    return module_index_t(index);
 }
 
 source_index_t TraceController::register_source_file(const QString &path)
@@ -620,26 +621,18 @@ source_index_t TraceController::register_source_file(const QString &path)
 
     QMutexLocker locker(&_index_mutex);
 
-    source_index_t index = 0;
-
-    QHash<QString, source_index_t>::const_iterator it = _sources_hash.find(path);
+    int index = _source_table.find(path);
 
-    if(it == _sources_hash.cend())
+    if(index < 0)
     {
-        index = _sources.size();
+        index = _source_table.append(entity_row_t(QDir::fromNativeSeparators(path), QFileInfo(path).fileName()));
 
-        _sources_hash.insert(path, index);
-
-        _sources.append(new EntityItem(SourceNameEntity, QDir::fromNativeSeparators(path), QFileInfo(path).fileName(), index));
+        _source_table.insert_key(path, index);
 
         _model_updated = true;
     }
-    else
-    {
-        index = it.value();
-    }
 
-    return index;
+    return source_index_t(index);
 }
 
 function_index_t TraceController::register_function(const function_t &function, source_index_t source_index, bool has_context)
@@ -664,24 +657,20 @@ function_index_t TraceController::register_function(const function_t &function,
     {
         QString class_name = function.namespace_string;
 
-        QHash<QString, class_index_t>::const_iterator it = _class_hash.find(class_name);
+        int row = _class_table.find(class_name);
 
-        if(it == _class_hash.cend())
+        if(row < 0)
         {
-            class_index = _classes.size();
+            row = _class_table.append(entity_row_t(function.namespace_string, function.namespace_list.last()));
 
-            _class_hash.insert(class_name, class_index);
+            _class_table.insert_key(class_name, row);
 
-            _classes.append(new EntityItem(ClassNameEntity, function.namespace_string, function.namespace_list.last(), class_index));
-
-            X_INFO("new class: {} [#{}]", class_name, class_index);
+            X_INFO("new class: {} [#{}]", class_name, row);
 
             _model_updated = true;
         }
-        else
-        {
-            class_index = it.value();
-        }
+
+        class_index = class_index_t(row);
     }
 
     //
@@ -694,12 +683,10 @@ function_index_t TraceController::register_function(const function_t &function,
 
     if(it == _functions_hash.cend())
     {
-        fun_index = _functions.size();
+        fun_index = _function_table.append(FunctionEntityItem::make_row(function, class_index));
 
         _functions_hash.insert(function_id, fun_index);
 
-        _functions.append(new FunctionEntityItem(function, fun_index, class_index));
-
         _model_updated = true;
     }
     else
@@ -716,16 +703,14 @@ tid_index_t TraceController::register_thread(const ProcessModel &process, quint6
 
     QMutexLocker locker(&_index_mutex);
 
-    tid_index_t index = _threads.size();
-
     ColorPair cp = _tid_colorer.next();
 
-    IDItem *thread_item = new IDItem(ThreadIdEntity, QString("%1").arg(tid), process.index() + 1,
-                                     process._thread_index_hash.size() + 1, tid, index, cp.bg_color, cp.fg_color);
+    entity_row_t thread = IDItem::make_row(QString("%1").arg(tid), process.index() + 1, process._thread_index_hash.size() + 1,
+                                           tid, cp.bg_color, cp.fg_color);
 
-    thread_item->setToolTip(thread_item->text());
+    thread.tool_tip = thread.text;
 
-    _threads.append(thread_item);
+    tid_index_t index = _thread_table.append(thread);
 
     _model_updated = true;
 
@@ -738,14 +723,12 @@ context_index_t TraceController::register_context(const ProcessModel &process, q
 
     QMutexLocker locker(&_index_mutex);
 
-    context_index_t index = _contexts.size();
-
     ColorPair cp = _context_colorer.next();
 
-    IDItem *context_item = new ContextEntityItem(context, class_at(function_index)->text(), process.index() + 1,
-                                                 process._context_index_hash.size(), index, cp.bg_color, cp.fg_color);
+    entity_row_t context_row = ContextEntityItem::make_row(context, class_at(function_index).text(), process.index() + 1,
+                                                           process._context_index_hash.size(), cp.bg_color, cp.fg_color);
 
-    _contexts.append(context_item);
+    context_index_t index = _context_table.append(context_row);
 
     _model_updated = true;
 
@@ -758,26 +741,18 @@ label_index_t TraceController::register_label(const QString &var_name)
 
     QMutexLocker locker(&_index_mutex);
 
-    label_index_t index = 0;
-
-    QHash<QString, label_index_t>::const_iterator it = _variable_hash.find(var_name);
+    int index = _label_table.find(var_name);
 
-    if(it == _variable_hash.cend())
+    if(index < 0)
     {
-        index = _labels.size();
+        index = _label_table.append(entity_row_t(var_name, var_name));
 
-        _variable_hash.insert(var_name, index);
-
-        _labels.append(new EntityItem(LabelNameEntity, var_name, var_name, index));
+        _label_table.insert_key(var_name, index);
 
         _model_updated = true;
     }
-    else
-    {
-        index = it.value();
-    }
 
-    return index;
+    return label_index_t(index);
 }
 
 QString TraceController::message_text_at(const trace_message_t *message) const
@@ -787,7 +762,7 @@ QString TraceController::message_text_at(const trace_message_t *message) const
         return message->message_text;
     }
 
-    return function_at(message)->toolTip();
+    return function_at(message).tool_tip();
 }
 
 QList<const trace_message_t *> TraceController::get_callers(const trace_message_t *message) const
@@ -823,7 +798,7 @@ QList<const trace_message_t *> TraceController::get_callers(const trace_message_
         {
             QMutexLocker lock(_main_trace.mutex());
 
-            index_t start_index = _main_trace._trace_list.first()->index;
+            index_t start_index = _main_trace.trace_index(0);
 
             //TODO omp
             for(int i = message->index - 1 - start_index; i >= 0; --i)
@@ -879,7 +854,7 @@ QList<const trace_message_t *> TraceController::get_callees(const trace_message_
 
         QMutexLocker lock(_main_trace.mutex());
 
-        index_t start_index = _main_trace._trace_list.first()->index;
+        index_t start_index = _main_trace.trace_index(0);
 
         for(size_t i = message->index + 1 - start_index; i < _main_trace.size(); ++i)
         {
@@ -1231,46 +1206,38 @@ void read_entity_list(QDataStream &in, QList<EntityItem*> &value)
     }
 }
 
-QDataStream & operator << (QDataStream &out, const trace_message_t &value)
+//! Writes rows of table by temporary items, so file keeps format of items
+template<class T>
+void write_entity_rows(QDataStream &out, EntityTable &table)
 {
-    out << quint64(value.index);
-    out << value.type;
-    out << quint64(value.timestamp);
-    out << quint64(value.extra_timestamp);
-    out << value.process_index;
-    out << value.tid_index;
-    out << value.context_index;
-    out << value.module_index;
-    out << value.function_index;
-    out << value.label_index;
-    out << value.source_index;
-    out << value.source_line;
-    out << value.call_level;
-    out << value.message_text;
+    int size = table.size();
 
-    return out;
+    out << quint32(size);
+
+    for(int i = 0; i < size; ++i)
+    {
+        T item(&table, i);
+
+        out << item;
+    }
 }
 
-QDataStream & operator >> (QDataStream &in, trace_message_t &value)
+//! Reads rows of table by temporary items, they append their rows to cleared table
+template<class T>
+void read_entity_rows(QDataStream &in, EntityTable &table)
 {
-    quint64 index; in >> index; value.index = index;
-    in >> value.type;
-    quint64 timestamp; in >> timestamp; value.timestamp = timestamp;
-    quint64 extra_timestamp; in >> extra_timestamp; value.extra_timestamp = extra_timestamp;
-    in >> value.process_index;
-    in >> value.tid_index;
-    in >> value.context_index;
-    in >> value.module_index;
-    in >> value.function_index;
-    in >> value.label_index;
-    in >> value.source_index;
-    in >> value.source_line;
-    in >> value.call_level;
-    in >> value.message_text;
-
-    value.flags = 0;
+    table.clear();
 
-    return in;
+    quint32 size = 0;
+
+    in >> size;
+
+    for(quint32 i = 0; i < size; ++i)
+    {
+        T item(&table);
+
+        in >> item;
+    }
 }
 
 QDataStream & operator << (QDataStream &out, const QList<const trace_message_t*> &value)
@@ -1305,6 +1272,56 @@ QDataStream & operator >> (QDataStream &in, QList<const trace_message_t*> &value
     return in;
 }
 
+namespace
+{
+
+//! Estimated size of message text in memory, it is used to decide, whether trace is loaded lazily
+const size_t AverageTextSize = 64;
+
+//! Writes messages by chunks. Chunks are compressed in parallel by batches, so memory usage is limited by batch size
+void write_chunks(QFile &file, const QList<const trace_message_t*> &list, int stream_version, QList<trace_chunk_t> &chunks)
+{
+    X_CALL_F;
+
+    struct chunk_task_t
+    {
+        trace_chunk_t chunk;
+        QByteArray data;
+    };
+
+    const int batch_size = 2 * QThread::idealThreadCount();
+
+    for(int batch_first = 0; batch_first < list.size(); batch_first += batch_size * TraceChunkSize)
+    {
+        QVector<chunk_task_t> tasks;
+
+        for(int first = batch_first; (first < list.size()) && (tasks.size() < batch_size); first += TraceChunkSize)
+        {
+            chunk_task_t task;
+
+            task.chunk.first_row = first;
+            task.chunk.row_count = qMin<qsizetype>(TraceChunkSize, list.size() - first);
+
+            tasks.append(task);
+        }
+
+        QtConcurrent::blockingMap(tasks, [&list, stream_version](chunk_task_t &task) {
+            task.data = encode_chunk(list, int(task.chunk.first_row), int(task.chunk.row_count), stream_version, task.chunk);
+        });
+
+        for(int i = 0; i < tasks.size(); ++i)
+        {
+            tasks[i].chunk.offset = file.pos();
+
+            file.write(tasks[i].data);
+
+            chunks.append(tasks[i].chunk);
+        }
+    }
+}
+
+}
+
 void TraceController::save_trace(const QString &name)
 {
     X_CALL;
@@ -1317,6 +1334,43 @@ void TraceController::save_trace(const QString &name)
 
         boost::filesystem::create_directories(boost_path.parent_path());
 
+        if(_main_trace.is_lazy())
+        {
+            // messages of lazy trace are not in memory, so loaded file is copied as is
+
+            if(QFileInfo(name) != QFileInfo(_loaded_file_name))
+            {
+                QFile::remove(name);
+                QFile::copy(_loaded_file_name, name);
+
+                if(QFileInfo::exists(_loaded_file_name + ".data"))
+                {
+                    QFile::remove(name + ".data");
+                    QFile::copy(_loaded_file_name + ".data", name + ".data");
+                }
+            }
+
+            return;
+        }
+
+        index_t journal_index;
+
+        if((QFileInfo(name).suffix() != "txt") && _journal.first_index(journal_index))
+        {
+            // if journal contains all messages of trace, it is finalized instead of writing of messages
+
+            _main_trace.lock();
+
+            bool is_journaled = _main_trace.size() && (_main_trace.trace_index(0) == journal_index);
+
+            _main_trace.unlock();
+
+            if(is_journaled && _journal.save(name))
+            {
+                return;
+            }
+        }
+
         QFile trace_file(name);
 
         if (trace_file.open(QFile::WriteOnly | QFile::Truncate))
@@ -1343,36 +1397,42 @@ void TraceController::save_trace(const QString &name)
 
                 QDataStream file_stream(&trace_file);
 
-                quint16 version = 1;
+                quint16 version = TraceFileVersion;
 
                 file_stream << version;
                 file_stream << quint32(file_stream.version());
 
-                QByteArray data_array;
+                // footer is written after chunks, it`s position is updated at the end
+
+                qint64 footer_position_offset = trace_file.pos();
+
+                file_stream << quint64(0);
 
-                QDataStream stream(&data_array, QIODevice::WriteOnly);
+                trace_footer_t footer;
 
-                stream << _zero_time;
-                stream << _start_point;
-                stream << _trace_index;
+                QList<const trace_message_t*> trace_list;
 
-                stream << _process_models;
-                stream << _process_names;
-                stream << _process_users;
-                stream << _modules;
-                stream << _sources;
-                stream << _functions;
-                stream << _classes;
-                stream << _labels;
-                stream << _threads;
-                stream << _contexts;
-                stream << _message_types;
+                _main_trace.lock();
 
-                stream << _main_trace.trace_list();
+                trace_list = _main_trace.trace_list();
 
-                QByteArray compressed_data = qCompress(data_array);
+                _main_trace.unlock();
 
-                file_stream << compressed_data;
+                ::write_chunks(trace_file, trace_list, file_stream.version(), footer.chunks);
+
+                footer.entity_data = entity_data();
+
+                quint64 footer_position = trace_file.pos();
+
+                file_stream << footer;
+
+                qint64 data_position = trace_file.pos();
+
+                trace_file.seek(footer_position_offset);
+
+                file_stream << footer_position;
+
+                trace_file.seek(data_position);
 
                 if(_data_storage.total_data_size() <= _file_data_limit)
                 {
@@ -1400,6 +1460,63 @@ void TraceController::save_trace(const QString &name)
     }
 }
 
+QByteArray TraceController::entity_data()
+{
+    X_CALL;
+
+    QMutexLocker data_lock(&_entity_data_mutex);
+
+    QByteArray data_array;
+
+    {
+        // entity tables and trace index are consistent with appended messages. Tables are serialized under lock,
+        // they are compressed after it, so capture isn`t blocked by compression
+
+        QMutexLocker append_lock(&_append_mutex);
+        QMutexLocker index_lock(&_index_mutex);
+
+        QVector<qsizetype> counts;
+
+        counts << qsizetype(_trace_index.size()) << _process_models.size() << _process_name_table.size() << _process_user_table.size()
+               << _module_table.size() << _source_table.size() << _function_table.size() << _class_table.size() << _label_table.size()
+               << _thread_table.size() << _context_table.size() << _message_types.size();
+
+        if(!_entity_data.isNull() && (counts == _entity_counts))
+        {
+            return _entity_data;
+        }
+
+        _entity_counts = counts;
+
+        QDataStream stream(&data_array, QIODevice::WriteOnly);
+
+        write_entities(stream);
+    }
+
+    _entity_data = qCompress(data_array);
+
+    return _entity_data;
+}
+
+void TraceController::write_entities(QDataStream &stream)
+{
+    stream << _zero_time;
+    stream << _start_point;
+    stream << _trace_index;
+
+    stream << _process_models;
+    write_entity_rows<EntityItem>(stream, _process_name_table);
+    write_entity_rows<EntityItem>(stream, _process_user_table);
+    write_entity_rows<EntityItem>(stream, _module_table);
+    write_entity_rows<EntityItem>(stream, _source_table);
+    write_entity_rows<FunctionEntityItem>(stream, _function_table);
+    write_entity_rows<EntityItem>(stream, _class_table);
+    write_entity_rows<EntityItem>(stream, _label_table);
+    write_entity_rows<IDItem>(stream, _thread_table);
+    write_entity_rows<ContextEntityItem>(stream, _context_table);
+    stream << _message_types;
+}
+
 bool TraceController::load_trace(const QString &file_name)
 {
     X_CALL;
@@ -1425,7 +1542,35 @@ bool TraceController::load_trace(const QString &file_name)
 
         QByteArray data_array;
 
-        file_stream >> data_array;
+        trace_footer_t footer;
+
+        if(version < 3)
+        {
+            file_stream >> data_array;
+        }
+        else
+        {
+            quint64 footer_position = 0;
+
+            file_stream >> footer_position;
+
+            if(!footer_position)
+            {
+                // journal, which was broken before the first checkpoint
+
+                X_ERROR("trace file {} has no index", file_name);
+
+                return false;
+            }
+
+            trace_file.seek(footer_position);
+
+            file_stream >> footer;
+
+            data_array = footer.entity_data;
+        }
+
+        qint64 data_position = trace_file.pos();
 
         QDataStream stream(qUncompress(data_array));
 
@@ -1442,20 +1587,44 @@ bool TraceController::load_trace(const QString &file_name)
             static_cast<ProcessModel*>(item)->_trace_controller = this;
         }
 
-        read_entity_list<EntityItem>(stream, _process_names);
-        read_entity_list<EntityItem>(stream, _process_users);
-        read_entity_list<EntityItem>(stream, _modules);
-        read_entity_list<EntityItem>(stream, _sources);
-        read_entity_list<FunctionEntityItem>(stream, _functions);
-        read_entity_list<EntityItem>(stream, _classes);
-        read_entity_list<EntityItem>(stream, _labels);
-        read_entity_list<IDItem>(stream, _threads);
-        read_entity_list<ContextEntityItem>(stream, _contexts);
+        read_entity_rows<EntityItem>(stream, _process_name_table);
+        read_entity_rows<EntityItem>(stream, _process_user_table);
+        read_entity_rows<EntityItem>(stream, _module_table);
+        read_entity_rows<EntityItem>(stream, _source_table);
+        read_entity_rows<FunctionEntityItem>(stream, _function_table);
+        read_entity_rows<EntityItem>(stream, _class_table);
+        read_entity_rows<EntityItem>(stream, _label_table);
+        read_entity_rows<IDItem>(stream, _thread_table);
+        read_entity_rows<ContextEntityItem>(stream, _context_table);
         read_entity_list<MessageTypeItem>(stream, _message_types);
 
         QList<const trace_message_t*> trace_list;
 
-        stream >> trace_list;
+        // messages of trace, which doesn`t fit into memory limit, are decoded on demand, so only entity tables are loaded
+
+        TraceChunkCachePtr chunk_cache;
+
+        bool is_lazy = (version >= 3) && (footer.row_count() * (sizeof(trace_message_t) + AverageTextSize) > _trace_memory_limit);
+
+        if(is_lazy)
+        {
+            chunk_cache = TraceChunkCachePtr(new TraceChunkCache(_trace_memory_limit));
+
+            is_lazy = chunk_cache->open(file_name, footer.chunks, stream_verion);
+        }
+
+        if(version < 3)
+        {
+            stream >> trace_list;
+        }
+        else if(!is_lazy && !footer.chunks.isEmpty())
+        {
+            // first chunk is shown at once
+
+            trace_file.seek(footer.chunks.first().offset);
+
+            trace_list = decode_chunk(trace_file.read(footer.chunks.first().size), stream_verion);
+        }
 
         QString data_file = file_name + ".data";
 
@@ -1465,14 +1634,34 @@ bool TraceController::load_trace(const QString &file_name)
         {
             data_file = file_name;
 
-            data_offset = trace_file.pos();
+            data_offset = data_position;
         }
 
         _data_storage.set_swap_file(data_file, data_offset);
 
+        _legacy_data = (version < 2);
+
         _model_updated = true;
 
-        _main_trace.set_message_list(trace_list);
+        if(is_lazy)
+        {
+            X_INFO("{} messages are decoded on demand", footer.row_count());
+
+            // derived models are switched before main trace, so filtration of it`s rows fills row mapped models
+
+            _trace_model_service->set_chunk_cache(chunk_cache);
+
+            _main_trace.set_chunk_cache(chunk_cache);
+        }
+        else
+        {
+            foreach (const trace_message_t *message, trace_list)
+            {
+                account_message(message);
+            }
+
+            _main_trace.set_message_list(trace_list);
+        }
 
         _loaded_file_name = file_name;
 
@@ -1480,6 +1669,15 @@ bool TraceController::load_trace(const QString &file_name)
 
         _trace_model_service->invalidate_all_filters();
 
+        if(!is_lazy && (footer.chunks.size() > 1))
+        {
+            _load_future = QtConcurrent::run(&TraceController::load_chunks, this, file_name, footer.chunks.mid(1), int(stream_verion));
+        }
+        else if(is_lazy)
+        {
+            _load_future = QtConcurrent::run(&TraceController::count_density, this);
+        }
+
         return true;
     }
     else
@@ -1490,12 +1688,201 @@ bool TraceController::load_trace(const QString &file_name)
     return false;
 }
 
+void TraceController::load_chunks(const QString &file_name, const QList<trace_chunk_t> &chunks, int stream_version)
+{
+    X_CALL;
+
+    QFile trace_file(file_name);
+
+    if(!trace_file.open(QFile::ReadOnly))
+    {
+        X_ERROR("can`t load chunks of {}", file_name);
+
+        return;
+    }
+
+    // chunks are read sequentially and decoded in parallel by batches, messages are appended in file order
+
+    struct chunk_task_t
+    {
+        QByteArray data;
+        QList<const trace_message_t*> messages;
+    };
+
+    const int batch_size = QThread::idealThreadCount();
+
+    for(int first = 0; (first < chunks.size()) && !_load_cancelled; first += batch_size)
+    {
+        QVector<chunk_task_t> tasks;
+
+        for(int i = first; i < qMin<qsizetype>(first + batch_size, chunks.size()); ++i)
+        {
+            trace_file.seek(chunks[i].offset);
+
+            chunk_task_t task;
+
+            task.data = trace_file.read(chunks[i].size);
+
+            tasks.append(task);
+        }
+
+        QtConcurrent::blockingMap(tasks, [stream_version](chunk_task_t &task) {
+            task.messages = decode_chunk(task.data, stream_version);
+            task.data.clear();
+        });
+
+        if(_load_cancelled)
+        {
+            foreach (const chunk_task_t &task, tasks)
+            {
+                qDeleteAll(task.messages);
+            }
+
+            break;
+        }
+
+        _main_trace.lock();
+
+        foreach (const chunk_task_t &task, tasks)
+        {
+            _main_trace._trace_list.append(task.messages);
+
+            foreach (const trace_message_t *message, task.messages)
+            {
+                _main_trace.index_type(message->index, message->type);
+
+                account_message(message);
+            }
+        }
+
+        _main_trace._has_new_messages = true;
+
+        _main_trace.unlock();
+
+        X_INFO("loaded {} of {} chunks", qMin<qsizetype>(first + batch_size, chunks.size()) + 1, chunks.size() + 1);
+    }
+}
+
+void TraceController::count_density()
+{
+    X_CALL;
+
+    // rows of lazy trace are not changed until it is cleared, so they are read without lock.
+    // Messages are indexed by type here, because lazy model can`t read them in gui thread
+
+    enum { IndexBatchSize = 65536 };
+
+    QVector<QVector<index_t>> type_indexes(trace_x::_MESSAGE_END_);
+
+    int batch = 0;
+
+    auto flush_type_indexes = [this, &type_indexes, &batch]()
+    {
+        _main_trace.lock();
+
+        _main_trace.append_type_indexes(type_indexes);
+
+        _main_trace.unlock();
+
+        type_indexes = QVector<QVector<index_t>>(trace_x::_MESSAGE_END_);
+
+        batch = 0;
+    };
+
+    _main_trace.for_each_message(0, _main_trace.size(), [&](size_t, const trace_message_t *message)
+    {
+        account_message(message);
+
+        if(message->type < type_indexes.size())
+        {
+            type_indexes[message->type].append(message->index);
+        }
+
+        if(++batch == IndexBatchSize)
+        {
+            flush_type_indexes();
+        }
+
+        return !_load_cancelled;
+    });
+
+    flush_type_indexes();
+}
+
+index_t TraceController::index_by_time(quint64 time) const
+{
+    X_CALL;
+
+    // time of rows isn`t monotonic, so marks of density bound rows, which are scanned for the first message of time
+
+    bool has_first, has_last;
+    index_t first_index, last_index;
+
+    _density.find_marks(time, has_first, first_index, has_last, last_index);
+
+    QMutexLocker lock(_main_trace.mutex());
+
+    size_t count = _main_trace.size();
+
+    if(!count)
+    {
+        return 0;
+    }
+
+    size_t first = has_first ? _main_trace.lower_row(first_index + 1) : 0;
+    size_t last = has_last ? qMin(_main_trace.lower_row(last_index) + 1, count) : count;
+
+    size_t row = last - 1;
+
+    _main_trace.for_each_message(first, last, [&](size_t i, const trace_message_t *message)
+    {
+        if(message_time(message) < time)
+        {
+            return true;
+        }
+
+        row = i;
+
+        return false;
+    });
+
+    return _main_trace.row_index(qMin(row, count - 1));
+}
+
+void TraceController::cancel_loading()
+{
+    X_CALL;
+
+    _load_cancelled = true;
+
+    _load_future.waitForFinished();
+
+    _load_cancelled = false;
+}
+
+void TraceController::wait_for_loading()
+{
+    X_CALL;
+
+    _load_future.waitForFinished();
+}
+
 QString TraceController::loaded_file() const
 {
     return _loaded_file_name;
 }
 
-QByteArray TraceController::data_at(const trace_message_t *message)
+QByteArray TraceController::data_at(const trace_message_t *message, DataPinPtr *pin)
 {
-    return _data_storage.request_data(message->index);
+    return data_by_index(message->index, pin);
+}
+
+QByteArray TraceController::data_by_index(uint64_t data_index, DataPinPtr *pin)
+{
+    if(_legacy_data)
+    {
+        return ::convert_legacy_image(_data_storage.request_data(data_index));
+    }
+
+    return _data_storage.request_data(data_index, pin);
 }
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QFuture>
 
 #include <boost/chrono.hpp>
 #include <boost/chrono/duration.hpp>
@@ -20,6 +21,11 @@
 #include "trace_model_service.h"
 
 #include "data_storage.h"
+#include "trace_file.h"
+#include "trace_journal.h"
+#include "message_density.h"
+#include "call_timeline.h"
+#include "text_index.h"
 
 struct FunctionID
 {
@@ -47,6 +53,16 @@ inline uint qHash(const FunctionID &f, uint seed)
     return uint(seed_s);
 }
 
+//! Data of process, which is copied for threads, which don`t access process models
+struct process_info_t
+{
+    process_info_t(): pid(0), time_delta(0), name_index(0) {}
+
+    uint64_t pid;
+    quint64 time_delta;
+    pid_index_t name_index;
+};
+
 //! Класс управления трассой.
 //! Содержит единый список всех сообщений и элементы модели трассы.
 //! Отвечает за идексацию элементов модели трассы.
@@ -59,7 +75,9 @@ public:
     explicit TraceController(QObject *parent = 0);
     ~TraceController();
 
-    void append(trace_message_t *message, bool register_only = false, const char* data_buffer = 0);
+    //! Data is stored without copying, see DataStorage::append_data. data_hash is DataStorage::content_hash() of data,
+    //! it is calculated by caller, so hashing of large data doesn`t block other connections
+    void append(trace_message_t *message, bool register_only = false, const QByteArray &data = QByteArray(), const hash128_t &data_hash = hash128_t());
 
     QMutex * index_mutex() { return &_index_mutex; }
 
@@ -75,63 +93,64 @@ public:
     inline const ProcessModel & process_at(const trace_message_t *message) const;
     inline const ProcessModel & process_at(pid_index_t index) const;
 
+    //! Processes are appended by capture thread and deleted by clear, so other threads read their copies taken under lock.
+    //! Called in gui thread, which clears trace
+    QVector<process_info_t> process_infos();
+
+    //! Time of message relative to the start of trace
+    inline quint64 message_time(const trace_message_t *message) const;
+
     void register_message_type(uint8_t type);
 
     inline EntityItem * message_type_at(int index) const;
 
-    inline EntityItem * process_name_at(const trace_message_t *message) const;
-    inline EntityItem * process_name_at(pid_index_t index) const;
+    //! Entities of tables are returned as row views, which are read in any thread
+    inline EntityRow process_name_at(const trace_message_t *message) const;
+    inline EntityRow process_name_at(pid_index_t index) const;
 
-    inline EntityItem * process_user_at(const trace_message_t *message) const;
-    inline EntityItem * process_user_at(pid_index_t index) const;
+    inline EntityRow process_user_at(const trace_message_t *message) const;
+    inline EntityRow process_user_at(pid_index_t index) const;
 
     module_index_t register_module(const QString &module, const ProcessModel &process);
 
-    inline EntityItem * module_at(module_index_t index) const;
-    inline EntityItem * module_at(const trace_message_t *message) const;
+    inline EntityRow module_at(module_index_t index) const;
+    inline EntityRow module_at(const trace_message_t *message) const;
 
     source_index_t register_source_file(const QString &path);
-    inline EntityItem * source_at(const trace_message_t *message) const;
-    inline EntityItem * source_at(source_index_t index) const;
+    inline EntityRow source_at(const trace_message_t *message) const;
+    inline EntityRow source_at(source_index_t index) const;
 
     function_index_t register_function(const function_t &function, source_index_t source_index, bool has_context);
-    inline EntityItem * function_at(const trace_message_t *message) const;
-    inline EntityItem * function_at(function_index_t index) const;
+    inline EntityRow function_at(const trace_message_t *message) const;
+    inline EntityRow function_at(function_index_t index) const;
 
-    inline EntityItem * class_at(const trace_message_t *message) const;
-    inline EntityItem * class_at(function_index_t index) const;
-    inline EntityItem * class_at(class_index_t index) const;
+    inline EntityRow class_at(const trace_message_t *message) const;
+    inline EntityRow class_at(function_index_t index) const;
+    inline EntityRow class_at(class_index_t index) const;
 
     tid_index_t register_thread(const ProcessModel &process, quint64 tid);
-    inline EntityItem * thread_item_at(const trace_message_t *message) const;
-    inline EntityItem * thread_item_at(tid_index_t index) const;
+    inline EntityRow thread_at(const trace_message_t *message) const;
+    inline EntityRow thread_at(tid_index_t index) const;
 
     context_index_t register_context(const ProcessModel &process, quint64 context, function_index_t function_index);
-    inline EntityItem * context_item_at(const trace_message_t *message) const;
-    inline EntityItem * context_item_at(context_index_t index) const;
+    inline EntityRow context_at(const trace_message_t *message) const;
+    inline EntityRow context_at(context_index_t index) const;
 
     label_index_t register_label(const QString &var_name);
-    inline EntityItem * label_item_at(const trace_message_t *message) const;
-    inline EntityItem * label_item_at(label_index_t index) const;
+    inline EntityRow label_at(const trace_message_t *message) const;
+    inline EntityRow label_at(label_index_t index) const;
 
     QString message_text_at(const trace_message_t *message) const;
 
-    QByteArray data_at(const trace_message_t *message);
+    //! If pin is set, large data can be returned as zero-copy view, see DataStorage::request_data
+    QByteArray data_at(const trace_message_t *message, DataPinPtr *pin = 0);
+
+    //! Data by message data index. Can be called from any thread
+    QByteArray data_by_index(uint64_t data_index, DataPinPtr *pin = 0);
 
     //
 
     QList<EntityItem*> * process_models() { return &_process_models; }
-    QList<EntityItem*> * process_names() { return &_process_names; }
-    QList<EntityItem*> * process_users() { return &_process_users; }
-    QList<EntityItem*> * modules() { return &_modules; }
-    QList<EntityItem*> * sources() { return &_sources; }
-    QList<EntityItem*> * functions() { return &_functions; }
-    QList<EntityItem*> * classes() { return &_classes; }
-    QList<EntityItem*> * variables() { return &_labels; }
-    QList<EntityItem*> * threads() { return &_threads; }
-    QList<EntityItem*> * contexts() { return &_contexts; }
-    QList<EntityItem*> * message_types() { return &_message_types; }
-    QList<EntityItem*> * full_message_types() { return &_full_message_types; }
 
     //
 
@@ -139,6 +158,15 @@ public:
     inline TraceDataModel &trace_model();
 
     inline DataStorage &data_storage();
+    inline TraceJournal &journal();
+    inline const MessageDensity &density() const;
+    inline const CallTimeline &timeline() const;
+
+    //! Distinct texts of messages of trace
+    inline const TextIndex &message_texts() const;
+
+    //! Texts of items of class for completer, which appends texts of new items, when it searches them
+    inline TextIndex *name_index(EntityClass class_id) const;
 
     inline TransmitterModelService &tx_model_service();
     inline TraceModelService &trace_model_service();
@@ -150,13 +178,13 @@ public:
 
     //
 
-    inline const QList<EntityItem *> &items_by_class(EntityClass class_id, bool full_types = false) const;
+    //! Entities of class. Message types are registered ones or all types, if full_types is set
+    inline EntityList entities_by_class(EntityClass class_id, bool full_types = false) const;
 
     inline size_t index_by_class(const trace_message_t *message, int class_id) const;
 
-    EntityItem * item_by_descriptor_id(EntityClass class_id, QVariant item_id) const;
-
-    inline const QHash<int, QList<EntityItem *> *> &items_hash() const;
+    //! Entity with id or null row
+    EntityRow entity_by_descriptor_id(EntityClass class_id, QVariant item_id) const;
 
     //
 
@@ -175,6 +203,9 @@ public:
     index_t get_next_call(index_t current, bool &finded);
     index_t get_prev_call(index_t current, bool &finded);
 
+    //! Index of the first message of trace, which isn`t earlier than time. Messages are ordered by time, so it is found by binary search
+    index_t index_by_time(quint64 time) const;
+
     trace_index_t & trace_index();
     const trace_index_t & trace_index() const;
 
@@ -183,8 +214,20 @@ public:
     QString filter_class_name(int class_id) const;
 
     void save_trace(const QString &file_name);
+
+    //! Compressed entity tables, which are stored in footer of trace file.
+    //! Entities are only appended, so data of the previous call is returned, while counts of them are unchanged
+    QByteArray entity_data();
+
+    //! Called under _append_mutex and _index_mutex
+    void write_entities(QDataStream &stream);
+
+    //! Loads entity tables and first chunk of messages, other chunks are loaded in background
     bool load_trace(const QString &file_name);
 
+    //! Waits, while background loading of trace is finished
+    void wait_for_loading();
+
     QString loaded_file() const;
 
 public:
@@ -194,6 +237,10 @@ public:
     uint64_t file_data_limit() const;
     void set_file_data_limit(uint64_t file_data_limit);
 
+    //! Memory limit of loaded trace messages. Larger trace is decoded on demand, it`s decoded chunks are limited by this size
+    uint64_t trace_memory_limit() const;
+    void set_trace_memory_limit(uint64_t trace_memory_limit);
+
 signals:
     void model_updated();
     void index_updated();
@@ -213,10 +260,20 @@ public slots:
 
 private:
     void check_updates();
+    void delete_retired();
     void clear_indexes();
     void initialize();
     void clear_trace(bool disconnect);
 
+    void load_chunks(const QString &file_name, const QList<trace_chunk_t> &chunks, int stream_version);
+    void cancel_loading();
+
+    //! Counts density, call timeline and texts of messages of lazy trace, which messages are not loaded
+    void count_density();
+
+    //! Accounts appended message in density, call timeline and texts of messages
+    inline void account_message(const trace_message_t *message);
+
 private:
     friend class ProcessModel;
     friend class TransmitterModelService;
@@ -230,9 +287,6 @@ private:
 
     QList<EntityClass> _entity_list;
 
-    //! Таблица со списками элементов модели трассы, сгруппированных по классу
-    QHash<int, QList<EntityItem*>*> _items_hash;
-
     //
 
     mutable TraceDataModel _main_trace;
@@ -245,41 +299,49 @@ private:
 
     //
 
-    QHash<QString, pid_index_t> _process_name_hash;
     QHash<quint64, pid_index_t> _process_id_hash;
-    QHash<QString, pid_index_t> _process_user_hash;
-    QHash<QString, module_index_t> _modules_hash;
-    QHash<QString, source_index_t> _sources_hash;
     QHash<FunctionID, function_index_t> _functions_hash;
-    QHash<QString, class_index_t> _class_hash;
-    QHash<QString, label_index_t> _variable_hash;
     QSet<uint8_t> _message_type_set;
 
+    //! Entities by class, names are found by keys of tables. Entities of tables have no items,
+    //! processes and message types are few, so they are kept by items of lists below
+
+    EntityTable _process_name_table;
+    EntityTable _process_user_table;
+    EntityTable _module_table;
+    EntityTable _source_table;
+    EntityTable _function_table;
+    EntityTable _class_table;
+    EntityTable _label_table;
+    EntityTable _thread_table;
+    EntityTable _context_table;
+
     //
 
     QList<EntityItem*> _process_models;
-    QList<EntityItem*> _process_names;
-    QList<EntityItem*> _process_users;
-    QList<EntityItem*> _modules;
-    QList<EntityItem*> _sources;
-    QList<EntityItem*> _functions;
-    QList<EntityItem*> _classes;
-    QList<EntityItem*> _labels;
-    QList<EntityItem*> _threads;
-    QList<EntityItem*> _contexts;
     QList<EntityItem*> _message_types;
 
     QList<EntityItem*> _full_message_types;
-    QList<EntityItem*> _empty_list;
 
     //
 
     QMutex _index_mutex;
     QMutex _append_mutex;
 
+    //! The last result of entity_data() and counts of entities, which it contains
+    QByteArray _entity_data;
+    QVector<qsizetype> _entity_counts;
+    QMutex _entity_data_mutex;
+
     boost::atomic<bool> _model_updated;
     boost::atomic<bool> _index_updated;
 
+    //! Messages, erased by message limit. They are deleted after the next frame, protected by main trace lock
+    QList<const trace_message_t*> _retired_messages;
+
+    //! Messages, retired before the previous frame, which are deleted after the current one
+    QList<const trace_message_t*> _deleted_messages;
+
     ColorGenerator _pid_colorer;
     ColorGenerator _tid_colorer;
     ColorGenerator _context_colorer;
@@ -288,10 +350,30 @@ private:
     QString _loaded_file_name;
 
     uint64_t _index_counter;
+
+    //! Data of loaded trace is in format before version 2
+    bool _legacy_data;
+
     uint64_t _message_limit;
     uint64_t _file_data_limit;
+    uint64_t _trace_memory_limit;
 
     DataStorage _data_storage;
+
+    TraceJournal _journal;
+
+    //! Density of messages of main trace
+    MessageDensity _density;
+
+    //! Calls of main trace by thread
+    CallTimeline _timeline;
+
+    TextIndex _message_texts;
+
+    QHash<int, TextIndex*> _name_indexes;
+
+    QFuture<void> _load_future;
+    boost::atomic<bool> _load_cancelled;
 };
 
 const TraceDataModel &TraceController::trace_model() const
@@ -309,9 +391,43 @@ DataStorage &TraceController::data_storage()
     return _data_storage;
 }
 
-const QHash<int, QList<EntityItem *> *> &TraceController::items_hash() const
+TraceJournal &TraceController::journal()
+{
+    return _journal;
+}
+
+const MessageDensity &TraceController::density() const
+{
+    return _density;
+}
+
+const CallTimeline &TraceController::timeline() const
+{
+    return _timeline;
+}
+
+const TextIndex &TraceController::message_texts() const
+{
+    return _message_texts;
+}
+
+TextIndex *TraceController::name_index(EntityClass class_id) const
 {
-    return _items_hash;
+    return _name_indexes.value(class_id);
+}
+
+void TraceController::account_message(const trace_message_t *message)
+{
+    _density.add(message_time(message), message->type);
+    _density.add_mark(message_time(message), message->index);
+    _timeline.add(message_time(message), message);
+
+    // text of CALL and RETURN is signature of function
+
+    if(message->type > trace_x::MESSAGE_RETURN)
+    {
+        _message_texts.append(message->message_text);
+    }
 }
 
 EntityItem * TraceController::process_item_at(pid_index_t index) const
@@ -334,104 +450,109 @@ const ProcessModel &TraceController::process_at(pid_index_t index) const
     return *static_cast<ProcessModel*>(_process_models.at(index));
 }
 
+quint64 TraceController::message_time(const trace_message_t *message) const
+{
+    return message->timestamp + process_at(message).time_delta();
+}
+
 EntityItem * TraceController::message_type_at(int index) const
 {
     return _full_message_types.at(index);
 }
 
-EntityItem * TraceController::process_name_at(const trace_message_t *message) const
+EntityRow TraceController::process_name_at(const trace_message_t *message) const
 {
     return process_name_at(process_at(message).name_index());
 }
 
-EntityItem *TraceController::process_name_at(pid_index_t index) const
+EntityRow TraceController::process_name_at(pid_index_t index) const
 {
-    return _process_names.at(index);
+    return EntityRow(&_process_name_table, int(index));
 }
 
-EntityItem * TraceController::process_user_at(const trace_message_t *message) const
+EntityRow TraceController::process_user_at(const trace_message_t *message) const
 {
     return process_user_at(process_at(message).user_index());
 }
 
-EntityItem *TraceController::process_user_at(pid_index_t index) const
+EntityRow TraceController::process_user_at(pid_index_t index) const
 {
-    return _process_users.at(index);
+    return EntityRow(&_process_user_table, int(index));
 }
 
-EntityItem * TraceController::module_at(module_index_t index) const
+EntityRow TraceController::module_at(module_index_t index) const
 {
-    return _modules.at(index);
+    return EntityRow(&_module_table, int(index));
 }
 
-EntityItem * TraceController::module_at(const trace_message_t *message) const
+EntityRow TraceController::module_at(const trace_message_t *message) const
 {
     return module_at(message->module_index);
 }
 
-EntityItem * TraceController::source_at(const trace_message_t *message) const
+EntityRow TraceController::source_at(const trace_message_t *message) const
 {
     return source_at(message->source_index);
 }
 
-EntityItem * TraceController::source_at(source_index_t index) const
+EntityRow TraceController::source_at(source_index_t index) const
 {
-    return _sources.at(index);
+    return EntityRow(&_source_table, int(index));
 }
 
-EntityItem * TraceController::function_at(const trace_message_t *message) const
+EntityRow TraceController::function_at(const trace_message_t *message) const
 {
     return function_at(message->function_index);
 }
 
-EntityItem * TraceController::function_at(function_index_t index) const
+EntityRow TraceController::function_at(function_index_t index) const
 {
-    return _functions.at(index);
+    return EntityRow(&_function_table, int(index));
 }
 
-EntityItem * TraceController::class_at(const trace_message_t *message) const
+EntityRow TraceController::class_at(const trace_message_t *message) const
 {
-    return class_at(static_cast<FunctionEntityItem*>(function_at(message))->_class_index);
+    return class_at(message->function_index);
 }
 
-EntityItem *TraceController::class_at(function_index_t index) const
+EntityRow TraceController::class_at(function_index_t index) const
 {
-    return class_at(static_cast<FunctionEntityItem*>(function_at(index))->_class_index);
+    return class_at(class_index_t(_function_table.parent(index)));
 }
 
-EntityItem *TraceController::class_at(class_index_t index) const
+EntityRow TraceController::class_at(class_index_t index) const
 {
-    return _classes.at(index);
+    return EntityRow(&_class_table, int(index));
 }
 
-EntityItem * TraceController::thread_item_at(const trace_message_t *message) const
+EntityRow TraceController::thread_at(const trace_message_t *message) const
 {
-    return _threads.at(message->tid_index);
+    return thread_at(message->tid_index);
 }
 
-EntityItem *TraceController::thread_item_at(tid_index_t index) const
+EntityRow TraceController::thread_at(tid_index_t index) const
 {
-    return _threads.at(index);
+    return EntityRow(&_thread_table, int(index));
 }
 
-EntityItem * TraceController::context_item_at(const trace_message_t *message) const
+EntityRow TraceController::context_at(const trace_message_t *message) const
 {
-    return _contexts.at(message->context_index);
+    return context_at(message->context_index);
 }
 
-EntityItem *TraceController::context_item_at(context_index_t index) const
+EntityRow TraceController::context_at(context_index_t index) const
 {
-    return _contexts.at(index);
+    return EntityRow(&_context_table, int(index));
 }
 
-EntityItem *TraceController::label_item_at(const trace_message_t *message) const
+EntityRow TraceController::label_at(const trace_message_t *message) const
 {
-    return _labels.at(message->label_index);
+    return label_at(message->label_index);
 }
 
-EntityItem *TraceController::label_item_at(label_index_t index) const
+EntityRow TraceController::label_at(label_index_t index) const
 {
-    return _labels.at(index);
+    return EntityRow(&_label_table, int(index));
 }
 
 TransmitterModelService &TraceController::tx_model_service()
@@ -459,19 +580,25 @@ FilterModel * TraceController::capture_filter() const
     return _tx_model_service->active_filter();
 }
 
-const QList<EntityItem *> & TraceController::items_by_class(EntityClass class_id, bool full_types) const
+EntityList TraceController::entities_by_class(EntityClass class_id, bool full_types) const
 {
-    if(!full_types && (class_id == MessageTypeEntity))
-    {
-        return _message_types;
-    }
-
-    if(_items_hash.contains(class_id))
+    switch (class_id)
     {
-        return *_items_hash.value(int(class_id));
+    case ProcessNameEntity:  return EntityList(&_process_name_table);
+    case ProcessIdEntity:    return EntityList(&_process_models);
+    case ProcessUserEntity:  return EntityList(&_process_user_table);
+    case ModuleNameEntity:   return EntityList(&_module_table);
+    case ThreadIdEntity:     return EntityList(&_thread_table);
+    case ContextIdEntity:    return EntityList(&_context_table);
+    case ClassNameEntity:    return EntityList(&_class_table);
+    case FunctionNameEntity: return EntityList(&_function_table);
+    case SourceNameEntity:   return EntityList(&_source_table);
+    case MessageTypeEntity:  return EntityList(full_types ? &_full_message_types : &_message_types);
+    case LabelNameEntity:    return EntityList(&_label_table);
+    case MessageTextEntity:  break;
     }
 
-    return _empty_list;
+    return EntityList();
 }
 
 size_t TraceController::index_by_class(const trace_message_t *message, int class_id) const
@@ -484,7 +611,7 @@ size_t TraceController::index_by_class(const trace_message_t *message, int class
     case ModuleNameEntity:   return message->module_index;
     case ThreadIdEntity:     return message->tid_index;
     case ContextIdEntity:    return message->context_index;
-    case ClassNameEntity:    return (static_cast<FunctionEntityItem*>(function_at(message)))->_class_index;
+    case ClassNameEntity:    return _function_table.parent(message->function_index);
     case FunctionNameEntity: return message->function_index;
     case SourceNameEntity:   return message->source_index;
     case MessageTypeEntity:  return message->type;
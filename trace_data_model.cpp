@@ -1,6 +1,8 @@
 #include "trace_data_model.h"
 
-#include <QTimer>
+#include <algorithm>
+
+#include "frame_scheduler.h"
 
 #include "trace_x/trace_x.h"
 
@@ -15,15 +17,15 @@ TraceDataModel::TraceDataModel(QObject *parent):
     _has_new_messages(false),
     _has_new_indexes(false),
     _emit_refiltered(false),
-    _safe_size(0)
+    _snapshot_reset(false),
+    _index_reset(false),
+    _row_mapped(false),
+    _safe_size(0),
+    _type_indexes(trace_x::_MESSAGE_END_)
 {
     X_CALL;
 
-    QTimer *timer = new QTimer(this);
-
-    connect(timer, &QTimer::timeout, this, &TraceDataModel::check_updates);
-
-    timer->start(100);
+    connect(&FrameScheduler::instance(), &FrameScheduler::frame, this, &TraceDataModel::check_updates);
 }
 
 bool TraceDataModel::find_relative_index(index_t trace_index, index_t &relative_index) const
@@ -32,32 +34,27 @@ bool TraceDataModel::find_relative_index(index_t trace_index, index_t &relative_
 
     QMutexLocker lock(&_trace_mutex);
 
-    int i = 0;
+    size_t count = size();
 
-    for(; i < _trace_list.size(); ++i)
+    size_t row = lower_row(trace_index);
+
+    if(row == count)
     {
-        if(_trace_list[i]->index == trace_index)
-        {
-            relative_index = i;
+        relative_index = count - 1;
 
-            return true;
-        }
-        else if(_trace_list[i]->index > trace_index)
-        {
-            if(i)
-            {
-                relative_index = abs_diff(_trace_list[i]->index, trace_index) < abs_diff(_trace_list[i - 1]->index, trace_index) ? i : i - 1;
-            }
-            else
-            {
-                relative_index = 0;
-            }
-
-            return false;
-        }
+        return false;
+    }
+
+    index_t index = row_index(row);
+
+    if(index == trace_index)
+    {
+        relative_index = row;
+
+        return true;
     }
 
-    relative_index = _trace_list.size() - 1;
+    relative_index = (row && (abs_diff(row_index(row - 1), trace_index) <= abs_diff(index, trace_index))) ? row - 1 : row;
 
     return false;
 }
@@ -72,6 +69,21 @@ void TraceDataModel::append(const trace_message_t *message)
 
     _trace_list.append(message);
 
+    index_type(message->index, message->type);
+
+    _has_new_messages = true;
+
+    _trace_mutex.unlock();
+}
+
+void TraceDataModel::append_row(quint64 row, uint8_t type)
+{
+    _trace_mutex.lock();
+
+    _rows.append(row);
+
+    index_type(_chunk_cache->first_index() + row, type);
+
     _has_new_messages = true;
 
     _trace_mutex.unlock();
@@ -87,7 +99,15 @@ void TraceDataModel::insert(const trace_message_t *message, int index)
 
     _trace_list.insert(index, message);
 
+    if(message->type < _type_indexes.size())
+    {
+        QVector<index_t> &indexes = _type_indexes[message->type];
+
+        indexes.insert(std::upper_bound(indexes.begin(), indexes.end(), message->index), message->index);
+    }
+
     _has_new_messages = true;
+    _snapshot_reset = true;
 
     _trace_mutex.unlock();
 }
@@ -96,11 +116,18 @@ void TraceDataModel::update_index(const trace_message_t *message)
 {
     X_CALL;
 
+    message_index_t index(message->type, message->process_index, message->module_index,
+                          message->tid_index, message->context_index,
+                          message->function_index, message->source_index, message->label_index);
+
     _index_mutex.lock();
 
-    auto result = _model_index.insert(message_index_t(message->type, message->process_index, message->module_index,
-                                                      message->tid_index, message->context_index,
-                                                      message->function_index, message->source_index, message->label_index));
+    auto result = _model_index.insert(index);
+
+    if(result.second)
+    {
+        _new_indexes.append(index);
+    }
 
     _index_mutex.unlock();
 
@@ -110,6 +137,23 @@ void TraceDataModel::update_index(const trace_message_t *message)
     }
 }
 
+QVector<message_index_t> TraceDataModel::take_new_indexes(bool &is_reset)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_index_mutex);
+
+    QVector<message_index_t> indexes;
+
+    indexes.swap(_new_indexes);
+
+    is_reset = _index_reset;
+
+    _index_reset = false;
+
+    return indexes;
+}
+
 void TraceDataModel::emit_refiltered()
 {
     X_CALL;
@@ -121,11 +165,36 @@ void TraceDataModel::emit_updated()
 {
     _trace_mutex.lock();
 
-    _safe_size = _trace_list.size();
+    _safe_size = size();
+
+    _trace_mutex.unlock();
+
+    // updated is emitted on the next frame, together with appended messages
+
+    _has_new_messages = true;
+}
+
+void TraceDataModel::set_chunk_cache(const TraceChunkCachePtr &chunk_cache, bool row_mapped)
+{
+    X_CALL;
+
+    _trace_mutex.lock();
+
+    _chunk_cache = chunk_cache;
+    _row_mapped = row_mapped;
+    _rows = QVector<quint64>();
+
+    _safe_size = size();
+    _snapshot_reset = true;
+
+    // rows of row mapped model are indexed, when they are appended, all rows are indexed by controller
+
+    clear_type_index();
 
     _trace_mutex.unlock();
 
     emit updated();
+    emit cleaned();
 }
 
 void TraceDataModel::set_message_list(const QList<const trace_message_t *> &list)
@@ -135,6 +204,14 @@ void TraceDataModel::set_message_list(const QList<const trace_message_t *> &list
     _trace_list = list;
 
     _safe_size = _trace_list.size();
+    _snapshot_reset = true;
+
+    clear_type_index();
+
+    foreach (const trace_message_t *message, _trace_list)
+    {
+        index_type(message->index, message->type);
+    }
 
     emit updated();
     emit cleaned();
@@ -149,7 +226,14 @@ void TraceDataModel::clear()
 
     _safe_size = 0;
     _trace_list = QList<const trace_message_t*>();
+    _rows = QVector<quint64>();
     _model_index = trace_index_t();
+    _new_indexes.clear();
+    _index_reset = true;
+
+    _snapshot_reset = true;
+
+    clear_type_index();
 
     _trace_mutex.unlock();
     _index_mutex.unlock();
@@ -164,6 +248,140 @@ const QList<const trace_message_t *> &TraceDataModel::trace_list() const
     return _trace_list;
 }
 
+TraceSnapshotPtr TraceDataModel::snapshot()
+{
+    QMutexLocker lock(&_trace_mutex);
+
+    size_t published = _snapshot ? _snapshot->size() : 0;
+
+    bool is_reset = _snapshot_reset.exchange(false) || (size() < published);
+
+    if(_snapshot && !is_reset && (size() == published))
+    {
+        return _snapshot;
+    }
+
+    // full blocks are shared with the previous snapshot, which can be read yet
+
+    trace_snapshot_t *snapshot = (_snapshot && !is_reset) ? new trace_snapshot_t(*_snapshot) : new trace_snapshot_t();
+
+    if(is_reset)
+    {
+        published = 0;
+
+        snapshot->epoch = _snapshot ? _snapshot->epoch + 1 : 0;
+    }
+
+    snapshot->chunk_cache = _chunk_cache;
+    snapshot->row_mapped = _row_mapped;
+
+    if(!_chunk_cache)
+    {
+        snapshot->messages.append(_trace_list, published);
+    }
+    else if(_row_mapped)
+    {
+        snapshot->rows.append(_rows, published);
+    }
+
+    snapshot->count = size();
+
+    _snapshot = TraceSnapshotPtr(snapshot);
+
+    return _snapshot;
+}
+
+index_t TraceDataModel::first_index() const
+{
+    if(_chunk_cache)
+    {
+        return _chunk_cache->first_index() + (_row_mapped ? _rows.first() : 0);
+    }
+
+    return _trace_list.first()->index;
+}
+
+size_t TraceDataModel::lazy_size() const
+{
+    return _row_mapped ? size_t(_rows.size()) : size_t(_chunk_cache->size());
+}
+
+const trace_message_t *TraceDataModel::lazy_at(size_t i) const
+{
+    return _chunk_cache->at(_row_mapped ? _rows.at(int(i)) : i);
+}
+
+index_t TraceDataModel::row_index(size_t row) const
+{
+    if(_chunk_cache)
+    {
+        // indices of trace file rows are sequential
+
+        return _chunk_cache->first_index() + (_row_mapped ? _rows.at(int(row)) : row);
+    }
+
+    return _trace_list.at(int(row))->index;
+}
+
+size_t TraceDataModel::lower_row(index_t trace_index) const
+{
+    if(!_chunk_cache)
+    {
+        return std::lower_bound(_trace_list.constBegin(), _trace_list.constEnd(), trace_index,
+                                [](const trace_message_t *message, index_t index) { return message->index < index; }) - _trace_list.constBegin();
+    }
+
+    index_t first_index = _chunk_cache->first_index();
+
+    quint64 row = (trace_index < first_index) ? 0 : trace_index - first_index;
+
+    if(!_row_mapped)
+    {
+        return qMin<size_t>(row, size());
+    }
+
+    return std::lower_bound(_rows.constBegin(), _rows.constEnd(), row) - _rows.constBegin();
+}
+
+void TraceDataModel::append_type_indexes(const QVector<QVector<index_t>> &indexes)
+{
+    for(int type = 0; type < qMin(indexes.size(), _type_indexes.size()); ++type)
+    {
+        _type_indexes[type].append(indexes.at(type));
+    }
+}
+
+void TraceDataModel::trim_type_index()
+{
+    if(!size())
+    {
+        clear_type_index();
+
+        return;
+    }
+
+    // removing from the head doesn`t move items in Qt 6
+
+    index_t first_index = row_index(0);
+
+    for(int type = 0; type < _type_indexes.size(); ++type)
+    {
+        QVector<index_t> &indexes = _type_indexes[type];
+
+        int removed = int(std::lower_bound(indexes.constBegin(), indexes.constEnd(), first_index) - indexes.constBegin());
+
+        if(removed)
+        {
+            indexes.remove(0, removed);
+        }
+    }
+}
+
+void TraceDataModel::clear_type_index()
+{
+    _type_indexes = QVector<QVector<index_t>>(trace_x::_MESSAGE_END_);
+}
+
 bool TraceDataModel::get_nearest_by_type(index_t current, uint8_t type, index_t &index) const
 {
     X_CALL;
@@ -175,7 +393,7 @@ bool TraceDataModel::get_nearest_by_type(index_t current, uint8_t type, index_t
 
     if(has_next && has_prev)
     {
-        index = qAbs(next_index - index) < qAbs(prev_index - index) ? next_index : prev_index;
+        index = abs_diff(next_index, current) < abs_diff(prev_index, current) ? next_index : prev_index;
     }
     else if(has_next)
     {
@@ -199,19 +417,23 @@ bool TraceDataModel::get_next_by_type(index_t current, uint8_t type, index_t &in
 
     QMutexLocker lock(&_trace_mutex);
 
-    current = relative_index(current);
-
-    for(int i = current; i < _trace_list.size(); ++i)
+    if(type >= _type_indexes.size())
     {
-        if(_trace_list[i]->type == type)
-        {
-            index = trace_index(i);
+        return false;
+    }
 
-            return true;
-        }
+    const QVector<index_t> &indexes = _type_indexes.at(type);
+
+    QVector<index_t>::const_iterator it = std::lower_bound(indexes.constBegin(), indexes.constEnd(), current);
+
+    if(it == indexes.constEnd())
+    {
+        return false;
     }
 
-    return false;
+    index = *it;
+
+    return true;
 }
 
 bool TraceDataModel::get_prev_by_type(index_t current, uint8_t type, index_t &index) const
@@ -220,32 +442,43 @@ bool TraceDataModel::get_prev_by_type(index_t current, uint8_t type, index_t &in
 
     QMutexLocker lock(&_trace_mutex);
 
-    current = relative_index(current);
-
-    for(intptr_t i = current - 1; i >= 0; --i)
+    if(type >= _type_indexes.size())
     {
-        if(_trace_list[i]->type == type)
-        {
-            index = trace_index(i);
+        return false;
+    }
 
-            return true;
-        }
+    const QVector<index_t> &indexes = _type_indexes.at(type);
+
+    QVector<index_t>::const_iterator it = std::lower_bound(indexes.constBegin(), indexes.constEnd(), current);
+
+    if(it == indexes.constBegin())
+    {
+        return false;
     }
 
-    return false;
+    index = *(it - 1);
+
+    return true;
 }
 
 void TraceDataModel::check_updates()
 {
     //X_CALL;
 
+    if(_chunk_cache && !_row_mapped)
+    {
+        // gui doesn`t keep messages between events, so chunks, evicted from cache, are not used
+
+        _chunk_cache->release_retired();
+    }
+
     if(_has_new_messages)
     {
         _has_new_messages = false;
 
         _trace_mutex.lock();
 
-        _safe_size = _trace_list.size();
+        _safe_size = size();
 
         _trace_mutex.unlock();
 
@@ -7,8 +7,78 @@
 #include <boost/atomic.hpp>
 
 #include "trace_model.h"
+#include "trace_file.h"
 #include "tx_index.h"
 
+//! Append-only list of snapshot. Blocks are implicitly shared between snapshots,
+//! so appending copies only new items and detaches the last block
+template<typename T>
+struct snapshot_list_t
+{
+    enum
+    {
+        BlockSize = 4096
+    };
+
+    snapshot_list_t(): size(0) {}
+
+    inline const T &at(size_t i) const { return blocks.at(int(i / BlockSize)).at(int(i % BlockSize)); }
+
+    //! Appends items [first, list.size()) of list
+    template<typename L>
+    void append(const L &list, size_t first)
+    {
+        for(size_t i = first; i < size_t(list.size()); ++i)
+        {
+            if(!(size % BlockSize))
+            {
+                blocks.append(QVector<T>());
+                blocks.last().reserve(BlockSize);
+            }
+
+            blocks.last().append(list.at(int(i)));
+
+            size++;
+        }
+    }
+
+    QVector<QVector<T>> blocks;
+    size_t size;
+};
+
+//! Immutable rows of data model, which are read by gui without lock of model
+struct trace_snapshot_t
+{
+    trace_snapshot_t(): row_mapped(false), count(0), epoch(0) {}
+
+    inline size_t size() const { return count; }
+
+    //! Messages of lazy snapshot are valid until return to event loop
+    inline const trace_message_t *at(size_t i) const
+    {
+        return chunk_cache ? chunk_cache->at(row_mapped ? rows.at(i) : i) : messages.at(i);
+    }
+
+    //! Message for reading in other threads. Chunk of lazy message is held by chunk argument
+    inline const trace_message_t *stream_at(size_t i, TraceChunkDataPtr &chunk) const
+    {
+        return chunk_cache ? chunk_cache->stream_at(row_mapped ? rows.at(i) : i, chunk) : messages.at(i);
+    }
+
+    snapshot_list_t<const trace_message_t*> messages;
+
+    TraceChunkCachePtr chunk_cache;
+    snapshot_list_t<quint64> rows;
+    bool row_mapped;
+
+    size_t count;
+
+    //! Incremented, when rows are removed or replaced. Messages of snapshot with previous epoch may be deleted
+    quint64 epoch;
+};
+
+typedef QSharedPointer<const trace_snapshot_t> TraceSnapshotPtr;
+
 //! Класс модели данных трассы
 class TraceDataModel : public QObject
 {
@@ -17,31 +87,69 @@ class TraceDataModel : public QObject
 public:
     explicit TraceDataModel(QObject *parent = 0);
 
-    inline size_t size() const { return _trace_list.count(); }
+    inline size_t size() const { return _chunk_cache ? lazy_size() : _trace_list.count(); }
     inline size_t safe_size() const { return _safe_size; }
 
     inline void remove_first(index_t index)
     {
-        if(!_trace_list.isEmpty() && (_trace_list.first()->index == index))
+        if(!_chunk_cache && !_trace_list.isEmpty() && (_trace_list.first()->index == index))
         {
-            _trace_list.removeFirst();
+            uint8_t type = _trace_list.takeFirst()->type;
+
+            _snapshot_reset = true;
+
+            if((type < _type_indexes.size()) && !_type_indexes.at(type).isEmpty() && (_type_indexes.at(type).first() == index))
+            {
+                _type_indexes[type].removeFirst();
+            }
         }
     }
 
-    //! return false, if equal index is not finded. In this case relative_index contains nearest relative index
+    //! return false, if equal index is not finded. In this case relative_index contains nearest relative index.
+    //! Indexes of messages grow with rows, so row is found by binary search
     bool find_relative_index(index_t trace_index, index_t &relative_index) const;
 
-    index_t relative_index(index_t index) const { return index - _trace_list.first()->index; }
-    index_t trace_index(index_t index) const { return index + _trace_list.first()->index; }
+    index_t relative_index(index_t index) const { return index - first_index(); }
+    index_t trace_index(index_t index) const { return index + first_index(); }
+
+    //! Messages of lazy model are valid until return to event loop, threads except gui use for_each_message()
+    inline trace_message_t *at(size_t i) { return const_cast<trace_message_t*>(_chunk_cache ? lazy_at(i) : _trace_list[int(i)]); }
+    inline const trace_message_t *at(size_t i) const { return _chunk_cache ? lazy_at(i) : _trace_list.at(int(i)); }
+    inline trace_message_t get(size_t i) const { return *at(i); }
+    inline const trace_message_t *safe_at(size_t i) const { QMutexLocker locker(&_trace_mutex); return at(i); }
+    inline const trace_message_t *value(size_t i) const { QMutexLocker locker(&_trace_mutex); return (i < size()) ? at(i) : 0; }
+
+    //! Calls function(i, message) for messages [first, last), while it returns true. Returns false, if loop is broken.
+    //! Messages of lazy model are read by chunks without caching, message is valid only during the call
+    template<typename F>
+    bool for_each_message(size_t first, size_t last, F function) const
+    {
+        TraceChunkDataPtr chunk;
+
+        for(size_t i = first; i < last; ++i)
+        {
+            const trace_message_t *message = _chunk_cache ? _chunk_cache->stream_at(_row_mapped ? _rows.at(int(i)) : i, chunk) : _trace_list.at(int(i));
 
-    inline trace_message_t *at(size_t i) { return const_cast<trace_message_t*>(_trace_list[int(i)]); }
-    inline const trace_message_t *at(size_t i) const { return _trace_list.at(int(i)); }
-    inline trace_message_t get(size_t i) const { return *_trace_list.at(int(i)); }
-    inline const trace_message_t *safe_at(size_t i) const { QMutexLocker locker(&_trace_mutex); return _trace_list.at(i); }
-    inline const trace_message_t *value(size_t i) const { QMutexLocker locker(&_trace_mutex); return _trace_list.value(i, 0); }
+            if(!function(i, message))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //! Makes model lazy, so messages are decoded from trace file on demand.
+    //! Row mapped model contains appended rows of trace file, else - all rows
+    void set_chunk_cache(const TraceChunkCachePtr &chunk_cache, bool row_mapped = false);
+    const TraceChunkCachePtr &chunk_cache() const { return _chunk_cache; }
+    bool is_lazy() const { return !_chunk_cache.isNull(); }
 
     void append(const trace_message_t *message);
-    void append_fast(const trace_message_t *message) { _trace_list.append(message);  _has_new_messages = true; }
+    void append_fast(const trace_message_t *message) { _trace_list.append(message); index_type(message->index, message->type); _has_new_messages = true; }
+
+    //! Appends row of trace file to row mapped model, type of message is indexed without decoding
+    void append_row(quint64 row, uint8_t type);
     void insert(const trace_message_t *message, int index);
     void update_index(const trace_message_t *message);
     void emit_refiltered();
@@ -62,10 +170,40 @@ public:
 
     const trace_index_t & index_model() const { return _model_index; }
 
+    //! Index entries, inserted after the previous call. is_reset is set, if index was cleared before them
+    QVector<message_index_t> take_new_indexes(bool &is_reset);
+
+    //! Publishes rows, appended after the previous snapshot. Called in gui thread, when model is updated,
+    //! so table models read snapshot between updates without lock
+    TraceSnapshotPtr snapshot();
+
+    //! Called after rows of trace_list() are removed or replaced, so the next snapshot is built again
+    void reset_snapshot() { _snapshot_reset = true; }
+
+    //! Appends index of message to indexes of it`s type. Called under lock, when message is appended to trace_list() directly
+    inline void index_type(index_t index, uint8_t type) { if(type < _type_indexes.size()) _type_indexes[type].append(index); }
+
+    //! Appends indexes of messages, which are collected by type without lock. Called under lock
+    void append_type_indexes(const QVector<QVector<index_t>> &indexes);
+
+    //! Drops indexes of messages, which are removed from the head of model. Called under lock
+    void trim_type_index();
+
+    //! Called under lock, after rows of trace_list() are replaced
+    void clear_type_index();
+
+    //! Messages of type are found by binary search in indexes of messages of type
     bool get_nearest_by_type(index_t current, uint8_t type, index_t &index) const;
     bool get_next_by_type(index_t current, uint8_t type, index_t &index) const;
     bool get_prev_by_type(index_t current, uint8_t type, index_t &index) const;
 
+    //! Index of message of row, lazy message is not decoded. Called under lock
+    index_t row_index(size_t row) const;
+
+    //! The first row, which index of message isn`t less than trace_index, or size(). Called under lock.
+    //! Rows are removed from the head of model, so readers continue from index of message instead of row
+    size_t lower_row(index_t trace_index) const;
+
 signals:
     void updated();
     void cleaned();
@@ -75,6 +213,12 @@ signals:
 private slots:
     void check_updates();
 
+private:
+    index_t first_index() const;
+
+    size_t lazy_size() const;
+    const trace_message_t *lazy_at(size_t i) const;
+
 private:
     friend class TraceController;
     friend class TraceModelService;
@@ -85,11 +229,30 @@ private:
     boost::atomic<bool> _has_new_messages;
     boost::atomic<bool> _has_new_indexes;
     boost::atomic<bool> _emit_refiltered;
+    boost::atomic<bool> _snapshot_reset;
 
     QList<const trace_message_t*> _trace_list;
     mutable trace_index_t _model_index;
 
+    //! Index entries, which are not taken by entity model yet
+    QVector<message_index_t> _new_indexes;
+    bool _index_reset;
+
+    //! Decoded chunks of lazy model
+    TraceChunkCachePtr _chunk_cache;
+
+    //! Rows of trace file in row mapped model
+    QVector<quint64> _rows;
+    bool _row_mapped;
+
     size_t _safe_size; //! thread-safe size field, used in main gui thread
+
+    //! Sorted indexes of messages of each type. Messages are indexed, when they are appended,
+    //! so navigation by type doesn`t read messages of model
+    QVector<QVector<index_t>> _type_indexes;
+
+    //! The last published snapshot, used in gui thread only
+    TraceSnapshotPtr _snapshot;
 };
 
 #endif // TRACE_DATA_MODEL_H
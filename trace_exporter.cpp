@@ -0,0 +1,442 @@
+#include "trace_exporter.h"
+
+#include <QAbstractItemModel>
+
+#include "trace_controller.h"
+#include "call_tree_model.h"
+#include "profile_model.h"
+
+#include "trace_x/trace_x.h"
+
+namespace
+{
+
+//! Messages count, which is read from trace under one lock
+const size_t ReadChunkSize = 4096;
+
+QByteArray json_escape(const QString &string)
+{
+    QByteArray utf8 = string.toUtf8();
+    QByteArray result;
+
+    result.reserve(utf8.size() + 2);
+
+    for(char c : utf8)
+    {
+        switch (c)
+        {
+        case '"':  result.append("\\\""); break;
+        case '\\': result.append("\\\\"); break;
+        case '\n': result.append("\\n"); break;
+        case '\r': result.append("\\r"); break;
+        case '\t': result.append("\\t"); break;
+        default:
+            if(uchar(c) < 0x20)
+            {
+                result.append(QString("\\u%1").arg(int(c), 4, 16, QChar('0')).toLatin1());
+            }
+            else
+            {
+                result.append(c);
+            }
+        }
+    }
+
+    return result;
+}
+
+QByteArray csv_escape(const QString &string)
+{
+    if(string.contains(',') || string.contains('"') || string.contains('\n'))
+    {
+        return QString(string).replace("\"", "\"\"").prepend('"').append('"').toUtf8();
+    }
+
+    return string.toUtf8();
+}
+
+//! Frame name in folded stacks can`t contain ';' and spaces are not recommended
+QByteArray folded_frame(const QString &string)
+{
+    return QString(string).replace(';', ':').replace(' ', '_').toUtf8();
+}
+
+QByteArray microseconds(uint64_t time)
+{
+    return QByteArray::number(time / 1000) + '.' + QByteArray::number(time % 1000).rightJustified(3, '0');
+}
+
+//! Calls function for every message of trace_data. Trace is locked only while reading of chunk,
+//! so capture is not blocked during export
+template<typename F>
+void for_each_message(TraceDataModel *trace_data, F function)
+{
+    if(trace_data->is_lazy())
+    {
+        // lazy trace is loaded from file and isn`t changed, it`s messages are valid only while chunk is read
+
+        trace_data->for_each_message(0, trace_data->size(), [&function](size_t, const trace_message_t *message)
+        {
+            function(message);
+
+            return true;
+        });
+
+        return;
+    }
+
+    // messages, removed from the head of trace by message limit, are deleted after the next frame, while export
+    // of chunk may take longer, so chunk is copied under lock. Strings of copies are shared with messages
+
+    QVector<trace_message_t> chunk;
+
+    chunk.reserve(ReadChunkSize);
+
+    index_t next_index = 0;
+
+    for(bool is_first_chunk = true;; is_first_chunk = false)
+    {
+        chunk.clear();
+
+        trace_data->lock();
+
+        // rows are removed from the head of trace, so export is continued from index of message instead of row
+
+        size_t first = trace_data->lower_row(next_index);
+        size_t last = qMin(trace_data->size(), first + ReadChunkSize);
+
+        if(!is_first_chunk && !first && (first < last) && (trace_data->row_index(0) > next_index))
+        {
+            X_WARNING_F("trace is truncated during export, messages from {} to {} are skipped", next_index, trace_data->row_index(0));
+        }
+
+        for(size_t i = first; i < last; ++i)
+        {
+            chunk.append(*trace_data->at(i));
+        }
+
+        if(first < last)
+        {
+            next_index = trace_data->row_index(last - 1) + 1;
+        }
+
+        trace_data->unlock();
+
+        if(chunk.isEmpty())
+        {
+            break;
+        }
+
+        for(const trace_message_t &message : chunk)
+        {
+            function(&message);
+        }
+    }
+}
+
+}
+
+BufferedWriter::BufferedWriter(const QString &file_name):
+    _file(file_name),
+    _ok(false)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    close();
+}
+
+bool BufferedWriter::open()
+{
+    X_CALL;
+
+    _ok = _file.open(QFile::WriteOnly | QFile::Truncate);
+
+    if(!_ok)
+    {
+        X_ERROR("can`t open {} for export", _file.fileName());
+    }
+
+    _buffer.reserve(BufferSize);
+
+    return _ok;
+}
+
+bool BufferedWriter::close()
+{
+    if(_file.isOpen())
+    {
+        flush();
+
+        _file.close();
+    }
+
+    return _ok;
+}
+
+void BufferedWriter::write(const char *data, int size)
+{
+    if(_buffer.size() + size > BufferSize)
+    {
+        flush();
+
+        if(size > BufferSize)
+        {
+            _ok = _ok && (_file.write(data, size) == size);
+
+            return;
+        }
+    }
+
+    _buffer.append(data, size);
+}
+
+void BufferedWriter::write(const char *data)
+{
+    write(data, int(qstrlen(data)));
+}
+
+void BufferedWriter::write_number(quint64 value)
+{
+    char digits[24];
+
+    int position = sizeof(digits);
+
+    do
+    {
+        digits[--position] = char('0' + value % 10);
+
+        value /= 10;
+    }
+    while(value);
+
+    write(digits + position, int(sizeof(digits)) - position);
+}
+
+bool BufferedWriter::flush()
+{
+    if(!_buffer.isEmpty())
+    {
+        _ok = _ok && (_file.write(_buffer) == _buffer.size());
+
+        _buffer.resize(0);
+    }
+
+    return _ok;
+}
+
+/* ===================================================================================== */
+
+ExportFormat export_format_by_name(const QString &name)
+{
+    if(name == "chrome" || name == "json") return ChromeTraceFormat;
+    if(name == "folded") return FoldedStacksFormat;
+    if(name == "csv") return ProfileCsvFormat;
+
+    return UnknownFormat;
+}
+
+bool export_chrome_trace(const QString &file_name, TraceController *controller, TraceDataModel *trace_data)
+{
+    X_CALL_F;
+
+    BufferedWriter writer(file_name);
+
+    if(!writer.open())
+    {
+        return false;
+    }
+
+    writer.write("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    bool first_event = true;
+
+    // process and thread names
+
+    foreach (EntityItem *item, *controller->process_models())
+    {
+        const ProcessModel *process = static_cast<const ProcessModel*>(item);
+
+        writer.write(first_event ? "" : ",\n");
+        writer.write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":");
+        writer.write_number(process->pid());
+        writer.write(",\"args\":{\"name\":\"");
+        writer.write(::json_escape(process->name()));
+        writer.write("\"}}");
+
+        first_event = false;
+    }
+
+    QVector<bool> thread_registered(controller->entities_by_class(ThreadIdEntity).size(), false);
+
+    // spans
+
+    ::for_each_message(trace_data, [&](const trace_message_t *message)
+    {
+        if(message->type != trace_x::MESSAGE_RETURN)
+        {
+            return;
+        }
+
+        const ProcessModel &process = controller->process_at(message);
+
+        QByteArray tid = controller->thread_at(message).text().toLatin1();
+
+        if((message->tid_index < thread_registered.size()) && !thread_registered.at(message->tid_index))
+        {
+            thread_registered[message->tid_index] = true;
+
+            writer.write(first_event ? "" : ",\n");
+            writer.write("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+            writer.write_number(process.pid());
+            writer.write(",\"tid\":");
+            writer.write(tid);
+            writer.write(",\"args\":{\"name\":\"");
+            writer.write(tid);
+            writer.write("\"}}");
+
+            first_event = false;
+        }
+
+        uint64_t duration = message->timestamp - message->extra_timestamp;
+        uint64_t start_time = message->extra_timestamp + process.time_delta();
+
+        writer.write(first_event ? "" : ",\n");
+        writer.write("{\"name\":\"");
+        writer.write(::json_escape(controller->function_at(message).text()));
+        writer.write("\",\"cat\":\"");
+        writer.write(::json_escape(controller->module_at(message).text()));
+        writer.write("\",\"ph\":\"X\",\"ts\":");
+        writer.write(::microseconds(start_time));
+        writer.write(",\"dur\":");
+        writer.write(::microseconds(duration));
+        writer.write(",\"pid\":");
+        writer.write_number(process.pid());
+        writer.write(",\"tid\":");
+        writer.write(tid);
+        writer.write("}");
+
+        first_event = false;
+    });
+
+    writer.write("\n]}\n");
+
+    return writer.close();
+}
+
+bool export_folded_stacks(const QString &file_name, TraceController *controller, TraceDataModel *trace_data)
+{
+    X_CALL_F;
+
+    BufferedWriter writer(file_name);
+
+    if(!writer.open())
+    {
+        return false;
+    }
+
+    CallTree call_tree;
+
+    ::for_each_message(trace_data, [&call_tree](const trace_message_t *message)
+    {
+        call_tree.append(message);
+    });
+
+    QVector<QByteArray> function_names(controller->entities_by_class(FunctionNameEntity).size());
+
+    for(int i = 0; i < call_tree.size(); ++i)
+    {
+        const call_node_t &node = call_tree.node(i);
+
+        if((node.parent == -1) || !node.exclusive_time)
+        {
+            continue;
+        }
+
+        writer.write(::folded_frame(controller->process_at(node.process_index).name()));
+        writer.write(";");
+        writer.write(::folded_frame(controller->thread_at(node.thread_index).text()));
+
+        foreach (function_index_t function_index, call_tree.path(i))
+        {
+            QByteArray &name = function_names[int(function_index)];
+
+            if(name.isEmpty())
+            {
+                name = ::folded_frame(controller->function_at(function_index).text());
+            }
+
+            writer.write(";");
+            writer.write(name);
+        }
+
+        writer.write(" ");
+        writer.write_number(node.exclusive_time);
+        writer.write("\n");
+    }
+
+    return writer.close();
+}
+
+bool export_csv(const QString &file_name, const QAbstractItemModel *model, int role)
+{
+    X_CALL_F;
+
+    BufferedWriter writer(file_name);
+
+    if(!writer.open())
+    {
+        return false;
+    }
+
+    for(int column = 0; column < model->columnCount(); ++column)
+    {
+        writer.write(column ? "," : "");
+        writer.write(::csv_escape(model->headerData(column, Qt::Horizontal, role).toString()));
+    }
+
+    writer.write("\n");
+
+    for(int row = 0; row < model->rowCount(); ++row)
+    {
+        for(int column = 0; column < model->columnCount(); ++column)
+        {
+            writer.write(column ? "," : "");
+            writer.write(::csv_escape(model->index(row, column).data(role).toString()));
+        }
+
+        writer.write("\n");
+    }
+
+    return writer.close();
+}
+
+bool export_profile_csv(const QString &file_name, TraceController *controller, TraceDataModel *trace_data)
+{
+    X_CALL_F;
+
+    ProfileModel profile_model(controller, trace_data);
+
+    return export_csv(file_name, &profile_model, ProfileModel::ExportRole);
+}
+
+bool export_trace(ExportFormat format, const QString &file_name, TraceController *controller, TraceDataModel *trace_data)
+{
+    X_CALL_F;
+
+    X_INFO_F("export trace to {}", file_name);
+
+    switch (format)
+    {
+    case ChromeTraceFormat:  return export_chrome_trace(file_name, controller, trace_data);
+    case FoldedStacksFormat: return export_folded_stacks(file_name, controller, trace_data);
+    case ProfileCsvFormat:   return export_profile_csv(file_name, controller, trace_data);
+    default:
+        break;
+    }
+
+    X_ERROR_F("unknown export format");
+
+    return false;
+}
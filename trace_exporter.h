@@ -0,0 +1,74 @@
+#ifndef TRACE_EXPORTER_H
+#define TRACE_EXPORTER_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+
+class QAbstractItemModel;
+class TraceController;
+class TraceDataModel;
+
+//! File writer with fixed size buffer.
+//! Data is flushed to file, when buffer is full, so memory usage doesn`t depend on size of output
+class BufferedWriter
+{
+public:
+    enum
+    {
+        BufferSize = 1024 * 1024
+    };
+
+    explicit BufferedWriter(const QString &file_name);
+    ~BufferedWriter();
+
+    bool open();
+    bool close();
+
+    bool is_ok() const { return _ok; }
+
+    void write(const char *data, int size);
+    void write(const char *data);
+    void write(const QByteArray &data) { write(data.constData(), data.size()); }
+    void write(const QString &data) { write(data.toUtf8()); }
+
+    void write_number(quint64 value);
+
+    bool flush();
+
+private:
+    QFile _file;
+    QByteArray _buffer;
+
+    bool _ok;
+};
+
+//! Export formats, supported by export_trace
+enum ExportFormat
+{
+    ChromeTraceFormat = 0, //! Chrome trace-event JSON (chrome://tracing, Perfetto, Speedscope)
+    FoldedStacksFormat,    //! Folded stacks (flamegraph.pl, Speedscope, Inferno)
+    ProfileCsvFormat,      //! Profile aggregates in CSV
+
+    UnknownFormat
+};
+
+ExportFormat export_format_by_name(const QString &name);
+
+//! Writes CALL/RETURN spans as complete ("X") events of Chrome trace-event format.
+//! Every span is written on RETURN message, so no call state is kept
+bool export_chrome_trace(const QString &file_name, TraceController *controller, TraceDataModel *trace_data);
+
+//! Writes exclusive time of every unique call stack in folded stacks format: "process;thread;f1;f2 time_ns".
+//! Memory usage is proportional to number of unique call stacks, not to the trace size
+bool export_folded_stacks(const QString &file_name, TraceController *controller, TraceDataModel *trace_data);
+
+//! Writes all rows of table model in CSV. Header and values are taken with given role
+bool export_csv(const QString &file_name, const QAbstractItemModel *model, int role = Qt::DisplayRole);
+
+//! Writes profile of trace_data in CSV
+bool export_profile_csv(const QString &file_name, TraceController *controller, TraceDataModel *trace_data);
+
+bool export_trace(ExportFormat format, const QString &file_name, TraceController *controller, TraceDataModel *trace_data);
+
+#endif // TRACE_EXPORTER_H
@@ -0,0 +1,451 @@
+#include "trace_file.h"
+
+#include <algorithm>
+
+#include "trace_x/trace_x.h"
+
+namespace
+{
+
+void append_message(QDataStream &stream, QList<const trace_message_t*> &list)
+{
+    trace_message_t *message = new trace_message_t;
+
+    stream >> *message;
+
+    list << message;
+}
+
+void append_message(QDataStream &stream, QVector<trace_message_t> &list)
+{
+    list.append(trace_message_t());
+
+    stream >> list.last();
+}
+
+//! Uncompresses chunk and appends it`s messages to list
+template<typename List>
+void read_messages(const QByteArray &data, int stream_version, List &list)
+{
+    X_CALL_F;
+
+    QByteArray data_array = qUncompress(data);
+
+    QDataStream stream(data_array);
+
+    stream.setVersion(stream_version);
+
+    quint32 count = 0;
+
+    stream >> count;
+
+    list.reserve(count);
+
+    for(quint32 i = 0; (i < count) && (stream.status() == QDataStream::Ok); ++i)
+    {
+        append_message(stream, list);
+    }
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        X_ERROR_F("can`t decode chunk: {} of {} messages", list.size(), count);
+    }
+}
+
+}
+
+QByteArray encode_chunk(const QList<const trace_message_t*> &list, int first, int count, int stream_version, trace_chunk_t &chunk)
+{
+    X_CALL_F;
+
+    QByteArray data_array;
+
+    QDataStream stream(&data_array, QIODevice::WriteOnly);
+
+    stream.setVersion(stream_version);
+
+    stream << quint32(count);
+
+    chunk.first_row = first;
+    chunk.row_count = count;
+    chunk.first_time = count ? list.at(first)->timestamp : 0;
+    chunk.last_time = chunk.first_time;
+
+    for(int i = first; i < first + count; ++i)
+    {
+        const trace_message_t *message = list.at(i);
+
+        // timestamps of different processes are not ordered
+
+        chunk.first_time = qMin<quint64>(chunk.first_time, message->timestamp);
+        chunk.last_time = qMax<quint64>(chunk.last_time, message->timestamp);
+
+        stream << *message;
+    }
+
+    QByteArray compressed_data = qCompress(data_array);
+
+    chunk.size = compressed_data.size();
+
+    return compressed_data;
+}
+
+QList<const trace_message_t*> decode_chunk(const QByteArray &data, int stream_version)
+{
+    X_CALL_F;
+
+    QList<const trace_message_t*> result;
+
+    read_messages(data, stream_version, result);
+
+    return result;
+}
+
+/* ===================================================================================== */
+
+TraceChunkCache::TraceChunkCache(size_t budget):
+    _file_memory(0),
+    _stream_version(0),
+    _first_index(0),
+    _budget(budget),
+    _size(0)
+{
+}
+
+TraceChunkCache::~TraceChunkCache()
+{
+    // file is unmapped on close
+}
+
+bool TraceChunkCache::open(const QString &file_name, const QList<trace_chunk_t> &chunks, int stream_version)
+{
+    X_CALL;
+
+    _file.setFileName(file_name);
+
+    if(!_file.open(QFile::ReadOnly))
+    {
+        X_ERROR("can`t open {}", file_name);
+
+        return false;
+    }
+
+    _file_memory = _file.map(0, _file.size());
+
+    if(!_file_memory)
+    {
+        X_INFO("{} can`t be mapped, chunks are read by seek", file_name);
+    }
+
+    _chunks = chunks;
+    _stream_version = stream_version;
+
+    if(!_chunks.isEmpty())
+    {
+        _first_index = at(0)->index;
+    }
+
+    return true;
+}
+
+quint64 TraceChunkCache::size() const
+{
+    return _chunks.isEmpty() ? 0 : _chunks.last().first_row + _chunks.last().row_count;
+}
+
+index_t TraceChunkCache::first_index() const
+{
+    return _first_index;
+}
+
+const trace_message_t *TraceChunkCache::at(quint64 row)
+{
+    QMutexLocker lock(&_mutex);
+
+    if(!_last_chunk || !_last_chunk->contains(row))
+    {
+        int chunk_number = find_chunk(row);
+
+        if(chunk_number < 0)
+        {
+            return 0;
+        }
+
+        QHash<int, TraceChunkDataPtr>::const_iterator it = _cache.constFind(chunk_number);
+
+        if(it != _cache.constEnd())
+        {
+            _last_chunk = it.value();
+
+            _lru_list.removeOne(chunk_number);
+            _lru_list.append(chunk_number);
+        }
+        else
+        {
+            _last_chunk = decode(chunk_number);
+
+            if(!_marks.isEmpty())
+            {
+                apply_marks(*_last_chunk, _marks);
+            }
+
+            _cache.insert(chunk_number, _last_chunk);
+            _lru_list.append(chunk_number);
+
+            _size += _last_chunk->size;
+
+            trim();
+        }
+    }
+
+    return &_last_chunk->messages.at(int(row - _last_chunk->first_row));
+}
+
+const trace_message_t *TraceChunkCache::stream_at(quint64 row, TraceChunkDataPtr &chunk) const
+{
+    if(!chunk || !chunk->contains(row))
+    {
+        int chunk_number = find_chunk(row);
+
+        if(chunk_number < 0)
+        {
+            return 0;
+        }
+
+        search_marks_t marks;
+
+        {
+            QMutexLocker lock(&_mutex);
+
+            chunk = _cache.value(chunk_number);
+            marks = _marks;
+        }
+
+        if(!chunk)
+        {
+            chunk = decode(chunk_number);
+
+            if(!marks.isEmpty())
+            {
+                apply_marks(*chunk, marks);
+            }
+        }
+    }
+
+    return &chunk->messages.at(int(row - chunk->first_row));
+}
+
+void TraceChunkCache::release_retired()
+{
+    QMutexLocker lock(&_mutex);
+
+    _retired.clear();
+}
+
+void TraceChunkCache::set_search_marks(const search_marks_t &marks)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _marks = marks;
+
+    for(QHash<int, TraceChunkDataPtr>::iterator it = _cache.begin(); it != _cache.end(); ++it)
+    {
+        // messages of copy are detached, when they are marked
+
+        TraceChunkDataPtr chunk(new trace_chunk_data_t(*it.value()));
+
+        apply_marks(*chunk, _marks);
+
+        _retired.append(it.value());
+
+        it.value() = chunk;
+    }
+
+    _last_chunk.clear();
+}
+
+void TraceChunkCache::set_budget(size_t size)
+{
+    X_CALL;
+
+    QMutexLocker lock(&_mutex);
+
+    _budget = size;
+
+    X_VALUE(_budget);
+
+    trim();
+}
+
+int TraceChunkCache::find_chunk(quint64 row) const
+{
+    QList<trace_chunk_t>::const_iterator it = std::upper_bound(_chunks.constBegin(), _chunks.constEnd(), row,
+                                                               [](quint64 row, const trace_chunk_t &chunk) { return row < chunk.first_row; });
+
+    if(it == _chunks.constBegin())
+    {
+        return -1;
+    }
+
+    --it;
+
+    if(row >= it->first_row + it->row_count)
+    {
+        return -1;
+    }
+
+    return int(it - _chunks.constBegin());
+}
+
+TraceChunkDataPtr TraceChunkCache::decode(int chunk_number) const
+{
+    X_CALL;
+
+    const trace_chunk_t &chunk = _chunks.at(chunk_number);
+
+    QByteArray data;
+
+    if(_file_memory)
+    {
+        // mapped chunk is uncompressed without copying
+
+        data = QByteArray::fromRawData(reinterpret_cast<const char*>(_file_memory + chunk.offset), qsizetype(chunk.size));
+    }
+    else
+    {
+        QMutexLocker lock(&_file_mutex);
+
+        _file.seek(chunk.offset);
+
+        data = _file.read(chunk.size);
+    }
+
+    TraceChunkDataPtr result(new trace_chunk_data_t);
+
+    result->first_row = chunk.first_row;
+
+    read_messages(data, _stream_version, result->messages);
+
+    if(result->messages.size() < qsizetype(chunk.row_count))
+    {
+        // rows of broken chunk stay addressable
+
+        result->messages.resize(chunk.row_count);
+    }
+
+    result->size = sizeof(trace_chunk_data_t) + size_t(result->messages.capacity()) * sizeof(trace_message_t);
+
+    foreach (const trace_message_t &message, result->messages)
+    {
+        result->size += size_t(message.message_text.capacity()) * sizeof(QChar);
+    }
+
+    return result;
+}
+
+void TraceChunkCache::apply_marks(trace_chunk_data_t &data, const search_marks_t &marks)
+{
+    for(int i = 0; i < data.messages.size(); ++i)
+    {
+        trace_message_t &message = data.messages[i];
+
+        search_marks_t::const_iterator it = marks.constFind(data.first_row + i);
+
+        if(it != marks.constEnd())
+        {
+            message.flags = SearchHighlighted;
+            message.search_indexes = it.value();
+        }
+        else if(message.flags)
+        {
+            message.flags = 0;
+            message.search_indexes.clear();
+        }
+    }
+}
+
+void TraceChunkCache::trim()
+{
+    // evicted chunks can be viewed yet, so they are freed by release_retired()
+
+    while((_size > _budget) && (_lru_list.size() > MinCachedChunks))
+    {
+        TraceChunkDataPtr chunk = _cache.take(_lru_list.takeFirst());
+
+        _size -= chunk->size;
+
+        _retired.append(chunk);
+    }
+}
+
+QDataStream & operator << (QDataStream &out, const trace_chunk_t &value)
+{
+    out << value.offset << value.size << value.first_row << value.row_count << value.first_time << value.last_time;
+
+    return out;
+}
+
+QDataStream & operator >> (QDataStream &in, trace_chunk_t &value)
+{
+    in >> value.offset >> value.size >> value.first_row >> value.row_count >> value.first_time >> value.last_time;
+
+    return in;
+}
+
+QDataStream & operator << (QDataStream &out, const trace_footer_t &value)
+{
+    out << value.entity_data << value.chunks;
+
+    return out;
+}
+
+QDataStream & operator >> (QDataStream &in, trace_footer_t &value)
+{
+    in >> value.entity_data >> value.chunks;
+
+    return in;
+}
+
+QDataStream & operator << (QDataStream &out, const trace_message_t &value)
+{
+    out << quint64(value.index);
+    out << value.type;
+    out << quint64(value.timestamp);
+    out << quint64(value.extra_timestamp);
+    out << value.process_index;
+    out << value.tid_index;
+    out << value.context_index;
+    out << value.module_index;
+    out << value.function_index;
+    out << value.label_index;
+    out << value.source_index;
+    out << value.source_line;
+    out << value.call_level;
+    out << value.message_text;
+
+    return out;
+}
+
+QDataStream & operator >> (QDataStream &in, trace_message_t &value)
+{
+    quint64 index; in >> index; value.index = index;
+    in >> value.type;
+    quint64 timestamp; in >> timestamp; value.timestamp = timestamp;
+    quint64 extra_timestamp; in >> extra_timestamp; value.extra_timestamp = extra_timestamp;
+    in >> value.process_index;
+    in >> value.tid_index;
+    in >> value.context_index;
+    in >> value.module_index;
+    in >> value.function_index;
+    in >> value.label_index;
+    in >> value.source_index;
+    in >> value.source_line;
+    in >> value.call_level;
+    in >> value.message_text;
+
+    value.flags = 0;
+
+    return in;
+}
@@ -0,0 +1,170 @@
+#ifndef TRACE_FILE_H
+#define TRACE_FILE_H
+
+#include <QDataStream>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QFile>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "trace_model.h"
+
+//! Versions of trace file:
+//! 1 - image data is serialized by QDataStream,
+//! 2 - image data is stored as received,
+//! 3 - messages are stored in independently compressed chunks with footer index
+static const quint16 TraceFileVersion = 3;
+
+//! Number of messages in one chunk of trace file
+static const int TraceChunkSize = 16384;
+
+//! Chunk of messages in trace file
+struct trace_chunk_t
+{
+    trace_chunk_t():
+        offset(0),
+        size(0),
+        first_row(0),
+        row_count(0),
+        first_time(0),
+        last_time(0)
+    {}
+
+    quint64 offset; //! position of compressed chunk in file
+    quint64 size;   //! size of compressed chunk
+
+    quint64 first_row;
+    quint32 row_count;
+
+    quint64 first_time; //! minimal timestamp of chunk messages
+    quint64 last_time;  //! maximal timestamp of chunk messages
+};
+
+//! Footer of trace file: compressed entity tables and chunk index
+struct trace_footer_t
+{
+    QByteArray entity_data;
+    QList<trace_chunk_t> chunks;
+
+    quint64 row_count() const { return chunks.isEmpty() ? 0 : chunks.last().first_row + chunks.last().row_count; }
+};
+
+//! Serializes and compresses messages [first, first + count) of list. Chunk info is filled except offset
+QByteArray encode_chunk(const QList<const trace_message_t*> &list, int first, int count, int stream_version, trace_chunk_t &chunk);
+
+//! Uncompresses and decodes messages of chunk. Messages are allocated by new
+QList<const trace_message_t*> decode_chunk(const QByteArray &data, int stream_version);
+
+//! Decoded chunk of trace file
+struct trace_chunk_data_t
+{
+    trace_chunk_data_t():
+        first_row(0),
+        size(0)
+    {}
+
+    bool contains(quint64 row) const { return (row >= first_row) && (row < first_row + quint64(messages.size())); }
+
+    quint64 first_row;
+    QVector<trace_message_t> messages;
+
+    size_t size; //! approximate size of decoded messages in memory, bytes
+};
+
+typedef QSharedPointer<trace_chunk_data_t> TraceChunkDataPtr;
+
+//! Search marks of messages: row -> highlighted text intervals
+typedef QHash<quint64, QVector<QPair<int, int>>> search_marks_t;
+
+//! Messages of trace file, which are decoded on demand, so trace larger than memory can be opened.
+//! File is mapped into memory, decoded chunks are kept in LRU cache, limited by size in bytes
+class TraceChunkCache
+{
+public:
+    enum
+    {
+        DefaultBudget   = 512 * 1024 * 1024,
+        MinCachedChunks = 4 //! chunks, which are cached even if they are larger than budget
+    };
+
+    explicit TraceChunkCache(size_t budget = DefaultBudget);
+    ~TraceChunkCache();
+
+    bool open(const QString &file_name, const QList<trace_chunk_t> &chunks, int stream_version);
+
+    quint64 size() const;
+
+    //! Index of the first message
+    index_t first_index() const;
+
+    //! Returns message of row. Evicted chunks are freed by release_retired(), so pointer is valid until it`s call
+    const trace_message_t *at(quint64 row);
+
+    //! Returns message of row for sequential reading. Chunk of message is held by chunk argument,
+    //! chunks, which are not cached, are decoded without caching, so reading of whole trace doesn`t evict chunks of view
+    const trace_message_t *stream_at(quint64 row, TraceChunkDataPtr &chunk) const;
+
+    //! Frees chunks, evicted from cache. Called, when pointers returned by at() are not used
+    void release_retired();
+
+    //! Cached chunks are read by other threads, so marks are applied to their copies, which replace them in cache.
+    //! Replaced chunks are retired, messages returned by at() stay valid and unchanged
+    void set_search_marks(const search_marks_t &marks);
+
+    void set_budget(size_t size);
+
+private:
+    int find_chunk(quint64 row) const;
+
+    TraceChunkDataPtr decode(int chunk_number) const;
+
+    static void apply_marks(trace_chunk_data_t &data, const search_marks_t &marks);
+
+    void trim();
+
+private:
+    mutable QFile _file;
+    uchar *_file_memory;
+
+    QList<trace_chunk_t> _chunks;
+    int _stream_version;
+
+    index_t _first_index;
+
+    size_t _budget; // bytes
+    size_t _size;   // bytes
+
+    QHash<int, TraceChunkDataPtr> _cache;
+
+    //! Numbers of cached chunks, least recently used first
+    QList<int> _lru_list;
+
+    //! Chunks, evicted from cache, which can be used yet
+    QList<TraceChunkDataPtr> _retired;
+
+    //! The most recently used chunk
+    TraceChunkDataPtr _last_chunk;
+
+    search_marks_t _marks;
+
+    mutable QMutex _mutex;
+
+    //! Serializes seek-based reading, when file can`t be mapped
+    mutable QMutex _file_mutex;
+};
+
+typedef QSharedPointer<TraceChunkCache> TraceChunkCachePtr;
+
+QDataStream & operator << (QDataStream &out, const trace_chunk_t &value);
+QDataStream & operator >> (QDataStream &in, trace_chunk_t &value);
+
+QDataStream & operator << (QDataStream &out, const trace_footer_t &value);
+QDataStream & operator >> (QDataStream &in, trace_footer_t &value);
+
+QDataStream & operator << (QDataStream &out, const trace_message_t &value);
+QDataStream & operator >> (QDataStream &in, trace_message_t &value);
+
+#endif // TRACE_FILE_H
@@ -0,0 +1,534 @@
+#include "trace_journal.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+
+#include "trace_controller.h"
+
+#include "trace_x/trace_x.h"
+
+namespace
+{
+
+//! Footer position follows version and stream version in header of trace file
+const qint64 FooterPositionOffset = sizeof(quint16) + sizeof(quint32);
+
+const QString JournalPattern = "journal_*.trace_x";
+
+}
+
+class JournalTask : public QRunnable
+{
+public:
+    JournalTask(TraceJournal *journal_):
+        journal(journal_)
+    {
+    }
+
+    void run()
+    {
+        journal->write_journal();
+    }
+
+    TraceJournal *journal;
+};
+
+/* ===================================================================================== */
+
+TraceJournal::TraceJournal(TraceController *controller, QObject *parent) : QObject(parent),
+    _controller(controller),
+    _rotation_size(1024 * 1024 * 1024),
+    _rotation_time(3600),
+    _retention_count(5),
+    _enabled(false),
+    _segment_started(false),
+    _first_index(0),
+    _has_new_messages(false),
+    _checkpoint_requested(false),
+    _scheduled(false),
+    _pending_data_size(0),
+    _stream_version(QDataStream().version()),
+    _row_count(0)
+{
+    X_CALL;
+
+    _thread_pool.setMaxThreadCount(1);
+
+    connect(&_checkpoint_timer, &QTimer::timeout, this, &TraceJournal::request_checkpoint);
+}
+
+TraceJournal::~TraceJournal()
+{
+    X_CALL;
+
+    // journal is closed by controller, while entity tables exist
+
+    _thread_pool.waitForDone();
+}
+
+void TraceJournal::set_dir(const QString &path)
+{
+    X_CALL;
+
+    if(path == _dir)
+    {
+        return;
+    }
+
+    _enabled = false;
+
+    close();
+
+    {
+        QMutexLocker file_lock(&_file_mutex);
+
+        _dir = path;
+    }
+
+    X_VALUE(_dir);
+
+    if(!path.isEmpty())
+    {
+        _checkpoint_timer.start(CheckpointInterval);
+
+        _enabled = true;
+    }
+    else
+    {
+        _checkpoint_timer.stop();
+    }
+}
+
+void TraceJournal::set_rotation_size(quint64 size)
+{
+    X_CALL;
+
+    QMutexLocker file_lock(&_file_mutex);
+
+    _rotation_size = size;
+
+    X_VALUE(_rotation_size);
+}
+
+void TraceJournal::set_rotation_time(int seconds)
+{
+    X_CALL;
+
+    QMutexLocker file_lock(&_file_mutex);
+
+    _rotation_time = seconds;
+
+    X_VALUE(_rotation_time);
+}
+
+void TraceJournal::set_retention_count(int count)
+{
+    X_CALL;
+
+    QMutexLocker file_lock(&_file_mutex);
+
+    // current file is always kept
+
+    _retention_count = qMax(1, count);
+
+    X_VALUE(_retention_count);
+}
+
+bool TraceJournal::is_enabled() const
+{
+    return _enabled;
+}
+
+void TraceJournal::append(const trace_message_t &message, const QByteArray &data)
+{
+    QMutexLocker lock(&_mutex);
+
+    if(!_segment_started)
+    {
+        _segment_started = true;
+        _first_index = message.index;
+    }
+
+    _pending.append(message);
+
+    if(!data.isNull())
+    {
+        _pending_data.append(qMakePair(quint64(message.index), data));
+
+        _pending_data_size += size_t(data.size());
+    }
+
+    _has_new_messages = true;
+
+    if((_pending.size() >= TraceChunkSize) || (_pending_data_size >= MaxPendingDataSize))
+    {
+        schedule_writing();
+    }
+}
+
+bool TraceJournal::first_index(index_t &index)
+{
+    QMutexLocker lock(&_mutex);
+
+    index = _first_index;
+
+    return _segment_started;
+}
+
+bool TraceJournal::save(const QString &file_name)
+{
+    X_CALL;
+
+    QString journal_name;
+
+    {
+        QMutexLocker file_lock(&_file_mutex);
+
+        write_chunk(take_pending());
+        write_data(take_pending_data());
+
+        if(!_file.isOpen())
+        {
+            return false;
+        }
+
+        // messages and data are written already, so only index is written on save
+
+        write_checkpoint();
+
+        journal_name = _file.fileName();
+
+        close_file();
+    }
+
+    if(QFileInfo(file_name) != QFileInfo(journal_name))
+    {
+        QFile::remove(file_name);
+
+        // closed journal file is moved, it is copied only to other volume, where it can`t be renamed
+
+        if(!QFile::rename(journal_name, file_name) && !QFile::copy(journal_name, file_name))
+        {
+            X_ERROR("can`t move journal {} to {}", journal_name, file_name);
+
+            return false;
+        }
+    }
+
+    X_INFO("journal {} is saved to {}", journal_name, file_name);
+
+    return true;
+}
+
+void TraceJournal::close()
+{
+    X_CALL;
+
+    QMutexLocker file_lock(&_file_mutex);
+
+    write_chunk(take_pending());
+    write_data(take_pending_data());
+    write_checkpoint();
+    close_file();
+}
+
+QString TraceJournal::last_journal()
+{
+    X_CALL;
+
+    QMutexLocker file_lock(&_file_mutex);
+
+    QString current_file = _file.isOpen() ? QFileInfo(_file).absoluteFilePath() : QString();
+
+    QFileInfoList files = QDir(_dir).entryInfoList(QStringList() << JournalPattern, QDir::Files, QDir::Name | QDir::Reversed);
+
+    foreach (const QFileInfo &info, files)
+    {
+        if(info.absoluteFilePath() != current_file)
+        {
+            return info.absoluteFilePath();
+        }
+    }
+
+    return QString();
+}
+
+void TraceJournal::request_checkpoint()
+{
+    QMutexLocker lock(&_mutex);
+
+    // idle journal isn`t grown by checkpoints
+
+    if(_segment_started && _has_new_messages)
+    {
+        _has_new_messages = false;
+        _checkpoint_requested = true;
+
+        schedule_writing();
+    }
+}
+
+void TraceJournal::write_journal()
+{
+    X_CALL;
+
+    forever
+    {
+        // file is locked before messages are taken, so chunks are written in order of messages
+
+        QMutexLocker file_lock(&_file_mutex);
+
+        QVector<trace_message_t> messages;
+        QList<QPair<quint64, QByteArray>> data;
+
+        bool is_checkpoint = false;
+
+        {
+            QMutexLocker lock(&_mutex);
+
+            if(_pending.size() >= TraceChunkSize)
+            {
+                messages = _pending.mid(0, TraceChunkSize);
+
+                _pending.remove(0, TraceChunkSize);
+            }
+            else if(_checkpoint_requested)
+            {
+                // partial chunk is sealed, so checkpoint contains all captured messages
+
+                messages.swap(_pending);
+
+                _checkpoint_requested = false;
+
+                is_checkpoint = true;
+            }
+            else if(_pending_data_size < MaxPendingDataSize)
+            {
+                _scheduled = false;
+
+                return;
+            }
+
+            // data of pending messages is written too, they are written to the same file not later than checkpoint
+
+            data.swap(_pending_data);
+
+            _pending_data_size = 0;
+        }
+
+        write_chunk(messages);
+        write_data(data);
+
+        if(is_checkpoint)
+        {
+            write_checkpoint();
+
+            if(_file.isOpen() && ((quint64(_file.size()) >= _rotation_size) || (_open_time.secsTo(QDateTime::currentDateTime()) >= _rotation_time)))
+            {
+                close_file();
+            }
+        }
+    }
+}
+
+void TraceJournal::schedule_writing()
+{
+    if(!_scheduled)
+    {
+        _scheduled = true;
+
+        _thread_pool.start(new JournalTask(this));
+    }
+}
+
+bool TraceJournal::open_file()
+{
+    X_CALL;
+
+    QDir().mkpath(_dir);
+
+    QString file_name = QDir(_dir).filePath(QString("journal_%1.trace_x").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss-zzz")));
+
+    _file.setFileName(file_name);
+
+    if(!_file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        X_ERROR("can`t open journal {}", file_name);
+
+        return false;
+    }
+
+    QDataStream stream(&_file);
+
+    _stream_version = stream.version();
+
+    // footer position is unknown until the first checkpoint
+
+    stream << TraceFileVersion;
+    stream << quint32(_stream_version);
+    stream << quint64(0);
+
+    _open_time = QDateTime::currentDateTime();
+
+    X_INFO("journal {} is opened", file_name);
+
+    return true;
+}
+
+void TraceJournal::write_chunk(const QVector<trace_message_t> &messages)
+{
+    if(messages.isEmpty() || (!_file.isOpen() && !open_file()))
+    {
+        return;
+    }
+
+    QList<const trace_message_t*> list;
+
+    list.reserve(messages.size());
+
+    for(int i = 0; i < messages.size(); ++i)
+    {
+        list.append(&messages.at(i));
+    }
+
+    trace_chunk_t chunk;
+
+    QByteArray data = encode_chunk(list, 0, list.size(), _stream_version, chunk);
+
+    chunk.first_row = _row_count;
+    chunk.offset = _file.pos();
+
+    _file.write(data);
+
+    _chunks.append(chunk);
+
+    _row_count += chunk.row_count;
+}
+
+void TraceJournal::write_data(const QList<QPair<quint64, QByteArray>> &data)
+{
+    if(data.isEmpty() || (!_file.isOpen() && !open_file()))
+    {
+        return;
+    }
+
+    typedef QPair<quint64, QByteArray> data_t;
+
+    foreach (const data_t &item, data)
+    {
+        DataObject data_object;
+
+        data_object.start = quint64(_file.pos());
+        data_object.size = quint64(item.second.size());
+
+        _file.write(item.second);
+
+        data_object.end = quint64(_file.pos()) - 1;
+
+        _data_list.append(item.first);
+        _data_map.insert(item.first, data_object);
+    }
+}
+
+void TraceJournal::write_checkpoint()
+{
+    X_CALL;
+
+    if(!_file.isOpen())
+    {
+        return;
+    }
+
+    trace_footer_t footer;
+
+    footer.entity_data = _controller->entity_data();
+    footer.chunks = _chunks;
+
+    quint64 footer_position = _file.pos();
+
+    QDataStream stream(&_file);
+
+    stream.setVersion(_stream_version);
+
+    stream << footer;
+
+    // data follows footer in trace file, data of journal is written before, so only references to it are written
+
+    stream << _data_list << _data_map;
+
+    _file.flush();
+
+    // footer is published after it is written, so crash doesn`t break the previous checkpoint
+
+    _file.seek(FooterPositionOffset);
+
+    stream << footer_position;
+
+    _file.flush();
+
+    _file.seek(_file.size());
+}
+
+void TraceJournal::close_file()
+{
+    if(_file.isOpen())
+    {
+        X_INFO("journal {} is closed, {} messages", _file.fileName(), _row_count);
+
+        _file.close();
+
+        _chunks.clear();
+        _row_count = 0;
+
+        _data_list.clear();
+        _data_map.clear();
+
+        remove_old_files();
+    }
+
+    // messages, captured while file was written, start the next file
+
+    QMutexLocker lock(&_mutex);
+
+    _segment_started = !_pending.isEmpty();
+    _first_index = _segment_started ? _pending.first().index : 0;
+}
+
+void TraceJournal::remove_old_files()
+{
+    X_CALL;
+
+    QFileInfoList files = QDir(_dir).entryInfoList(QStringList() << JournalPattern, QDir::Files, QDir::Name | QDir::Reversed);
+
+    for(int i = _retention_count; i < files.size(); ++i)
+    {
+        X_INFO("remove journal {}", files[i].absoluteFilePath());
+
+        QFile::remove(files[i].absoluteFilePath());
+    }
+}
+
+QVector<trace_message_t> TraceJournal::take_pending()
+{
+    QMutexLocker lock(&_mutex);
+
+    QVector<trace_message_t> messages;
+
+    messages.swap(_pending);
+
+    return messages;
+}
+
+QList<QPair<quint64, QByteArray>> TraceJournal::take_pending_data()
+{
+    QMutexLocker lock(&_mutex);
+
+    QList<QPair<quint64, QByteArray>> data;
+
+    data.swap(_pending_data);
+
+    _pending_data_size = 0;
+
+    return data;
+}
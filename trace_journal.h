@@ -0,0 +1,133 @@
+#ifndef TRACE_JOURNAL_H
+#define TRACE_JOURNAL_H
+
+#include <QObject>
+#include <QFile>
+#include <QDateTime>
+#include <QMutex>
+#include <QTimer>
+#include <QThreadPool>
+#include <QVector>
+#include <QMap>
+#include <QPair>
+
+#include <boost/atomic.hpp>
+
+#include "trace_model.h"
+#include "trace_file.h"
+#include "data_storage.h"
+
+class TraceController;
+
+//! Append-only journal of captured messages.
+//! Messages are written by background task in sealed compressed chunks, data of messages is written after them
+//! as it is received. Footer with entity tables and references to written data is written periodically
+//! and published in header after it is flushed. So journal file is a trace file, which can be opened after crash
+//! with messages and data of the last checkpoint. Journal files are rotated by size and age, only the latest files are kept
+class TraceJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        CheckpointInterval = 5000,             //! ms
+        MaxPendingDataSize = 64 * 1024 * 1024  //! bytes of data, which are held before chunk of their messages is full
+    };
+
+    explicit TraceJournal(TraceController *controller, QObject *parent = 0);
+    ~TraceJournal();
+
+    //! Journal is disabled, if directory is empty
+    void set_dir(const QString &path);
+    void set_rotation_size(quint64 size);
+    void set_rotation_time(int seconds);
+    void set_retention_count(int count);
+
+    bool is_enabled() const;
+
+    //! Appends captured message and it`s data. Messages are appended in order of indices
+    void append(const trace_message_t &message, const QByteArray &data = QByteArray());
+
+    //! Index of the first message of current journal file. Returns false, if file is not started
+    bool first_index(index_t &index);
+
+    //! Finalizes current journal file and moves it to file_name. Next messages are written to new file
+    bool save(const QString &file_name);
+
+    //! Finalizes current journal file, next messages are written to new file
+    void close();
+
+    //! The latest journal file except of current one
+    QString last_journal();
+
+private slots:
+    void request_checkpoint();
+
+private:
+    void write_journal();
+    void schedule_writing();
+
+    bool open_file();
+    void write_chunk(const QVector<trace_message_t> &messages);
+    void write_data(const QList<QPair<quint64, QByteArray>> &data);
+    void write_checkpoint();
+    void close_file();
+    void remove_old_files();
+
+    QVector<trace_message_t> take_pending();
+    QList<QPair<quint64, QByteArray>> take_pending_data();
+
+private:
+    friend class JournalTask;
+
+    TraceController *_controller;
+
+    QString _dir;
+    quint64 _rotation_size;  // bytes
+    int _rotation_time;      // seconds
+    int _retention_count;
+
+    boost::atomic<bool> _enabled;
+
+    //! Messages, which are not written yet
+    QVector<trace_message_t> _pending;
+
+    //! Data of messages by index of message, which is not written yet. Data is shared with storage, so it isn`t copied
+    QList<QPair<quint64, QByteArray>> _pending_data;
+    size_t _pending_data_size;
+
+    bool _segment_started;
+    index_t _first_index;
+
+    //! Messages are appended after the last checkpoint
+    bool _has_new_messages;
+
+    bool _checkpoint_requested;
+
+    //! Writing task is queued and not finished yet
+    bool _scheduled;
+
+    QFile _file;
+    QDateTime _open_time;
+    int _stream_version;
+
+    QList<trace_chunk_t> _chunks;
+    quint64 _row_count;
+
+    //! Data, which is written to current file, it is referenced by checkpoints in format of data storage
+    QList<quint64> _data_list;
+    QMap<quint64, DataObject> _data_map;
+
+    QTimer _checkpoint_timer;
+
+    QThreadPool _thread_pool;
+
+    //! Protects pending messages and flags
+    QMutex _mutex;
+
+    //! Protects journal file
+    QMutex _file_mutex;
+};
+
+#endif // TRACE_JOURNAL_H
@@ -3,6 +3,10 @@
 #include <QTimer>
 #include <QMimeData>
 #include <QDir>
+#include <QFont>
+
+#include <algorithm>
+#include <iterator>
 
 #include "filter_model.h"
 #include "trace_controller.h"
@@ -109,117 +113,104 @@ MessageTypeItem::MessageTypeView MessageTypeItem::_type_view;
 
 /* ===================================================================================== */
 
-IDItem::IDItem() : EntityItem() {}
-
-IDItem::IDItem(EntityClass class_id, const QString &string, quint64 i1, quint64 i2, quint64 id, qint64 index, const QColor &bg_color, const QColor &fg_color):
-    EntityItem(class_id, id, QString("%1_%2] %3").arg(i1).arg(i2).arg(string), index, bg_color, fg_color),
-    _id(id),
-    _i1(i1),
-    _i2(i2)
+IDItem::IDItem(EntityTable *table, int row):
+    EntityItem(table, row)
 {
-    if(string.isEmpty())
-    {
-        setText("");
-    }
-
-    setData(quintptr(i1), Idx1Role);
-    setData(quintptr(i2), Idx2Role);
 }
 
-bool IDItem::operator<(const QStandardItem &other) const
+entity_row_t IDItem::make_row(const QString &string, quint64 i1, quint64 i2, quint64 id, const QColor &bg_color, const QColor &fg_color)
 {
-    if(_i1 == other.data(Idx1Role).toULongLong())
-    {
-        return _i2 < other.data(Idx2Role).toULongLong();
-    }
+    entity_row_t row(id, string.isEmpty() ? QString("") : QString("%1_%2] %3").arg(i1).arg(i2).arg(string), QString(), bg_color, fg_color);
+
+    row.parent = quint32(i1);
+    row.ordinal = quint32(i2);
 
-    return _i1 < other.data(Idx1Role).toULongLong();
+    return row;
 }
 
 void IDItem::read(QDataStream &in)
 {
-    in >> _id >> _i1 >> _i2;
+    quint64 id, i1, i2;
+
+    in >> id >> i1 >> i2;
+
+    entity_row_t row;
 
-    EntityItem::read(in);
+    row.parent = quint32(i1);
+    row.ordinal = quint32(i2);
+
+    read_row(in, row);
 }
 
 void IDItem::write(QDataStream &out) const
 {
-    out << _id << _i1 << _i2;
+    out << quint64(_table->id(_table_row).toULongLong()) << i1() << i2();
 
     EntityItem::write(out);
 }
 
-QVariant IDItem::item_data(int role, int flags) const
+void IDItem::fill_values(QStandardItem &values) const
 {
-    if(role == Qt::DisplayRole)
-    {
-        if(flags & OnlyIndex)
-        {
-            return QString("%1_%2").arg(_i1).arg(_i2);
-        }
-    }
+    EntityItem::fill_values(values);
 
-    return EntityItem::item_data(role, flags);
+    values.setData(i1(), Idx1Role);
+    values.setData(i2(), Idx2Role);
 }
 
 /* ===================================================================================== */
 
-ContextEntityItem::ContextEntityItem() : IDItem() {}
-
-ContextEntityItem::ContextEntityItem(quint64 context, const QString &class_name, quint64 i1, quint64 i2, qint64 index, const QColor &bg_color, const QColor &fg_color):
-    IDItem(ContextIdEntity, "", i1, i2, context, index, bg_color, fg_color),
-    _text(QString("%1_%2] 0x%3").arg(i1).arg(i2).arg(context, 0, 16)),
-    _class_name(class_name)
+ContextEntityItem::ContextEntityItem(EntityTable *table, int row):
+    IDItem(table, row)
 {
-    setData(_class_name, ContextEntityItem::ClassNameRole);
 }
 
-QVariant ContextEntityItem::item_data(int role, int flags) const
+entity_row_t ContextEntityItem::make_row(quint64 context, const QString &class_name, quint64 i1, quint64 i2, const QColor &bg_color, const QColor &fg_color)
 {
-    if(role == Qt::DisplayRole)
-    {
-        QString text = _text;
+    entity_row_t row = IDItem::make_row("", i1, i2, context, bg_color, fg_color);
 
-        if(flags & FullText)
-        {
-            text += " " % _class_name;
-        }
-        else if(flags & OnlyIndex)
-        {
-            text = QString("%1_%2").arg(_i1).arg(_i2);
-        }
-
-        return text;
-    }
+    row.text = QString("%1_%2] 0x%3").arg(i1).arg(i2).arg(context, 0, 16);
+    row.note = class_name;
 
-    return IDItem::item_data(role, flags);
+    return row;
 }
 
-bool ContextEntityItem::operator<(const QStandardItem &other) const
+void ContextEntityItem::read(QDataStream &in)
 {
-    if(_i1 == other.data(Idx1Role).toULongLong())
-    {
-        return _class_name < other.data(ContextEntityItem::ClassNameRole).toString();
-    }
+    // text of context is kept apart from text of QStandardItem, which is empty
 
-    return _i1 < other.data(Idx1Role).toULongLong();
-}
+    QString text, class_name;
 
-void ContextEntityItem::read(QDataStream &in)
-{
-    in >> _text >> _class_name;
+    in >> text >> class_name;
+
+    quint64 id, i1, i2;
+
+    in >> id >> i1 >> i2;
+
+    entity_row_t row;
 
-    IDItem::read(in);
+    row.text = text;
+    row.note = class_name;
+    row.parent = quint32(i1);
+    row.ordinal = quint32(i2);
+
+    read_row(in, row);
 }
 
 void ContextEntityItem::write(QDataStream &out) const
 {
-    out << _text << _class_name;
+    out << _table->text(_table_row) << _table->note(_table_row);
 
     IDItem::write(out);
 }
 
+void ContextEntityItem::fill_values(QStandardItem &values) const
+{
+    IDItem::fill_values(values);
+
+    values.setText("");
+    values.setData(_table->note(_table_row), ContextEntityItem::ClassNameRole);
+}
+
 /* ===================================================================================== */
 
 MessageTypeItem::MessageTypeItem():
@@ -233,25 +224,36 @@ MessageTypeItem::MessageTypeItem(int type):
     setForeground(message_type_color(type));
 }
 
-FunctionEntityItem::FunctionEntityItem(): EntityItem() {}
+FunctionEntityItem::FunctionEntityItem(EntityTable *table, int row):
+    EntityItem(table, row)
+{
+}
 
-FunctionEntityItem::FunctionEntityItem(const function_t &function, function_index_t fun_index, class_index_t class_index):
-    EntityItem(FunctionNameEntity, function.full_name, function.full_name, fun_index, QColor(), QColor(),
-               function.signature),
-    _class_index(class_index)
+entity_row_t FunctionEntityItem::make_row(const function_t &function, class_index_t class_index)
 {
+    entity_row_t row(function.full_name, function.full_name, function.signature);
+
+    row.parent = class_index;
+
+    return row;
 }
 
 void FunctionEntityItem::read(QDataStream &in)
 {
-    in >> _class_index;
+    class_index_t class_index;
 
-    EntityItem::read(in);
+    in >> class_index;
+
+    entity_row_t row;
+
+    row.parent = class_index;
+
+    read_row(in, row);
 }
 
 void FunctionEntityItem::write(QDataStream &out) const
 {
-    out << _class_index;
+    out << class_index();
 
     EntityItem::write(out);
 }
@@ -298,16 +300,16 @@ QByteArray EntityStandardItemModel::drag_from(const QModelIndexList &indexes) co
 
 /* ===================================================================================== */
 
-ProxyEntryItem::ProxyEntryItem(const QString &text, const QStandardItem *parent):
+ProxyEntryItem::ProxyEntryItem(const QString &text, const EntityRow &entity):
     QStandardItem(text),
-    _parent(parent)
+    _entity(entity)
 {
-    setData(parent->data(ColorRole), Qt::DecorationRole);
+    setData(entity.data(ColorRole), Qt::DecorationRole);
 }
 
 bool ProxyEntryItem::operator<(const QStandardItem &other) const
 {
-    return _parent->operator <(other);
+    return _entity < static_cast<const ProxyEntryItem &>(other)._entity;
 }
 
 QVariant ProxyEntryItem::data(int role) const
@@ -319,27 +321,76 @@ QVariant ProxyEntryItem::data(int role) const
 
     if(role == Qt::DecorationRole)
     {
-        return _parent->data(ColorRole);
+        return _entity.data(ColorRole);
     }
 
-    return _parent->data(role);
+    return _entity.data(role);
 }
 
 /* ===================================================================================== */
 
+namespace
+{
+QString name_for_class(EntityClass class_id)
+{
+    switch (class_id)
+    {
+    case ProcessIdEntity:    return "Process";
+    case ProcessNameEntity:  return "Process name";
+    case ProcessUserEntity:  return "Process user";
+    case ModuleNameEntity:   return "Module";
+    case ThreadIdEntity:     return "Thread";
+    case ContextIdEntity:    return "Object";
+    case ClassNameEntity:    return "Classe";
+    case FunctionNameEntity: return "Function";
+    case SourceNameEntity:   return "Source";
+    case MessageTypeEntity:  return "Message type";
+    case MessageTextEntity:  return "Message";
+    case LabelNameEntity: return "Variable";
+    }
+
+    return QString();
+}
+
+//! Compares entities of group by their indexes
+struct entity_less_t
+{
+    entity_less_t(const EntityList &entities_): entities(entities_) {}
+
+    bool operator()(int index_1, int index_2) const { return entities.at(index_1) < entities.at(index_2); }
+
+    EntityList entities;
+};
+
+}
+
 TraceEntityModel::TraceEntityModel(QObject *parent):
-    EntityStandardItemModel(parent),
+    EntityItemModel(parent),
     _controller(0)
 {
 }
 
 TraceEntityModel::TraceEntityModel(TraceController *controller, const QList<EntityClass> &class_list, bool full_trace_model, QObject *parent):
-    EntityStandardItemModel(parent),
+    EntityItemModel(parent),
     _controller(controller),
     _class_list(class_list)
 {
     X_CALL;
 
+    foreach (EntityClass class_id, _class_list)
+    {
+        group_t group;
+
+        group.class_id = class_id;
+        group.name = ::name_for_class(class_id);
+
+        // full model takes registered message types, entries of index refer to all types
+
+        group.entities = _controller->entities_by_class(class_id, !full_trace_model);
+
+        _groups.append(group);
+    }
+
     if(full_trace_model)
     {
         connect(_controller, &TraceController::model_updated, this, &TraceEntityModel::update_trace_model);
@@ -348,216 +399,485 @@ TraceEntityModel::TraceEntityModel(TraceController *controller, const QList<Enti
     }
 }
 
-QSize TraceEntityModel::span(const QModelIndex &index) const
+QModelIndex TraceEntityModel::index(int row, int column, const QModelIndex &parent) const
 {
-    if(!index.parent().isValid())
+    if((row < 0) || (column != 0))
     {
-        return QSize(1, 1);
+        return QModelIndex();
     }
-    else if(!index.sibling(index.row(), 1).isValid())
+
+    if(!parent.isValid())
     {
-        return QSize(1, 1);
+        return (row < _group_rows.size()) ? createIndex(row, 0, quintptr(0)) : QModelIndex();
     }
 
-    return QSize(0, 0);
+    if(parent.internalId())
+    {
+        // items have no children
+
+        return QModelIndex();
+    }
+
+    int group_index = _group_rows.at(parent.row());
+
+    return (row < _groups.at(group_index).children.size()) ? createIndex(row, 0, quintptr(group_index + 1)) : QModelIndex();
 }
 
-namespace
+QModelIndex TraceEntityModel::parent(const QModelIndex &child) const
 {
-QString name_for_class(EntityClass class_id)
+    if(!child.isValid() || !child.internalId())
+    {
+        return QModelIndex();
+    }
+
+    return createIndex(group_row(int(child.internalId()) - 1), 0, quintptr(0));
+}
+
+int TraceEntityModel::rowCount(const QModelIndex &parent) const
 {
-    switch (class_id)
+    if(!parent.isValid())
     {
-    case ProcessIdEntity:    return "Process";
-    case ProcessNameEntity:  return "Process name";
-    case ProcessUserEntity:  return "Process user";
-    case ModuleNameEntity:   return "Module";
-    case ThreadIdEntity:     return "Thread";
-    case ContextIdEntity:    return "Object";
-    case ClassNameEntity:    return "Classe";
-    case FunctionNameEntity: return "Function";
-    case SourceNameEntity:   return "Source";
-    case MessageTypeEntity:  return "Message type";
-    case MessageTextEntity:  return "Message";
-    case LabelNameEntity: return "Variable";
+        return _group_rows.size();
     }
 
-    return QString();
+    if(parent.internalId() || parent.column())
+    {
+        return 0;
+    }
+
+    return _groups.at(_group_rows.at(parent.row())).children.size();
 }
 
+int TraceEntityModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+
+    return 1;
 }
 
-EntityItem * TraceEntityModel::item_for_class(EntityClass class_id, const trace_index_t::iterator &it) const
+bool TraceEntityModel::hasChildren(const QModelIndex &parent) const
 {
-    trace_message_t fake_message;
+    if(!parent.isValid())
+    {
+        return !_group_rows.isEmpty();
+    }
+
+    if(parent.internalId() || parent.column())
+    {
+        return false;
+    }
 
-    fake_message.process_index = it->process_index;
-    fake_message.module_index = it->module_index;
-    fake_message.tid_index = it->tid_index;
-    fake_message.context_index = it->context_index;
-    fake_message.function_index = it->function_index;
-    fake_message.source_index = it->source_index;
-    fake_message.label_index = it->label_index;
+    return !_groups.at(_group_rows.at(parent.row())).keys.isEmpty();
+}
 
-    switch (class_id)
+bool TraceEntityModel::canFetchMore(const QModelIndex &parent) const
+{
+    if(!parent.isValid() || parent.internalId() || parent.column())
     {
-    case ProcessIdEntity:    return _controller->process_item_at(&fake_message);
-    case ProcessNameEntity:  return _controller->process_name_at(&fake_message);
-    case ProcessUserEntity:  return _controller->process_user_at(&fake_message);
-    case ModuleNameEntity:   return _controller->module_at(&fake_message);
-    case ThreadIdEntity:     return _controller->thread_item_at(&fake_message);
-    case ContextIdEntity:    return _controller->context_item_at(&fake_message);
-    case ClassNameEntity:    return _controller->class_at(&fake_message);
-    case FunctionNameEntity: return _controller->function_at(&fake_message);
-    case SourceNameEntity:   return _controller->source_at(&fake_message);
-    case MessageTypeEntity:  return _controller->message_type_at(it->type);
-    case LabelNameEntity: return _controller->label_item_at(&fake_message);
-    default: return 0;
+        return false;
     }
 
-    return 0;
+    return !_groups.at(_group_rows.at(parent.row())).is_populated;
 }
 
-void TraceEntityModel::append_class_items(EntityClass class_id, const QList<EntityItem *> &class_items)
+void TraceEntityModel::fetchMore(const QModelIndex &parent)
 {
     X_CALL;
 
-    if((!class_items.empty() && !class_items.first()->text().isEmpty()) || (class_items.count() > 1))
+    if(!canFetchMore(parent))
     {
-        QStandardItem *root_item = make_root_group(::name_for_class(class_id));
+        return;
+    }
 
-        // align words by columns
-        int word_count = class_items.last()->text().split(' ').size(); //last, because first m.b. empty
+    group_t &group = _groups[_group_rows.at(parent.row())];
+
+    QVector<int> children;
+
+    children.swap(group.pending);
+
+    std::sort(children.begin(), children.end(), entity_less_t(group.entities));
+
+    group.is_populated = true;
+
+    if(!children.isEmpty())
+    {
+        beginInsertRows(parent, 0, children.size() - 1);
+
+        group.children = children;
 
-        QVector<int> word_max_len(word_count);
+        endInsertRows();
+    }
+}
+
+QVariant TraceEntityModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid())
+    {
+        return QVariant();
+    }
+
+    if(!index.internalId())
+    {
+        const group_t &group = _groups.at(_group_rows.at(index.row()));
 
-        foreach (const QStandardItem *item, class_items)
+        switch (role)
         {
-            if(!item->text().isEmpty())
-            {
-                QStandardItem *new_item = new ProxyEntryItem(item->text(), item);
+        case Qt::DisplayRole:       return group.name;
+        case Qt::ToolTipRole:       return group.name + QString(" [%1]").arg(group.keys.size());
+        case Qt::TextAlignmentRole: return int(Qt::AlignCenter);
+        case Qt::FontRole:
+        {
+            QFont font;
+            font.setBold(true);
 
-                if(word_count > 1)
-                {
-                    QStringList word_list = item->text().split(' ');
-
-                    for(int i = 0; i < word_list.size(); ++i)
-                    {
-                        if(word_list[i].length() > word_max_len[i])
-                        {
-                            word_max_len[i] = word_list[i].length();
-                        }
-                    }
-                }
+            return font;
+        }
+        }
 
-                root_item->appendRow(new_item);
-            }
+        return QVariant();
+    }
+
+    const group_t &group = _groups.at(int(index.internalId()) - 1);
+
+    EntityRow entity = group.entities.at(group.children.at(index.row()));
+
+    if(role == Qt::DisplayRole)
+    {
+        return aligned_text(group, entity.text());
+    }
+
+    if(role == Qt::DecorationRole)
+    {
+        return entity.data(ColorRole);
+    }
+
+    return entity.data(role);
+}
+
+Qt::ItemFlags TraceEntityModel::flags(const QModelIndex &index) const
+{
+    if(!index.isValid() || !index.internalId())
+    {
+        // group items are not selectable
+
+        return Qt::NoItemFlags;
+    }
+
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDragEnabled;
+}
+
+QSize TraceEntityModel::span(const QModelIndex &index) const
+{
+    Q_UNUSED(index)
+
+    return QSize(1, 1);
+}
+
+void TraceEntityModel::append_indexes(const QVector<message_index_t> &indexes, bool is_reset)
+{
+    X_CALL;
+
+    if(is_reset)
+    {
+        clear();
+    }
+
+    for(int i = 0; i < _groups.size(); ++i)
+    {
+        QVector<int> entities;
+
+        entities.reserve(indexes.size());
+
+        foreach (const message_index_t &index, indexes)
+        {
+            entities.append(entity_for_class(_groups.at(i).class_id, index));
         }
 
-        if(word_count > 1)
+        add_entities(i, entities);
+    }
+
+    show_groups();
+}
+
+void TraceEntityModel::update_trace_model()
+{
+    X_CALL;
+
+    foreach (const group_t &group, _groups)
+    {
+        if(group.entities.size() < group.known_count)
         {
-            for(int i = 0; i < root_item->rowCount(); ++i)
-            {
-                QString complete_text;
+            // entity tables are cleared
 
-                QStringList word_list = root_item->child(i)->text().split(' ');
+            clear();
 
-                for(int k = 0; k < word_list.size(); ++k)
-                {
-                    complete_text += word_list[k] + " ";
+            break;
+        }
+    }
 
-                    if(k != word_list.size() - 1)
-                    {
-                        complete_text += QString(' ').repeated(word_max_len[k] - word_list[k].length());
-                    }
-                }
+    for(int i = 0; i < _groups.size(); ++i)
+    {
+        int known_count = _groups.at(i).known_count;
 
-                root_item->child(i)->setText(complete_text);
+        int count = _groups.at(i).entities.size();
+
+        if(count > known_count)
+        {
+            _groups[i].known_count = count;
+
+            QVector<int> entities;
+
+            entities.reserve(count - known_count);
+
+            for(int index = known_count; index < count; ++index)
+            {
+                entities.append(index);
             }
+
+            add_entities(i, entities);
         }
+    }
+
+    show_groups();
+}
+
+void TraceEntityModel::clear()
+{
+    X_CALL;
+
+    beginResetModel();
+
+    for(int i = 0; i < _groups.size(); ++i)
+    {
+        group_t &group = _groups[i];
 
-        root_item->sortChildren(0);
+        group.known_count = 0;
+        group.is_shown = false;
+        group.is_populated = false;
 
-        root_item->setToolTip(root_item->text() + QString(" [%1]").arg(root_item->rowCount()));
+        group.keys.clear();
+        group.pending.clear();
+        group.children.clear();
+        group.word_max_len.clear();
     }
+
+    _group_rows.clear();
+
+    endResetModel();
 }
 
-void TraceEntityModel::set_index_model(const trace_index_t &index_model)
+int TraceEntityModel::entity_for_class(EntityClass class_id, const message_index_t &index) const
 {
-    X_CALL;
+    trace_message_t fake_message;
 
-    emit layoutAboutToBeChanged();
+    fake_message.process_index = index.process_index;
+    fake_message.module_index = index.module_index;
+    fake_message.tid_index = index.tid_index;
+    fake_message.context_index = index.context_index;
+    fake_message.function_index = index.function_index;
+    fake_message.source_index = index.source_index;
+    fake_message.label_index = index.label_index;
+    fake_message.type = index.type;
 
-    clear();
+    size_t entity_index = _controller->index_by_class(&fake_message, class_id);
 
-    setColumnCount(1);
+    return (entity_index < size_t(_controller->entities_by_class(class_id, true).size())) ? int(entity_index) : -1;
+}
 
-    foreach (EntityClass class_type, _class_list)
+void TraceEntityModel::add_entities(int group_index, const QVector<int> &entities)
+{
+    group_t &group = _groups[group_index];
+
+    QVector<int> added;
+
+    bool words_changed = false;
+
+    foreach (int entity_index, entities)
     {
-        const QList<EntityItem *> &class_items = _controller->items_by_class(class_type);
+        if((entity_index < 0) || group.keys.contains(entity_index))
+        {
+            continue;
+        }
 
-        // we shows only groups with number of childs more than one - it`s simpler
-        if(class_items.size() > 1)
+        QString text = group.entities.at(entity_index).text();
+
+        if(text.isEmpty())
         {
-            QSet<EntityItem *> item_set;
+            continue;
+        }
 
-            for(trace_index_t::iterator it = index_model.begin(); it != index_model.end(); ++it)
+        group.keys.insert(entity_index);
+
+        added.append(entity_index);
+
+        // align words by columns
+
+        QStringList word_list = text.split(' ');
+
+        if(word_list.size() > 1)
+        {
+            if(group.word_max_len.size() < word_list.size())
             {
-                EntityItem *index_item = item_for_class(class_type, it);
+                group.word_max_len.resize(word_list.size());
+            }
 
-                if(!item_set.contains(index_item))
+            for(int i = 0; i < word_list.size(); ++i)
+            {
+                if(word_list[i].length() > group.word_max_len[i])
                 {
-                    item_set.insert(index_item);
+                    group.word_max_len[i] = word_list[i].length();
+
+                    words_changed = true;
                 }
             }
+        }
+    }
+
+    if(added.isEmpty())
+    {
+        return;
+    }
+
+    int row = group_row(group_index);
 
-            append_class_items(class_type, item_set.values());
+    if(!group.is_populated)
+    {
+        // children are sorted, when view fetches them
+
+        group.pending += added;
+
+        if(row != -1)
+        {
+            emit dataChanged(index(row, 0), index(row, 0));
         }
+
+        return;
     }
 
-    emit layoutChanged();
-}
+    QModelIndex parent = index(row, 0);
 
-void TraceEntityModel::update_trace_model()
-{
-    X_CALL;
+    if(words_changed && !group.children.isEmpty())
+    {
+        emit dataChanged(index(0, 0, parent), index(group.children.size() - 1, 0, parent));
+    }
 
-    emit layoutAboutToBeChanged();
+    if(added.size() <= InsertBatchSize)
+    {
+        foreach (int entity_index, added)
+        {
+            int position = std::upper_bound(group.children.begin(), group.children.end(), entity_index, entity_less_t(group.entities)) - group.children.begin();
 
-    clear();
+            beginInsertRows(parent, position, position);
 
-    setColumnCount(1);
+            group.children.insert(position, entity_index);
 
-    foreach (EntityClass class_type, _class_list)
+            endInsertRows();
+        }
+    }
+    else
     {
-        const QList<EntityItem *> &class_items = _controller->items_by_class(class_type);
+        entity_less_t entity_less(group.entities);
 
-        // we shows only groups with number of childs more than one - it`s simpler
-        if(class_items.size() > 1)
+        std::sort(added.begin(), added.end(), entity_less);
+
+        emit layoutAboutToBeChanged();
+
+        QVector<int> merged;
+
+        merged.reserve(group.children.size() + added.size());
+
+        std::merge(group.children.constBegin(), group.children.constEnd(), added.constBegin(), added.constEnd(), std::back_inserter(merged), entity_less);
+
+        // persistent indexes of children are moved to new rows of their items
+
+        QModelIndexList from;
+        QModelIndexList to;
+
+        foreach (const QModelIndex &persistent_index, persistentIndexList())
         {
-            append_class_items(class_type, class_items);
+            if(persistent_index.internalId() != quintptr(group_index + 1))
+            {
+                continue;
+            }
+
+            int entity_index = group.children.at(persistent_index.row());
+
+            int new_row = std::lower_bound(merged.constBegin(), merged.constEnd(), entity_index, entity_less) - merged.constBegin();
+
+            while(merged.at(new_row) != entity_index)
+            {
+                new_row++;
+            }
+
+            from << persistent_index;
+            to << createIndex(new_row, 0, persistent_index.internalId());
         }
+
+        group.children.swap(merged);
+
+        changePersistentIndexList(from, to);
+
+        emit layoutChanged();
     }
 
-    emit layoutChanged();
+    emit dataChanged(parent, parent);
 }
 
-QStandardItem *TraceEntityModel::make_root_group(const QString &text)
+void TraceEntityModel::show_groups()
 {
-    QStandardItem *item = new QStandardItem(text);
+    for(int i = 0; i < _groups.size(); ++i)
+    {
+        group_t &group = _groups[i];
+
+        // we shows only groups with number of childs more than one - it`s simpler
+
+        if(group.is_shown || group.keys.isEmpty() || (_controller->entities_by_class(group.class_id).size() <= 1))
+        {
+            continue;
+        }
+
+        int row = 0;
+
+        while((row < _group_rows.size()) && (_group_rows.at(row) < i))
+        {
+            row++;
+        }
 
-    item->setEditable(false);
-    item->setSelectable(false);
-    item->setEnabled(false);
+        beginInsertRows(QModelIndex(), row, row);
 
-    QFont font = item->font();
-    font.setBold(true);
+        group.is_shown = true;
 
-    item->setTextAlignment(Qt::AlignCenter);
-    item->setFont(font);
+        _group_rows.insert(row, i);
 
-    this->invisibleRootItem()->appendRow(item);
+        endInsertRows();
+    }
+}
 
-    return item;
+int TraceEntityModel::group_row(int group_index) const
+{
+    return _group_rows.indexOf(group_index);
 }
 
+QString TraceEntityModel::aligned_text(const group_t &group, const QString &text) const
+{
+    if(group.word_max_len.size() < 2)
+    {
+        return text;
+    }
+
+    QStringList word_list = text.split(' ');
+
+    QString complete_text;
+
+    for(int k = 0; k < word_list.size(); ++k)
+    {
+        complete_text += word_list[k] + " ";
+
+        if(k != word_list.size() - 1)
+        {
+            complete_text += QString(' ').repeated(group.word_max_len.value(k) - word_list[k].length());
+        }
+    }
+
+    return complete_text;
+}
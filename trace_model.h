@@ -6,6 +6,8 @@
 #include <QObject>
 #include <QString>
 #include <QMutex>
+#include <QSet>
+#include <QVector>
 #include <QStandardItem>
 #include <QFileInfo>
 
@@ -117,7 +119,7 @@ private:
     static MessageTypeView _type_view;
 };
 
-//! Model item with sort operator "i1_i2"
+//! Item of entity with id, which is sorted by "i1_i2", i1 and i2 are parent and ordinal of row of table
 class IDItem : public EntityItem
 {
 public:
@@ -125,62 +127,65 @@ public:
     static const int Idx2Role = Qt::UserRole + 2;
 
 public:
-    IDItem();
-    IDItem(EntityClass class_id, const QString &string, quint64 i1, quint64 i2,
-           quint64 id, qint64 index, const QColor &bg_color, const QColor &fg_color);
+    IDItem(EntityTable *table, int row = -1);
 
-    virtual bool operator<(const QStandardItem &other) const;
-    virtual void read(QDataStream &in);
-    virtual void write(QDataStream &out) const;
+    //! Row of table for entity with id, text is "i1_i2] string"
+    static entity_row_t make_row(const QString &string, quint64 i1, quint64 i2, quint64 id, const QColor &bg_color, const QColor &fg_color);
 
-    QVariant item_data(int role, int flags) const;
+    inline quint64 i1() const { return _table->parent(_table_row); }
+    inline quint64 i2() const { return _table->ordinal(_table_row); }
 
-    quint64 _id;
+    virtual void read(QDataStream &in);
+    virtual void write(QDataStream &out) const;
 
-    quint64 _i1;
-    quint64 _i2;
+protected:
+    virtual void fill_values(QStandardItem &values) const;
 };
 
+//! Data of item is shown by EntityRow: display text of context has class name, ClassNameRole is class name
 class ContextEntityItem : public IDItem
 {
+public:
     static const int ClassNameRole = Qt::UserRole + 3;
 
 public:
-    ContextEntityItem();
-    ContextEntityItem(quint64 context, const QString &class_name, quint64 i1, quint64 i2, qint64 index, const QColor &bg_color, const QColor &fg_color);
+    ContextEntityItem(EntityTable *table, int row = -1);
 
-    virtual QVariant item_data(int role, int flags = ShortText) const;
+    //! Row of table for context, class name is kept as note of row
+    static entity_row_t make_row(quint64 context, const QString &class_name, quint64 i1, quint64 i2, const QColor &bg_color, const QColor &fg_color);
 
-    virtual bool operator<(const QStandardItem &other) const;
     virtual void read(QDataStream &in);
     virtual void write(QDataStream &out) const;
 
-    QString _text;
-    QString _class_name;
+protected:
+    virtual void fill_values(QStandardItem &values) const;
 };
 
 class FunctionEntityItem : public EntityItem
 {
 public:
-    FunctionEntityItem();
-    FunctionEntityItem(const function_t &function, function_index_t fun_index, class_index_t class_index);
+    FunctionEntityItem(EntityTable *table, int row = -1);
 
-    class_index_t _class_index;
+    //! Row of table for function, class is parent of row
+    static entity_row_t make_row(const function_t &function, class_index_t class_index);
+
+    inline class_index_t class_index() const { return class_index_t(_table->parent(_table_row)); }
 
     virtual void read(QDataStream &in);
     virtual void write(QDataStream &out) const;
 };
 
+//! Completer item, which shows entity with aligned text. Children of entry are proxies, so they are sorted by their entities
 class ProxyEntryItem : public QStandardItem
 {
 public:
-    ProxyEntryItem(const QString &text, const QStandardItem *parent);
+    ProxyEntryItem(const QString &text, const EntityRow &entity);
 
     virtual bool operator<(const QStandardItem &other) const;
 
     QVariant data(int role) const;
 
-    const QStandardItem *_parent;
+    EntityRow _entity;
 };
 
 //
@@ -209,31 +214,98 @@ public:
     QByteArray drag_from(const QModelIndexList &indexes) const;
 };
 
-//! QStandardItemModel with two levels, represents set of trace model items
+//! Model with two levels, represents set of trace model items
 //! First level - group root items(modules, threads, classes, etc)
 //! Second level - trace model items
-class TraceEntityModel : public EntityStandardItemModel
+//! Rows refer to entities of controller by their indexes, so model doesn`t copy them. Groups are filled incrementally by new entities,
+//! children of group are sorted, when view fetches them first time, then new ones are inserted in sorted position
+class TraceEntityModel : public EntityItemModel
 {
     Q_OBJECT
 
 public:
+    enum
+    {
+        //! New children of populated group are inserted one by one, larger batch is merged with layout change
+        InsertBatchSize = 64
+    };
+
     TraceEntityModel(QObject *parent = 0);
     TraceEntityModel(TraceController *controller, const QList<EntityClass> &class_list, bool full_trace_model = true, QObject *parent = 0);
 
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    QModelIndex parent(const QModelIndex &child) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+
     QSize span(const QModelIndex &index) const;
 
-    void set_index_model(const trace_index_t &index_model);
+    //! Adds items of index entries, which are inserted after the previous call. If is_reset, index was cleared before them
+    void append_indexes(const QVector<message_index_t> &indexes, bool is_reset);
+
+    //! Adds items, which are registered by controller after the previous call
     void update_trace_model();
 
+    void clear();
+
 private:
-    QStandardItem * make_root_group(const QString &text);
-    EntityItem * item_for_class(EntityClass class_id, const trace_index_t::iterator &it) const;
+    struct group_t
+    {
+        group_t(): class_id(ProcessNameEntity), known_count(0), is_shown(false), is_populated(false) {}
+
+        EntityClass class_id;
+        QString name;
+
+        //! Entities of class in controller
+        EntityList entities;
+
+        //! Number of entities of controller, which are added to full model
+        int known_count;
+
+        bool is_shown;
+        bool is_populated;
+
+        //! Indexes of added entities
+        QSet<int> keys;
+
+        //! Entities, which are added before group is populated
+        QVector<int> pending;
 
-    void append_class_items(EntityClass class_id, const QList<EntityItem *> &class_items);
+        //! Sorted children of populated group
+        QVector<int> children;
+
+        //! Maximal length of each word of item texts, texts are aligned by columns
+        QVector<int> word_max_len;
+    };
+
+    //! Index of entity of class in message index entry or -1
+    int entity_for_class(EntityClass class_id, const message_index_t &index) const;
+
+    void add_entities(int group_index, const QVector<int> &entities);
+    void show_groups();
+
+    //! Row of group in model or -1, if it is not shown
+    int group_row(int group_index) const;
+
+    QString aligned_text(const group_t &group, const QString &text) const;
 
 private:
     TraceController *_controller;
     QList<EntityClass> _class_list;
+
+    QVector<group_t> _groups;
+
+    //! Indices of shown groups by row
+    QVector<int> _group_rows;
 };
 
 QMimeData* entity_mime_data(const QModelIndexList &indexes);
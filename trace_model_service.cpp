@@ -162,7 +162,11 @@ bool TraceModelService::filter_message_list(size_t start, size_t end, const trac
         return false;
     }
 
-    for(size_t i = start; i < end; ++i)
+    // messages of lazy trace are read by chunks, so derived models keep rows of messages
+
+    bool is_lazy = trace_data.is_lazy();
+
+    return trace_data.for_each_message(start, end, [&](size_t i, const trace_message_t *message)
     {
         if(!is_new_messages && _filter_interrupt_flag)
         {
@@ -171,18 +175,20 @@ bool TraceModelService::filter_message_list(size_t start, size_t end, const trac
             return false;
         }
 
-        const trace_message_t *message = trace_data.at(i);
-
         if(is_new_messages)
         {
-            _issue_model.append(message);
+            if(!is_lazy)
+            {
+                // issues keep messages, so they are not collected for lazy trace
+
+                _issue_model.append(message);
+            }
 
             //
 
             if(message->type == trace_x::MESSAGE_IMAGE)
             {
-                _main_image_model->append(message);
-                _main_image_model->update_index(message);
+                append_message(_main_image_model, i, message);
             }
         }
 
@@ -230,20 +236,32 @@ bool TraceModelService::filter_message_list(size_t start, size_t end, const trac
 
                 if(accepted)
                 {
-                    filter_data.model->append(message);
-                    filter_data.model->update_index(message);
+                    append_message(filter_data.model, i, message);
 
                     if(message->type == trace_x::MESSAGE_IMAGE)
                     {
-                        filter_data.image_model->append(message);
-                        filter_data.image_model->update_index(message);
+                        append_message(filter_data.image_model, i, message);
                     }
                 }
             }
         }
+
+        return true;
+    });
+}
+
+void TraceModelService::append_message(TraceDataModel *model, size_t row, const trace_message_t *message)
+{
+    if(model->is_lazy())
+    {
+        model->append_row(row, message->type);
+    }
+    else
+    {
+        model->append(message);
     }
 
-    return true;
+    model->update_index(message);
 }
 
 void TraceModelService::filter_loop()
@@ -459,16 +477,16 @@ void TraceModelService::fill_descriptor(const trace_index_t::iterator &it, QHash
     const ProcessModel &process = _trace_controller->process_at(it->process_index);
 
     descriptor[ProcessIdEntity]    = process.descriptor();
-    descriptor[ProcessNameEntity]  = _trace_controller->process_name_at(process.name_index())->descriptor();
-    descriptor[ProcessUserEntity]  = _trace_controller->process_user_at(process.user_index())->descriptor();
-    descriptor[ModuleNameEntity]   = _trace_controller->module_at(it->module_index)->descriptor();
-    descriptor[FunctionNameEntity] = _trace_controller->function_at(it->function_index)->descriptor();
-    descriptor[ClassNameEntity]    = _trace_controller->class_at(it->function_index)->descriptor();
-    descriptor[SourceNameEntity]   = _trace_controller->source_at(it->source_index)->descriptor();
-    descriptor[ThreadIdEntity]     = _trace_controller->thread_item_at(it->tid_index)->descriptor();
-    descriptor[ContextIdEntity]    = _trace_controller->context_item_at(it->context_index)->descriptor();
+    descriptor[ProcessNameEntity]  = _trace_controller->process_name_at(process.name_index()).descriptor();
+    descriptor[ProcessUserEntity]  = _trace_controller->process_user_at(process.user_index()).descriptor();
+    descriptor[ModuleNameEntity]   = _trace_controller->module_at(it->module_index).descriptor();
+    descriptor[FunctionNameEntity] = _trace_controller->function_at(it->function_index).descriptor();
+    descriptor[ClassNameEntity]    = _trace_controller->class_at(it->function_index).descriptor();
+    descriptor[SourceNameEntity]   = _trace_controller->source_at(it->source_index).descriptor();
+    descriptor[ThreadIdEntity]     = _trace_controller->thread_at(it->tid_index).descriptor();
+    descriptor[ContextIdEntity]    = _trace_controller->context_at(it->context_index).descriptor();
     descriptor[MessageTypeEntity]  = _trace_controller->message_type_at(it->type)->descriptor();
-    descriptor[LabelNameEntity]    = _trace_controller->label_item_at(it->label_index)->descriptor();
+    descriptor[LabelNameEntity]    = _trace_controller->label_at(it->label_index).descriptor();
 }
 
 void TraceModelService::update_filter_pair(trace_index_t::iterator &it, const FilterChain &pair, const QHash<int, ItemDescriptor> &trace_message_desc)
@@ -511,6 +529,12 @@ FilterData TraceModelService::make_filter_data_model(const FilterModel *filter,
     data.model = model;
     data.image_model = image_model;
 
+    if(_chunk_cache)
+    {
+        model->set_chunk_cache(_chunk_cache, true);
+        image_model->set_chunk_cache(_chunk_cache, true);
+    }
+
     data.is_complex_filter = (filter && filter->has_class_in_filter(MessageTextEntity)) || (subfilter && subfilter->has_class_in_filter(MessageTextEntity));
 
     data.index_item_model = new TraceEntityModel(_trace_controller, x_settings().entity_model_layout, false, model);
@@ -522,11 +546,13 @@ FilterData TraceModelService::make_filter_data_model(const FilterModel *filter,
     {
         X_CALL_F;
 
-        model->index_mutex()->lock();
+        // only new entries of index are added, so update takes O(new entities)
+
+        bool is_reset = false;
 
-        data.index_item_model->set_index_model(data.model->index_model());
+        QVector<message_index_t> indexes = model->take_new_indexes(is_reset);
 
-        model->index_mutex()->unlock();
+        data.index_item_model->append_indexes(indexes, is_reset);
     };
 
     connect(model, &TraceDataModel::model_changed, this, update_index_item, Qt::QueuedConnection);
@@ -575,6 +601,29 @@ void TraceModelService::clear()
     _entity_model->clear();
 
     clear_data();
+
+    set_chunk_cache(TraceChunkCachePtr());
+}
+
+void TraceModelService::set_chunk_cache(const TraceChunkCachePtr &chunk_cache)
+{
+    X_CALL;
+
+    QMutexLocker locker(&_filter_mutex);
+
+    _chunk_cache = chunk_cache;
+
+    _main_image_model->set_chunk_cache(_chunk_cache, true);
+
+    QMutableMapIterator<FilterChain, FilterData> map_iter(_filter_model_map);
+
+    while (map_iter.hasNext())
+    {
+        map_iter.next();
+
+        map_iter.value().model->set_chunk_cache(_chunk_cache, true);
+        map_iter.value().image_model->set_chunk_cache(_chunk_cache, true);
+    }
 }
 
 void TraceModelService::clear_data()
@@ -609,31 +658,56 @@ uint64_t TraceModelService::search(FilterItem search_filter, const QSet<int> &de
 
     trace_data.lock();
 
-    // parallel for!
+    int class_id = search_filter.class_id();
 
-    if(search_filter.is_empty())
+    QSet<int> filters;
+
+    if(class_id == -1)
     {
-        for(size_t i = 0; i < trace_data.size(); ++i)
-        {
-            trace_data.at(i)->flags = 0;
-            trace_data.at(i)->search_indexes.clear();
-        }
+        filters = default_filters;
     }
     else
     {
-        int class_id = search_filter.class_id();
+        filters << class_id;
+    }
+
+    // parallel for!
+
+    if(trace_data.is_lazy())
+    {
+        // messages of lazy trace are decoded on demand, so found rows are marked in chunk cache
 
-        QSet<int> filters;
+        search_marks_t marks;
 
-        if(class_id == -1)
+        if(!search_filter.is_empty())
         {
-            filters = default_filters;
+            trace_data.for_each_message(0, trace_data.size(), [&](size_t i, const trace_message_t *message)
+            {
+                QVector<QPair<int, int>> indexes;
+
+                if(search_message(search_filter, filters, message, indexes))
+                {
+                    marks.insert(i, indexes);
+
+                    found_counter++;
+                }
+
+                return true;
+            });
         }
-        else
+
+        trace_data.chunk_cache()->set_search_marks(marks);
+    }
+    else if(search_filter.is_empty())
+    {
+        for(size_t i = 0; i < trace_data.size(); ++i)
         {
-            filters << class_id;
+            trace_data.at(i)->flags = 0;
+            trace_data.at(i)->search_indexes.clear();
         }
-
+    }
+    else
+    {
         for(size_t i = 0; i < trace_data.size(); ++i)
         {
             trace_message_t *message = trace_data.at(i);
@@ -643,33 +717,12 @@ uint64_t TraceModelService::search(FilterItem search_filter, const QSet<int> &de
 
             QVector<QPair<int, int>> indexes;
 
-            foreach(int filter_class, filters)
+            if(search_message(search_filter, filters, message, indexes))
             {
-                if(filter_class == MessageTextEntity)
-                {
-                    if(search_filter.contains(_trace_controller->message_text_at(message), indexes))
-                    {
-                        message->flags = SearchHighlighted;
-                        message->search_indexes = indexes;
-
-                        found_counter++;
-
-                        break;
-                    }
-                }
-                else
-                {
-                    if(search_filter.contains(
-                                _trace_controller->items_by_class(EntityClass(filter_class), true).at(
-                                    _trace_controller->index_by_class(message, filter_class))->descriptor(), indexes))
-                    {
-                        message->flags = SearchHighlighted;
-
-                        found_counter++;
+                message->flags = SearchHighlighted;
+                message->search_indexes = indexes;
 
-                        break;
-                    }
-                }
+                found_counter++;
             }
         }
     }
@@ -681,13 +734,44 @@ uint64_t TraceModelService::search(FilterItem search_filter, const QSet<int> &de
     return found_counter;
 }
 
+bool TraceModelService::search_message(const FilterItem &search_filter, const QSet<int> &filters, const trace_message_t *message, QVector<QPair<int, int>> &indexes) const
+{
+    foreach(int filter_class, filters)
+    {
+        if(filter_class == MessageTextEntity)
+        {
+            if(search_filter.contains(_trace_controller->message_text_at(message), indexes))
+            {
+                return true;
+            }
+        }
+        else
+        {
+            QVector<QPair<int, int>> entity_indexes;
+
+            if(search_filter.contains(
+                        _trace_controller->entities_by_class(EntityClass(filter_class), true).at(
+                            int(_trace_controller->index_by_class(message, filter_class))).descriptor(), entity_indexes))
+            {
+                // only message text is highlighted
+
+                indexes.clear();
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 void TraceModelService::lock()
 {
     X_CALL;
 
     _filter_mutex.lock();
 
-    _issue_model.data_model()->lock();
+    _issue_model.lock();
 
     _main_image_model->lock();
 
@@ -705,7 +789,7 @@ void TraceModelService::unlock()
 {
     X_CALL;
 
-    _issue_model.data_model()->unlock();
+    _issue_model.unlock();
 
     _main_image_model->unlock();
 
@@ -814,7 +898,7 @@ void TraceModelService::update_all_data()
 
     QMutexLocker locker(&_filter_mutex);
 
-    _issue_model.data_model()->emit_updated();
+    _issue_model.emit_updated();
 
     _main_image_model->emit_updated();
 
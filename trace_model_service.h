@@ -90,6 +90,9 @@ public:
     void clear();
     void clear_data();
 
+    //! Makes derived models of lazy trace row mapped
+    void set_chunk_cache(const TraceChunkCachePtr &chunk_cache);
+
     TraceDataModel * request_trace_model(const FilterChain &filter_pair);
     TraceDataModel * request_image_model(const FilterChain &filter_pair);
     TraceEntityModel * request_index_item_model(const FilterChain &filter_pair);
@@ -106,7 +109,7 @@ public:
     void invalidate_all_filters();
 
 public:
-    inline QStandardItemModel *item_model() const;
+    inline TraceEntityModel *item_model() const;
 
     QByteArray save_state() const;
     void restore_state(const QByteArray &state);
@@ -123,6 +126,10 @@ signals:
 private:
     bool filter_message_list(size_t start, size_t end, const trace_index_t &trace_index, bool is_new_messages);
 
+    static void append_message(TraceDataModel *model, size_t row, const trace_message_t *message);
+
+    bool search_message(const FilterItem &search_filter, const QSet<int> &filters, const trace_message_t *message, QVector<QPair<int, int>> &indexes) const;
+
     void update_trace_filter(FilterModel *model);
 
     void filter_destroyed(QObject *filter);
@@ -169,9 +176,12 @@ private:
     QStringList _source_map_list;
 
     size_t _last_index;
+
+    //! Decoded chunks of lazy trace
+    TraceChunkCachePtr _chunk_cache;
 };
 
-QStandardItemModel *TraceModelService::item_model() const
+TraceEntityModel *TraceModelService::item_model() const
 {
     return _entity_model;
 }
@@ -48,9 +48,15 @@ void TraceService::update_config()
 
     _trace_controller->set_message_limit(x_settings().message_limit_option->uint_value());
     _trace_controller->set_file_data_limit(x_settings().file_data_limit_option->uint_value() * 1024ull * 1024ull);
+    _trace_controller->set_trace_memory_limit(x_settings().trace_memory_limit_option->uint_value() * 1024ull * 1024ull);
+    _trace_controller->journal().set_rotation_size(x_settings().journal_size_option->uint_value() * 1024ull * 1024ull);
+    _trace_controller->journal().set_rotation_time(x_settings().journal_time_option->uint_value() * 60);
+    _trace_controller->journal().set_retention_count(x_settings().journal_count_option->uint_value());
+    _trace_controller->journal().set_dir(x_settings().journal_dir_option->string_value());
     _trace_controller->data_storage().set_memory_limit(x_settings().memory_limit_option->uint_value() * 1024ull * 1024ull);
     _trace_controller->data_storage().set_swap_limit(x_settings().swap_limit_option->uint_value()  * 1024ull * 1024ull);
     _trace_controller->data_storage().set_swap_state(!x_settings().no_swap_option->bool_value());
+    _trace_controller->data_storage().set_compression_state(!x_settings().no_compression_option->bool_value());
     _trace_controller->data_storage().set_swap_dir(x_settings().swap_path_option->string_value());
 }
 
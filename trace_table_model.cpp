@@ -9,14 +9,41 @@
 #include <QFontMetrics>
 #include <QStringBuilder>
 
+class FormatTask : public QRunnable
+{
+public:
+    FormatTask(TraceTableModel *model_):
+        model(model_)
+    {
+    }
+
+    void run()
+    {
+        model->format_rows();
+    }
+
+    TraceTableModel *model;
+};
+
+/* ===================================================================================== */
+
 TraceTableModel::TraceTableModel(TraceDataModel *trace_model, TraceController &trace_controller,
                                  const QList<TraceColumns> &columns, QObject *parent):
     QAbstractTableModel(parent),
     _trace_controller(trace_controller),
-    _trace_model(0)
+    _trace_model(0),
+    _format_first(0),
+    _format_last(-1),
+    _format_requested(false),
+    _format_scheduled(false),
+    _format_generation(0),
+    _is_shown(true),
+    _update_pending(false)
 {
     X_CALL;
 
+    _thread_pool.setMaxThreadCount(1);
+
     _number_index       = -1;
     _timestamp_index    = -1;
     _process_index      = -1;
@@ -82,6 +109,17 @@ TraceTableModel::TraceTableModel(TraceDataModel *trace_model, TraceController &t
     }
 
     set_data(trace_model);
+
+    // formatting thread reads entity tables, so it is stopped before controller clears them
+
+    connect(&_trace_controller, &TraceController::cleaned, this, &TraceTableModel::stop_formatting, Qt::DirectConnection);
+}
+
+TraceTableModel::~TraceTableModel()
+{
+    X_CALL;
+
+    stop_formatting();
 }
 
 void TraceTableModel::set_data(TraceDataModel *data_model)
@@ -101,13 +139,18 @@ void TraceTableModel::set_data(TraceDataModel *data_model)
         _trace_model->disconnect(this);
     }
 
+    stop_formatting();
+
+    _snapshot.clear();
+
     _trace_model = data_model;
 
     if(data_model)
     {
-        connect(_trace_model, &TraceDataModel::destroyed, [this] { _trace_model = 0; });
+        connect(_trace_model, &TraceDataModel::destroyed, [this] { _trace_model = 0; _snapshot.clear(); });
         connect(_trace_model, &TraceDataModel::updated, this, &TraceTableModel::model_updated);
         connect(_trace_model, &TraceDataModel::cleaned, this, &TraceTableModel::cleaned);
+        connect(_trace_model, &TraceDataModel::cleaned, this, &TraceTableModel::clear_formats);
         connect(_trace_model, &TraceDataModel::refiltered, this, &TraceTableModel::refiltered);
     }
 
@@ -118,10 +161,10 @@ void TraceTableModel::set_data(TraceDataModel *data_model)
 
 int TraceTableModel::rowCount(const QModelIndex &parent) const
 {
-    if(!_trace_model)
+    if(!_snapshot)
         return 0;
 
-    return parent.isValid() ? 0 : int(_trace_model->safe_size());
+    return parent.isValid() ? 0 : int(_snapshot->size());
 }
 
 int TraceTableModel::columnCount(const QModelIndex &parent) const
@@ -161,37 +204,23 @@ QVariant TraceTableModel::data(const QModelIndex &index, int role) const
         process_role = false;
     }
 
-    if(!_trace_model || !process_role)
+    if(!process_role)
         return result;
 
-    _trace_model->mutex()->lock();
+    // snapshot is immutable and messages of it are deleted after it is replaced, so they are read without lock
 
-    if(index.row() < int(_trace_model->size()))
-    {
-        trace_message_t message_k = *_trace_model->at(index.row());
+    const trace_message_t *message = at(index.row());
 
-        const trace_message_t *message = &message_k;
-
-        _trace_model->mutex()->unlock();
-
-        //TODO можно сделать проще - перенести эту часть на EnityItem
-
-        // message->module_data(role, flags);
+    if(message)
+    {
+        if(((role == Qt::DisplayRole) || (role == Qt::ToolTipRole)) && find_format(message->index, index.column(), role, result))
+        {
+            return result;
+        }
 
-        if(index.column() == _number_index) return data_number(message, index, role);
-        else if(index.column() == _timestamp_index) return data_timestamp(message, index, role);
-        else if(index.column() == _process_index) return data_process(message, index, role);
-        else if(index.column() == _module_index) return data_module(message, index, role);
-        else if(index.column() == _thread_index) return data_thread(message, index, role);
-        else if(index.column() == _call_level_index) return data_call_level(message, index, role);
-        else if(index.column() == _message_type_index) return data_message_type(message, index, role);
-        else if(index.column() == _context_index) return data_context(message, index, role);
-        else if(index.column() == _message_index) return data_message(message, index, role);
-        else return data_function(message, index, role);
+        return column_data(message, index.column(), index, role, _processes);
     }
 
-    _trace_model->mutex()->unlock();
-
     return result;
 }
 
@@ -206,9 +235,9 @@ QVariant TraceTableModel::headerData(int section, Qt::Orientation orientation, i
     {
         if(role == Qt::DisplayRole)
         {
-            if(_trace_model && (section == this->columnCount() - 1) && _trace_model->size())
+            if(_snapshot && (section == this->columnCount() - 1) && _snapshot->size())
             {
-                return QString(tr("%1 %2 displayed: %3")).arg(_header_model.at(section).text).arg(QChar(UnicodeBullet)).arg(_trace_model->size());
+                return QString(tr("%1 %2 displayed: %3")).arg(_header_model.at(section).text).arg(QChar(UnicodeBullet)).arg(_snapshot->size());
             }
 
             return _header_model.at(section).text;
@@ -241,16 +270,256 @@ void TraceTableModel::model_updated()
 {
     X_CALL;
 
-    //  emit dataChanged(index(_size + 1, 0), index(_trace_model.size(), 0));
-    //    beginInsertRows(QModelIndex(), _size + 1, _trace_model.size());
+    TraceSnapshotPtr snapshot = _trace_model ? _trace_model->snapshot() : TraceSnapshotPtr();
+
+    _processes = _trace_controller.process_infos();
+
+    bool is_reset = !snapshot || !_snapshot || (snapshot->epoch != _snapshot->epoch) || (snapshot->size() < _snapshot->size());
+
+    if(is_reset)
+    {
+        // messages of previous snapshot may be deleted after frame, so it is replaced even in hidden view
+
+        stop_formatting();
+    }
+    else if(!_is_shown)
+    {
+        _update_pending = true;
+
+        return;
+    }
+
+    _update_pending = false;
+
+    if(!is_reset && (snapshot->size() > _snapshot->size()))
+    {
+        // messages, appended during frame, are inserted by one notification
+
+        beginInsertRows(QModelIndex(), int(_snapshot->size()), int(snapshot->size()) - 1);
+
+        _snapshot = snapshot;
 
-    //    _size = _trace_model.size();
+        endInsertRows();
+
+        return;
+    }
 
-    //    endInsertRows();
+    _snapshot = snapshot;
 
     emit layoutChanged();
-    // emit rowsInserted(QModelIndex(), _trace_model.size(), _trace_model.size());
-    //emit dataChanged(index(_trace_model.size()));
+}
+
+void TraceTableModel::set_shown(bool is_shown)
+{
+    X_CALL;
+
+    _is_shown = is_shown;
+
+    if(_is_shown && _update_pending)
+    {
+        model_updated();
+    }
+}
+
+void TraceTableModel::set_visible_rows(int first, int last)
+{
+    QMutexLocker lock(&_format_mutex);
+
+    if(!_snapshot || (first < 0) || (last < first))
+    {
+        return;
+    }
+
+    _format_snapshot = _snapshot;
+    _format_processes = _processes;
+    _format_first = qMax(0, first - FormatMargin);
+    _format_last = qMin(int(_snapshot->size()) - 1, last + FormatMargin);
+
+    _format_requested = true;
+
+    if(!_format_scheduled)
+    {
+        _format_scheduled = true;
+
+        _thread_pool.start(new FormatTask(this));
+    }
+}
+
+void TraceTableModel::clear_formats()
+{
+    X_CALL;
+
+    QMutexLocker lock(&_format_mutex);
+
+    // indices of messages are reused by the next trace
+
+    _format_generation++;
+
+    _row_formats.clear();
+}
+
+void TraceTableModel::stop_formatting()
+{
+    {
+        QMutexLocker lock(&_format_mutex);
+
+        _format_requested = false;
+        _format_generation++;
+    }
+
+    // messages of formatted snapshot can be deleted after return
+
+    _thread_pool.waitForDone();
+}
+
+QVariant TraceTableModel::column_data(const trace_message_t *message, int column, const QModelIndex &index, int role, const QVector<process_info_t> &processes) const
+{
+    //TODO можно сделать проще - перенести эту часть на EnityItem
+
+    // message->module_data(role, flags);
+
+    if(column == _number_index) return data_number(message, index, role);
+    else if(column == _timestamp_index) return data_timestamp(message, index, role, processes);
+    else if(column == _process_index) return data_process(message, index, role, processes);
+    else if(column == _module_index) return data_module(message, index, role);
+    else if(column == _thread_index) return data_thread(message, index, role);
+    else if(column == _call_level_index) return data_call_level(message, index, role);
+    else if(column == _message_type_index) return data_message_type(message, index, role);
+    else if(column == _context_index) return data_context(message, index, role);
+    else if(column == _message_index) return data_message(message, index, role);
+    else return data_function(message, index, role);
+}
+
+TraceTableModel::row_format_t TraceTableModel::format_row(const trace_message_t *message, const QVector<process_info_t> &processes) const
+{
+    row_format_t format;
+
+    format.display.resize(_header_model.size());
+    format.tool_tip.resize(_header_model.size());
+
+    for(int column = 0; column < _header_model.size(); ++column)
+    {
+        // number depends on row, not on message
+
+        if(column != _number_index)
+        {
+            format.display[column] = column_data(message, column, QModelIndex(), Qt::DisplayRole, processes);
+            format.tool_tip[column] = column_data(message, column, QModelIndex(), Qt::ToolTipRole, processes);
+        }
+    }
+
+    return format;
+}
+
+bool TraceTableModel::find_format(index_t message_index, int column, int role, QVariant &result) const
+{
+    if(column == _number_index)
+    {
+        return false;
+    }
+
+    QMutexLocker lock(&_format_mutex);
+
+    QHash<index_t, row_format_t>::const_iterator it = _row_formats.constFind(message_index);
+
+    if(it == _row_formats.constEnd())
+    {
+        return false;
+    }
+
+    result = (role == Qt::DisplayRole) ? it->display.at(column) : it->tool_tip.at(column);
+
+    return true;
+}
+
+void TraceTableModel::format_rows()
+{
+    X_CALL;
+
+    forever
+    {
+        TraceSnapshotPtr snapshot;
+        QVector<process_info_t> processes;
+
+        int first;
+        int last;
+
+        quint64 generation;
+
+        {
+            QMutexLocker lock(&_format_mutex);
+
+            if(!_format_requested)
+            {
+                _format_scheduled = false;
+                _format_snapshot.clear();
+                _format_processes.clear();
+
+                return;
+            }
+
+            _format_requested = false;
+
+            snapshot = _format_snapshot;
+            processes = _format_processes;
+            first = _format_first;
+            last = _format_last;
+            generation = _format_generation;
+        }
+
+        QHash<index_t, row_format_t> formats;
+
+        TraceChunkDataPtr chunk;
+
+        bool is_complete = true;
+
+        for(int row = first; row <= last; ++row)
+        {
+            const trace_message_t *message = snapshot->stream_at(row, chunk);
+
+            {
+                QMutexLocker lock(&_format_mutex);
+
+                if(_format_requested || (generation != _format_generation))
+                {
+                    // view is scrolled, rows of the new window are formatted first
+
+                    is_complete = false;
+
+                    break;
+                }
+
+                QHash<index_t, row_format_t>::const_iterator it = _row_formats.constFind(message->index);
+
+                if(it != _row_formats.constEnd())
+                {
+                    formats.insert(message->index, *it);
+
+                    continue;
+                }
+            }
+
+            formats.insert(message->index, format_row(message, processes));
+        }
+
+        QMutexLocker lock(&_format_mutex);
+
+        if(generation != _format_generation)
+        {
+            continue;
+        }
+
+        // formats of rows out of window are dropped after complete pass, so cache is limited by window size
+
+        if(is_complete)
+        {
+            _row_formats.swap(formats);
+        }
+        else
+        {
+            _row_formats.insert(formats);
+        }
+    }
 }
 
 QVariant TraceTableModel::data_number(const trace_message_t *, const QModelIndex &index, int role) const
@@ -268,7 +537,7 @@ QVariant TraceTableModel::data_number(const trace_message_t *, const QModelIndex
     return result;
 }
 
-QVariant TraceTableModel::data_timestamp(const trace_message_t *message, const QModelIndex &, int role) const
+QVariant TraceTableModel::data_timestamp(const trace_message_t *message, const QModelIndex &, int role, const QVector<process_info_t> &processes) const
 {
     QVariant result;
 
@@ -276,14 +545,14 @@ QVariant TraceTableModel::data_timestamp(const trace_message_t *message, const Q
     {
     case Qt::DisplayRole:
     case Qt::ToolTipRole:
-        result = QString::number((message->timestamp + _trace_controller.process_at(message).time_delta()) / 1000000000.0, 'f', 6);
+        result = QString::number((message->timestamp + processes.value(message->process_index).time_delta) / 1000000000.0, 'f', 6);
         break;
     }
 
     return result;
 }
 
-QVariant TraceTableModel::data_process(const trace_message_t *message, const QModelIndex &, int role) const
+QVariant TraceTableModel::data_process(const trace_message_t *message, const QModelIndex &, int role, const QVector<process_info_t> &processes) const
 {
     QVariant result;
 
@@ -293,8 +562,12 @@ QVariant TraceTableModel::data_process(const trace_message_t *message, const QMo
         result = message->process_index + 1;
         break;
     case Qt::ToolTipRole:
-        result = QString("#%1: %2 [%3]").arg(message->process_index + 1).arg(_trace_controller.process_at(message).pid()).arg(_trace_controller.process_at(message).pid());
+    {
+        process_info_t process = processes.value(message->process_index);
+
+        result = QString("#%1: %2 [%3]").arg(message->process_index + 1).arg(_trace_controller.process_name_at(process.name_index).text()).arg(process.pid);
         break;
+    }
     case Qt::BackgroundRole:
         result = _trace_controller.process_at(message).data(ColorRole);
         break;
@@ -319,13 +592,13 @@ QVariant TraceTableModel::data_module(const trace_message_t *message, const QMod
     {
     case Qt::DisplayRole:
     case Qt::ToolTipRole:
-        result = _trace_controller.module_at(message)->text();
+        result = _trace_controller.module_at(message).text();
         break;
     case Qt::DecorationRole:
-        result = _trace_controller.module_at(message)->data(ColorRole);
+        result = _trace_controller.module_at(message).data(ColorRole);
         break;
     case FilterDataRole:
-        result = _trace_controller.module_at(message)->data(FilterDataRole);
+        result = _trace_controller.module_at(message).data(FilterDataRole);
         break;
     }
 
@@ -341,19 +614,19 @@ QVariant TraceTableModel::data_thread(const trace_message_t *message, const QMod
     switch(role)
     {
     case Qt::DisplayRole:
-        result = QString("%1_%2").arg(message->process_index + 1).arg(_trace_controller.thread_item_at(message)->data(IDItem::Idx2Role).toInt());
+        result = QString("%1_%2").arg(message->process_index + 1).arg(_trace_controller.thread_at(message).data(IDItem::Idx2Role).toInt());
         break;
     case Qt::ToolTipRole:
-        result = _trace_controller.thread_item_at(message)->text();
+        result = _trace_controller.thread_at(message).text();
         break;
     case Qt::BackgroundRole:
-        result = _trace_controller.thread_item_at(message)->data(ColorRole);
+        result = _trace_controller.thread_at(message).data(ColorRole);
         break;
     case Qt::ForegroundRole:
-        result = _trace_controller.thread_item_at(message)->data(TextColorRole);
+        result = _trace_controller.thread_at(message).data(TextColorRole);
         break;
     case FilterDataRole:
-        result = _trace_controller.thread_item_at(message)->data(FilterDataRole);
+        result = _trace_controller.thread_at(message).data(FilterDataRole);
         break;
     }
 
@@ -369,19 +642,19 @@ QVariant TraceTableModel::data_context(const trace_message_t *message, const QMo
     switch(role)
     {
     case Qt::DisplayRole:
-        result = QString("%1_%2").arg(message->process_index + 1).arg(_trace_controller.context_item_at(message)->data(IDItem::Idx2Role).toInt());
+        result = QString("%1_%2").arg(message->process_index + 1).arg(_trace_controller.context_at(message).data(IDItem::Idx2Role).toInt());
         break;
     case Qt::ToolTipRole:
-        result = _trace_controller.context_item_at(message)->text();
+        result = _trace_controller.context_at(message).text();
         break;
     case Qt::BackgroundRole:
-        result = _trace_controller.context_item_at(message)->data(ColorRole);
+        result = _trace_controller.context_at(message).data(ColorRole);
         break;
     case Qt::ForegroundRole:
-        result = _trace_controller.context_item_at(message)->data(TextColorRole);
+        result = _trace_controller.context_at(message).data(TextColorRole);
         break;
     case FilterDataRole:
-        result = _trace_controller.context_item_at(message)->data(FilterDataRole);
+        result = _trace_controller.context_at(message).data(FilterDataRole);
         break;
     }
 
@@ -469,7 +742,7 @@ QVariant TraceTableModel::data_message(const trace_message_t *message, const QMo
 //        {
 ////            if((message->type == trace_x::MESSAGE_VALUE) || (message->type == trace_x::MESSAGE_IMAGE) || (message->type == trace_x::MESSAGE_DATA))
 ////            {
-////                result = _trace_controller.label_item_at(message)->data(FilterDataRole);
+////                result = _trace_controller.label_at(message).data(FilterDataRole);
 ////            }
 ////            else
 //            {
@@ -479,12 +752,12 @@ QVariant TraceTableModel::data_message(const trace_message_t *message, const QMo
 //        }
 //        else
 //        {
-//            QString message_text = _trace_controller.function_at(message)->text();
+//            QString message_text = _trace_controller.function_at(message).text();
 
 //            result = QVariant::fromValue(FilterItem(message_text, message_text, MessageTextEntity,
 //                                                    FilterItem::ID, -1, QVariant(), QVariant()));
 
-//           // result = _trace_controller.function_at(message)->data(FilterDataRole);
+//           // result = _trace_controller.function_at(message).data(FilterDataRole);
 //        }
 
         break;
@@ -518,8 +791,8 @@ QVariant TraceTableModel::data_function(const trace_message_t *message, const QM
 
     switch(role)
     {
-    case Qt::DisplayRole: return _trace_controller.function_at(message)->text();
-    case Qt::ToolTipRole: return _trace_controller.function_at(message)->toolTip();
+    case Qt::DisplayRole: return _trace_controller.function_at(message).text();
+    case Qt::ToolTipRole: return _trace_controller.function_at(message).tool_tip();
     }
 
     return result;
@@ -5,6 +5,9 @@
 #include <QFont>
 #include <QSize>
 #include <QColor>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
 
 #include "trace_model.h"
 #include "trace_controller.h"
@@ -28,9 +31,15 @@ public:
         Function
     };
 
+    enum
+    {
+        FormatMargin = 100 //! rows, which are formatted before and after visible rows
+    };
+
 public:
     TraceTableModel(TraceDataModel *trace_model, TraceController &trace_controller,
                     const QList<TraceColumns> &columns, QObject *parent = 0);
+    ~TraceTableModel();
 
     void set_data(TraceDataModel *data_model);
 
@@ -48,6 +57,12 @@ public:
 
     inline const trace_message_t * at(int index) const;
 
+    //! Texts of visible rows and rows around them are formatted in background, so painting doesn`t format them
+    void set_visible_rows(int first, int last);
+
+    //! Hidden view isn`t notified about appended rows until it is shown
+    void set_shown(bool is_shown);
+
     inline TraceDataModel * data_model() const;
     inline const TraceController &controller() const;
 
@@ -57,11 +72,27 @@ signals:
 
 private slots:
     void model_updated();
+    void clear_formats();
 
 private:
+    struct row_format_t
+    {
+        QVector<QVariant> display;
+        QVector<QVariant> tool_tip;
+    };
+
+    void stop_formatting();
+
+    //! Processes are read from copy, so formatting thread doesn`t access process models
+    QVariant column_data(const trace_message_t *message, int column, const QModelIndex &index, int role, const QVector<process_info_t> &processes) const;
+    row_format_t format_row(const trace_message_t *message, const QVector<process_info_t> &processes) const;
+    bool find_format(index_t message_index, int column, int role, QVariant &result) const;
+
+    void format_rows();
+
     QVariant data_number(const trace_message_t *message, const QModelIndex &index, int role) const;
-    QVariant data_timestamp(const trace_message_t *message, const QModelIndex &index, int role) const;
-    QVariant data_process(const trace_message_t *message, const QModelIndex &index, int role) const;
+    QVariant data_timestamp(const trace_message_t *message, const QModelIndex &index, int role, const QVector<process_info_t> &processes) const;
+    QVariant data_process(const trace_message_t *message, const QModelIndex &index, int role, const QVector<process_info_t> &processes) const;
     QVariant data_module(const trace_message_t *message, const QModelIndex &index, int role) const;
     QVariant data_thread(const trace_message_t *message, const QModelIndex &index, int role) const;
     QVariant data_context(const trace_message_t *message, const QModelIndex &index, int role) const;
@@ -87,6 +118,41 @@ protected:
     TraceDataModel *_trace_model;
     TraceController &_trace_controller;
 
+    //! Rows of data model, published on the last update. Cells are read from it without lock of data model
+    TraceSnapshotPtr _snapshot;
+
+    //! Processes of snapshot, they are taken after rows, so they cover all messages of it
+    QVector<process_info_t> _processes;
+
+private:
+    friend class FormatTask;
+
+    //! Display and tool tip texts of rows around visible rows by message index
+    QHash<index_t, row_format_t> _row_formats;
+
+    //! Requested window of rows
+    TraceSnapshotPtr _format_snapshot;
+    QVector<process_info_t> _format_processes;
+    int _format_first;
+    int _format_last;
+
+    bool _format_requested;
+
+    //! Formatting task is queued and not finished yet
+    bool _format_scheduled;
+
+    //! Incremented on clear, so formats of cleared rows are discarded
+    quint64 _format_generation;
+
+    QThreadPool _thread_pool;
+
+    mutable QMutex _format_mutex;
+
+    bool _is_shown;
+
+    //! Rows are appended, while view is hidden
+    bool _update_pending;
+
     int _number_index;
     int _timestamp_index;
     int _process_index;
@@ -101,7 +167,7 @@ protected:
 
 const trace_message_t *TraceTableModel::at(int index) const
 {
-    return _trace_model->value(index);
+    return (_snapshot && (index >= 0) && (size_t(index) < _snapshot->size())) ? _snapshot->at(index) : 0;
 }
 
 TraceDataModel *TraceTableModel::data_model() const
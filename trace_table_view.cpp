@@ -92,6 +92,175 @@ private:
     QPen _pen;
 };
 
+//! Density of trace messages by time, split by message types. Visible rows and issues are marked over it,
+//! click jumps to the first message of time. Density is counted for main trace, so strip is shown only with it
+class DensityStrip : public QWidget
+{
+public:
+    enum
+    {
+        StripWidth     = 14,
+        IssueMarkWidth = 3
+    };
+
+    DensityStrip(TraceTableView *parent):
+        QWidget(parent),
+        _view(parent),
+        _controller(0)
+    {
+        setCursor(Qt::PointingHandCursor);
+        setToolTip(tr("Message density"));
+    }
+
+    void set_controller(TraceController *controller)
+    {
+        _controller = controller;
+
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent *)
+    {
+        QPainter painter(this);
+
+        painter.fillRect(rect(), palette().base());
+
+        if(!_view->model() || !_controller || !height())
+        {
+            return;
+        }
+
+        const MessageDensity &density = _controller->density();
+
+        quint64 end = density.last_time() + 1;
+
+        // counts are taken from pyramid level, which has about one bucket per pixel
+
+        QVector<quint32> counts = density.counts(0, end, height());
+
+        QVector<quint32> totals(height());
+
+        quint32 max_total = 0;
+
+        for(int y = 0; y < height(); ++y)
+        {
+            for(int type = 0; type < MessageDensity::TypeCount; ++type)
+            {
+                totals[y] += counts.at(y * MessageDensity::TypeCount + type);
+            }
+
+            max_total = qMax(max_total, totals.at(y));
+        }
+
+        if(!max_total)
+        {
+            return;
+        }
+
+        const QVector<trace_x::MessageType> &issue_types = _controller->trace_model_service().issue_model()->issue_types();
+
+        int bar_width = width() - IssueMarkWidth;
+
+        for(int y = 0; y < height(); ++y)
+        {
+            quint32 total = totals.at(y);
+
+            if(!total)
+            {
+                continue;
+            }
+
+            int length = qMax(1, int(quint64(bar_width) * total / max_total));
+
+            quint64 sum = 0;
+
+            int x = 0;
+
+            for(int type = 0; type < MessageDensity::TypeCount; ++type)
+            {
+                sum += counts.at(y * MessageDensity::TypeCount + type);
+
+                int next_x = int(length * sum / total);
+
+                if(next_x > x)
+                {
+                    painter.fillRect(x, y, next_x - x, 1, MessageTypeItem::message_type_color(type));
+
+                    x = next_x;
+                }
+            }
+
+            foreach (trace_x::MessageType type, issue_types)
+            {
+                if(counts.at(y * MessageDensity::TypeCount + type))
+                {
+                    painter.fillRect(bar_width, y - 1, IssueMarkWidth, 3, MessageTypeItem::message_type_color(type));
+                }
+            }
+        }
+
+        // visible rows
+
+        int first_row = _view->rowAt(0);
+        int last_row = _view->rowAt(_view->viewport()->height() - 1);
+
+        if(last_row < 0)
+        {
+            last_row = _view->model()->rowCount() - 1;
+        }
+
+        const trace_message_t *first_message = _view->model()->at(first_row);
+        const trace_message_t *last_message = _view->model()->at(last_row);
+
+        if(first_message && last_message)
+        {
+            int top = int(_controller->message_time(first_message) * height() / end);
+            int bottom = int(_controller->message_time(last_message) * height() / end);
+
+            QColor color = x_settings().main_color;
+
+            painter.setPen(color);
+
+            color.setAlpha(60);
+
+            painter.setBrush(color);
+
+            painter.drawRect(0, qMin(top, bottom), width() - 1, qMax(2, qAbs(bottom - top)));
+        }
+    }
+
+    void mousePressEvent(QMouseEvent *event)
+    {
+        jump(event->pos().y());
+    }
+
+    void mouseMoveEvent(QMouseEvent *event)
+    {
+        if(event->buttons() & Qt::LeftButton)
+        {
+            jump(event->pos().y());
+        }
+    }
+
+private:
+    void jump(int y)
+    {
+        if(!_view->model() || !_controller || !height())
+        {
+            return;
+        }
+
+        quint64 time = quint64(qBound(0, y, height() - 1)) * (_controller->density().last_time() + 1) / height();
+
+        _view->select_by_index(_controller->index_by_time(time), true, true);
+    }
+
+private:
+    TraceTableView *_view;
+    TraceController *_controller;
+};
+
 class HeaderView : public QHeaderView
 {
 public:
@@ -135,6 +304,7 @@ private:
 
 TraceTableView::TraceTableView(QWidget *parent):
     TableView(parent),
+    _controller(0),
     _model(0),
     _auto_scroll(false),
     _current_message_index(0),
@@ -149,9 +319,13 @@ TraceTableView::TraceTableView(QWidget *parent):
     setDragDropMode(QAbstractItemView::DragDrop);
     setDragDropOverwriteMode(true);
 
+    _density_strip = new DensityStrip(this);
+
     setVerticalScrollBar(_scrollbar = new ScrollBar(this));
     setHorizontalHeader(new HeaderView(Qt::Horizontal));
 
+    connect(_scrollbar, &QScrollBar::valueChanged, this, &TraceTableView::update_visible_rows);
+
     setSelectionBehavior(QTableView::SelectRows);
     verticalHeader()->setVisible(false);
 
@@ -180,6 +354,10 @@ void TraceTableView::initialize(TraceController *controller, TraceTableModel *mo
 
     _controller = controller;
 
+    _density_strip->set_controller(controller);
+
+    update_density_strip();
+
     connect(_controller, &TraceController::model_updated, this, &TraceTableView::update_columns);
 
     connect(&_controller->trace_model_service(), &TraceModelService::update_search, this, &TraceTableView::update_search);
@@ -205,6 +383,9 @@ void TraceTableView::set_model(TraceTableModel *model)
     connect(model, &TraceTableModel::cleaned, this, &TraceTableView::clear_search);
 
     connect(model, &TraceTableModel::layoutChanged, this, &TraceTableView::update_scroll);
+    connect(model, &TraceTableModel::rowsInserted, this, &TraceTableView::update_scroll);
+
+    model->set_shown(isVisible());
 }
 
 void TraceTableView::set_filter(FilterChain filter)
@@ -214,6 +395,8 @@ void TraceTableView::set_filter(FilterChain filter)
     _filter_set = filter;
 
     _model->set_data(_controller->trace_model_service().request_trace_model(filter));
+
+    update_density_strip();
 }
 
 void TraceTableView::set_autoscroll(bool enabled)
@@ -370,16 +553,60 @@ void TraceTableView::resizeEvent(QResizeEvent *event)
 
     QRect geometry = _filter_widget->geometry();
 
+    int strip_width = _density_strip->isHidden() ? 0 : int(DensityStrip::StripWidth);
+
     if(!verticalScrollBar()->isVisible())
     {
-        geometry.moveTopRight(QPoint(this->width(), 0));
+        geometry.moveTopRight(QPoint(this->width() - strip_width, 0));
     }
     else
     {
-        geometry.moveTopRight(QPoint(this->width() - this->verticalScrollBar()->width(), 0));
+        geometry.moveTopRight(QPoint(this->width() - this->verticalScrollBar()->width() - strip_width, 0));
     }
 
     _filter_widget->setGeometry(geometry);
+
+    update_visible_rows();
+}
+
+void TraceTableView::updateGeometries()
+{
+    TableView::updateGeometries();
+
+    // density strip is placed between viewport and scroll bar
+
+    QMargins margins = viewportMargins();
+
+    int strip_width = _density_strip->isHidden() ? 0 : int(DensityStrip::StripWidth);
+
+    if(margins.right() != strip_width)
+    {
+        setViewportMargins(margins.left(), margins.top(), strip_width, margins.bottom());
+    }
+
+    QRect geometry = viewport()->geometry();
+
+    _density_strip->setGeometry(geometry.right() + 1, geometry.top(), DensityStrip::StripWidth, geometry.height());
+}
+
+void TraceTableView::showEvent(QShowEvent *event)
+{
+    TableView::showEvent(event);
+
+    if(_model)
+    {
+        _model->set_shown(true);
+    }
+}
+
+void TraceTableView::hideEvent(QHideEvent *event)
+{
+    TableView::hideEvent(event);
+
+    if(_model)
+    {
+        _model->set_shown(false);
+    }
 }
 
 void TraceTableView::dragEnterEvent(QDragEnterEvent *event)
@@ -525,9 +752,9 @@ void TraceTableView::update_columns()
 {
     X_CALL;
 
-    setColumnHidden(TraceTableModel::Module, _controller->items_by_class(ModuleNameEntity).size() <= 1);
-    setColumnHidden(TraceTableModel::Process, _controller->items_by_class(ProcessIdEntity).size() <= 1);
-    setColumnHidden(TraceTableModel::Thread, _controller->items_by_class(ThreadIdEntity).size() <= 2);
+    setColumnHidden(TraceTableModel::Module, _controller->entities_by_class(ModuleNameEntity).size() <= 1);
+    setColumnHidden(TraceTableModel::Process, _controller->entities_by_class(ProcessIdEntity).size() <= 1);
+    setColumnHidden(TraceTableModel::Thread, _controller->entities_by_class(ThreadIdEntity).size() <= 2);
 }
 
 void TraceTableView::update_search()
@@ -540,13 +767,15 @@ void TraceTableView::update_search()
 
     data->lock();
 
-    for(size_t i = 0; i < data->size(); ++i)
+    data->for_each_message(0, data->size(), [&markers](size_t i, const trace_message_t *message)
     {
-        if(data->at(i)->flags == SearchHighlighted)
+        if(message->flags == SearchHighlighted)
         {
             markers.append(i);
         }
-    }
+
+        return true;
+    });
 
     data->unlock();
 
@@ -568,6 +797,42 @@ void TraceTableView::update_scroll()
     {
         scrollToBottom();
     }
+
+    update_visible_rows();
+}
+
+void TraceTableView::update_density_strip()
+{
+    // filtered and call stack tables have rows of other models, so main trace density and jumps don`t match them
+
+    bool is_main = _controller && _model && (_model->data_model() == &_controller->trace_model());
+
+    if(is_main == _density_strip->isHidden())
+    {
+        _density_strip->setVisible(is_main);
+
+        updateGeometries();
+    }
+}
+
+void TraceTableView::update_visible_rows()
+{
+    _density_strip->update();
+
+    if(!_model || !_model->rowCount())
+    {
+        return;
+    }
+
+    int first = rowAt(0);
+    int last = rowAt(viewport()->height() - 1);
+
+    if(last < 0)
+    {
+        last = _model->rowCount() - 1;
+    }
+
+    _model->set_visible_rows(qMax(0, first), last);
 }
 
 void TraceTableView::select_by_index(index_t message_index, bool clear_selection, bool set_current, int column)
@@ -601,15 +866,20 @@ void TraceTableView::select_by_index(index_t message_index, bool clear_selection
 
     if(data_model->size() > 0)
     {
-        for(; selected_index < data_model->size(); ++selected_index)
+        selected_index = data_model->size();
+
+        data_model->for_each_message(0, data_model->size(), [&](size_t i, const trace_message_t *message)
         {
-            if(data_model->at(selected_index)->index >= message_index)
+            if(message->index >= message_index)
             {
-                strong_equal = (data_model->at(selected_index)->index == message_index);
+                selected_index = i;
+                strong_equal = (message->index == message_index);
 
-                break;
+                return false;
             }
-        }
+
+            return true;
+        });
 
         valid_index = selected_index;
 
@@ -7,6 +7,7 @@
 #include "trace_filter_widget.h"
 
 class ScrollBar;
+class DensityStrip;
 
 //! Table view of trace list
 class TraceTableView : public TableView
@@ -62,6 +63,9 @@ protected:
     void mouseMoveEvent(QMouseEvent *event);
     void mouseReleaseEvent(QMouseEvent *event);
     void resizeEvent(QResizeEvent *event);
+    void updateGeometries();
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
 
     void dragEnterEvent(QDragEnterEvent *event);
     void dragLeaveEvent(QDragLeaveEvent *event);
@@ -76,6 +80,8 @@ private:
     void restore_selected_index();
     void update_scroll();
     void update_columns();
+    void update_visible_rows();
+    void update_density_strip();
 
     void update_search();
     void clear_search();
@@ -90,6 +96,7 @@ private:
     TableItemDelegate *_message_item_delegate;
 
     ScrollBar *_scrollbar;
+    DensityStrip *_density_strip;
 
     bool _auto_scroll;
 
@@ -12,11 +12,17 @@
 #include <QHeaderView>
 #include <QToolButton>
 #include <QApplication>
+#include <QTabWidget>
+#include <QSplitter>
+#include <QFileDialog>
 
 #include "settings.h"
 
 #include "panel_container.h"
 #include "profile_model.h"
+#include "call_tree_model.h"
+#include "sparkline_widget.h"
+#include "trace_exporter.h"
 
 #include "image_lib/image.h"
 
@@ -139,6 +145,9 @@ TraceViewWidget::TraceViewWidget(QWidget *parent) :
     _code_browser = new CodeBrowser();
     _code_browser->setWindowTitle(tr("Code Browser"));
 
+    _timeline_view = new TimelineView();
+    _timeline_view->setObjectName("_timeline_view");
+
     _panel_manager.add_widget(_extra_tree_view, Qt::RightEdge);
 
     PanelContainer *preview_panel = _panel_manager.add_widget(_preview_dock, Qt::RightEdge);
@@ -148,6 +157,7 @@ TraceViewWidget::TraceViewWidget(QWidget *parent) :
     _panel_manager.add_widget(_callstack_view, Qt::RightEdge);
     _panel_manager.add_widget(_issues_view, Qt::RightEdge);
     _panel_manager.add_widget(_code_browser, Qt::BottomEdge);
+    _panel_manager.add_widget(_timeline_view, Qt::BottomEdge);
 
     //
 
@@ -345,6 +355,18 @@ void TraceViewWidget::initialize(TraceService *trace_service, const QByteArray &
 
     //
 
+    _timeline_view->set_controller(_trace_controller);
+
+    connect(&_trace_controller->trace_model(), &TraceDataModel::updated, _timeline_view, &TimelineView::refresh);
+    connect(_trace_controller, &TraceController::cleaned, _timeline_view, &TimelineView::clear);
+
+    connect(_timeline_view, &TimelineView::message_selected, this, [this](index_t message_index)
+    {
+        ui->trace_view->select_by_index(message_index, true, true);
+    });
+
+    //
+
     update_trace_filter();
 
     //
@@ -514,6 +536,8 @@ void TraceViewWidget::update_current(const trace_message_t *message)
 
     update_preview();
     update_code_browser(message);
+
+    _timeline_view->set_current(message);
 }
 
 void TraceViewWidget::update_preview()
@@ -530,7 +554,11 @@ void TraceViewWidget::update_preview()
 
     if(_current_message->type == trace_x::MESSAGE_IMAGE)
     {
-        Image image = get_image(_trace_controller->data_at(_current_message));
+        DataPinPtr data_pin;
+
+        Image image = get_image(_trace_controller->data_at(_current_message, &data_pin));
+
+        image.data_pin = data_pin;
 
         _image_preview_scene->set_image(image);
 
@@ -550,7 +578,7 @@ void TraceViewWidget::update_preview()
         }
         else
         {
-            text = _trace_controller->function_at(_current_message)->toolTip();
+            text = _trace_controller->function_at(_current_message).tool_tip();
         }
 
         _text_preview->setPlainText(text);
@@ -660,7 +688,27 @@ void TraceViewWidget::update_trace_indicators()
         }
     }
 
+    // data usage by processes
+
+    QStringList usage_list;
+
+    QHash<quint32, data_usage_t> process_usage = _trace_controller->data_storage().process_usage();
+
+    for(QHash<quint32, data_usage_t>::const_iterator it = process_usage.begin(); it != process_usage.end(); ++it)
+    {
+        if(!it->memory_size && !it->swap_size)
+        {
+            continue;
+        }
+
+        QString process_name = (it.key() < quint32(_trace_controller->process_models()->size())) ?
+                    _trace_controller->process_item_at(it.key())->text() : tr("loaded");
+
+        usage_list << tr("%1 data: %2 (swap %3)").arg(process_name, string_format_bytes(it->memory_size + it->swap_size), string_format_bytes(it->swap_size));
+    }
+
     ui->captured_label->setText(text);
+    ui->captured_label->setToolTip(usage_list.join("\n"));
 }
 
 TraceTableModel *TraceViewWidget::make_table_model()
@@ -732,6 +780,8 @@ void TraceViewWidget::set_menu(QMenu *trace_menu, QMenu *help_menu)
 
     // Profile action
     table_menu->addAction(QIcon(":/icons/clock"), tr("Profile ..."), this, SLOT(profile_current_table()), QKeySequence(Qt::CTRL + Qt::Key_P));
+    table_menu->addAction(tr("Profile Difference ..."), this, SLOT(profile_difference()));
+    table_menu->addAction(tr("Export ..."), this, SLOT(export_current_table()));
 
     // Image Browser action
     table_menu->addAction(QIcon(":/icons/image"), tr("Image Browser ..."), this, SLOT(open_image_browser()), QKeySequence(Qt::CTRL + Qt::Key_I));
@@ -857,7 +907,7 @@ void TraceViewWidget::issue_selected(const QModelIndex &index)
 
     if(index.isValid())
     {
-        index_t message_index = _trace_controller->trace_model_service().issue_model()->data_model()->at(index.row())->index;
+        index_t message_index = _trace_controller->trace_model_service().issue_model()->message_at(index.row()).index;
 
         X_VALUE("selected_message_index", message_index);
 
@@ -1005,7 +1055,7 @@ void TraceViewWidget::update_code_browser(const trace_message_t *message)
 
     if(message)
     {
-        QString source_path = _trace_controller->source_at(message)->descriptor().id.toString();
+        QString source_path = _trace_controller->source_at(message).descriptor().id.toString();
 
         if(!source_path.isEmpty())
         {
@@ -1094,6 +1144,8 @@ void TraceViewWidget::clear()
 
     update_code_browser(0);
 
+    _timeline_view->set_current(0);
+
     _call_stack.clear();
 }
 
@@ -1136,7 +1188,12 @@ void TraceViewWidget::profile_current_table()
 {
     X_CALL;
 
-    ProfilerTable *table = new ProfilerTable(_trace_controller, _current_table->model()->data_model(), this);
+    QTabWidget *profiler_widget = new QTabWidget(this);
+
+    profiler_widget->setWindowTitle(tr("Profiler"));
+    profiler_widget->setDocumentMode(true);
+
+    ProfilerTable *table = new ProfilerTable(_trace_controller, _current_table->model()->data_model(), profiler_widget);
 
     connect(table, &ProfilerTable::activated_ex, this, &TraceViewWidget::filter_item_activated);
     connect(table, &ProfilerTable::find, this, &TraceViewWidget::search_by);
@@ -1144,7 +1201,44 @@ void TraceViewWidget::profile_current_table()
     connect(_trace_controller, &TraceController::cleaned, table->model(), &ProfileModel::clear);
     connect(_trace_controller, &TraceController::truncated, table->model(), &ProfileModel::clear);
 
-    Dialog *profiler_dialog = new Dialog(table, this);
+    QSplitter *profile_splitter = new QSplitter(Qt::Vertical, profiler_widget);
+
+    SparklineWidget *sparkline = new SparklineWidget(profile_splitter);
+
+    profile_splitter->addWidget(table);
+    profile_splitter->addWidget(sparkline);
+    profile_splitter->setStretchFactor(0, 1);
+    profile_splitter->setStretchFactor(1, 0);
+
+    connect(table->selectionModel(), &QItemSelectionModel::currentRowChanged, sparkline, [table, sparkline](const QModelIndex &current)
+    {
+        int row = table->source_row(current);
+
+        if(row != -1)
+        {
+            sparkline->set_timeline(table->model()->timeline(row), table->model()->index(row, ProfileModel::Function).data().toString());
+        }
+        else
+        {
+            sparkline->clear();
+        }
+    });
+
+    connect(_trace_controller, &TraceController::cleaned, sparkline, &SparklineWidget::clear);
+    connect(_trace_controller, &TraceController::truncated, sparkline, &SparklineWidget::clear);
+
+    CallTreeView *call_tree = new CallTreeView(_trace_controller, _current_table->model()->data_model(), profiler_widget);
+
+    connect(call_tree, &CallTreeView::activated_ex, this, &TraceViewWidget::filter_item_activated);
+    connect(call_tree, &CallTreeView::find, this, &TraceViewWidget::search_by);
+
+    connect(_trace_controller, &TraceController::cleaned, call_tree->model(), &CallTreeModel::clear);
+    connect(_trace_controller, &TraceController::truncated, call_tree->model(), &CallTreeModel::clear);
+
+    profiler_widget->addTab(profile_splitter, table->windowTitle());
+    profiler_widget->addTab(call_tree, call_tree->windowTitle());
+
+    Dialog *profiler_dialog = new Dialog(profiler_widget, this);
 
     profiler_dialog->setAttribute(Qt::WA_DeleteOnClose);
     profiler_dialog->setGeometry(this->geometry().adjusted(this->width() / 5, this->height() / 4, -this->width() / 5, -this->height() / 4));
@@ -1152,6 +1246,49 @@ void TraceViewWidget::profile_current_table()
     profiler_dialog->show();
 }
 
+void TraceViewWidget::profile_difference()
+{
+    X_CALL;
+
+    // main trace table is the base, subtrace table with additional filter is compared with it
+
+    ProfileModel base_profile(_trace_controller, ui->trace_view->model()->data_model());
+    ProfileModel current_profile(_trace_controller, ui->subtrace_view->model()->data_model());
+
+    ProfileDiffTable *table = new ProfileDiffTable(base_profile.function_summary(), current_profile.function_summary());
+
+    Dialog *diff_dialog = new Dialog(table, this);
+
+    diff_dialog->setAttribute(Qt::WA_DeleteOnClose);
+    diff_dialog->setGeometry(this->geometry().adjusted(this->width() / 5, this->height() / 4, -this->width() / 5, -this->height() / 4));
+
+    diff_dialog->show();
+}
+
+void TraceViewWidget::export_current_table()
+{
+    X_CALL;
+
+    QStringList filters;
+
+    filters << tr("Chrome trace (*.json)") << tr("Folded stacks (*.folded)") << tr("Profile (*.csv)");
+
+    QString selected_filter;
+
+    QString file_name = QFileDialog::getSaveFileName(this, tr("Export"), QString(), filters.join(";;"), &selected_filter);
+
+    if(!file_name.isEmpty())
+    {
+        ExportFormat format = ExportFormat(qMax(0, filters.indexOf(selected_filter)));
+
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+
+        export_trace(format, file_name, _trace_controller, _current_table->model()->data_model());
+
+        QApplication::restoreOverrideCursor();
+    }
+}
+
 void TraceViewWidget::open_image_browser()
 {
     X_CALL;
@@ -20,6 +20,7 @@
 #include "trace_table_view.h"
 #include "panel_manager.h"
 #include "code_browser.h"
+#include "timeline_view.h"
 
 #include "image_lib/image_view.h"
 #include "image_lib/image_scene.h"
@@ -98,6 +99,8 @@ private slots:
 
     void invoke_on_current_table(table_method_t method);
     void profile_current_table();
+    void profile_difference();
+    void export_current_table();
     void open_image_browser();
 
     void select_next_table();
@@ -136,6 +139,7 @@ private:
     CallstackModel *_call_stack_model;
     TraceTableView *_current_table;
     CodeBrowser *_code_browser;
+    TimelineView *_timeline_view;
 
     uint64_t _current_duration;
 